@@ -0,0 +1,426 @@
+/*
+ * app_calib.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ */
+
+#include "app_calib.h"
+
+#define CALIB_CONFIRM_TICKS ((CALIB_CONFIRM_MS + CTRL_PERIOD_MS - 1) / CTRL_PERIOD_MS)
+#define CALIB_SETTLE_TICKS  (CALIB_SETTLE_MS / CTRL_PERIOD_MS)
+#define CALIB_HOLD_TICKS    (CALIB_HOLD_MS / CTRL_PERIOD_MS)
+#define CALIB_STRIDE_TICKS  (CALIB_STEP_MS / CALIB_STEP_SAMPLES / CTRL_PERIOD_MS)
+#define CALIB_STEP_TICKS    (CALIB_STRIDE_TICKS * CALIB_STEP_SAMPLES)
+
+typedef enum
+{
+    CALIB_PHASE_UP = 0, // 占空比上升，等待起转 Duty rising until the wheel breaks away
+    CALIB_PHASE_DOWN,   // 占空比下降，拟合库仑摩擦 Duty falling, fitting the Coulomb level
+    CALIB_PHASE_HOLD,   // 辨识：保持低占空比 Identification: holding the low duty
+    CALIB_PHASE_STEP,   // 辨识：阶跃到高占空比并记录 Identification: stepped to the high duty, recording
+    CALIB_PHASE_DONE
+} Calib_Phase_t;
+
+// 一路电机一个方向的标定状态 Calibration state of one motor in one direction
+typedef struct
+{
+    uint8_t phase;
+    uint8_t valid;         // 已测到起转 Breakaway was found
+    uint16_t confirm;      // 条件已连续满足的拍数 Ticks the condition has held in a row
+    int32_t duty_mc;       // 当前占空比，千分之一PWM计数 Current duty, thousandths of a PWM count
+    int16_t mark;          // 条件开始满足时的占空比 Duty when the condition started to hold
+    int16_t static_pulse;
+    int16_t coulomb_pulse;
+    int16_t viscous_q8;
+    // 下降段占空比对轮速的最小二乘和 Least-squares sums of duty against wheel speed on the way down
+    int32_t n, sum_v, sum_d;
+    int64_t sum_vv, sum_vd;
+    // 阶跃辨识 Step identification
+    uint8_t stepped;       // 阶跃已记录完 The step was recorded
+    int16_t step_lo, step_hi;
+    int16_t v0;            // 阶跃前的轮速 Wheel speed before the step
+    uint16_t tick;         // 本阶段已过的拍数 Ticks into this phase
+    int32_t acc;           // 轮速累加 Speed accumulator
+    int16_t sample[CALIB_STEP_SAMPLES];
+} Calib_Motor_t;
+
+static struct
+{
+    volatile uint8_t running;
+    uint8_t ident;   // 摩擦标定后再做阶跃辨识 Run the step identification after the friction ramps
+    uint8_t dir;     // 0正转，1反转 0 forward, 1 reverse
+    uint16_t settle; // 剩余等待拍数 Ticks left to wait
+    Calib_Motor_t motor[MAX_MOTOR];
+} s_calib;
+
+static Calib_Ident_t s_ident[MAX_MOTOR];
+
+static void Calib_Reset_Motors(void)
+{
+    for (uint8_t i = 0; i < MAX_MOTOR; i++)
+    {
+        s_calib.motor[i] = (Calib_Motor_t){0};
+    }
+}
+
+static void Calib_Start(uint8_t ident)
+{
+    s_calib.running = 0;
+    Motion_Stop(STOP_FREE);
+    s_calib.ident = ident;
+    s_calib.dir = 0;
+    s_calib.settle = CALIB_SETTLE_TICKS;
+    Calib_Reset_Motors();
+    s_calib.running = 1;
+}
+
+/**
+ * @brief  开始摩擦标定，小车先自由停车，之后由Calib_Handle在TIM6中断中推进
+ *         Start the friction calibration. The car coasts to a stop first;
+ *         Calib_Handle then runs it from the TIM6 interrupt
+ * @retval 无
+ */
+void Calib_Friction_Start(void)
+{
+    Calib_Start(0);
+}
+
+/**
+ * @brief  开始系统辨识：摩擦标定之后每个方向再做一次占空比阶跃，
+ *         测出增益、时间常数和死区，写回摩擦前馈并整定各电机的速度环
+ *         Start the system identification: the friction ramps followed by
+ *         a duty step in each direction, measuring gain, time constant and
+ *         dead band, which go to the friction feedforward and tune each
+ *         motor's speed loop
+ * @retval 无
+ */
+void Calib_Ident_Start(void)
+{
+    for (uint8_t i = 0; i < MAX_MOTOR; i++)
+    {
+        s_ident[i] = (Calib_Ident_t){0};
+    }
+    Calib_Start(1);
+}
+
+uint8_t Calib_Is_Running(void)
+{
+    return s_calib.running;
+}
+
+// 最近一次辨识的结果，未辨识的方向valid对应位为0 Results of the last identification; directions not identified have their valid bit clear
+const Calib_Ident_t *Calib_Get_Ident(uint8_t motor_id)
+{
+    return &s_ident[motor_id < MAX_MOTOR ? motor_id : 0];
+}
+
+// 下降段拟合占空比=库仑摩擦+粘性项×轮速，样本不足时返回0
+// Fit duty = Coulomb + viscous x speed on the way down, returns 0 without enough samples
+static uint8_t Calib_Fit(Calib_Motor_t *m)
+{
+    int64_t den = (int64_t)m->n * m->sum_vv - (int64_t)m->sum_v * m->sum_v;
+    if (m->n < 3 || den <= 0)
+        return 0;
+    int64_t coulomb = ((int64_t)m->sum_d * m->sum_vv - (int64_t)m->sum_v * m->sum_vd) / den;
+    int64_t viscous = (((int64_t)m->n * m->sum_vd - (int64_t)m->sum_v * m->sum_d) << 8) / den;
+    if (coulomb < 0 || coulomb > m->static_pulse || viscous < 0 || viscous > INT16_MAX)
+        return 0;
+    m->coulomb_pulse = (int16_t)coulomb;
+    m->viscous_q8 = (int16_t)viscous;
+    return 1;
+}
+
+// 按摩擦拟合换算轮速对应的占空比 Duty for a wheel speed from the friction fit
+static int16_t Calib_Fit_Duty(const Calib_Motor_t *m, int16_t speed)
+{
+    int32_t duty = m->coulomb_pulse + (((int32_t)m->viscous_q8 * speed) >> 8);
+    return (int16_t)(duty < MOTOR_MAX_PULSE ? duty : MOTOR_MAX_PULSE);
+}
+
+/**
+ * @brief  由阶跃响应求一阶模型：增益为轮速变化除以占空比变化，死区为低占空比减去起始轮速对应的量，
+ *         时间常数为轮速升到63.2%的时刻(样本取区间中点，相邻样本间线性插值)
+ *         Fit a first-order model to the step: gain is the speed change over
+ *         the duty change, dead band is the low duty less what the starting
+ *         speed needs, and the time constant is when the speed reaches 63.2%
+ *         (each sample stands at the middle of its interval, interpolated
+ *         between neighbours)
+ * @retval 1成功，0响应不可用 1 on success, 0 if the response is unusable
+ */
+static uint8_t Calib_Ident_Fit(const Calib_Motor_t *m, float *gain, float *tau_s, int16_t *dead)
+{
+    const float ts = CALIB_STRIDE_TICKS * CTRL_PERIOD_MS * 0.001f;
+    int32_t v1 = 0;
+
+    for (uint8_t k = CALIB_STEP_SAMPLES - CALIB_STEP_SAMPLES / 4; k < CALIB_STEP_SAMPLES; k++)
+    {
+        v1 += m->sample[k];
+    }
+    v1 /= CALIB_STEP_SAMPLES / 4;
+    if (m->v0 < MOTOR_FF_MOVING_MM_S || v1 <= m->v0 || m->step_hi <= m->step_lo)
+        return 0;
+
+    // 增益过小时粘性项256/gain或死区超出int16，转换无定义，同Calib_Fit拒绝
+    // With too small a gain the viscous term 256/gain or the dead band overflows int16,
+    // where the conversion is undefined; rejected as in Calib_Fit
+    *gain = (float)(v1 - m->v0) / (m->step_hi - m->step_lo);
+    float dead_f = m->step_lo - m->v0 / *gain;
+    if (256.0f / *gain > INT16_MAX || dead_f < 0 || dead_f > MOTOR_MAX_PULSE)
+        return 0;
+    *dead = (int16_t)dead_f;
+
+    float level = m->v0 + 0.632f * (v1 - m->v0);
+    float prev_v = m->v0, prev_t = 0;
+    for (uint8_t k = 0; k < CALIB_STEP_SAMPLES; k++)
+    {
+        float t = (k + 0.5f) * ts;
+        if (m->sample[k] >= level)
+        {
+            *tau_s = prev_t + (t - prev_t) * (level - prev_v) / (m->sample[k] - prev_v);
+            return 1;
+        }
+        prev_v = m->sample[k];
+        prev_t = t;
+    }
+    return 0;
+}
+
+/**
+ * @brief  按两个方向的平均模型用IMC规则整定一路电机的速度环，等效纯滞后取一个控制周期
+ *         (测速为上一拍的平均，输出保持到下一拍)
+ *         Tune one motor's speed loop with the IMC rules on the model
+ *         averaged over both directions, taking one control period as the
+ *         dead time (the speed is the mean over the last tick and the output
+ *         holds until the next)
+ */
+static void Calib_Ident_Tune(uint8_t motor_id)
+{
+    Calib_Ident_t *r = &s_ident[motor_id];
+    float gain = 0, tau = 0;
+    uint8_t n = 0;
+
+    for (uint8_t dir = 0; dir < 2; dir++)
+    {
+        if (r->valid & (1u << dir))
+        {
+            gain += r->gain[dir];
+            tau += r->tau_s[dir];
+            n++;
+        }
+    }
+    if (n == 0)
+        return;
+    gain /= n;
+    tau /= n;
+
+    const float theta = CTRL_PERIOD_MS * 0.001f, lambda = CALIB_LAMBDA_MS * 0.001f;
+    float ti = tau + theta * 0.5f;
+    r->kp = ti / (gain * (lambda + theta * 0.5f));
+    r->ki = r->kp / ti;
+    r->kd = r->kp * tau * theta / (2.0f * tau + theta);
+    PID_Set_Motor_Parm(motor_id, r->kp, r->ki, r->kd);
+}
+
+// 推进一路电机一拍，返回本拍的占空比幅值 Advance one motor by one tick, returns this tick's duty magnitude
+static int16_t Calib_Step_Motor(Calib_Motor_t *m, int16_t speed)
+{
+    int16_t duty = (int16_t)(m->duty_mc / 1000);
+
+    switch (m->phase)
+    {
+    case CALIB_PHASE_UP:
+        // 起转后继续升到CALIB_FIT_MAX_MM_S，使下降段覆盖整个拟合范围
+        // Keep rising after breakaway up to CALIB_FIT_MAX_MM_S so the way down spans the whole fit range
+        if (m->valid && speed >= CALIB_FIT_MAX_MM_S)
+        {
+            m->confirm = 0;
+            m->phase = CALIB_PHASE_DOWN;
+            return duty;
+        }
+        if (!m->valid && speed >= MOTOR_FF_MOVING_MM_S)
+        {
+            if (m->confirm++ == 0)
+                m->mark = duty;
+            if (m->confirm >= CALIB_CONFIRM_TICKS)
+            {
+                m->static_pulse = m->mark;
+                m->valid = 1;
+            }
+        }
+        else
+        {
+            m->confirm = 0;
+        }
+        m->duty_mc += CALIB_RAMP_UP * CTRL_PERIOD_MS;
+        if (m->duty_mc >= MOTOR_MAX_PULSE * 1000)
+        {
+            // 满占空比仍不转则保留原值，转得不够快就从这里开始下降
+            // Still stopped at full duty: keep the old values; turning but slowly: start down from here
+            m->phase = m->valid ? CALIB_PHASE_DOWN : CALIB_PHASE_DONE;
+            return m->valid ? duty : 0;
+        }
+        return duty;
+
+    case CALIB_PHASE_DOWN:
+        if (speed >= MOTOR_FF_MOVING_MM_S && speed <= CALIB_FIT_MAX_MM_S)
+        {
+            m->n++;
+            m->sum_v += speed;
+            m->sum_d += duty;
+            m->sum_vv += (int64_t)speed * speed;
+            m->sum_vd += (int64_t)speed * duty;
+        }
+        if (speed < MOTOR_FF_MOVING_MM_S)
+        {
+            if (m->confirm++ == 0)
+                m->mark = duty;
+            if (m->confirm >= CALIB_CONFIRM_TICKS)
+            {
+                if (!Calib_Fit(m))
+                {
+                    m->coulomb_pulse = m->mark;
+                    m->viscous_q8 = 0;
+                }
+                m->phase = CALIB_PHASE_DONE;
+                if (s_calib.ident && m->viscous_q8 > 0)
+                {
+                    m->step_lo = Calib_Fit_Duty(m, CALIB_STEP_LO_MM_S);
+                    m->step_hi = Calib_Fit_Duty(m, CALIB_STEP_HI_MM_S);
+                    m->tick = 0;
+                    m->acc = 0;
+                    m->phase = CALIB_PHASE_HOLD;
+                }
+                return 0;
+            }
+        }
+        else
+        {
+            m->confirm = 0;
+        }
+        m->duty_mc -= CALIB_RAMP_DOWN * CTRL_PERIOD_MS;
+        if (m->duty_mc < 0)
+            m->duty_mc = 0;
+        return duty;
+
+    case CALIB_PHASE_HOLD:
+        if (m->tick >= CALIB_HOLD_TICKS - CALIB_HOLD_TICKS / 4)
+            m->acc += speed;
+        if (++m->tick >= CALIB_HOLD_TICKS)
+        {
+            // 本拍起输出高占空比，下一拍测到的是阶跃后第一个周期
+            // The high duty starts this tick, so the next measurement is the first period after the step
+            m->v0 = (int16_t)(m->acc / (CALIB_HOLD_TICKS / 4));
+            m->tick = 0;
+            m->acc = 0;
+            m->phase = CALIB_PHASE_STEP;
+            return m->step_hi;
+        }
+        return m->step_lo;
+
+    case CALIB_PHASE_STEP:
+        m->acc += speed;
+        if (++m->tick % CALIB_STRIDE_TICKS == 0)
+        {
+            m->sample[m->tick / CALIB_STRIDE_TICKS - 1] = (int16_t)(m->acc / CALIB_STRIDE_TICKS);
+            m->acc = 0;
+            if (m->tick >= CALIB_STEP_TICKS)
+            {
+                m->stepped = 1;
+                m->phase = CALIB_PHASE_DONE;
+                return 0;
+            }
+        }
+        return m->step_hi;
+
+    default:
+        return 0;
+    }
+}
+
+// 两个方向都完成并等轮子停稳后结束 Finish once both directions are done and the wheels have stopped
+static void Calib_Finish(void)
+{
+    if (s_calib.ident)
+    {
+        for (uint8_t i = 0; i < MAX_MOTOR; i++)
+        {
+            Calib_Ident_Tune(i);
+        }
+    }
+    s_calib.running = 0;
+    Motion_Stop(STOP_FREE);
+}
+
+/**
+ * @brief  标定的一拍，由Motion_Handle在测速之后调用
+ *         One calibration tick, called by Motion_Handle after the speed measurement
+ * @note   每个方向上各电机独立地先升占空比直到起转(静摩擦)，再降占空比，
+ *         对下降段的占空比-轮速拟合直线，截距为库仑摩擦，斜率为粘性项。两个方向都完成后
+ *         写入Motor_Set_Friction并停车；起转失败的电机和方向保留原值
+ *         In each direction every motor ramps its duty up until it breaks
+ *         away (static friction), then down, fitting a duty/speed line to
+ *         the way down: the intercept is the Coulomb level and the slope the
+ *         viscous term. After both directions the results go to
+ *         Motor_Set_Friction and the car stops; a motor and direction that
+ *         never broke away keeps its old values.
+ *         辨识时下降段之后保持低占空比再阶跃到高占空比，记录响应(见Calib_Ident_Fit)，
+ *         两个方向完成后整定各电机的PID(见Calib_Ident_Tune)
+ *         When identifying, the way down is followed by a hold at the low
+ *         duty and a step to the high one whose response is recorded (see
+ *         Calib_Ident_Fit); after both directions each motor's PID is tuned
+ *         (see Calib_Ident_Tune)
+ * @retval 无
+ */
+void Calib_Handle(void)
+{
+    if (!s_calib.running)
+        return;
+
+    if (s_calib.settle > 0)
+    {
+        s_calib.settle--;
+        return;
+    }
+    if (s_calib.dir > 1)
+    {
+        Calib_Finish();
+        return;
+    }
+
+    float speed[MAX_MOTOR];
+    uint8_t done = 1;
+    Motion_Get_Motor_Speed(speed);
+    for (uint8_t i = 0; i < MAX_MOTOR; i++)
+    {
+        int16_t v = (int16_t)(s_calib.dir ? -speed[i] : speed[i]);
+        int16_t duty = Calib_Step_Motor(&s_calib.motor[i], v);
+        Motor_Set_Duty(i, s_calib.dir ? -duty : duty);
+        done &= s_calib.motor[i].phase == CALIB_PHASE_DONE;
+    }
+    if (!done)
+        return;
+
+    for (uint8_t i = 0; i < MAX_MOTOR; i++)
+    {
+        const Calib_Motor_t *m = &s_calib.motor[i];
+        Calib_Ident_t *r = &s_ident[i];
+        uint8_t d = s_calib.dir;
+        if (!m->valid)
+            continue;
+        // 阶跃的死区和增益不受斜坡滞后影响，可用时代替下降段拟合
+        // The step's dead band and gain carry no ramp lag, so they replace the ramp fit when available
+        if (m->stepped && Calib_Ident_Fit(m, &r->gain[d], &r->tau_s[d], &r->dead_pulse[d]))
+        {
+            r->valid |= 1u << d;
+            Motor_Set_Friction(i, d, m->static_pulse, r->dead_pulse[d], (int16_t)(256.0f / r->gain[d] + 0.5f));
+        }
+        else
+        {
+            Motor_Set_Friction(i, d, m->static_pulse, m->coulomb_pulse, m->viscous_q8);
+        }
+    }
+    Calib_Reset_Motors();
+    s_calib.settle = CALIB_SETTLE_TICKS;
+    s_calib.dir++;
+}
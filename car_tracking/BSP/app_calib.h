@@ -0,0 +1,62 @@
+/*
+ * app_calib.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * 车上标定：在TIM6中断里逐拍驱动电机并测量编码器响应，结果写回摩擦前馈，
+ * 系统辨识还据此整定各电机的速度环。标定时最好把车架空，四轮同时进行，先正转后反转。
+ * On-car calibration: drives the motors tick by tick from the TIM6
+ * interrupt, measures the encoder response and writes the results back to
+ * the friction feedforward; the system identification also tunes each
+ * motor's speed loop from them. Best done with the wheels off the ground;
+ * all four run at once, forward first, then reverse.
+ */
+
+#ifndef APP_CALIB_H_
+#define APP_CALIB_H_
+
+#include "bsp.h"
+
+// 起转时占空比上升速度，PWM计数/s Duty ramp rate while looking for breakaway, PWM counts per second
+#define CALIB_RAMP_UP (600)
+// 找库仑摩擦时占空比下降速度 Duty ramp rate while looking for the Coulomb level
+#define CALIB_RAMP_DOWN (200)
+// 轮速持续这么久高于/低于MOTOR_FF_MOVING_MM_S才算起转/停转，ms
+// The wheel speed must stay above/below MOTOR_FF_MOVING_MM_S this long to count as started/stopped, ms
+#define CALIB_CONFIRM_MS (30)
+// 下降段用于直线拟合的轮速上限，mm/s Upper wheel speed of the samples fitted on the way down, mm/s
+#define CALIB_FIT_MAX_MM_S (300)
+// 两个方向之间等待轮子停稳，ms Wait for the wheels to stop between directions, ms
+#define CALIB_SETTLE_MS (500)
+
+// 辨识阶跃的起止轮速，按摩擦拟合换算成占空比，mm/s Identification step from/to these wheel speeds, converted to duty with the friction fit, mm/s
+#define CALIB_STEP_LO_MM_S (200)
+#define CALIB_STEP_HI_MM_S (600)
+// 阶跃前保持低占空比的时长，最后四分之一取平均为起始轮速，ms
+// Hold the low duty this long before the step; the last quarter is averaged as the starting speed, ms
+#define CALIB_HOLD_MS (400)
+// 阶跃后记录的时长和点数，每点为CALIB_STEP_MS/CALIB_STEP_SAMPLES内的平均轮速
+// Record this long after the step in this many samples, each the mean speed over CALIB_STEP_MS/CALIB_STEP_SAMPLES
+#define CALIB_STEP_MS (640)
+#define CALIB_STEP_SAMPLES (64)
+// 按辨识结果整定速度环时的期望闭环时间常数，ms Closed-loop time constant the speed loop is tuned for, ms
+#define CALIB_LAMBDA_MS (100)
+
+// 一路电机的辨识结果，下标0正转1反转 Identified model of one motor, index 0 forward, 1 reverse
+typedef struct
+{
+    uint8_t valid;         // bit0正转、bit1反转已辨识 bit0 forward, bit1 reverse identified
+    float gain[2];         // 死区以上的增益，(mm/s)/PWM Gain above the dead band, (mm/s) per PWM count
+    float tau_s[2];        // 时间常数，s Time constant, s
+    int16_t dead_pulse[2]; // 死区，PWM计数 Dead band, PWM counts
+    float kp, ki, kd;      // 整定出的速度环增益，单位同PID_Set_Motor_Parm Tuned speed-loop gains, units as PID_Set_Motor_Parm
+} Calib_Ident_t;
+
+void Calib_Friction_Start(void);
+void Calib_Ident_Start(void);
+uint8_t Calib_Is_Running(void);
+const Calib_Ident_t *Calib_Get_Ident(uint8_t motor_id);
+void Calib_Handle(void);
+
+#endif /* APP_CALIB_H_ */
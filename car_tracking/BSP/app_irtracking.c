@@ -11,6 +11,8 @@
 uint8_t g_sensor_status = 0;
 // 巡线速度控制（默认500）
 int16_t g_line_speed =500;
+// 巡线可调参数
+AppTune_t g_app_tune = APP_TUNE_DEFAULT;
 
 /**
  * @brief  设置巡线基础速度
@@ -61,6 +63,10 @@ void car_irtrack(void)
 	// 获取传感器状态
 	uint8_t status = get_sensor_status();
 	int16_t base_speed = g_line_speed;
+	int16_t soft_speed = base_speed * g_app_tune.irtrack_soft_pct / 100;
+	int16_t hard_speed = base_speed * g_app_tune.irtrack_hard_pct / 100;
+	int16_t sharp_speed = base_speed * g_app_tune.irtrack_sharp_pct / 100;
+	int16_t slow_speed = base_speed * g_app_tune.irtrack_slow_pct / 100;
 
 	//测试代码
 	/*switch (status)
@@ -90,27 +96,27 @@ void car_irtrack(void)
 		break;
 
 	case 0x02: // 0010 - 偏左，右转调整
-		Motion_Set_Speed(0, 0, base_speed, base_speed);
+		Motion_Set_Speed(soft_speed, soft_speed, base_speed, base_speed);
 		break;
 
 	case 0x04: // 0100 - 偏右，左转调整
-		Motion_Set_Speed(base_speed, base_speed, 0, 0);
+		Motion_Set_Speed(base_speed, base_speed, soft_speed, soft_speed);
 		break;
 
 	case 0x03: // 0011 - 更偏左，向右调整
-		Motion_Set_Speed(0, 0, base_speed, base_speed);
+		Motion_Set_Speed(hard_speed, hard_speed, base_speed, base_speed);
 		break;
 
 	case 0x0C: // 1100 - 更偏右，向左调整
-		Motion_Set_Speed(base_speed, base_speed, 0, 0);
+		Motion_Set_Speed(base_speed, base_speed, hard_speed, hard_speed);
 		break;
 
 	case 0x01: // 0001 - 大幅偏左，急转向右
-		Motion_Set_Speed(-base_speed / 2, -base_speed / 2, base_speed, base_speed);
+		Motion_Set_Speed(sharp_speed, sharp_speed, base_speed, base_speed);
 		break;
 
 	case 0x08: // 1000 - 大幅偏右，急转向左
-		Motion_Set_Speed(base_speed, base_speed, -base_speed / 2, -base_speed / 2);
+		Motion_Set_Speed(base_speed, base_speed, sharp_speed, sharp_speed);
 		break;
 
 	case 0x0F: // 1111 - 所有传感器都在线上，可能是交叉点
@@ -122,11 +128,11 @@ void car_irtrack(void)
 		break;
 
 	case 0x09: // 1001 - 两侧都检测到，可能是特殊情况
-		Motion_Set_Speed(base_speed / 2, base_speed / 2, base_speed / 2, base_speed / 2);
+		Motion_Set_Speed(slow_speed, slow_speed, slow_speed, slow_speed);
 		break;
 
 	default: // 其它情况，适当减速直行
-		Motion_Set_Speed(base_speed / 2, base_speed / 2, base_speed / 2, base_speed / 2);
+		Motion_Set_Speed(slow_speed, slow_speed, slow_speed, slow_speed);
 		break;
 	}
 }
@@ -143,6 +149,7 @@ void car_arc_tracking(uint8_t turn_direction, uint8_t turn_radius)
 	uint8_t status = get_sensor_status();
 	int16_t base_speed = g_line_speed;
 	int16_t inner_speed, outer_speed;
+	int16_t inner_slow, outer_slow, inner_lost;
 
 	// 根据弧线方向和弯曲半径计算内外轮速度
 	if (turn_radius > 100)
@@ -151,6 +158,9 @@ void car_arc_tracking(uint8_t turn_direction, uint8_t turn_radius)
 	// 内轮速度为外轮速度的比例(0-100%)
 	outer_speed = base_speed;
 	inner_speed = base_speed * turn_radius / 100;
+	inner_slow = inner_speed * g_app_tune.arc_correct_pct / 100;
+	outer_slow = outer_speed * g_app_tune.arc_correct_pct / 100;
+	inner_lost = inner_speed * g_app_tune.arc_lost_pct / 100;
 
 	if (turn_direction == 0) // 左转弧线
 	{
@@ -161,15 +171,15 @@ void car_arc_tracking(uint8_t turn_direction, uint8_t turn_radius)
 		}
 		else if (status == 0x01 || status == 0x03) // 偏右，需要向左调整
 		{
-			Motion_Set_Speed(inner_speed / 2, inner_speed / 2, outer_speed, outer_speed);
+			Motion_Set_Speed(inner_slow, inner_slow, outer_speed, outer_speed);
 		}
 		else if (status == 0x08 || status == 0x0C) // 偏左，需要向右调整
 		{
-			Motion_Set_Speed(inner_speed, inner_speed, outer_speed / 2, outer_speed / 2);
+			Motion_Set_Speed(inner_speed, inner_speed, outer_slow, outer_slow);
 		}
 		else if (status == 0x00) // 丢线处理，继续转向
 		{
-			Motion_Set_Speed(inner_speed / 2, inner_speed / 2, outer_speed, outer_speed);
+			Motion_Set_Speed(inner_lost, inner_lost, outer_speed, outer_speed);
 		}
 		else // 其它情况
 		{
@@ -185,15 +195,15 @@ void car_arc_tracking(uint8_t turn_direction, uint8_t turn_radius)
 		}
 		else if (status == 0x01 || status == 0x03) // 偏右，需要向左调整
 		{
-			Motion_Set_Speed(outer_speed, outer_speed, inner_speed / 2, inner_speed / 2);
+			Motion_Set_Speed(outer_speed, outer_speed, inner_slow, inner_slow);
 		}
 		else if (status == 0x08 || status == 0x0C) // 偏左，需要向右调整
 		{
-			Motion_Set_Speed(outer_speed / 2, outer_speed / 2, inner_speed, inner_speed);
+			Motion_Set_Speed(outer_slow, outer_slow, inner_speed, inner_speed);
 		}
 		else if (status == 0x00) // 丢线处理，继续转向
 		{
-			Motion_Set_Speed(outer_speed, outer_speed, inner_speed / 2, inner_speed / 2);
+			Motion_Set_Speed(outer_speed, outer_speed, inner_lost, inner_lost);
 		}
 		else // 其它情况
 		{
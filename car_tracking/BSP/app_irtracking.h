@@ -11,6 +11,7 @@
 #include <stdint.h>  /* 添加标准整数类型定义 */
 #include "bsp_irtracking.h"
 #include "app_motor.h"
+#include "app_tune.h"
 
 /* 函数声明 */
 void car_irtrack(void);
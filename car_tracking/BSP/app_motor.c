@@ -17,6 +17,9 @@ static uint16_t g_speed_setup = 0;
 int g_Encoder_All_Now[MAX_MOTOR] = {0};
 int g_Encoder_All_Last[MAX_MOTOR] = {0};
 int g_Encoder_All_Offset[MAX_MOTOR] = {0};
+// 测速用的每周期计数，Q16.16：M/T测速的电机为沿间隔换算值，其余同g_Encoder_All_Offset
+// Counts per period used for speed, Q16.16: from edge timing on M/T motors, otherwise g_Encoder_All_Offset
+pidq_t g_Encoder_All_Rate[MAX_MOTOR] = {0};
 
 uint8_t g_start_ctrl = 0;
 
@@ -25,10 +28,12 @@ motor_data_t motor_data;
 
 uint8_t g_yaw_adjust = 0;
 
+#if !MOTION_USE_FIXED
 static float Motion_Get_Circle_Pulse(void)
 {
     return ENCODER_CIRCLE_450;
 }
+#endif
 
 // 仅用于添加到调试中显示数据。
 //Only used to display data when added to debugging.
@@ -40,6 +45,8 @@ void *Motion_Get_Data(uint8_t index)
         return (int *)g_Encoder_All_Last;
     if (index == 3)
         return (int *)g_Encoder_All_Offset;
+    if (index == 4)
+        return (pidq_t *)g_Encoder_All_Rate;
     return 0;
 }
 
@@ -49,7 +56,11 @@ void Motion_Get_Motor_Speed(float *speed)
 {
     for (int i = 0; i < 4; i++)
     {
+#if MOTION_USE_FIXED
+        speed[i] = PIDQ_TO_FLOAT(motor_data.speed_q[i]);
+#else
         speed[i] = motor_data.speed_mm_s[i];
+#endif
     }
 }
 
@@ -166,6 +177,27 @@ void Wheel_Yaw_Calc(float yaw)
 void Motion_Get_Speed(car_data_t *car)
 {
     int i = 0;
+#if MOTION_USE_FIXED
+    // 整数换算：每轮一次32x32->64位乘法，常数在编译期折算为Q16.16，轮速与浮点版相差小于0.001mm/s
+    // Integer path: one 32x32->64-bit multiply per wheel with the constants folded to Q16.16 at
+    // compile time; wheel speeds are within 0.001 mm/s of the float version
+    pidq_t *rate = g_Encoder_All_Rate;
+
+    Motion_Get_Encoder();
+
+    car->Vx = PIDQ_TO_INT(PIDQ_MUL(rate[0] + rate[1] + rate[2] + rate[3], MOTION_SPEED_Q) / 4);
+    car->Vy = PIDQ_TO_INT(PIDQ_MUL(-(rate[0] - rate[1] - rate[2] + rate[3]), MOTION_SPEED_Q) / 4);
+    car->Vz = PIDQ_TO_INT(PIDQ_MUL(-(rate[0] + rate[1] - rate[2] - rate[3]), MOTION_VZ_Q));
+
+    // 轮速总是更新，速度环PID在Motion_Handle中计算 Wheel speeds are always updated; the speed-loop PID runs in Motion_Handle
+    for (i = 0; i < MAX_MOTOR; i++)
+    {
+        motor_data.speed_q[i] = PIDQ_MUL(rate[i], MOTION_SPEED_Q);
+#if !PID_USE_FIXED
+        motor_data.speed_mm_s[i] = PIDQ_TO_FLOAT(motor_data.speed_q[i]);
+#endif
+    }
+#else
     float speed_mm[MAX_MOTOR] = {0};
     float circle_mm = Motion_Get_Circle_MM();
     float circle_pulse = Motion_Get_Circle_Pulse();
@@ -177,21 +209,31 @@ void Motion_Get_Speed(car_data_t *car)
     //Calculate the wheel speed in mm/s.
     for (i = 0; i < 4; i++)
     {
-        speed_mm[i] = (g_Encoder_All_Offset[i]) * 100 * circle_mm / circle_pulse;
+        speed_mm[i] = PIDQ_TO_FLOAT(g_Encoder_All_Rate[i]) * CTRL_RATE_HZ * circle_mm / circle_pulse;
     }
 
     car->Vx = (speed_mm[0] + speed_mm[1] + speed_mm[2] + speed_mm[3]) / 4;
     car->Vy = -(speed_mm[0] - speed_mm[1] - speed_mm[2] + speed_mm[3]) / 4;
     car->Vz = -(speed_mm[0] + speed_mm[1] - speed_mm[2] - speed_mm[3]) / 4.0f / robot_APB * 1000;
 
-    if (g_start_ctrl)
+    for (i = 0; i < MAX_MOTOR; i++)
     {
-        for (i = 0; i < MAX_MOTOR; i++)
-        {
-            motor_data.speed_mm_s[i] = speed_mm[i];
-        }
-        PID_Calc_Motor(&motor_data);
+        motor_data.speed_mm_s[i] = speed_mm[i];
     }
+#endif
+}
+
+// 轮速是否超过MOTOR_FF_MOVING_MM_S，决定摩擦前馈取静摩擦还是库仑摩擦
+// Whether the wheel speed exceeds MOTOR_FF_MOVING_MM_S, selecting the static or Coulomb feedforward
+static uint8_t Motion_Wheel_Moving(uint8_t i)
+{
+#if MOTION_USE_FIXED
+    pidq_t speed = motor_data.speed_q[i];
+    return speed >= PIDQ_FROM_INT(MOTOR_FF_MOVING_MM_S) || speed <= -PIDQ_FROM_INT(MOTOR_FF_MOVING_MM_S);
+#else
+    float speed = motor_data.speed_mm_s[i];
+    return speed >= MOTOR_FF_MOVING_MM_S || speed <= -MOTOR_FF_MOVING_MM_S;
+#endif
 }
 
 // 返回当前小车轮子轴间距和的一半
@@ -222,6 +264,12 @@ void Motion_Get_Encoder(void)
         // 记录上次编码器数据
         //Record Last Encoder Data
         g_Encoder_All_Last[i] = g_Encoder_All_Now[i];
+
+        // 按电机选择M/T测速或按计数测速 Per motor, M/T or count-based speed
+        if (Encoder_MT_Is_Enabled(i))
+            g_Encoder_All_Rate[i] = Encoder_MT_Rate(i, g_Encoder_All_Offset[i]);
+        else
+            g_Encoder_All_Rate[i] = PIDQ_FROM_INT(g_Encoder_All_Offset[i]);
     }
 }
 
@@ -370,8 +418,28 @@ void Motion_Handle(void)
 {
     Motion_Get_Speed(&car_data);
 
+    // 标定期间电机由标定程序驱动 The calibration drives the motors while it runs
+    if (Calib_Is_Running())
+    {
+        Calib_Handle();
+        return;
+    }
+
     if (g_start_ctrl)
     {
-        Motion_Set_Pwm(motor_data.speed_pwm[0], motor_data.speed_pwm[1], motor_data.speed_pwm[2], motor_data.speed_pwm[3]);
+        // 先算按目标方向的摩擦前馈，PID输出限在±MOTOR_MAX_PULSE减去前馈之内，抗饱和按实际PWM限幅工作
+        // Friction feedforward for the target direction first; the PID output is limited to
+        // ±MOTOR_MAX_PULSE minus the feedforward, so its anti-windup works on the real PWM limit
+        int16_t ff[MAX_MOTOR];
+        for (uint8_t i = 0; i < MAX_MOTOR; i++)
+        {
+            ff[i] = Motor_Friction_FF(i, motor_data.speed_set[i], Motion_Wheel_Moving(i));
+            PID_Set_Motor_Limit(i, -MOTOR_MAX_PULSE - ff[i], MOTOR_MAX_PULSE - ff[i]);
+        }
+        PID_Calc_Motor(&motor_data);
+        for (uint8_t i = 0; i < MAX_MOTOR; i++)
+        {
+            Motor_Set_Duty(i, (int16_t)motor_data.speed_pwm[i] + ff[i]);
+        }
     }
 }
@@ -15,6 +15,13 @@
 // The displacement of a wheel in one complete revolution, measured in meters 轮子转一整圈的位移，单位为米
 #define MECANUM_CIRCLE_MM (204.203f)
 
+// MOTION_USE_FIXED时Motion_Get_Speed的换算常数，Q16.16，编译期求值
+// Scale constants of Motion_Get_Speed with MOTION_USE_FIXED, Q16.16, folded at compile time
+// 一个CTRL_PERIOD_MS周期内一个编码器计数对应的轮速mm/s Wheel speed in mm/s of one encoder count per CTRL_PERIOD_MS period
+#define MOTION_SPEED_Q PIDQ_FROM_FLOAT(CTRL_RATE_HZ * MECANUM_CIRCLE_MM / ENCODER_CIRCLE_450)
+// 同上，左右差一个计数对应的Vz Same, Vz of one count of left/right difference
+#define MOTION_VZ_Q PIDQ_FROM_FLOAT(CTRL_RATE_HZ * MECANUM_CIRCLE_MM / ENCODER_CIRCLE_450 / 4 / STM32Car_APB * 1000)
+
 // 停止模式，STOP_FREE表示自由停止，STOP_BRAKE表示刹车。
 //Stop mode, STOP_ FREE stands for free stop, STOP_ BRAKE stands for braking.
 typedef enum _stop_mode
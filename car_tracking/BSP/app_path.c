@@ -13,6 +13,8 @@ static ArcState_t current_arc = ARC_NONE;
 static uint8_t task4_lap_count = 0;
 static uint32_t task_start_time = 0;
 static uint8_t task_completed = 0;
+static uint8_t lap_finished = 0;  // 沿DA弧线回到A点，一圈完成
+static uint8_t arc_turn_radius = ARC_TURN_RADIUS_DEF;  // 弧线巡线弯曲半径(%)
 
 /**
  * @brief  初始化路径控制模块
@@ -27,6 +29,7 @@ void APP_Path_Init(void)
     current_arc = ARC_NONE;
     task4_lap_count = 0;
     task_completed = 0;
+    lap_finished = 0;
     
     // 初始化LED
     BSP_LED_Init();
@@ -67,6 +70,10 @@ void APP_Path_Loop(void)
             APP_Task4_Process();
             break;
             
+        case MODE_CALIB:
+            APP_Calib_Process();
+            break;
+            
         default:
             // 未知模式，恢复到空闲
             current_mode = MODE_IDLE;
@@ -74,7 +81,7 @@ void APP_Path_Loop(void)
     }
     
     // 检查路线中的关键点
-    if (current_mode != MODE_IDLE && !task_completed) {
+    if (current_mode != MODE_IDLE && current_mode != MODE_CALIB && !task_completed) {
         APP_Check_Points();
     }
 }
@@ -87,7 +94,7 @@ void APP_Path_Loop(void)
 void APP_Check_Button(void)
 {
     static uint32_t last_key_time = 0;
-    uint32_t current_time = HAL_GetTick();
+    uint32_t current_time = TRACE_TICK();
     
     // 按键防抖动，限制按键检测频率
     if (current_time - last_key_time < 300) {
@@ -100,25 +107,45 @@ void APP_Check_Button(void)
     }
     
     // 使用HAL_GPIO_ReadPin直接读取按键状态而不是宏
-    GPIO_PinState key1_state = HAL_GPIO_ReadPin(KEY_GPIO_Port, KEY1_Pin);
-    GPIO_PinState key2_state = HAL_GPIO_ReadPin(KEY_GPIO_Port, KEY2_Pin);
-    GPIO_PinState key3_state = HAL_GPIO_ReadPin(KEY_GPIO_Port, KEY3_Pin);
+    GPIO_PinState key1_state = TRACE_IN(TRACE_PIN_KEY1, HAL_GPIO_ReadPin(KEY_GPIO_Port, KEY1_Pin));
+    GPIO_PinState key2_state = TRACE_IN(TRACE_PIN_KEY2, HAL_GPIO_ReadPin(KEY_GPIO_Port, KEY2_Pin));
+    GPIO_PinState key3_state = TRACE_IN(TRACE_PIN_KEY3, HAL_GPIO_ReadPin(KEY_GPIO_Port, KEY3_Pin));
     
-    // 检查按键1 - 任务1 (按键为低电平表示按下)
+    // 检查按键1 - 任务1 (按键为低电平表示按下，长按为保存参数)
     if (key1_state == GPIO_PIN_RESET) {
-        APP_Set_Mode(MODE_TASK1);
+        HAL_Delay(500);
+        key1_state = TRACE_IN(TRACE_PIN_KEY1, HAL_GPIO_ReadPin(KEY_GPIO_Port, KEY1_Pin));
+        if (key1_state == GPIO_PIN_RESET) {
+            // 长按，把当前参数写入Flash参数区，成功提示一次，失败亮红灯
+            if (Param_Save() == HAL_OK) {
+                BSP_Notify_Point();
+            } else {
+                BSP_LED_Set_Color(1, 0, 0, 1, 0, 0);
+            }
+        } else {
+            // 短按，选择任务1
+            APP_Set_Mode(MODE_TASK1);
+        }
         last_key_time = current_time;
     }
-    // 检查按键2 - 任务2
+    // 检查按键2 - 任务2（长按为电机辨识）
     else if (key2_state == GPIO_PIN_RESET) {
-        APP_Set_Mode(MODE_TASK2);
+        HAL_Delay(500);
+        key2_state = TRACE_IN(TRACE_PIN_KEY2, HAL_GPIO_ReadPin(KEY_GPIO_Port, KEY2_Pin));
+        if (key2_state == GPIO_PIN_RESET) {
+            // 长按，电机辨识
+            APP_Set_Mode(MODE_CALIB);
+        } else {
+            // 短按，选择任务2
+            APP_Set_Mode(MODE_TASK2);
+        }
         last_key_time = current_time;
     }
     // 检查按键3 - 任务3或4（长按为任务4）
     else if (key3_state == GPIO_PIN_RESET) {
         // 简单长按检测
         HAL_Delay(500);
-        key3_state = HAL_GPIO_ReadPin(KEY_GPIO_Port, KEY3_Pin);
+        key3_state = TRACE_IN(TRACE_PIN_KEY3, HAL_GPIO_ReadPin(KEY_GPIO_Port, KEY3_Pin));
         if (key3_state == GPIO_PIN_RESET) {
             // 长按，选择任务4
             APP_Set_Mode(MODE_TASK4);
@@ -146,9 +173,10 @@ void APP_Set_Mode(CarMode_t mode)
     current_arc = ARC_NONE;
     task4_lap_count = 0;
     task_completed = 0;
+    lap_finished = 0;
     
     // 记录开始时间
-    task_start_time = HAL_GetTick();
+    task_start_time = TRACE_TICK();
     
     // 根据模式设置LED颜色
     switch (mode) {
@@ -175,6 +203,10 @@ void APP_Set_Mode(CarMode_t mode)
         case MODE_TASK4:
             BSP_LED_Set_Color(1, 0, 1, 1, 0, 1);  // 紫色
             break;
+        case MODE_CALIB:
+            BSP_LED_Set_Color(1, 1, 1, 1, 1, 1);  // 白色
+            Calib_Ident_Start();
+            break;
     }
     
     // 对于除了任务1和任务2以外的任务，在启动时给出提示
@@ -200,7 +232,7 @@ void APP_Task1_Process(void)
         return;
     }
     
-    uint32_t current_time = HAL_GetTick();
+    uint32_t current_time = TRACE_TICK();
     
     // 第一次进入，记录初始传感器状态和启动时间
     if (!init_done) {
@@ -272,15 +304,13 @@ void APP_Task2_Process(void)
 {
     static uint32_t start_time = 0;
     static uint8_t has_started = 0;
-    static uint32_t last_state_time = 0;
     static uint8_t in_black_area = 0; // 0表示在白色区域，1表示在黑色区域
     static uint8_t point_a_count = 0; // 记录经过A点的次数
-    static uint8_t prev_all_black = 0; // 上一次是否全为黑色
     static uint32_t prev_state_change_time = 0; // 上次状态变化时间
     static uint32_t white_area_start_time = 0; // 开始进入白色区域的时间
     static uint8_t white_area_confirmed = 0; // 是否确认已进入白色区域
     
-    uint32_t current_time = HAL_GetTick();
+    uint32_t current_time = TRACE_TICK();
     
     if (task_completed) {
         return;
@@ -290,7 +320,6 @@ void APP_Task2_Process(void)
     if (!has_started) {
         start_time = current_time;
         has_started = 1;
-        last_state_time = current_time;
         
         // 假设开始时在A点（黑色区域）
         in_black_area = 1;
@@ -300,7 +329,6 @@ void APP_Task2_Process(void)
     
     // 获取当前传感器状态
     uint8_t all_black = (IN_X1==1 && IN_X2==1 && IN_X3==1 && IN_X4==1);
-    uint8_t all_white = (IN_X1==0 && IN_X2==0 && IN_X3==0 && IN_X4==0);
     uint8_t mostly_white = (!IN_X1 && !IN_X2 && !IN_X3 && !IN_X4) || // 全白
                            (IN_X1 == 0 && IN_X2 == 0 && IN_X3 == 0) || // 左三个传感器为白
                            (IN_X2 == 0 && IN_X3 == 0 && IN_X4 == 0); // 右三个传感器为白
@@ -434,13 +462,14 @@ void APP_Task3_Process(void)
     }
     
     // 检查是否完成任务
-    if (current_point == POINT_A && current_arc == ARC_NONE) {
-        // 回到A点且不在弧线上，表示完成一圈
+    // 起点也是A点且不在弧线上，须以DA弧线结束为准，否则一开始就会判定完成
+    if (lap_finished) {
+        // 沿DA弧线回到A点，表示完成一圈
         Motion_Stop(1);
         BSP_Notify_Point();  // A点提示
         
         // 检查时间限制
-        if (HAL_GetTick() - task_start_time <= 40000) {
+        if (TRACE_TICK() - task_start_time <= 40000) {
             // 在规定时间内完成
             BSP_LED_Set_Color(0, 1, 0, 0, 1, 0);  // 绿色表示成功
         } else {
@@ -466,42 +495,45 @@ void APP_Task4_Process(void)
     // 大部分处理逻辑与任务3相同
     switch (current_point) {
         case POINT_A:
+            // 弧线DA在APP_Check_Points中结束，此时已回到A点
+            if (lap_finished) {
+                lap_finished = 0;
+                
+                // 完成一圈，发出提示
+                BSP_Notify_Point();
+                
+                // 增加圈数
+                task4_lap_count++;
+                
+                // 如果未完成4圈，继续前进
+                if (task4_lap_count < 4) {
+                    // 短暂停顿后继续
+                    HAL_Delay(500);
+                } else {
+                    // 完成4圈，停车
+                    Motion_Stop(1);
+                    // 检查完成时间
+                    uint32_t total_time = TRACE_TICK() - task_start_time;
+                    
+                    // 设置完成指示灯 - 任务4没有明确的时间限制，显示总时间
+                    // 这里假设小于140秒为良好表现
+                    if (total_time <= 140000) {
+                        BSP_LED_Set_Color(0, 1, 0, 0, 1, 0);  // 绿色表示良好
+                    } else {
+                        BSP_LED_Set_Color(1, 1, 0, 1, 1, 0);  // 黄色表示一般
+                    }
+                    
+                    task_completed = 1;
+                    break;
+                }
+            }
+            
             if (current_arc == ARC_NONE) {
                 // 从A点前进到C点
                 car_irtrack();
             } else if (current_arc == ARC_DA) {
                 // 沿弧线DA行驶到A点
                 APP_Arc_Tracking(current_arc);
-                
-                // 如果已到达A点且完成弧线
-                if (current_point == POINT_A && current_arc == ARC_NONE) {
-                    // 完成一圈，发出提示
-                    BSP_Notify_Point();
-                    
-                    // 增加圈数
-                    task4_lap_count++;
-                    
-                    // 如果未完成4圈，继续前进
-                    if (task4_lap_count < 4) {
-                        // 短暂停顿后继续
-                        HAL_Delay(500);
-                    } else {
-                        // 完成4圈，停车
-                        Motion_Stop(1);
-                        // 检查完成时间
-                        uint32_t total_time = HAL_GetTick() - task_start_time;
-                        
-                        // 设置完成指示灯 - 任务4没有明确的时间限制，显示总时间
-                        // 这里假设小于140秒为良好表现
-                        if (total_time <= 140000) {
-                            BSP_LED_Set_Color(0, 1, 0, 0, 1, 0);  // 绿色表示良好
-                        } else {
-                            BSP_LED_Set_Color(1, 1, 0, 1, 1, 0);  // 黄色表示一般
-                        }
-                        
-                        task_completed = 1;
-                    }
-                }
             }
             break;
             
@@ -530,6 +562,27 @@ void APP_Task4_Process(void)
     }
 }
 
+/**
+ * @brief  电机辨识处理函数 - 辨识在TIM6中断中进行，这里等待结束
+ * @param  无
+ * @retval 无
+ */
+void APP_Calib_Process(void)
+{
+    if (task_completed || Calib_Is_Running()) {
+        return;
+    }
+    
+    // 辨识结果已写入速度环和摩擦前馈，存入Flash后提示完成，绿色表示可以选择任务，红色表示保存失败
+    BSP_Notify_Point();
+    if (Param_Save() == HAL_OK) {
+        BSP_LED_Set_Color(0, 1, 0, 0, 1, 0);
+    } else {
+        BSP_LED_Set_Color(1, 0, 0, 1, 0, 0);
+    }
+    task_completed = 1;
+}
+
 /**
  * @brief  检查当前是否到达关键点
  * @param  无
@@ -538,10 +591,10 @@ void APP_Task4_Process(void)
 void APP_Check_Points(void)
 {
     static uint32_t last_point_time = 0;
-    uint32_t current_time = HAL_GetTick();
+    uint32_t current_time = TRACE_TICK();
     
-    // 防止短时间内重复检测关键点（至少间隔1秒）
-    if (current_time - last_point_time < 1000) {
+    // 防止短时间内重复检测关键点（至少间隔POINT_DEBOUNCE_MS）
+    if (current_time - last_point_time < g_app_tune.point_debounce_ms) {
         return;
     }
     
@@ -587,7 +640,7 @@ void APP_Check_Points(void)
         // 判断弧线完成的条件，使用过渡区域传感器状态
         // 由于弧线结束时的传感器状态可能多种多样，我们检测特定的组合
         if ((status == 0x06 || status == 0x07 || status == 0x0E || status == 0x0F) && 
-            (current_time - last_point_time > 2000)) {  // 要求从开始弧线行驶后至少经过2秒
+            (current_time - last_point_time > g_app_tune.arc_min_ms)) {  // 要求从开始弧线行驶后至少经过ARC_MIN_MS
             
             switch (current_arc) {
                 case ARC_BC:
@@ -600,6 +653,7 @@ void APP_Check_Points(void)
                 case ARC_DA:
                     current_point = POINT_A;
                     current_arc = ARC_NONE;
+                    lap_finished = 1;
                     last_point_time = current_time;
                     // A点提示在完成任务时处理
                     break;
@@ -636,22 +690,22 @@ void APP_Arc_Tracking(ArcState_t arc)
     switch (arc) {
         case ARC_BC:
             // B→C弧线，左转弧线
-            car_arc_tracking(0, 60);  // 左转，弯曲半径60%
+            car_arc_tracking(0, arc_turn_radius);  // 左转
             break;
             
         case ARC_DA:
             // D→A弧线，右转弧线
-            car_arc_tracking(1, 60);  // 右转，弯曲半径60%
+            car_arc_tracking(1, arc_turn_radius);  // 右转
             break;
             
         case ARC_CB:
             // C→B弧线，右转弧线
-            car_arc_tracking(1, 60);  // 右转，弯曲半径60%
+            car_arc_tracking(1, arc_turn_radius);  // 右转
             break;
             
         case ARC_AD:
             // A→D弧线，左转弧线
-            car_arc_tracking(0, 60);  // 左转，弯曲半径60%
+            car_arc_tracking(0, arc_turn_radius);  // 左转
             break;
             
         default:
@@ -659,4 +713,67 @@ void APP_Arc_Tracking(ArcState_t arc)
             car_irtrack();
             break;
     }
-} 
\ No newline at end of file
+} 
+
+/**
+ * @brief  设置弧线巡线的弯曲半径
+ * @param  turn_radius: 弯曲半径系数(0-100)，默认ARC_TURN_RADIUS_DEF
+ * @retval 无
+ */
+void APP_Set_Arc_Radius(uint8_t turn_radius)
+{
+    if (turn_radius <= 100)
+    {
+        arc_turn_radius = turn_radius;
+    }
+}
+
+/**
+ * @brief  获取弧线巡线的弯曲半径
+ * @param  无
+ * @retval 弯曲半径系数(0-100)
+ */
+uint8_t APP_Get_Arc_Radius(void)
+{
+    return arc_turn_radius;
+}
+
+/**
+ * @brief  获取当前模式
+ * @param  无
+ * @retval 当前模式
+ */
+CarMode_t APP_Get_Mode(void)
+{
+    return current_mode;
+}
+
+/**
+ * @brief  获取当前所在关键点
+ * @param  无
+ * @retval 当前关键点
+ */
+PathPoint_t APP_Get_Point(void)
+{
+    return current_point;
+}
+
+/**
+ * @brief  获取当前弧线状态
+ * @param  无
+ * @retval 当前弧线
+ */
+ArcState_t APP_Get_Arc(void)
+{
+    return current_arc;
+}
+
+/**
+ * @brief  查询当前任务是否已完成
+ * @param  无
+ * @retval 1表示已完成
+ */
+uint8_t APP_Get_Task_Completed(void)
+{
+    return task_completed;
+}
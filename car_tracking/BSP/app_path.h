@@ -13,6 +13,7 @@
 #include "bsp_buzzer_led.h"
 #include "app_motor.h"
 #include "app_irtracking.h"
+#include "app_tune.h"
 
 /* 小车行驶模式 */
 typedef enum {
@@ -20,7 +21,8 @@ typedef enum {
     MODE_TASK1 = 1,      // 任务1：基础行驶，A点到B点
     MODE_TASK2 = 2,      // 任务2：环形路径1，A->B->C->D->A
     MODE_TASK3 = 3,      // 任务3：环形路径2，A->C->B->D->A
-    MODE_TASK4 = 4       // 任务4：循环行驶，按任务3路径行驶4圈
+    MODE_TASK4 = 4,      // 任务4：循环行驶，按任务3路径行驶4圈
+    MODE_CALIB = 5       // 电机辨识：架空小车，测出各电机模型并整定速度环和摩擦前馈
 } CarMode_t;
 
 /* 路径点 */
@@ -56,8 +58,17 @@ void APP_Task1_Process(void);
 void APP_Task2_Process(void);
 void APP_Task3_Process(void);
 void APP_Task4_Process(void);
+void APP_Calib_Process(void);
 void APP_Check_Points(void);
 void APP_Arc_Tracking(ArcState_t arc);
+void APP_Set_Arc_Radius(uint8_t turn_radius);
+uint8_t APP_Get_Arc_Radius(void);
+
+/* 状态查询函数 */
+CarMode_t APP_Get_Mode(void);
+PathPoint_t APP_Get_Point(void);
+ArcState_t APP_Get_Arc(void);
+uint8_t APP_Get_Task_Completed(void);
 
 /* 区域状态机函数 */
 void APP_AreaStateMachine_Init(AreaType_t initial_area, uint8_t threshold, uint32_t min_interval);
@@ -0,0 +1,156 @@
+/*
+ * app_tune.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * 可调常数汇总。定义APP_TUNE_GENERATED时先包含由主机端lap_opt生成的
+ * app_tune_gen.h，其中的宏覆盖这里的默认值。
+ * Tunable constants in one place. With APP_TUNE_GENERATED defined, the
+ * app_tune_gen.h written by the host lap_opt tool is included first and
+ * its macros override the defaults below.
+ */
+
+#ifndef APP_TUNE_H_
+#define APP_TUNE_H_
+
+#include <stdint.h>
+
+#ifdef APP_TUNE_GENERATED
+#include "app_tune_gen.h"
+#endif
+
+/* 速度环周期 Speed loop period */
+#ifndef CTRL_PERIOD_MS
+#define CTRL_PERIOD_MS (10)        // TIM6中断周期ms，可选1/2/5/10 TIM6 interrupt period in ms: 1, 2, 5 or 10
+#endif
+#if CTRL_PERIOD_MS != 1 && CTRL_PERIOD_MS != 2 && CTRL_PERIOD_MS != 5 && CTRL_PERIOD_MS != 10
+#error "CTRL_PERIOD_MS must be 1, 2, 5 or 10"
+#endif
+#define CTRL_RATE_HZ (1000 / CTRL_PERIOD_MS)
+
+/* 电机速度环PID，连续时间单位，换周期不用重调 Motor speed PID in continuous-time units, unchanged across periods */
+#ifndef PID_DEF_KP
+#define PID_DEF_KP (0.8f)          // PWM/(mm/s)
+#endif
+#ifndef PID_DEF_KI
+#define PID_DEF_KI (6.0f)          // PWM/(mm/s)/s，10ms周期下每拍0.06 0.06 per tick at 10 ms
+#endif
+#ifndef PID_DEF_KD
+#define PID_DEF_KD (0.005f)        // PWM/(mm/s)*s，10ms周期下每拍0.5 0.5 per tick at 10 ms
+#endif
+#ifndef PID_USE_2DOF
+#define PID_USE_2DOF (1)           // 速度环和偏航角用两自由度PID(bsp_pid2.c)，0为原增量式/位置式 2-DOF PID (bsp_pid2.c) for the speed and yaw loops, 0 = the original incremental/positional ones
+#endif
+#ifndef PID_DEF_B
+#define PID_DEF_B (1.0f)           // 比例项设定值权重 Setpoint weight of the P term
+#endif
+#ifndef PID_DEF_C
+#define PID_DEF_C (0.0f)           // 微分项设定值权重，0为只对轮速微分 Setpoint weight of the D term, 0 = wheel speed only
+#endif
+#ifndef PID_DEF_TF
+#define PID_DEF_TF (0.01f)         // 微分滤波时间常数s Derivative filter time constant, s
+#endif
+#ifndef PID_DEF_TT
+#define PID_DEF_TT (0.02f)         // 抗饱和跟踪时间s Anti-windup tracking time, s
+#endif
+#ifndef PID_USE_SCHED
+#define PID_USE_SCHED (0)          // 速度环增益按目标速度和方向调度(PID_Sched_t)，0为固定增益 Speed-loop gains scheduled on target speed and direction (PID_Sched_t), 0 = fixed
+#endif
+#ifndef PID_SCHED_SPEEDS
+#define PID_SCHED_SPEEDS {150, 400, 700, 1000}  // 调度点的目标速度mm/s Target speeds of the schedule points, mm/s
+#endif
+#ifndef PID_SCHED_SCALE
+#define PID_SCHED_SCALE {256, 256, 256, 256}    // 各点增益倍率，Q8(256为1倍)，默认不变 Gain scale at each point, Q8 (256 = 1x), flat by default
+#endif
+#ifndef PID_USE_FIXED
+#define PID_USE_FIXED (1)          // pid_motor/pid_Yaw用定点(bsp_pid_q.c)，0为浮点 Fixed-point pid_motor/pid_Yaw (bsp_pid_q.c), 0 = float
+#endif
+#ifndef MOTION_USE_FIXED
+#define MOTION_USE_FIXED PID_USE_FIXED // Motion_Get_Speed用整数换算轮速和Vx/Vy/Vz Integer wheel speeds and Vx/Vy/Vz in Motion_Get_Speed
+#endif
+#ifndef ENCODER_MT_MASK
+#define ENCODER_MT_MASK (0x0)      // 上电时用M/T法测速的电机，bit0为M1 Motors using M/T speed estimation at power-on, bit0 = M1
+#endif
+#ifndef ENCODER_SYNC_LATCH
+#define ENCODER_SYNC_LATCH (0)     // 1: 四路编码器在同一次TIM1/TIM8更新时硬件锁存 All four encoders latched by hardware on one TIM1/TIM8 update
+#endif
+
+/* 巡线速度与弧线半径 Line speed and arc radius */
+#ifndef LINE_SPEED_DEF
+#define LINE_SPEED_DEF (700)       // 上电默认巡线速度 Line speed set at power-on
+#endif
+#ifndef ARC_TURN_RADIUS_DEF
+#define ARC_TURN_RADIUS_DEF (60)   // 弧线巡线默认弯曲半径(%) Default arc tracking radius (%)
+#endif
+
+/* car_irtrack各状态内侧轮速度，占基础速度的百分比 Inner wheel speed per car_irtrack state, % of base */
+#ifndef IRTRACK_SOFT_PCT
+#define IRTRACK_SOFT_PCT (0)       // 0010/0100 小幅偏离 Slightly off the line
+#endif
+#ifndef IRTRACK_HARD_PCT
+#define IRTRACK_HARD_PCT (0)       // 0011/1100 更大偏离 Further off
+#endif
+#ifndef IRTRACK_SHARP_PCT
+#define IRTRACK_SHARP_PCT (-50)    // 0001/1000 大幅偏离，内侧反转 Far off, inner side reverses
+#endif
+#ifndef IRTRACK_SLOW_PCT
+#define IRTRACK_SLOW_PCT (50)      // 1001及其它，减速直行 1001 and others, slow straight
+#endif
+
+/* car_arc_tracking修正，占内/外轮速度的百分比 car_arc_tracking corrections, % of inner/outer speed */
+#ifndef ARC_CORRECT_PCT
+#define ARC_CORRECT_PCT (50)       // 偏离时被减速一侧 Side slowed down when off the line
+#endif
+#ifndef ARC_LOST_PCT
+#define ARC_LOST_PCT (50)          // 丢线时内轮 Inner wheel when the line is lost
+#endif
+
+/* APP_Check_Points判定时间 APP_Check_Points timing */
+#ifndef POINT_DEBOUNCE_MS
+#define POINT_DEBOUNCE_MS (1000)   // 两次关键点判定的最小间隔 Minimum time between point detections
+#endif
+#ifndef ARC_MIN_MS
+#define ARC_MIN_MS (2000)          // 进入弧线后判定弧线结束前的最短时间 Minimum time on an arc before it can end
+#endif
+
+// 运行时可改的巡线参数，上电为上面的默认值 Line-following parameters changeable at run time, defaults above
+typedef struct
+{
+    int16_t irtrack_soft_pct;
+    int16_t irtrack_hard_pct;
+    int16_t irtrack_sharp_pct;
+    int16_t irtrack_slow_pct;
+    int16_t arc_correct_pct;
+    int16_t arc_lost_pct;
+    uint16_t point_debounce_ms;
+    uint16_t arc_min_ms;
+} AppTune_t;
+
+// 速度环增益调度表的点数 Points in the speed-loop gain schedule
+#define PID_SCHED_POINTS (4)
+
+// 速度环增益调度：按目标速度绝对值在相邻两点间线性插值出倍率，乘到每个电机的基准增益
+// (PID_Set_Motor_Parm)上；两端之外取端点值。前进、后退各一组，下标同摩擦前馈(0前进，1后退)
+// Speed-loop gain schedule: scales interpolated linearly between the two points around
+// the absolute target speed multiply each motor's base gains (PID_Set_Motor_Parm); beyond
+// either end the end value holds. One set per direction, indexed as the friction
+// feedforward (0 forward, 1 reverse)
+typedef struct
+{
+    int16_t speed[PID_SCHED_POINTS];        // 目标速度绝对值，递增，mm/s Absolute target speed, increasing, mm/s
+    uint16_t kp_q8[2][PID_SCHED_POINTS];    // 倍率，Q8，256为1倍 Scales in Q8, 256 = 1x
+    uint16_t ki_q8[2][PID_SCHED_POINTS];
+    uint16_t kd_q8[2][PID_SCHED_POINTS];
+} PID_Sched_t;
+
+#define APP_TUNE_DEFAULT                                                  \
+    {                                                                     \
+        IRTRACK_SOFT_PCT, IRTRACK_HARD_PCT, IRTRACK_SHARP_PCT,            \
+        IRTRACK_SLOW_PCT, ARC_CORRECT_PCT, ARC_LOST_PCT,                  \
+        POINT_DEBOUNCE_MS, ARC_MIN_MS                                     \
+    }
+
+extern AppTune_t g_app_tune;
+
+#endif /* APP_TUNE_H_ */
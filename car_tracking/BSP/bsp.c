@@ -6,17 +6,27 @@
 void BSP_Init(void)
 {
 	Bsp_Tim_Init();
+	Motor_Friction_Init();//摩擦前馈 Friction feedforward
 	PID_Param_Init();//电机PID初始化 Motor PID initialization
 	BSP_LED_Init();  // LED初始化
 	APP_Path_Init(); // 路径控制初始化
 	
 	// 设置巡线速度
-	set_line_speed(700);  // 设置中等速度
+	set_line_speed(LINE_SPEED_DEF);  // 设置中等速度
+
+	// 用Flash参数区中保存的参数覆盖以上默认值 Saved parameters from the flash store override the defaults above
+	Param_Init();
+
+#ifdef BSP_TRACE
+	BSP_Trace_Start(NULL, 0); // 开始记录输入 Start the input trace
+#endif
 }
 
 
 void BSP_Loop(void)
 {
+	TRACE_LOOP();
+
 	// 更新蜂鸣器状态（非阻塞）
 	BSP_Buzzer_Beep(0);
 	
@@ -12,10 +12,13 @@
 #include "bsp_tim.h"
 #include "bsp_PID_motor.h"
 #include "app_motor.h"
+#include "app_calib.h"
 #include "bsp_irtracking.h"
 #include "app_irtracking.h"
 #include "bsp_buzzer_led.h"
 #include "app_path.h"
+#include "bsp_trace.h"
+#include "bsp_param.h"
 #include "stdio.h"
 
 void BSP_Init(void);
@@ -1,10 +1,90 @@
 #include "bsp_PID_motor.h"
 
-PID_t pid_motor[4];
-
-// YAW偏航角
-//YAW yaw angle
-PID pid_Yaw = {0, 0.4, 0, 0.1, 0, 0, 0};
+// PID_USE_FIXED为1时pid_motor/pid_Yaw为定点，接口仍为浮点，在此换算
+// With PID_USE_FIXED the pid_motor/pid_Yaw state is fixed point; the interface stays float and converts here
+#if PID_USE_FIXED
+#define PID_VAL(x) PIDQ_FROM_FLOAT(x)
+#define PID_FLOAT(x) PIDQ_TO_FLOAT(x)
+#define PID_INT(x) PIDQ_FROM_INT(x)
+// 按Q8倍率缩放 Scale by a Q8 factor
+#define PID_SCALE(v, q8) ((pidq_t)(((int64_t)(v) * (q8)) >> 8))
+typedef pidq_t PID_Val_t;
+#else
+#define PID_VAL(x) (x)
+#define PID_FLOAT(x) (x)
+#define PID_INT(x) ((float)(x))
+#define PID_SCALE(v, q8) ((v) * ((q8) * (1.0f / 256)))
+typedef float PID_Val_t;
+#endif
+
+// pid_motor/pid_Yaw所用的PID实现 The PID implementation behind pid_motor/pid_Yaw
+#if PID_USE_2DOF && PID_USE_FIXED
+#define PID_MOTOR_CALC PIDQ2_Calc
+#define PID2_RESET PIDQ2_Reset
+#define PID2_SET_GAINS PIDQ2_Set_Gains
+#define PID2_SET_SHAPE PIDQ2_Set_Shape
+#define PID2_SET_LIMIT PIDQ2_Set_Limit
+#elif PID_USE_2DOF
+#define PID_MOTOR_CALC PID2_Calc
+#define PID2_RESET PID2_Reset
+#define PID2_SET_GAINS PID2_Set_Gains
+#define PID2_SET_SHAPE PID2_Set_Shape
+#define PID2_SET_LIMIT PID2_Set_Limit
+#elif PID_USE_FIXED
+#define PID_MOTOR_CALC PIDQ_Incre_Calc
+#else
+#define PID_MOTOR_CALC PID_Incre_Calc
+#endif
+
+PID_Motor_t pid_motor[4];
+
+// 各电机的基准增益(每拍)，调度倍率乘在其上 Each motor's base gains per tick; the schedule scales multiply them
+static PID_Val_t s_base_gain[MAX_MOTOR][3];
+// 各电机当前增益对应的目标速度 Target speed each motor's current gains were scheduled for
+static int16_t s_sched_at[MAX_MOTOR];
+
+#if !PID_USE_2DOF
+// 增量式速度环的输出范围，由PID_Set_Motor_Limit随摩擦前馈每拍设置
+// Output range of the incremental speed loop, set every tick around the friction feedforward by PID_Set_Motor_Limit
+static PID_Val_t s_incre_min[MAX_MOTOR];
+static PID_Val_t s_incre_max[MAX_MOTOR];
+#endif
+
+static PID_Sched_t s_sched = {
+    PID_SCHED_SPEEDS,
+    {PID_SCHED_SCALE, PID_SCHED_SCALE},
+    {PID_SCHED_SCALE, PID_SCHED_SCALE},
+    {PID_SCHED_SCALE, PID_SCHED_SCALE},
+};
+
+// YAW偏航角，两自由度时由PID_Param_Init设置
+//YAW yaw angle, set up by PID_Param_Init in the 2-DOF build
+#if PID_USE_2DOF
+PID_Yaw_t pid_Yaw;
+#else
+PID_Yaw_t pid_Yaw = {0, PID_VAL(0.4), 0, PID_VAL(0.1), 0, 0, 0};
+#endif
+
+// 按目标速度取调度倍率，乘到基准增益上写入pid_motor，定点时只用整数运算
+// Take the schedule scales for the target speed and write the scaled base gains to pid_motor; integer arithmetic in the fixed build
+static void PID_Sched_Apply(uint8_t motor_id, int16_t target)
+{
+    uint16_t scale[3] = {256, 256, 256};
+    const PID_Val_t *base = s_base_gain[motor_id];
+
+#if PID_USE_SCHED
+    PID_Get_Sched_Scale(target, scale);
+#endif
+    s_sched_at[motor_id] = target;
+#if PID_USE_2DOF
+    PID2_SET_GAINS(&pid_motor[motor_id], PID_SCALE(base[0], scale[0]), PID_SCALE(base[1], scale[1]),
+                   PID_SCALE(base[2], scale[2]));
+#else
+    pid_motor[motor_id].Kp = PID_SCALE(base[0], scale[0]);
+    pid_motor[motor_id].Ki = PID_SCALE(base[1], scale[1]);
+    pid_motor[motor_id].Kd = PID_SCALE(base[2], scale[2]);
+#endif
+}
 
 // 初始化PID参数
 //Initialize PID parameters
@@ -12,23 +92,47 @@ void PID_Param_Init(void)
 {
     /* 速度相关初始化参数 */
 	//Speed dependent initialization parameters
+#if PID_USE_2DOF
+    for (int i = 0; i < MAX_MOTOR; i++)
+    {
+        pid_motor[i].target_val = 0;
+        PID2_SET_SHAPE(&pid_motor[i], PID_DEF_B, PID_DEF_C, PID_S_TICKS(PID_DEF_TF), PID_S_TICKS(PID_DEF_TT));
+        s_base_gain[i][0] = PID_VAL(PID_DEF_KP);
+        s_base_gain[i][1] = PID_VAL(PID_KI_TICK(PID_DEF_KI));
+        s_base_gain[i][2] = PID_VAL(PID_KD_TICK(PID_DEF_KD));
+        PID_Sched_Apply(i, 0);
+        PID2_SET_LIMIT(&pid_motor[i], -PID_INT(MOTOR_PID_LIMIT), PID_INT(MOTOR_PID_LIMIT));
+        PID2_RESET(&pid_motor[i]);
+    }
+
+    // 设定值只在PID_Yaw_Reset时变，b=1，只对航向微分 The setpoint only moves in PID_Yaw_Reset; b = 1, D on the heading only
+    pid_Yaw.target_val = 0;
+    PID2_SET_SHAPE(&pid_Yaw, 1.0f, 0.0f, PID_YAW_TF, PID_YAW_TT);
+    PID2_SET_GAINS(&pid_Yaw, PID_VAL(PID_YAW_DEF_KP), PID_VAL(PID_YAW_DEF_KI), PID_VAL(PID_YAW_DEF_KD));
+    PID2_SET_LIMIT(&pid_Yaw, -PID_VAL(PI / 6), PID_VAL(PI / 6));
+    PID2_RESET(&pid_Yaw);
+#else
     for (int i = 0; i < MAX_MOTOR; i++)
     {
-        pid_motor[i].target_val = 0.0;
-        pid_motor[i].pwm_output = 0.0;
-        pid_motor[i].err = 0.0;
-        pid_motor[i].err_last = 0.0;
-        pid_motor[i].err_next = 0.0;
-        pid_motor[i].integral = 0.0;
-
-        pid_motor[i].Kp = PID_DEF_KP;
-        pid_motor[i].Ki = PID_DEF_KI;
-        pid_motor[i].Kd = PID_DEF_KD;
+        pid_motor[i].target_val = 0;
+        pid_motor[i].pwm_output = 0;
+        pid_motor[i].err = 0;
+        pid_motor[i].err_last = 0;
+        pid_motor[i].err_next = 0;
+        pid_motor[i].integral = 0;
+
+        s_base_gain[i][0] = PID_VAL(PID_DEF_KP);
+        s_base_gain[i][1] = PID_VAL(PID_KI_TICK(PID_DEF_KI));
+        s_base_gain[i][2] = PID_VAL(PID_KD_TICK(PID_DEF_KD));
+        PID_Sched_Apply(i, 0);
+        s_incre_min[i] = -PID_INT(MOTOR_PID_LIMIT);
+        s_incre_max[i] = PID_INT(MOTOR_PID_LIMIT);
     }
 
-    pid_Yaw.Proportion = PID_YAW_DEF_KP;
-    pid_Yaw.Integral = PID_YAW_DEF_KI;
-    pid_Yaw.Derivative = PID_YAW_DEF_KD;
+    pid_Yaw.Proportion = PID_VAL(PID_YAW_DEF_KP);
+    pid_Yaw.Integral = PID_VAL(PID_YAW_DEF_KI);
+    pid_Yaw.Derivative = PID_VAL(PID_YAW_DEF_KD);
+#endif
 }
 
 // Set PID parameters 设置PID参数
@@ -68,10 +172,10 @@ float PID_Incre_Calc(PID_t *pid, float actual_val)
     /*返回PWM输出值*/
     /*Return PWM output value*/
 
-    if (pid->pwm_output > (MOTOR_MAX_PULSE - MOTOR_IGNORE_PULSE))
-        pid->pwm_output = (MOTOR_MAX_PULSE - MOTOR_IGNORE_PULSE);
-    if (pid->pwm_output < (MOTOR_IGNORE_PULSE - MOTOR_MAX_PULSE))
-        pid->pwm_output = (MOTOR_IGNORE_PULSE - MOTOR_MAX_PULSE);
+    if (pid->pwm_output > MOTOR_PID_LIMIT)
+        pid->pwm_output = MOTOR_PID_LIMIT;
+    if (pid->pwm_output < -MOTOR_PID_LIMIT)
+        pid->pwm_output = -MOTOR_PID_LIMIT;
 
     return pid->pwm_output;
 }
@@ -86,7 +190,7 @@ float PID_Location_Calc(PID_t *pid, float actual_val)
 
     /* 限定闭环死区 */
     /*Limited closed-loop dead zone*/
-    if ((pid->err >= -40) && (pid->err <= 40))
+    if ((pid->err >= -PID_LOC_DEAD_BAND) && (pid->err <= PID_LOC_DEAD_BAND))
     {
         pid->err = 0;
         pid->integral = 0;
@@ -94,15 +198,15 @@ float PID_Location_Calc(PID_t *pid, float actual_val)
 
     /* 积分分离，偏差较大时去掉积分作用 */
     /*Integral separation, removing the integral effect when the deviation is large*/
-    if (pid->err > -1500 && pid->err < 1500)
+    if (pid->err > -PID_LOC_SEPARATE && pid->err < PID_LOC_SEPARATE)
     {
         pid->integral += pid->err; // error accumulation 误差累积
 
         /* Limit the integration range to prevent integration saturation 限定积分范围，防止积分饱和 */
-        if (pid->integral > 4000)
-            pid->integral = 4000;
-        else if (pid->integral < -4000)
-            pid->integral = -4000;
+        if (pid->integral > PID_LOC_INTEGRAL_LIMIT)
+            pid->integral = PID_LOC_INTEGRAL_LIMIT;
+        else if (pid->integral < -PID_LOC_INTEGRAL_LIMIT)
+            pid->integral = -PID_LOC_INTEGRAL_LIMIT;
     }
 
     /*PID算法实现*/ /*PID algorithm implementation*/
@@ -117,6 +221,25 @@ float PID_Location_Calc(PID_t *pid, float actual_val)
     return pid->output_val;
 }
 
+// 速度环一拍；增量式另把累加的输出限在前馈之外的PWM余量内，避免超出电机实际能得到的PWM而积累
+// One speed-loop tick; the incremental loop also keeps its accumulated output within the PWM the
+// feedforward leaves, so it does not wind up beyond what the motor can actually get
+static PID_Val_t PID_Motor_Step(uint8_t motor_id, PID_Val_t actual_val)
+{
+#if PID_USE_2DOF
+    return PID_MOTOR_CALC(&pid_motor[motor_id], actual_val);
+#else
+    PID_Motor_t *pid = &pid_motor[motor_id];
+
+    PID_MOTOR_CALC(pid, actual_val);
+    if (pid->pwm_output > s_incre_max[motor_id])
+        pid->pwm_output = s_incre_max[motor_id];
+    if (pid->pwm_output < s_incre_min[motor_id])
+        pid->pwm_output = s_incre_min[motor_id];
+    return pid->pwm_output;
+#endif
+}
+
 // PID计算输出值 PID calculation output value
 void PID_Calc_Motor(motor_data_t *motor)
 {
@@ -130,7 +253,18 @@ void PID_Calc_Motor(motor_data_t *motor)
 
     for (i = 0; i < MAX_MOTOR; i++)
     {
-        motor->speed_pwm[i] = PID_Incre_Calc(&pid_motor[i], motor->speed_mm_s[i]);
+#if PID_USE_SCHED
+        // 目标速度变化时按调度表换增益，Motion_Set_Speed重复设同一速度时不重算
+        // Gains follow the schedule when the target speed changes; repeating the same speed costs nothing
+        if (motor->speed_set[i] != s_sched_at[i])
+            PID_Sched_Apply(i, motor->speed_set[i]);
+#endif
+#if PID_USE_FIXED && MOTION_USE_FIXED
+        // 轮速已是定点，不经浮点 Wheel speeds are already fixed point, no float on the way
+        motor->speed_pwm[i] = PIDQ_TO_INT(PID_Motor_Step(i, motor->speed_q[i]));
+#else
+        motor->speed_pwm[i] = PID_Calc_One_Motor(i, motor->speed_mm_s[i]);
+#endif
     }
 }
 
@@ -139,33 +273,116 @@ float PID_Calc_One_Motor(uint8_t motor_id, float now_speed)
 {
     if (motor_id >= MAX_MOTOR)
         return 0;
-    return PID_Incre_Calc(&pid_motor[motor_id], now_speed);
+#if PID_USE_FIXED
+    // 输出取整，Motion_Set_Pwm转为int16_t时结果相同 Truncated; Motion_Set_Pwm's int16_t conversion gives the same value
+    return PIDQ_TO_INT(PID_Motor_Step(motor_id, PID_VAL(now_speed)));
+#else
+    return PID_Motor_Step(motor_id, now_speed);
+#endif
 }
 
-// 设置PID参数，motor_id=4设置所有，=0123设置对应电机的PID参数。
-//Set PID parameters, motor_ Id=4 Set all,=0123 Set the PID parameters of the corresponding motor.
+// 设置PID参数，motor_id=4设置所有，=0123设置对应电机的PID参数。ki单位1/s，kd单位s
+// 设置的是基准增益，调度倍率乘在其上；两自由度时运行中改参数输出不跳变
+//Set PID parameters, motor_ Id=4 Set all,=0123 Set the PID parameters of the corresponding motor. ki per second, kd in seconds
+//These are the base gains the schedule scales; in the 2-DOF build a change while running does not make the output jump
 void PID_Set_Motor_Parm(uint8_t motor_id, float kp, float ki, float kd)
 {
     if (motor_id > MAX_MOTOR)
         return;
 
-    if (motor_id == MAX_MOTOR)
+    ki = PID_KI_TICK(ki);
+    kd = PID_KD_TICK(kd);
+
+    for (uint8_t i = 0; i < MAX_MOTOR; i++)
     {
-        for (int i = 0; i < MAX_MOTOR; i++)
+        if (motor_id == MAX_MOTOR || motor_id == i)
         {
-            pid_motor[i].Kp = kp;
-            pid_motor[i].Ki = ki;
-            pid_motor[i].Kd = kd;
+            s_base_gain[i][0] = PID_VAL(kp);
+            s_base_gain[i][1] = PID_VAL(ki);
+            s_base_gain[i][2] = PID_VAL(kd);
+            PID_Sched_Apply(i, s_sched_at[i]);
         }
     }
-    else
+}
+
+// 读回一路电机的PID参数，单位同PID_Set_Motor_Parm
+// Read back one motor's PID parameters, in the units of PID_Set_Motor_Parm
+void PID_Get_Motor_Parm(uint8_t motor_id, float *kp, float *ki, float *kd)
+{
+    if (motor_id >= MAX_MOTOR)
+        return;
+
+    *kp = PID_FLOAT(s_base_gain[motor_id][0]);
+    *ki = PID_FLOAT(s_base_gain[motor_id][1]) * (1000.0f / CTRL_PERIOD_MS);
+    *kd = PID_FLOAT(s_base_gain[motor_id][2]) * (CTRL_PERIOD_MS / 1000.0f);
+}
+
+// 设置增益调度表，各电机的增益立即按新表换算
+// Set the gain schedule; every motor's gains are rescaled at once
+void PID_Set_Motor_Sched(const PID_Sched_t *sched)
+{
+    s_sched = *sched;
+    for (uint8_t i = 0; i < MAX_MOTOR; i++)
     {
-        pid_motor[motor_id].Kp = kp;
-        pid_motor[motor_id].Ki = ki;
-        pid_motor[motor_id].Kd = kd;
+        PID_Sched_Apply(i, s_sched_at[i]);
     }
 }
 
+// 当前的增益调度表 The gain schedule in effect
+const PID_Sched_t *PID_Get_Motor_Sched(void)
+{
+    return &s_sched;
+}
+
+/**
+ * @brief  按目标速度和方向在调度表中插值出Kp/Ki/Kd倍率
+ *         Interpolate the Kp/Ki/Kd scales for a target speed and direction
+ *         from the schedule
+ * @param  target: 目标速度mm/s，负为后退 Target speed in mm/s, negative = reverse
+ * @param  scale: 输出Kp、Ki、Kd的倍率，Q8 Out: Kp, Ki and Kd scales in Q8
+ * @retval 无
+ */
+void PID_Get_Sched_Scale(int16_t target, uint16_t scale[3])
+{
+    const uint8_t dir = target < 0;
+    const int32_t speed = dir ? -(int32_t)target : target;
+    const int16_t *at = s_sched.speed;
+    const uint16_t *tab[3] = {s_sched.kp_q8[dir], s_sched.ki_q8[dir], s_sched.kd_q8[dir]};
+    uint8_t k = 0;
+    int32_t frac = 0; // 在第k、k+1点之间的位置，Q8 Position between points k and k+1, Q8
+
+    if (speed >= at[PID_SCHED_POINTS - 1])
+    {
+        k = PID_SCHED_POINTS - 2;
+        frac = 256;
+    }
+    else if (speed > at[0])
+    {
+        while (speed >= at[k + 1])
+            k++;
+        frac = ((speed - at[k]) << 8) / (at[k + 1] - at[k]);
+    }
+    for (uint8_t g = 0; g < 3; g++)
+    {
+        scale[g] = (uint16_t)(tab[g][k] + (((int32_t)tab[g][k + 1] - tab[g][k]) * frac >> 8));
+    }
+}
+
+// 速度环PID输出范围，随摩擦前馈每拍设置，使输出和抗饱和按实际PWM限幅工作
+// Output range of a speed-loop PID, set every tick around the friction feedforward so the output
+// and the anti-windup work on the real PWM limit
+void PID_Set_Motor_Limit(uint8_t motor_id, int16_t out_min, int16_t out_max)
+{
+    if (motor_id >= MAX_MOTOR)
+        return;
+#if PID_USE_2DOF
+    PID2_SET_LIMIT(&pid_motor[motor_id], PID_INT(out_min), PID_INT(out_max));
+#else
+    s_incre_min[motor_id] = PID_INT(out_min);
+    s_incre_max[motor_id] = PID_INT(out_max);
+#endif
+}
+
 // 清除PID数据
 //Clear PID data
 void PID_Clear_Motor(uint8_t motor_id)
@@ -173,25 +390,33 @@ void PID_Clear_Motor(uint8_t motor_id)
     if (motor_id > MAX_MOTOR)
         return;
 
+#if PID_USE_2DOF
+    for (int i = 0; i < MAX_MOTOR; i++)
+    {
+        if (motor_id == MAX_MOTOR || motor_id == i)
+            PID2_RESET(&pid_motor[i]);
+    }
+#else
     if (motor_id == MAX_MOTOR)
     {
         for (int i = 0; i < MAX_MOTOR; i++)
         {
-            pid_motor[i].pwm_output = 0.0;
-            pid_motor[i].err = 0.0;
-            pid_motor[i].err_last = 0.0;
-            pid_motor[i].err_next = 0.0;
-            pid_motor[i].integral = 0.0;
+            pid_motor[i].pwm_output = 0;
+            pid_motor[i].err = 0;
+            pid_motor[i].err_last = 0;
+            pid_motor[i].err_next = 0;
+            pid_motor[i].integral = 0;
         }
     }
     else
     {
-        pid_motor[motor_id].pwm_output = 0.0;
-        pid_motor[motor_id].err = 0.0;
-        pid_motor[motor_id].err_last = 0.0;
-        pid_motor[motor_id].err_next = 0.0;
-        pid_motor[motor_id].integral = 0.0;
+        pid_motor[motor_id].pwm_output = 0;
+        pid_motor[motor_id].err = 0;
+        pid_motor[motor_id].err_last = 0;
+        pid_motor[motor_id].err_next = 0;
+        pid_motor[motor_id].integral = 0;
     }
+#endif
 }
 
 // 设置PID目标速度，单位为：mm/s
@@ -205,18 +430,18 @@ void PID_Set_Motor_Target(uint8_t motor_id, float target)
     {
         for (int i = 0; i < MAX_MOTOR; i++)
         {
-            pid_motor[i].target_val = target;
+            pid_motor[i].target_val = PID_VAL(target);
         }
     }
     else
     {
-        pid_motor[motor_id].target_val = target;
+        pid_motor[motor_id].target_val = PID_VAL(target);
     }
 }
 
 // 返回PID结构体数组
 //Returns an array of PID structures
-PID_t *Pid_Get_Motor(void)
+PID_Motor_t *Pid_Get_Motor(void)
 {
     return pid_motor;
 }
@@ -228,26 +453,31 @@ PID_t *Pid_Get_Motor(void)
 //Reset the target value of yaw angle
 void PID_Yaw_Reset(float yaw)
 {
-    pid_Yaw.SetPoint = yaw;
+#if PID_USE_2DOF
+    pid_Yaw.target_val = PID_VAL(yaw);
+    PID2_RESET(&pid_Yaw);
+#else
+    pid_Yaw.SetPoint = PID_VAL(yaw);
     pid_Yaw.SumError = 0;
     pid_Yaw.LastError = 0;
     pid_Yaw.PrevError = 0;
+#endif
 }
 
-// 计算偏航角的输出值
-//Calculate the output value of yaw angle
-float PID_Yaw_Calc(float NextPoint)
+// 计算偏航角的输出值，浮点版，pid可为任一偏航角PID结构
+//Calculate the output value of yaw angle, float version, on any yaw PID structure
+float PID_Yaw_Step(PID *pid, float NextPoint)
 {
     float dError, Error;
-    Error = pid_Yaw.SetPoint - NextPoint;           // deviation 偏差
-    pid_Yaw.SumError += Error;                      // integral 积分
-    dError = pid_Yaw.LastError - pid_Yaw.PrevError; // Current differential 当前微分
-    pid_Yaw.PrevError = pid_Yaw.LastError;
-    pid_Yaw.LastError = Error;
+    Error = pid->SetPoint - NextPoint;           // deviation 偏差
+    pid->SumError += Error;                      // integral 积分
+    dError = pid->LastError - pid->PrevError;    // Current differential 当前微分
+    pid->PrevError = pid->LastError;
+    pid->LastError = Error;
 
-    double omega_rad = pid_Yaw.Proportion * Error            // proportional 比例项
-                       + pid_Yaw.Integral * pid_Yaw.SumError // Integral term 积分项
-                       + pid_Yaw.Derivative * dError;        // differential term 微分项
+    double omega_rad = pid->Proportion * Error         // proportional 比例项
+                       + pid->Integral * pid->SumError // Integral term 积分项
+                       + pid->Derivative * dError;     // differential term 微分项
 
     if (omega_rad > PI / 6)
         omega_rad = PI / 6;
@@ -256,10 +486,43 @@ float PID_Yaw_Calc(float NextPoint)
     return omega_rad;
 }
 
+// 计算偏航角的输出值
+//Calculate the output value of yaw angle
+float PID_Yaw_Calc(float NextPoint)
+{
+#if PID_USE_2DOF && PID_USE_FIXED
+    return PIDQ_TO_FLOAT(PIDQ2_Calc(&pid_Yaw, PID_VAL(NextPoint)));
+#elif PID_USE_2DOF
+    return PID2_Calc(&pid_Yaw, NextPoint);
+#elif PID_USE_FIXED
+    return PIDQ_TO_FLOAT(PIDQ_Yaw_Calc(&pid_Yaw, PID_VAL(NextPoint)));
+#else
+    return PID_Yaw_Step(&pid_Yaw, NextPoint);
+#endif
+}
+
 // Set parameters for yaw angle PID 设置偏航角PID的参数
 void PID_Yaw_Set_Parm(float kp, float ki, float kd)
 {
-    pid_Yaw.Proportion = kp;
-    pid_Yaw.Integral = ki;
-    pid_Yaw.Derivative = kd;
+#if PID_USE_2DOF
+    PID2_SET_GAINS(&pid_Yaw, PID_VAL(kp), PID_VAL(ki), PID_VAL(kd));
+#else
+    pid_Yaw.Proportion = PID_VAL(kp);
+    pid_Yaw.Integral = PID_VAL(ki);
+    pid_Yaw.Derivative = PID_VAL(kd);
+#endif
+}
+
+// Read back the yaw PID parameters 读回偏航角PID的参数
+void PID_Yaw_Get_Parm(float *kp, float *ki, float *kd)
+{
+#if PID_USE_2DOF
+    *kp = PID_FLOAT(pid_Yaw.Kp);
+    *ki = PID_FLOAT(pid_Yaw.Ki);
+    *kd = PID_FLOAT(pid_Yaw.Kd);
+#else
+    *kp = PID_FLOAT(pid_Yaw.Proportion);
+    *ki = PID_FLOAT(pid_Yaw.Integral);
+    *kd = PID_FLOAT(pid_Yaw.Derivative);
+#endif
 }
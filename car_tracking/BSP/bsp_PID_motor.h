@@ -2,20 +2,35 @@
 #define __BSP_PID_MOTOR_H
 
 #include "bsp.h"
+#include "app_tune.h"
+#include "bsp_pid_q.h"
+#include "bsp_pid2.h"
 
 #define PI (3.1415926f)
 
-#define PID_MOTOR_KP (1.5f)
-#define PID_MOTOR_KI (0.08f)
-#define PID_MOTOR_KD (0.5f)
+// PID_DEF_KP/KI/KD见app_tune.h See app_tune.h for PID_DEF_KP/KI/KD
 
-#define PID_DEF_KP (0.8f)
-#define PID_DEF_KI (0.06f)
-#define PID_DEF_KD (0.5f)
+// 速度环增益为连续时间单位(Ki为1/s，Kd为s)，写入pid_motor时按CTRL_PERIOD_MS换算为每拍系数
+// Speed loop gains are in continuous-time units (Ki per second, Kd in seconds) and are
+// converted to per-tick coefficients for CTRL_PERIOD_MS when written to pid_motor
+#define PID_KI_TICK(ki) ((ki) * (CTRL_PERIOD_MS / 1000.0f))
+#define PID_KD_TICK(kd) ((kd) * (1000.0f / CTRL_PERIOD_MS))
+// 时间常数s换算为拍 Time constant in seconds to ticks
+#define PID_S_TICKS(s) ((s) * (1000.0f / CTRL_PERIOD_MS))
+
+// PID_Location_Calc的闭环死区、积分分离阈值和积分限幅，单位同误差
+// Closed-loop dead band, integral separation threshold and integral limit of
+// PID_Location_Calc, in units of the error
+#define PID_LOC_DEAD_BAND (40)
+#define PID_LOC_SEPARATE (1500)
+#define PID_LOC_INTEGRAL_LIMIT (4000)
 
 #define PID_YAW_DEF_KP (0.4)
 #define PID_YAW_DEF_KI (0.0)
 #define PID_YAW_DEF_KD (0.1)
+// 偏航角两自由度PID的微分滤波和跟踪时间，单位为调用次数 Yaw 2-DOF derivative filter and tracking time, in calls
+#define PID_YAW_TF (0.0f)
+#define PID_YAW_TT (2.0f)
 
 typedef struct _pid
 {
@@ -41,9 +56,26 @@ typedef struct
     float SumError;   // Sums of Errors
 } PID;
 
+// pid_motor和pid_Yaw的类型，PID_USE_2DOF为1时为两自由度PID，PID_USE_FIXED为1时为定点
+// Types of pid_motor and pid_Yaw: two-degree-of-freedom with PID_USE_2DOF, fixed point with PID_USE_FIXED
+#if PID_USE_2DOF && PID_USE_FIXED
+typedef PIDQ2_t PID_Motor_t;
+typedef PIDQ2_t PID_Yaw_t;
+#elif PID_USE_2DOF
+typedef PID2_t PID_Motor_t;
+typedef PID2_t PID_Yaw_t;
+#elif PID_USE_FIXED
+typedef PIDQ_t PID_Motor_t;
+typedef PIDQ_Yaw_t PID_Yaw_t;
+#else
+typedef PID_t PID_Motor_t;
+typedef PID PID_Yaw_t;
+#endif
+
 typedef struct _motor_data_t
 {
     float speed_mm_s[4];  // 输入值，编码器计算速度
+    pidq_t speed_q[4];    // 同上，Q16.16，MOTION_USE_FIXED时代替speed_mm_s Same in Q16.16, replaces speed_mm_s with MOTION_USE_FIXED
     float speed_pwm[4];   // 输出值，PID计算出PWM值
     int16_t speed_set[4]; // 速度设置值
 } motor_data_t;
@@ -56,10 +88,17 @@ float PID_Calc_One_Motor(uint8_t motor_id, float now_speed);
 void PID_Set_Motor_Target(uint8_t motor_id, float target);
 void PID_Clear_Motor(uint8_t motor_id);
 void PID_Set_Motor_Parm(uint8_t motor_id, float kp, float ki, float kd);
+void PID_Get_Motor_Parm(uint8_t motor_id, float *kp, float *ki, float *kd);
+void PID_Set_Motor_Limit(uint8_t motor_id, int16_t out_min, int16_t out_max);
+void PID_Set_Motor_Sched(const PID_Sched_t *sched);
+const PID_Sched_t *PID_Get_Motor_Sched(void);
+void PID_Get_Sched_Scale(int16_t target, uint16_t scale[3]);
 float PID_Incre_Calc(PID_t *pid, float actual_val);
 
 void PID_Yaw_Reset(float yaw);
 float PID_Yaw_Calc(float NextPoint);
+float PID_Yaw_Step(PID *pid, float NextPoint);
 void PID_Yaw_Set_Parm(float kp, float ki, float kd);
+void PID_Yaw_Get_Parm(float *kp, float *ki, float *kd);
 
 #endif
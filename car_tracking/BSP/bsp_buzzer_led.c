@@ -79,7 +79,7 @@ void BSP_Buzzer_Beep(uint16_t time_ms)
 {
     static uint32_t beep_start_time = 0;
     static uint8_t beep_active = 0;
-    uint32_t current_time = HAL_GetTick();
+    uint32_t current_time = TRACE_TICK();
     
     if (time_ms > 0 && !beep_active) {
         // 开始新的蜂鸣
@@ -108,7 +108,7 @@ void BSP_Notify_Point(void)
     // 闪烁RGB灯
     static uint32_t last_toggle_time = 0;
     static uint8_t toggle_count = 0;
-    uint32_t current_time = HAL_GetTick();
+    uint32_t current_time = TRACE_TICK();
     
     if (current_time - last_toggle_time >= 100) {
         // 每100ms切换一次
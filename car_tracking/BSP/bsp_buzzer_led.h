@@ -10,6 +10,7 @@
 
 #include <stdint.h>  /* 添加标准整数类型定义 */
 #include "main.h"
+#include "bsp_trace.h"
 
 /* 蜂鸣器控制宏 */
 #define BUZZER_ON()  HAL_GPIO_WritePin(BUZZER_GPIO_Port, BUZZER_Pin, GPIO_PIN_SET)
@@ -33,9 +34,9 @@
 #define RRGB_B_OFF() HAL_GPIO_WritePin(RRGB_GPIO_Port, RRGB_B_Pin, GPIO_PIN_RESET)
 
 /* 按键读取宏 */
-#define KEY1_PRESSED() (HAL_GPIO_ReadPin(KEY_GPIO_Port, KEY1_Pin) == GPIO_PIN_RESET)
-#define KEY2_PRESSED() (HAL_GPIO_ReadPin(KEY_GPIO_Port, KEY2_Pin) == GPIO_PIN_RESET)
-#define KEY3_PRESSED() (HAL_GPIO_ReadPin(KEY_GPIO_Port, KEY3_Pin) == GPIO_PIN_RESET)
+#define KEY1_PRESSED() (TRACE_IN(TRACE_PIN_KEY1, HAL_GPIO_ReadPin(KEY_GPIO_Port, KEY1_Pin)) == GPIO_PIN_RESET)
+#define KEY2_PRESSED() (TRACE_IN(TRACE_PIN_KEY2, HAL_GPIO_ReadPin(KEY_GPIO_Port, KEY2_Pin)) == GPIO_PIN_RESET)
+#define KEY3_PRESSED() (TRACE_IN(TRACE_PIN_KEY3, HAL_GPIO_ReadPin(KEY_GPIO_Port, KEY3_Pin)) == GPIO_PIN_RESET)
 
 /* 函数声明 */
 void BSP_LED_Init(void);
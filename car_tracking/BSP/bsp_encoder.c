@@ -7,45 +7,127 @@
 
 #include "bsp_encoder.h"
 #include "bsp_motor.h"
+#include "bsp_trace.h"
 
 int g_Encoder_M1_Now = 0;
 int g_Encoder_M2_Now = 0;
 int g_Encoder_M3_Now = 0;
 int g_Encoder_M4_Now = 0;
 
+// 各定时器上次读到的CNT，计数器自由运行不再写回
+// CNT seen on the previous read of each timer; the counters free-run and are never written back
+static uint16_t s_Encoder_Last[MAX_MOTOR];
+
+// 以当前CNT为起点，之后的读数相对它求差 Take the current CNT as the reference for later reads
+void Encoder_Init(void)
+{
+	s_Encoder_Last[MOTOR_ID_M1] = (uint16_t)TIM4->CNT;
+	s_Encoder_Last[MOTOR_ID_M2] = (uint16_t)TIM2->CNT;
+	s_Encoder_Last[MOTOR_ID_M3] = (uint16_t)TIM5->CNT;
+	s_Encoder_Last[MOTOR_ID_M4] = (uint16_t)TIM3->CNT;
+}
+
 /**
- * @Brief: To read the encoder count, call every 10 milliseconds  读取编码器计数，需每10毫秒调用一次
- * @Note:
+ * @Brief: 由本次CNT求相对上次的计数变化，需每个控制周期调用一次
+ *         Turn this period's CNT into the change since the previous one, call every control period
+ * @Note: 只读CNT不写，两次读数按16位取模相减，读写之间不会丢计数。每个周期的变化须小于32768
+ *        CNT is only read, never written; reads are subtracted modulo 2^16 so no count is lost
+ *        between a read and a write. The change per period must stay below 32768
  * @Parm: Motor id：电机的ID号:MOTOR_ID_M1
- * @Retval: Returns encoder count data  返回编码器计数数据
+ * @Parm: cnt：本周期读到的CNT CNT read this period
+ * @Retval: Returns encoder count data  返回编码器计数数据，符号同原先的0x7fff-CNT Same sign as the old 0x7fff - CNT
  */
-static int16_t Encoder_Read_CNT(uint8_t Motor_id)
+static int16_t Encoder_Read_CNT(uint8_t Motor_id, uint16_t cnt)
 {
-	int16_t Encoder_TIM = 0;
-	switch (Motor_id)
+	int16_t delta = (int16_t)(uint16_t)(s_Encoder_Last[Motor_id] - cnt);
+	s_Encoder_Last[Motor_id] = cnt;
+	return delta;
+}
+
+#if ENCODER_SYNC_LATCH
+/*
+ * 同步锁存：TIM1的TRGO输出更新事件，TIM2/TIM3/TIM4经ITR0、TIM5经TIM8(ITR3)收到触发，
+ * CH3配置为TRC输入捕获，每个PWM周期把CNT同时锁存到CCR3，编码器模式不受影响。
+ * TIM5的ITR中没有TIM1，TIM8以触发模式由TIM1的更新启动，两者同频同相。
+ * Synchronous latch: TIM1 drives TRGO on update; TIM2/TIM3/TIM4 take it on
+ * ITR0 and TIM5, which has no TIM1 input, on ITR3 from TIM8. CH3 is an input
+ * capture on TRC, so every PWM period all four CNTs land in CCR3 on the same
+ * clock edge while the encoder mode keeps counting. TIM8 is started in
+ * trigger mode by a TIM1 update, so the two run in phase.
+ */
+static void Encoder_Sync_Slave(TIM_TypeDef *tim, uint32_t trigger)
+{
+	// RM0008：TS只能在SMS=000时修改，先关从模式再写TS，最后恢复编码器模式；
+	// 此时编码器定时器尚未启动，SMS=000期间CNT不会按内部时钟计数
+	// RM0008: TS may only change while SMS = 000, so the slave mode is switched off
+	// around the write and the encoder mode restored after it. The encoder timers are
+	// not started yet, so CNT does not count the internal clock while SMS = 000
+	uint32_t sms = tim->SMCR & TIM_SMCR_SMS;
+
+	tim->SMCR &= ~TIM_SMCR_SMS;
+	tim->SMCR = (tim->SMCR & ~TIM_SMCR_TS) | trigger;
+	tim->SMCR |= sms;
+	tim->CCER &= ~TIM_CCER_CC3E;
+	tim->CCMR2 = (tim->CCMR2 & ~(TIM_CCMR2_CC3S | TIM_CCMR2_IC3F | TIM_CCMR2_IC3PSC)) | TIM_ICSELECTION_TRC;
+	tim->CCER |= TIM_CCER_CC3E;
+}
+
+/**
+ * @brief  配置编码器同步锁存，须在TIM1/TIM8启动前调用
+ *         Set up the synchronous encoder latch; call before TIM1/TIM8 start
+ * @retval 无
+ */
+void Encoder_Sync_Init(void)
+{
+	TIM1->CR2 = (TIM1->CR2 & ~TIM_CR2_MMS) | TIM_TRGO_UPDATE;
+	TIM8->CR2 = (TIM8->CR2 & ~TIM_CR2_MMS) | TIM_TRGO_UPDATE;
+	// TIM8由TIM1的第一次更新启动 TIM8 starts on the first TIM1 update
+	TIM8->SMCR = (TIM8->SMCR & ~(TIM_SMCR_TS | TIM_SMCR_SMS)) | TIM_TS_ITR0 | TIM_SLAVEMODE_TRIGGER;
+
+	Encoder_Sync_Slave(TIM4, TIM_TS_ITR0);
+	Encoder_Sync_Slave(TIM2, TIM_TS_ITR0);
+	Encoder_Sync_Slave(TIM5, TIM_TS_ITR3);
+	Encoder_Sync_Slave(TIM3, TIM_TS_ITR0);
+}
+
+/**
+ * @brief  等到下一次TIM1更新，TIM6在其后启动，控制周期是PWM周期的整数倍，
+ *         之后每次TIM6中断都读到同一相位的锁存值
+ *         Wait for the next TIM1 update. TIM6 is started right after it, and
+ *         since the control period is a whole number of PWM periods every
+ *         TIM6 interrupt then reads the latch from the same phase
+ * @note   最多等待约两个PWM周期 Waits for about two PWM periods at most
+ * @retval 无
+ */
+void Encoder_Sync_Align(void)
+{
+	__HAL_TIM_CLEAR_FLAG(&htim1, TIM_FLAG_UPDATE);
+	for (uint32_t i = 0; i < htim1.Init.Period + 1; i++)
 	{
-	case MOTOR_ID_M1:
-		Encoder_TIM = 0x7fff - (short)TIM4->CNT;
-		TIM4->CNT = 0x7fff;
-		break;
-	case MOTOR_ID_M2:
-		Encoder_TIM = 0x7fff - (short)TIM2->CNT;
-		TIM2->CNT = 0x7fff;
-		break;
-	case MOTOR_ID_M3:
-		Encoder_TIM = 0x7fff - (short)TIM5->CNT;
-		TIM5->CNT = 0x7fff;
-		break;
-	case MOTOR_ID_M4:
-		Encoder_TIM = 0x7fff - (short)TIM3->CNT;
-		TIM3->CNT = 0x7fff;
-		break;
-	default:
-		break;
+		if (__HAL_TIM_GET_FLAG(&htim1, TIM_FLAG_UPDATE))
+			break;
 	}
-	return Encoder_TIM;
 }
 
+// 取四路同一次触发锁存的CNT，读的过程中有新的触发则重读
+// Fetch the four CNTs latched by one trigger, reading again if a new one arrived meanwhile
+static void Encoder_Read_Latched(uint16_t *cnt)
+{
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	do
+	{
+		__HAL_TIM_CLEAR_FLAG(&htim1, TIM_FLAG_UPDATE);
+		__HAL_TIM_CLEAR_FLAG(&htim8, TIM_FLAG_UPDATE);
+		cnt[MOTOR_ID_M1] = (uint16_t)TIM4->CCR3;
+		cnt[MOTOR_ID_M2] = (uint16_t)TIM2->CCR3;
+		cnt[MOTOR_ID_M3] = (uint16_t)TIM5->CCR3;
+		cnt[MOTOR_ID_M4] = (uint16_t)TIM3->CCR3;
+	} while (__HAL_TIM_GET_FLAG(&htim1, TIM_FLAG_UPDATE) || __HAL_TIM_GET_FLAG(&htim8, TIM_FLAG_UPDATE));
+	__set_PRIMASK(primask);
+}
+#endif
+
 // 返回开机到现在总共统计的编码器的计数（单路）。
 // Returns the total count of encoders from boot up to now (single channel)
 int Encoder_Get_Count_Now(uint8_t Motor_id)
@@ -71,12 +153,182 @@ void Encoder_Get_ALL(int *Encoder_all)
 	Encoder_all[3] = g_Encoder_M4_Now;
 }
 
-// 更新编码器的计数总值。需每10毫秒调用一次
-// Update the count value of the encoder. call every 10 milliseconds
+// 更新编码器的计数总值，16位增量累加为32位总数。需每个控制周期调用一次
+// Update the count value of the encoder, accumulating the 16-bit deltas into 32-bit totals. Call every control period
 void Encoder_Update_Count(void)
 {
-	g_Encoder_M1_Now -= Encoder_Read_CNT(MOTOR_ID_M1);
-	g_Encoder_M2_Now -= Encoder_Read_CNT(MOTOR_ID_M2);
-	g_Encoder_M3_Now += Encoder_Read_CNT(MOTOR_ID_M3);
-	g_Encoder_M4_Now += Encoder_Read_CNT(MOTOR_ID_M4);
+	uint16_t cnt[MAX_MOTOR];
+#if ENCODER_SYNC_LATCH
+	Encoder_Read_Latched(cnt);
+#else
+	cnt[MOTOR_ID_M1] = (uint16_t)TIM4->CNT;
+	cnt[MOTOR_ID_M2] = (uint16_t)TIM2->CNT;
+	cnt[MOTOR_ID_M3] = (uint16_t)TIM5->CNT;
+	cnt[MOTOR_ID_M4] = (uint16_t)TIM3->CNT;
+#endif
+	g_Encoder_M1_Now -= Encoder_Read_CNT(MOTOR_ID_M1, (uint16_t)TRACE_CNT(MOTOR_ID_M1, cnt[MOTOR_ID_M1]));
+	g_Encoder_M2_Now -= Encoder_Read_CNT(MOTOR_ID_M2, (uint16_t)TRACE_CNT(MOTOR_ID_M2, cnt[MOTOR_ID_M2]));
+	g_Encoder_M3_Now += Encoder_Read_CNT(MOTOR_ID_M3, (uint16_t)TRACE_CNT(MOTOR_ID_M3, cnt[MOTOR_ID_M3]));
+	g_Encoder_M4_Now += Encoder_Read_CNT(MOTOR_ID_M4, (uint16_t)TRACE_CNT(MOTOR_ID_M4, cnt[MOTOR_ID_M4]));
+}
+
+/*
+ * M/T法测速：低速时一个周期只有几个计数，按计数算出的速度量化严重。
+ * 编码器模式下CH1仍可输入捕获，在TI1上升沿(每4个计数一次)中断里记下DWT周期计数，
+ * 速度为本周期内的沿数除以首尾两沿的时间差，分辨率由72MHz时钟决定。
+ * M/T speed estimation: at low speed a period holds only a few counts and the
+ * count-based speed is coarsely quantised. CH1 can still capture in encoder
+ * mode; the TI1 rising edge interrupt (once every 4 counts) stamps the DWT
+ * cycle counter, and the speed is the number of edges over the time between
+ * the last edges of two periods, resolved to the 72 MHz clock.
+ */
+typedef struct
+{
+	volatile uint32_t edges; // 上次取值以来的沿数 Edges since the last read
+	volatile uint32_t stamp; // 最后一个沿的DWT周期计数 DWT cycle count of the latest edge
+	uint32_t last_stamp;     // 上个有沿周期的最后一个沿 Latest edge of the previous period that had one
+	pidq_t rate;             // 上次的估计，计数/周期 Last estimate, counts per period
+	uint16_t idle;           // 连续无沿的周期数 Periods in a row without an edge
+	uint8_t valid;           // last_stamp有效 last_stamp is usable
+	uint8_t enabled;
+} Encoder_MT_t;
+
+// DWT周期计数器与HCLK同频 The DWT cycle counter runs at HCLK
+#define ENCODER_MT_HZ          (72000000u)
+#define ENCODER_MT_TICK_CYCLES (ENCODER_MT_HZ / CTRL_RATE_HZ)
+
+static Encoder_MT_t s_mt[MAX_MOTOR];
+
+static TIM_HandleTypeDef *Encoder_MT_Tim(uint8_t Motor_id)
+{
+	switch (Motor_id)
+	{
+	case MOTOR_ID_M1:
+		return &htim4;
+	case MOTOR_ID_M2:
+		return &htim2;
+	case MOTOR_ID_M3:
+		return &htim5;
+	case MOTOR_ID_M4:
+		return &htim3;
+	default:
+		return NULL;
+	}
+}
+
+/**
+ * @brief  打开或关闭一路电机的M/T测速，打开时使能TI1捕获中断和DWT周期计数器
+ *         Enable or disable M/T speed estimation on one motor; enabling turns
+ *         on the TI1 capture interrupt and the DWT cycle counter
+ * @param  Motor_id: MOTOR_ID_M1..MOTOR_ID_M4
+ * @param  enable: 1打开，0关闭并回到按计数测速 1 = on, 0 = off, back to count-based speed
+ * @retval 无
+ */
+void Encoder_MT_Enable(uint8_t Motor_id, uint8_t enable)
+{
+	TIM_HandleTypeDef *htim = Encoder_MT_Tim(Motor_id);
+	if (htim == NULL)
+		return;
+
+	__HAL_TIM_DISABLE_IT(htim, TIM_IT_CC1);
+	s_mt[Motor_id].edges = 0;
+	s_mt[Motor_id].rate = 0;
+	s_mt[Motor_id].idle = 0;
+	s_mt[Motor_id].valid = 0;
+	s_mt[Motor_id].enabled = enable != 0;
+	if (!enable)
+		return;
+
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	__HAL_TIM_CLEAR_IT(htim, TIM_IT_CC1);
+	__HAL_TIM_ENABLE_IT(htim, TIM_IT_CC1);
+}
+
+uint8_t Encoder_MT_Is_Enabled(uint8_t Motor_id)
+{
+	return Motor_id < MAX_MOTOR && s_mt[Motor_id].enabled;
+}
+
+// TI1捕获中断，由HAL_TIM_IC_CaptureCallback调用 TI1 capture interrupt, called from HAL_TIM_IC_CaptureCallback
+void Encoder_MT_Capture(TIM_HandleTypeDef *htim)
+{
+	uint32_t now = DWT->CYCCNT;
+	Encoder_MT_t *mt;
+
+	if (htim->Instance == TIM4)
+		mt = &s_mt[MOTOR_ID_M1];
+	else if (htim->Instance == TIM2)
+		mt = &s_mt[MOTOR_ID_M2];
+	else if (htim->Instance == TIM5)
+		mt = &s_mt[MOTOR_ID_M3];
+	else if (htim->Instance == TIM3)
+		mt = &s_mt[MOTOR_ID_M4];
+	else
+		return;
+
+	mt->stamp = now;
+	mt->edges++;
+}
+
+/**
+ * @brief  M/T法估计本周期的速度，每个控制周期调用一次
+ *         M/T speed estimate for this period, call once per control period
+ * @note   方向取自本周期的计数；停转后的第一个沿和换向时没有可用的时间基准，
+ *         退回按计数测速。无沿时速度不超过一个沿间隔除以距上一沿的时间，
+ *         连续ENCODER_MT_IDLE_TICKS个周期无沿则为0
+ *         The direction comes from this period's counts. The first edge after
+ *         standstill and a reversal have no usable time base and fall back to
+ *         the count. Without an edge the speed is at most one edge interval
+ *         over the time since the last edge, and 0 after
+ *         ENCODER_MT_IDLE_TICKS periods without one
+ * @param  Motor_id: MOTOR_ID_M1..MOTOR_ID_M4
+ * @param  offset: 本周期的编码器计数 Encoder counts this period
+ * @retval 计数/周期，Q16.16 Counts per period, Q16.16
+ */
+pidq_t Encoder_MT_Rate(uint8_t Motor_id, int offset)
+{
+	Encoder_MT_t *mt = &s_mt[Motor_id];
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	uint32_t edges = mt->edges;
+	uint32_t stamp = mt->stamp;
+	mt->edges = 0;
+	__set_PRIMASK(primask);
+
+	if (edges == 0)
+	{
+		if (!mt->valid || ++mt->idle >= ENCODER_MT_IDLE_TICKS)
+		{
+			mt->valid = 0;
+			mt->rate = PIDQ_FROM_INT(offset);
+			return mt->rate;
+		}
+		uint32_t since = DWT->CYCCNT - mt->last_stamp;
+		if (since == 0)
+			return mt->rate;
+		pidq_t bound = (pidq_t)(((int64_t)ENCODER_MT_EDGE_COUNTS * ENCODER_MT_TICK_CYCLES << PIDQ_FRAC) / since);
+		if (mt->rate > bound)
+			mt->rate = bound;
+		else if (mt->rate < -bound)
+			mt->rate = -bound;
+		return mt->rate;
+	}
+
+	uint32_t span = stamp - mt->last_stamp;
+	mt->idle = 0;
+	if (!mt->valid || offset == 0 || span == 0)
+	{
+		mt->rate = PIDQ_FROM_INT(offset);
+	}
+	else
+	{
+		int64_t rate = ((int64_t)edges * ENCODER_MT_EDGE_COUNTS * ENCODER_MT_TICK_CYCLES << PIDQ_FRAC) / span;
+		if (rate > PIDQ_MAX)
+			rate = PIDQ_MAX;
+		mt->rate = offset > 0 ? (pidq_t)rate : -(pidq_t)rate;
+	}
+	mt->last_stamp = stamp;
+	mt->valid = 1;
+	return mt->rate;
 }
@@ -8,13 +8,31 @@
 #ifndef BSP_ENCODER_H_
 #define BSP_ENCODER_H_
 #include "bsp.h"
+#include "app_tune.h"
+#include "bsp_pid_q.h"
 
 //// 轮子转一整圈，编码器获得的脉冲数:30*11*2*2
 //// One full turn of the wheel, the number of pulses picked up by the coder: 30*13*2*2
 //#define ENCODER_CIRCLE (1040)
 
+// TI1相邻两个上升沿之间的计数(四倍频) Counts between two TI1 rising edges (x4 decoding)
+#define ENCODER_MT_EDGE_COUNTS (4)
+// 连续这么多个周期没有沿时认为停转 No edge for this many periods counts as standstill
+#define ENCODER_MT_IDLE_TICKS (200 / CTRL_PERIOD_MS)
+
+void Encoder_Init(void);
 void Encoder_Update_Count(void);
 int Encoder_Get_Count_Now(uint8_t Motor_id);
 void Encoder_Get_ALL(int *Encoder_all);
 
+void Encoder_MT_Enable(uint8_t Motor_id, uint8_t enable);
+uint8_t Encoder_MT_Is_Enabled(uint8_t Motor_id);
+void Encoder_MT_Capture(TIM_HandleTypeDef *htim);
+pidq_t Encoder_MT_Rate(uint8_t Motor_id, int offset);
+
+#if ENCODER_SYNC_LATCH
+void Encoder_Sync_Init(void);
+void Encoder_Sync_Align(void);
+#endif
+
 #endif /* BSP_ENCODER_H_ */
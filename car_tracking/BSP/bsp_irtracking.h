@@ -10,11 +10,12 @@
 
 #include <stdint.h>
 #include "main.h"  /* 确保包含main.h以获取GPIO定义 */
+#include "bsp_trace.h"
 
 
-#define IN_X1 HAL_GPIO_ReadPin(X1_GPIO_Port,X1_Pin)//读取X1引脚的状态 Read the status of X1 pin
-#define IN_X2 HAL_GPIO_ReadPin(X2_GPIO_Port,X2_Pin)//读取X2引脚的状态 Read the status of X2 pin
-#define IN_X3 HAL_GPIO_ReadPin(X3_GPIO_Port,X3_Pin)//读取X3引脚的状态 Read the status of X3 pin
-#define IN_X4 HAL_GPIO_ReadPin(X4_GPIO_Port,X4_Pin)//读取X4引脚的状态 Read the status of X4 pin
+#define IN_X1 TRACE_IN(TRACE_PIN_X1, HAL_GPIO_ReadPin(X1_GPIO_Port,X1_Pin))//读取X1引脚的状态 Read the status of X1 pin
+#define IN_X2 TRACE_IN(TRACE_PIN_X2, HAL_GPIO_ReadPin(X2_GPIO_Port,X2_Pin))//读取X2引脚的状态 Read the status of X2 pin
+#define IN_X3 TRACE_IN(TRACE_PIN_X3, HAL_GPIO_ReadPin(X3_GPIO_Port,X3_Pin))//读取X3引脚的状态 Read the status of X3 pin
+#define IN_X4 TRACE_IN(TRACE_PIN_X4, HAL_GPIO_ReadPin(X4_GPIO_Port,X4_Pin))//读取X4引脚的状态 Read the status of X4 pin
 
 #endif /* BSP_IRTRACKING_H_ */
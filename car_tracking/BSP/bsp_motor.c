@@ -7,6 +7,9 @@
 
 #include "bsp_motor.h"
 
+// 各电机各方向的摩擦前馈 Friction feedforward per motor and direction
+static Motor_Friction_t s_friction[MAX_MOTOR];
+
 // Ignore PWM dead band  忽略PWM信号死区
 static int16_t Motor_Ignore_Dead_Zone(int16_t pulse)
 {
@@ -36,7 +39,13 @@ void Motor_Stop(uint8_t brake)
 // Set motor speed, speed:± (3600-MOTOR_IGNORE_PULSE), 0 indicates stop
 void Motor_Set_Pwm(uint8_t id, int16_t speed)
 {
-    int16_t pulse = Motor_Ignore_Dead_Zone(speed);
+    Motor_Set_Duty(id, Motor_Ignore_Dead_Zone(speed));
+}
+
+// 直接设置占空比，不加死区，pulse:±3600，超出部分限幅，正为前进
+// Set the duty directly without the dead band, pulse: ±3600, limited beyond that, positive = forward
+void Motor_Set_Duty(uint8_t id, int16_t pulse)
+{
     // Limit input  限制输入
     if (pulse >= MOTOR_MAX_PULSE)
         pulse = MOTOR_MAX_PULSE;
@@ -112,3 +121,56 @@ void Motor_Set_Pwm(uint8_t id, int16_t speed)
         break;
     }
 }
+
+// 摩擦前馈恢复为MOTOR_IGNORE_PULSE，两个方向、静摩擦和库仑摩擦相同，无粘性项
+// Reset the friction feedforward to MOTOR_IGNORE_PULSE for both directions, static and Coulomb alike, no viscous term
+void Motor_Friction_Init(void)
+{
+    for (uint8_t i = 0; i < MAX_MOTOR; i++)
+    {
+        Motor_Set_Friction(i, 0, MOTOR_IGNORE_PULSE, MOTOR_IGNORE_PULSE, 0);
+        Motor_Set_Friction(i, 1, MOTOR_IGNORE_PULSE, MOTOR_IGNORE_PULSE, 0);
+    }
+}
+
+// 设置一路电机一个方向的摩擦前馈，dir:0正转，1反转
+// Set the friction feedforward of one motor and direction, dir: 0 forward, 1 reverse
+void Motor_Set_Friction(uint8_t id, uint8_t dir, int16_t static_pulse, int16_t coulomb_pulse, int16_t viscous_q8)
+{
+    if (id >= MAX_MOTOR || dir > 1)
+        return;
+    s_friction[id].static_pulse[dir] = static_pulse;
+    s_friction[id].coulomb_pulse[dir] = coulomb_pulse;
+    s_friction[id].viscous_q8[dir] = viscous_q8;
+}
+
+const Motor_Friction_t *Motor_Get_Friction(uint8_t id)
+{
+    if (id >= MAX_MOTOR)
+        return NULL;
+    return &s_friction[id];
+}
+
+/**
+ * @brief  摩擦前馈，方向取自目标速度而不是PID输出，PID的小幅修正不会跳到死区另一侧
+ *         Friction feedforward. The direction comes from the target speed,
+ *         not from the PID output, so small corrections no longer jump
+ *         across the dead band
+ * @param  id: MOTOR_ID_M1..MOTOR_ID_M4
+ * @param  target: 目标速度mm/s，0时无前馈 Target speed in mm/s, no feedforward at 0
+ * @param  moving: 轮子在转，0时取静摩擦 Wheel is turning; 0 selects the static term
+ * @retval 带符号的PWM计数：静摩擦，或库仑摩擦加粘性项 Signed PWM counts: static, or Coulomb plus the viscous term
+ */
+int16_t Motor_Friction_FF(uint8_t id, int16_t target, uint8_t moving)
+{
+    if (id >= MAX_MOTOR || target == 0)
+        return 0;
+    uint8_t dir = target < 0;
+    int32_t speed = dir ? -(int32_t)target : target;
+    int32_t pulse = s_friction[id].coulomb_pulse[dir] + ((s_friction[id].viscous_q8[dir] * speed) >> 8);
+    if (!moving && pulse < s_friction[id].static_pulse[dir])
+        pulse = s_friction[id].static_pulse[dir];
+    if (pulse > MOTOR_MAX_PULSE)
+        pulse = MOTOR_MAX_PULSE;
+    return (int16_t)(dir ? -pulse : pulse);
+}
@@ -25,6 +25,15 @@
 #define MOTOR_MAX_PULSE (3600)
 #define MOTOR_FREQ_DIVIDE (0)
 
+// 速度环PID只输出摩擦前馈之外的部分，可正可负；此为PID自身的限幅，运行中PID_Set_Motor_Limit
+// 每拍再按±MOTOR_MAX_PULSE减去前馈收紧，叠加后由Motor_Set_Duty限幅
+// The speed-loop PID only supplies what the friction feedforward does not. This is the PID's own
+// limit; while running, PID_Set_Motor_Limit narrows it every tick to ±MOTOR_MAX_PULSE minus the
+// feedforward, and Motor_Set_Duty limits the sum
+#define MOTOR_PID_LIMIT (MOTOR_MAX_PULSE)
+// 轮速低于此值时认为静止，前馈取静摩擦 Below this wheel speed the wheel counts as stopped and gets the static term, mm/s
+#define MOTOR_FF_MOVING_MM_S (30)
+
 // MOTOR: M1 M2 M3 M4
 // MOTOR: L1 L2 R1 R2
 typedef enum
@@ -36,7 +45,22 @@ typedef enum
 	MAX_MOTOR
 } Motor_ID;
 
+// 一路电机的摩擦前馈，PWM计数，下标为方向：0正转(前进)，1反转
+// Friction feedforward of one motor in PWM counts, indexed by direction: 0 forward, 1 reverse
+typedef struct
+{
+    int16_t static_pulse[2];  // 静摩擦，从静止起转所需 Static: needed to break away from rest
+    int16_t coulomb_pulse[2]; // 库仑摩擦，维持低速转动所需 Coulomb: needed to keep turning slowly
+    int16_t viscous_q8[2];    // 粘性项，每mm/s所需PWM，Q8 Viscous term, PWM per mm/s, Q8
+} Motor_Friction_t;
+
 void Motor_Set_Pwm(uint8_t id, int16_t speed);
+void Motor_Set_Duty(uint8_t id, int16_t pulse);
 void Motor_Stop(uint8_t brake);
 
+void Motor_Friction_Init(void);
+void Motor_Set_Friction(uint8_t id, uint8_t dir, int16_t static_pulse, int16_t coulomb_pulse, int16_t viscous_q8);
+const Motor_Friction_t *Motor_Get_Friction(uint8_t id);
+int16_t Motor_Friction_FF(uint8_t id, int16_t target, uint8_t moving);
+
 #endif /* BSP_MOTOR_H_ */
@@ -0,0 +1,277 @@
+/*
+ * bsp_param.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ */
+
+#include "bsp_param.h"
+#include <stddef.h>
+#include <string.h>
+
+// 按地址读Flash，主机替身把Flash映射到数组时另行定义
+// Read flash by address; the host shim defines its own when it maps flash to an array
+#ifndef FLASH_READ_PTR
+#define FLASH_READ_PTR(addr) ((const void *)(addr))
+#endif
+
+#define PARAM_MAGIC (0x5041u) // "PA"
+
+// 一条记录，CRC覆盖之前的全部字节。magic和version所在的字最后写入，作为提交标记，
+// 写到一半掉电的记录头部无效，序号也不会被当真
+// One record; the CRC covers every byte before it. The word holding magic and
+// version is written last as the commit mark, so a record cut off part-way has
+// no valid header and its sequence number is never believed
+typedef struct
+{
+    uint16_t magic;
+    uint16_t version;
+    uint32_t seq; // 写入序号，从1递增 Write sequence number, counting up from 1
+    Param_Data_t data;
+    uint32_t crc;
+} Param_Record_t;
+
+// 当前一条记录196字节，每页10条，四页共40条；Param_Data_t改变时随PARAM_VERSION一起更新
+// A record is 196 bytes today: 10 per page, 40 over four pages. Update this with PARAM_VERSION when Param_Data_t changes
+#define PARAM_RECORD_SIZE (196u)
+_Static_assert(sizeof(Param_Record_t) == PARAM_RECORD_SIZE, "Param_Data_t changed: update PARAM_RECORD_SIZE and PARAM_VERSION");
+// 按字编程，记录须为整字 Records are programmed by word, so they must be whole words
+_Static_assert(sizeof(Param_Record_t) % 4u == 0, "Param_Record_t must be a whole number of words");
+_Static_assert(sizeof(Param_Record_t) <= FLASH_PAGE_SIZE, "a record must fit in one flash page");
+
+#define PARAM_SLOTS_PER_PAGE (FLASH_PAGE_SIZE / sizeof(Param_Record_t))
+#define PARAM_SLOTS          (PARAM_SLOTS_PER_PAGE * PARAM_PAGES)
+
+static struct
+{
+    int16_t head; // 序号最大的记录(不论CRC)所在的位置，-1为空 Slot of the highest sequence number, good CRC or not, -1 = empty
+    uint32_t seq; // 当前生效记录的序号，0为默认值 Sequence number of the record in effect, 0 = defaults
+    uint32_t last_seq;
+} s_param = {-1, 0, 0};
+
+// 记录不跨页，页尾不足一条的部分不用 Records never straddle a page; the tail of each page too short for one stays unused
+static uint32_t Param_Slot_Addr(uint16_t slot)
+{
+    return PARAM_ADDR + (slot / PARAM_SLOTS_PER_PAGE) * FLASH_PAGE_SIZE + (slot % PARAM_SLOTS_PER_PAGE) * sizeof(Param_Record_t);
+}
+
+static const Param_Record_t *Param_Slot(uint16_t slot)
+{
+    return (const Param_Record_t *)FLASH_READ_PTR(Param_Slot_Addr(slot));
+}
+
+// CRC-32(同zlib)，每字节查两次16项表 CRC-32 as in zlib, two lookups in a 16-entry table per byte
+static uint32_t Param_Crc32(const void *buf, uint32_t len)
+{
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+    const uint8_t *p = (const uint8_t *)buf;
+    uint32_t crc = 0xFFFFFFFFu;
+
+    while (len--)
+    {
+        crc ^= *p++;
+        crc = (crc >> 4) ^ table[crc & 0xF];
+        crc = (crc >> 4) ^ table[crc & 0xF];
+    }
+    return ~crc;
+}
+
+static uint8_t Param_Header_Ok(const Param_Record_t *rec)
+{
+    return rec->magic == PARAM_MAGIC && rec->version == PARAM_VERSION && rec->seq != 0xFFFFFFFFu;
+}
+
+static uint8_t Param_Crc_Ok(const Param_Record_t *rec)
+{
+    return rec->crc == Param_Crc32(rec, offsetof(Param_Record_t, crc));
+}
+
+static uint8_t Param_Slot_Blank(const Param_Record_t *rec)
+{
+    const uint32_t *w = (const uint32_t *)rec;
+    for (uint32_t i = 0; i < sizeof(Param_Record_t) / 4; i++)
+    {
+        if (w[i] != 0xFFFFFFFFu)
+            return 0;
+    }
+    return 1;
+}
+
+// 读取各模块当前的参数 Collect the parameters currently in effect
+static void Param_Capture(Param_Data_t *d)
+{
+    memset(d, 0, sizeof(*d));
+    for (uint8_t i = 0; i < MAX_MOTOR; i++)
+    {
+        PID_Get_Motor_Parm(i, &d->motor_kp[i], &d->motor_ki[i], &d->motor_kd[i]);
+        d->friction[i] = *Motor_Get_Friction(i);
+    }
+    PID_Yaw_Get_Parm(&d->yaw_kp, &d->yaw_ki, &d->yaw_kd);
+    d->line_speed = g_line_speed;
+    d->arc_turn_radius = APP_Get_Arc_Radius();
+    d->tune = g_app_tune;
+    d->sched = *PID_Get_Motor_Sched();
+}
+
+static void Param_Apply(const Param_Data_t *d)
+{
+    for (uint8_t i = 0; i < MAX_MOTOR; i++)
+    {
+        const Motor_Friction_t *f = &d->friction[i];
+        PID_Set_Motor_Parm(i, d->motor_kp[i], d->motor_ki[i], d->motor_kd[i]);
+        for (uint8_t dir = 0; dir < 2; dir++)
+        {
+            Motor_Set_Friction(i, dir, f->static_pulse[dir], f->coulomb_pulse[dir], f->viscous_q8[dir]);
+        }
+    }
+    PID_Set_Motor_Sched(&d->sched);
+    PID_Yaw_Set_Parm(d->yaw_kp, d->yaw_ki, d->yaw_kd);
+    set_line_speed(d->line_speed);
+    APP_Set_Arc_Radius(d->arc_turn_radius);
+    g_app_tune = d->tune;
+}
+
+/**
+ * @brief  上电时读取参数区，应用序号最大且CRC正确的记录；没有时保持各模块的默认值
+ *         Read the store at power-up and apply the record with the highest
+ *         sequence number and a good CRC; without one the modules keep their
+ *         defaults
+ * @note   只读各位置的头部，只对候选记录算CRC，72MHz下约几十微秒
+ *         Only the slot headers are read and only candidates are
+ *         checksummed: some tens of microseconds at 72 MHz
+ * @retval 无
+ */
+void Param_Init(void)
+{
+    uint32_t below = 0xFFFFFFFFu;
+
+#if defined(__GNUC__) && defined(__arm__) && !defined(__ARMCC_VERSION)
+    // 导出参数区地址和大小，STM32F103ZETX_FLASH.ld据此检查PARAM区域；Keil由IROM大小保证
+    // Export the store's address and size for the PARAM checks in STM32F103ZETX_FLASH.ld; Keil relies on its IROM size
+    __asm__(".global _param_addr\n\t.set _param_addr, %c0\n\t.global _param_size\n\t.set _param_size, %c1"
+            :: "i"(PARAM_ADDR), "i"(PARAM_PAGES * FLASH_PAGE_SIZE));
+#endif
+
+    s_param.head = -1;
+    s_param.seq = 0;
+    s_param.last_seq = 0;
+    for (;;)
+    {
+        int16_t best = -1;
+        uint32_t best_seq = 0;
+        for (uint16_t slot = 0; slot < PARAM_SLOTS; slot++)
+        {
+            const Param_Record_t *rec = Param_Slot(slot);
+            if (!Param_Header_Ok(rec))
+                continue;
+            if (rec->seq > s_param.last_seq)
+            {
+                s_param.last_seq = rec->seq;
+                s_param.head = (int16_t)slot;
+            }
+            if (rec->seq < below && rec->seq > best_seq)
+            {
+                best = (int16_t)slot;
+                best_seq = rec->seq;
+            }
+        }
+        if (best < 0)
+            return;
+        if (Param_Crc_Ok(Param_Slot(best)))
+        {
+            Param_Apply(&Param_Slot(best)->data);
+            s_param.seq = best_seq;
+            return;
+        }
+        // 写到一半掉电的记录，退回上一条 A record cut off by a power loss: fall back to the one before
+        below = best_seq;
+    }
+}
+
+/**
+ * @brief  把当前参数作为新记录写入下一个空位，跨入新页时先擦除该页
+ *         Write the current parameters as a new record in the next free slot,
+ *         erasing a page first when the write moves into it
+ * @note   擦页约20ms，写一条约4ms，期间CPU取指停顿、中断被推迟，只在停车时调用
+ *         A page erase takes about 20 ms and a record about 4 ms, during which
+ *         instruction fetch stalls and interrupts wait; call it only with the
+ *         car stopped
+ * @retval HAL_OK成功，其它为Flash编程或校验失败 HAL_OK on success, otherwise the flash program or verify failed
+ */
+HAL_StatusTypeDef Param_Save(void)
+{
+    Param_Record_t rec;
+    uint16_t slot = (uint16_t)(s_param.head + 1) % PARAM_SLOTS;
+    HAL_StatusTypeDef ret = HAL_OK;
+
+    memset(&rec, 0, sizeof(rec));
+    rec.magic = PARAM_MAGIC;
+    rec.version = PARAM_VERSION;
+    rec.seq = s_param.last_seq + 1;
+    Param_Capture(&rec.data);
+    rec.crc = Param_Crc32(&rec, offsetof(Param_Record_t, crc));
+
+    HAL_FLASH_Unlock();
+    // 跳过掉电留下的非空位置，到页首时擦除整页(其中是最旧的记录)
+    // Skip slots left dirty by a power loss; at a page start erase the page, which holds the oldest records
+    for (uint16_t n = 0; n < PARAM_SLOTS; n++, slot = (slot + 1) % PARAM_SLOTS)
+    {
+        if (slot % PARAM_SLOTS_PER_PAGE == 0)
+        {
+            FLASH_EraseInitTypeDef erase = {FLASH_TYPEERASE_PAGES, FLASH_BANK_1, Param_Slot_Addr(slot), 1};
+            uint32_t page_error;
+            ret = HAL_FLASHEx_Erase(&erase, &page_error);
+            if (ret != HAL_OK)
+                break;
+        }
+        if (Param_Slot_Blank(Param_Slot(slot)))
+            break;
+    }
+
+    uint32_t addr = Param_Slot_Addr(slot);
+    const uint32_t *w = (const uint32_t *)&rec;
+    for (uint32_t i = 1; ret == HAL_OK && i < sizeof(rec) / 4; i++)
+    {
+        ret = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addr + i * 4, w[i]);
+    }
+    if (ret == HAL_OK)
+        ret = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addr, w[0]);
+    HAL_FLASH_Lock();
+
+    // 不论成败该位置都已用过，下次从它之后开始 Used either way; the next save starts after it
+    s_param.head = (int16_t)slot;
+    s_param.last_seq = rec.seq;
+    if (ret == HAL_OK && memcmp(Param_Slot(slot), &rec, sizeof(rec)) != 0)
+        ret = HAL_ERROR;
+    if (ret == HAL_OK)
+        s_param.seq = rec.seq;
+    return ret;
+}
+
+/**
+ * @brief  擦除整个参数区，下次上电恢复编译时的默认值
+ *         Erase the whole store; the compiled-in defaults return at the next power-up
+ * @retval HAL_OK成功 HAL_OK on success
+ */
+HAL_StatusTypeDef Param_Erase(void)
+{
+    FLASH_EraseInitTypeDef erase = {FLASH_TYPEERASE_PAGES, FLASH_BANK_1, PARAM_ADDR, PARAM_PAGES};
+    uint32_t page_error;
+    HAL_StatusTypeDef ret;
+
+    HAL_FLASH_Unlock();
+    ret = HAL_FLASHEx_Erase(&erase, &page_error);
+    HAL_FLASH_Lock();
+    s_param.head = -1;
+    s_param.seq = 0;
+    s_param.last_seq = 0;
+    return ret;
+}
+
+// 当前生效记录的序号，0表示使用默认值 Sequence number of the record in effect, 0 while on the defaults
+uint32_t Param_Get_Seq(void)
+{
+    return s_param.seq;
+}
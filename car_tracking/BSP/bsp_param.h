@@ -0,0 +1,49 @@
+/*
+ * bsp_param.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * Flash参数区：512KB Flash的最后PARAM_PAGES页模拟EEPROM，保存可在车上修改的参数。
+ * 每次保存把全部参数作为一条记录追加到下一个空位，页写满后擦除环中的下一页，
+ * 擦写均匀分布在各页上；上电时取序号最大且CRC正确的记录。
+ * Flash parameter store: the last PARAM_PAGES pages of the 512 KB flash
+ * emulate an EEPROM holding the parameters that can change on the car. Each
+ * save appends all parameters as one record in the next free slot; when a
+ * page is full the next page of the ring is erased, so wear spreads over
+ * all pages. At power-up the record with the highest sequence number and a
+ * good CRC wins.
+ */
+
+#ifndef BSP_PARAM_H_
+#define BSP_PARAM_H_
+
+#include "bsp.h"
+
+// 参数区页数，每页2KB Pages in the store, 2 KB each
+#define PARAM_PAGES (4)
+#define PARAM_ADDR  (FLASH_BANK1_END + 1u - PARAM_PAGES * FLASH_PAGE_SIZE)
+// Param_Data_t布局改变时加1，旧记录随之作废 Bump when Param_Data_t changes; older records are then ignored
+#define PARAM_VERSION (2)
+
+// 保存的参数，上电时按此恢复 The saved parameters, restored at power-up
+typedef struct
+{
+    float motor_kp[MAX_MOTOR]; // 速度环，单位同PID_Set_Motor_Parm Speed loops, units as PID_Set_Motor_Parm
+    float motor_ki[MAX_MOTOR];
+    float motor_kd[MAX_MOTOR];
+    float yaw_kp, yaw_ki, yaw_kd;
+    int16_t line_speed;        // g_line_speed
+    uint8_t arc_turn_radius;   // APP_Set_Arc_Radius
+    uint8_t reserved;
+    AppTune_t tune;            // 巡线和弧线比例、判定时间 Line and arc ratios, detection timeouts
+    Motor_Friction_t friction[MAX_MOTOR];
+    PID_Sched_t sched;         // 速度环增益调度表 Speed-loop gain schedule
+} Param_Data_t;
+
+void Param_Init(void);
+HAL_StatusTypeDef Param_Save(void);
+HAL_StatusTypeDef Param_Erase(void);
+uint32_t Param_Get_Seq(void);
+
+#endif /* BSP_PARAM_H_ */
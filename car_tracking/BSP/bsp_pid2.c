@@ -0,0 +1,135 @@
+/*
+ * bsp_pid2.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * 两自由度PID的浮点版本，定点版本PIDQ2_Calc在bsp_pid_q.c中逐行对应。
+ * Float version of the two-degree-of-freedom PID; the fixed-point
+ * PIDQ2_Calc in bsp_pid_q.c follows it line for line.
+ */
+
+#include "bsp_pid2.h"
+
+/**
+ * @brief  清除状态，保留增益、权重和限幅
+ *         Clear the state, keeping gains, weights and limits
+ * @param  pid: PID状态 PID state
+ * @retval 无
+ */
+void PID2_Reset(PID2_t *pid)
+{
+	pid->integral = 0;
+	pid->deriv = 0;
+	pid->ep_last = 0;
+	pid->ed_last = 0;
+	pid->output = 0;
+	pid->first = 1;
+}
+
+/**
+ * @brief  设置增益：滤波后的微分状态按新旧Kd之比缩放，积分项补偿比例项和微分项的变化，
+ *         下一拍输出不跳变
+ *         Set the gains. The filtered derivative state is scaled by the ratio
+ *         of new to old Kd, and the integral absorbs the change of the
+ *         proportional and derivative terms so the next output does not jump
+ * @param  pid: PID状态 PID state
+ * @param  kp: 比例系数 Proportional gain
+ * @param  ki: 每拍积分系数 Integral gain per tick
+ * @param  kd: 每拍微分系数 Derivative gain per tick
+ * @retval 无
+ */
+void PID2_Set_Gains(PID2_t *pid, float kp, float ki, float kd)
+{
+	pid->integral += (pid->Kp - kp) * pid->ep_last;
+	if (pid->Kd != 0)
+	{
+		float deriv = pid->deriv * (kd / pid->Kd);
+		pid->integral += pid->deriv - deriv;
+		pid->deriv = deriv;
+	}
+	pid->Kp = kp;
+	pid->Ki = ki;
+	pid->Kd = kd;
+	pid->Kdf = (1.0f - pid->alpha) * kd;
+}
+
+/**
+ * @brief  设置设定值权重、微分滤波和抗饱和跟踪时间
+ *         Set the setpoint weights, the derivative filter and the
+ *         anti-windup tracking time
+ * @param  pid: PID状态 PID state
+ * @param  b: 比例项权重，小于1时阶跃目标的比例冲击减小 P weight; below 1 softens the kick on a setpoint step
+ * @param  c: 微分项权重，0为只对测量值微分 D weight; 0 differentiates the measurement only
+ * @param  tf: 微分滤波时间常数，拍，0为不滤波 Derivative filter time constant in ticks, 0 = unfiltered
+ * @param  tt: 抗饱和跟踪时间，拍，0为不抗饱和 Anti-windup tracking time in ticks, 0 = none
+ * @retval 无
+ */
+void PID2_Set_Shape(PID2_t *pid, float b, float c, float tf, float tt)
+{
+	pid->b = b;
+	pid->c = c;
+	pid->alpha = tf > 0 ? tf / (tf + 1.0f) : 0.0f;
+	pid->Kdf = (1.0f - pid->alpha) * pid->Kd;
+	pid->Kt = tt > 0 ? 1.0f / tt : 0.0f;
+}
+
+/**
+ * @brief  设置输出限幅，可每拍调用，如随前馈移动
+ *         Set the output limits; may be called every tick, e.g. to follow a feedforward
+ * @param  pid: PID状态 PID state
+ * @param  out_min: 下限 Lower limit
+ * @param  out_max: 上限 Upper limit
+ * @retval 无
+ */
+void PID2_Set_Limit(PID2_t *pid, float out_min, float out_max)
+{
+	pid->out_min = out_min;
+	pid->out_max = out_max;
+}
+
+/**
+ * @brief  计算一拍
+ *         Compute one tick
+ * @note   积分项另限在输出范围内，Kt为0时也不会无限累积
+ *         The integral is also kept within the output range, so it stays
+ *         bounded when Kt is 0
+ * @param  pid: PID状态 PID state
+ * @param  actual_val: 实际值 Measured value
+ * @retval 限幅后的输出 Limited output
+ */
+float PID2_Calc(PID2_t *pid, float actual_val)
+{
+	float e = pid->target_val - actual_val;
+	float ep = pid->b * pid->target_val - actual_val;
+	float ed = pid->c * pid->target_val - actual_val;
+
+	if (pid->first)
+	{
+		pid->ed_last = ed;
+		pid->first = 0;
+	}
+	pid->deriv = pid->alpha * pid->deriv + pid->Kdf * (ed - pid->ed_last);
+	pid->integral += pid->Ki * e;
+
+	float v = pid->Kp * ep + pid->integral + pid->deriv;
+	float u = v;
+	if (u > pid->out_max)
+		u = pid->out_max;
+	if (u < pid->out_min)
+		u = pid->out_min;
+
+	// Ki为0时没有积分可反算，修正会作为永久偏置留在积分里
+	// With Ki at 0 there is no integral to back-calculate; the correction would stay in it as a permanent bias
+	if (pid->Ki != 0)
+		pid->integral += pid->Kt * (u - v);
+	if (pid->integral > pid->out_max)
+		pid->integral = pid->out_max;
+	if (pid->integral < pid->out_min)
+		pid->integral = pid->out_min;
+
+	pid->ep_last = ep;
+	pid->ed_last = ed;
+	pid->output = u;
+	return u;
+}
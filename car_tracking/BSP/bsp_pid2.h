@@ -0,0 +1,57 @@
+/*
+ * bsp_pid2.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * 两自由度PID：比例和微分项按设定值权重b、c取误差，微分项一阶低通滤波，
+ * 输出限幅到[out_min, out_max]，积分按限幅前后之差反算(抗饱和)。改增益时
+ * 微分状态按新Kd缩放，修正积分使输出不跳变。位置式，每次调用为一拍，系数均为每拍值。
+ * Two-degree-of-freedom PID: the proportional and derivative terms act on
+ * setpoint-weighted errors (weights b and c), the derivative term passes a
+ * first-order low-pass, the output is limited to [out_min, out_max] and the
+ * integral is corrected by the difference before and after the limit
+ * (back-calculation anti-windup). A gain change rescales the derivative
+ * state to the new Kd and adjusts the integral so the output does not jump.
+ * Positional form; one call is one tick and all coefficients are per tick.
+ *
+ *   e  = r - y,  ep = b*r - y,  ed = c*r - y
+ *   D  = alpha*D + (1 - alpha)*Kd*(ed - ed_last),  alpha = Tf/(Tf + 1)
+ *   I += Ki*e
+ *   v  = Kp*ep + I + D,  u = clamp(v)
+ *   I += Kt*(u - v),  Kt = 1/Tt,  仅当 only when Ki != 0
+ *
+ * 线性区内b=c=1、Tf=0时与PID_Incre_Calc输出相同。定点版见bsp_pid_q.h中的PIDQ2_t。
+ * In the linear region with b = c = 1 and Tf = 0 the output equals
+ * PID_Incre_Calc's. The fixed-point version is PIDQ2_t in bsp_pid_q.h.
+ */
+
+#ifndef BSP_PID2_H_
+#define BSP_PID2_H_
+
+#include <stdint.h>
+
+typedef struct
+{
+    float target_val;       // 设定值r Setpoint r
+    float Kp, Ki, Kd;       // 每拍系数 Per-tick coefficients
+    float b, c;             // 比例、微分项的设定值权重 Setpoint weights of the P and D terms
+    float alpha;            // 微分滤波系数Tf/(Tf+1) Derivative filter coefficient Tf/(Tf+1)
+    float Kdf;              // (1-alpha)*Kd
+    float Kt;               // 反算增益1/Tt，0为不抗饱和 Back-calculation gain 1/Tt, 0 = no anti-windup
+    float out_min, out_max; // 输出限幅 Output limits
+    float integral;         // 积分项I Integral term I
+    float deriv;            // 滤波后的微分项D Filtered derivative term D
+    float ep_last;          // 上一拍的b*r-y b*r - y of the last tick
+    float ed_last;          // 上一拍的c*r-y c*r - y of the last tick
+    float output;           // 上一拍限幅后的输出 Limited output of the last tick
+    uint8_t first;          // 复位后第一拍，不算微分 First tick after a reset, no derivative
+} PID2_t;
+
+void PID2_Reset(PID2_t *pid);
+void PID2_Set_Gains(PID2_t *pid, float kp, float ki, float kd);
+void PID2_Set_Shape(PID2_t *pid, float b, float c, float tf, float tt);
+void PID2_Set_Limit(PID2_t *pid, float out_min, float out_max);
+float PID2_Calc(PID2_t *pid, float actual_val);
+
+#endif /* BSP_PID2_H_ */
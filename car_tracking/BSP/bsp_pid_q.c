@@ -0,0 +1,257 @@
+/*
+ * bsp_pid_q.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * 逐行对应bsp_PID_motor.c和bsp_pid2.c中的浮点版本，阈值和限幅在编译期换算为定点。
+ * 舍入误差每次乘法不超过2^-PIDQ_FRAC，主机端Tests/pid_q_test.c
+ * 与浮点版本逐步比较。
+ * Line for line the float versions in bsp_PID_motor.c and bsp_pid2.c, with
+ * thresholds and limits converted to fixed point at compile time. Each
+ * multiply rounds by at most 2^-PIDQ_FRAC; the host Tests/pid_q_test.c
+ * compares step by step against the float versions.
+ */
+
+#include "bsp.h"
+
+#define PIDQ_PWM_LIMIT      PIDQ_FROM_INT(MOTOR_PID_LIMIT)
+#define PIDQ_DEAD_BAND      PIDQ_FROM_INT(PID_LOC_DEAD_BAND)
+#define PIDQ_SEPARATE       PIDQ_FROM_INT(PID_LOC_SEPARATE)
+#define PIDQ_INTEGRAL_LIMIT PIDQ_FROM_INT(PID_LOC_INTEGRAL_LIMIT)
+#define PIDQ_YAW_LIMIT      PIDQ_FROM_FLOAT(PI / 6)
+
+/**
+ * @brief  增量式PID，同PID_Incre_Calc
+ *         Incremental PID, as PID_Incre_Calc
+ * @param  pid: PID状态 PID state
+ * @param  actual_val: 实际值 Measured value
+ * @retval PWM输出值，限幅同PID_Incre_Calc PWM output, limited as in PID_Incre_Calc
+ */
+pidq_t PIDQ_Incre_Calc(PIDQ_t *pid, pidq_t actual_val)
+{
+	pid->err = pid->target_val - actual_val;
+	pid->pwm_output += PIDQ_MUL(pid->Kp, pid->err - pid->err_next) + PIDQ_MUL(pid->Ki, pid->err) +
+					   PIDQ_MUL(pid->Kd, pid->err - 2 * pid->err_next + pid->err_last);
+	pid->err_last = pid->err_next;
+	pid->err_next = pid->err;
+
+	if (pid->pwm_output > PIDQ_PWM_LIMIT)
+		pid->pwm_output = PIDQ_PWM_LIMIT;
+	if (pid->pwm_output < -PIDQ_PWM_LIMIT)
+		pid->pwm_output = -PIDQ_PWM_LIMIT;
+
+	return pid->pwm_output;
+}
+
+/**
+ * @brief  位置式PID，同PID_Location_Calc，含闭环死区、积分分离和积分限幅
+ *         Positional PID, as PID_Location_Calc, with the closed-loop dead
+ *         band, integral separation and integral limit
+ * @param  pid: PID状态 PID state
+ * @param  actual_val: 实际值 Measured value
+ * @retval 输出值 Output value
+ */
+pidq_t PIDQ_Location_Calc(PIDQ_t *pid, pidq_t actual_val)
+{
+	pid->err = pid->target_val - actual_val;
+
+	/* 限定闭环死区 Closed-loop dead band */
+	if (pid->err >= -PIDQ_DEAD_BAND && pid->err <= PIDQ_DEAD_BAND)
+	{
+		pid->err = 0;
+		pid->integral = 0;
+	}
+
+	/* 积分分离，偏差较大时去掉积分作用 Integral separation on large errors */
+	if (pid->err > -PIDQ_SEPARATE && pid->err < PIDQ_SEPARATE)
+	{
+		pid->integral += pid->err;
+		if (pid->integral > PIDQ_INTEGRAL_LIMIT)
+			pid->integral = PIDQ_INTEGRAL_LIMIT;
+		else if (pid->integral < -PIDQ_INTEGRAL_LIMIT)
+			pid->integral = -PIDQ_INTEGRAL_LIMIT;
+	}
+
+	pid->output_val = PIDQ_MUL(pid->Kp, pid->err) + PIDQ_MUL(pid->Ki, pid->integral) +
+					  PIDQ_MUL(pid->Kd, pid->err - pid->err_last);
+	pid->err_last = pid->err;
+
+	return pid->output_val;
+}
+
+/**
+ * @brief  偏航角PID，同PID_Yaw_Calc
+ *         Yaw PID, as PID_Yaw_Calc
+ * @note   浮点版的误差和不会溢出；这里饱和在±PIDQ_MAX/2，只在积分常数
+ *         不为0且长期偏离时才会不同
+ *         The float error sum cannot overflow; here it saturates at
+ *         ±PIDQ_MAX/2, which only differs with a non-zero integral constant
+ *         and a long-standing error
+ * @param  pid: PID状态 PID state
+ * @param  next_point: 当前偏航角，rad Current yaw, rad
+ * @retval 角速度修正，限幅±PI/6 Angular rate correction, limited to ±PI/6
+ */
+pidq_t PIDQ_Yaw_Calc(PIDQ_Yaw_t *pid, pidq_t next_point)
+{
+	pidq_t error = pid->SetPoint - next_point;
+	pidq_t d_error = pid->LastError - pid->PrevError;
+
+	pid->SumError += error;
+	if (pid->SumError > PIDQ_MAX / 2)
+		pid->SumError = PIDQ_MAX / 2;
+	else if (pid->SumError < -PIDQ_MAX / 2)
+		pid->SumError = -PIDQ_MAX / 2;
+	pid->PrevError = pid->LastError;
+	pid->LastError = error;
+
+	pidq_t omega = PIDQ_MUL(pid->Proportion, error) + PIDQ_MUL(pid->Integral, pid->SumError) +
+				   PIDQ_MUL(pid->Derivative, d_error);
+	if (omega > PIDQ_YAW_LIMIT)
+		omega = PIDQ_YAW_LIMIT;
+	if (omega < -PIDQ_YAW_LIMIT)
+		omega = -PIDQ_YAW_LIMIT;
+	return omega;
+}
+
+/**
+ * @brief  清除状态，同PID2_Reset
+ *         Clear the state, as PID2_Reset
+ * @param  pid: PID状态 PID state
+ * @retval 无
+ */
+void PIDQ2_Reset(PIDQ2_t *pid)
+{
+	pid->integral = 0;
+	pid->deriv = 0;
+	pid->ep_last = 0;
+	pid->ed_last = 0;
+	pid->output = 0;
+	pid->first = 1;
+}
+
+// 定点数之比num/den，只用32位除法(Cortex-M3有硬件UDIV)，在TIM6中断中改增益时不调用64位除法库函数。
+// 分母先右移到小数位数以内，余数左移不溢出，丢掉的低位相对误差约2^-15；比值过大时取PIDQ_MAX
+// Ratio num/den of two fixed-point values with 32-bit divides only (the Cortex-M3 divides in hardware),
+// so a gain change in the TIM6 interrupt pulls in no 64-bit division routine. The denominator is first
+// shifted down into the fraction bits so the remainder can be shifted up without overflow; the dropped
+// low bits cost about 2^-15 relative. A ratio too large to represent gives PIDQ_MAX
+static pidq_t PIDQ_Ratio(pidq_t num, pidq_t den)
+{
+	uint32_t n = num < 0 ? 0u - (uint32_t)num : (uint32_t)num;
+	uint32_t d = den < 0 ? 0u - (uint32_t)den : (uint32_t)den;
+
+	while (d >> (32 - PIDQ_FRAC))
+	{
+		n >>= 1;
+		d >>= 1;
+	}
+	uint32_t q = n / d;
+	uint32_t r = n % d;
+	pidq_t ratio = q > (uint32_t)(PIDQ_MAX >> PIDQ_FRAC) ? PIDQ_MAX
+	                                                    : (pidq_t)((q << PIDQ_FRAC) + (r << PIDQ_FRAC) / d);
+	return (num < 0) != (den < 0) ? -ratio : ratio;
+}
+
+/**
+ * @brief  设置增益，同PID2_Set_Gains，无浮点运算，可在中断中调用
+ *         Set the gains, as PID2_Set_Gains; no float arithmetic, safe in an interrupt
+ * @param  pid: PID状态 PID state
+ * @param  kp: 比例系数 Proportional gain
+ * @param  ki: 每拍积分系数 Integral gain per tick
+ * @param  kd: 每拍微分系数 Derivative gain per tick
+ * @retval 无
+ */
+void PIDQ2_Set_Gains(PIDQ2_t *pid, pidq_t kp, pidq_t ki, pidq_t kd)
+{
+	pid->integral += PIDQ_MUL(pid->Kp - kp, pid->ep_last);
+	if (pid->Kd != 0)
+	{
+		pidq_t deriv = PIDQ_MUL(pid->deriv, PIDQ_Ratio(kd, pid->Kd));
+		pid->integral += pid->deriv - deriv;
+		pid->deriv = deriv;
+	}
+	pid->Kp = kp;
+	pid->Ki = ki;
+	pid->Kd = kd;
+	pid->Kdf = PIDQ_MUL(PIDQ_ONE - pid->alpha, kd);
+}
+
+/**
+ * @brief  设置设定值权重、微分滤波和抗饱和跟踪时间，同PID2_Set_Shape
+ *         Set the setpoint weights, derivative filter and anti-windup
+ *         tracking time, as PID2_Set_Shape
+ * @note   参数为浮点，只在初始化和改参数时调用 Float arguments; call it at set-up only
+ * @param  pid: PID状态 PID state
+ * @param  b: 比例项权重 P weight
+ * @param  c: 微分项权重 D weight
+ * @param  tf: 微分滤波时间常数，拍 Derivative filter time constant in ticks
+ * @param  tt: 抗饱和跟踪时间，拍 Anti-windup tracking time in ticks
+ * @retval 无
+ */
+void PIDQ2_Set_Shape(PIDQ2_t *pid, float b, float c, float tf, float tt)
+{
+	float alpha = tf > 0 ? tf / (tf + 1.0f) : 0.0f;
+	float kt = tt > 0 ? 1.0f / tt : 0.0f;
+
+	pid->b = PIDQ_FROM_FLOAT(b);
+	pid->c = PIDQ_FROM_FLOAT(c);
+	pid->alpha = PIDQ_FROM_FLOAT(alpha);
+	pid->Kdf = PIDQ_MUL(PIDQ_ONE - pid->alpha, pid->Kd);
+	pid->Kt = PIDQ_FROM_FLOAT(kt);
+}
+
+/**
+ * @brief  设置输出限幅，同PID2_Set_Limit
+ *         Set the output limits, as PID2_Set_Limit
+ * @param  pid: PID状态 PID state
+ * @param  out_min: 下限 Lower limit
+ * @param  out_max: 上限 Upper limit
+ * @retval 无
+ */
+void PIDQ2_Set_Limit(PIDQ2_t *pid, pidq_t out_min, pidq_t out_max)
+{
+	pid->out_min = out_min;
+	pid->out_max = out_max;
+}
+
+/**
+ * @brief  两自由度PID一拍，同PID2_Calc
+ *         One tick of the two-degree-of-freedom PID, as PID2_Calc
+ * @param  pid: PID状态 PID state
+ * @param  actual_val: 实际值 Measured value
+ * @retval 限幅后的输出 Limited output
+ */
+pidq_t PIDQ2_Calc(PIDQ2_t *pid, pidq_t actual_val)
+{
+	pidq_t e = pid->target_val - actual_val;
+	pidq_t ep = PIDQ_MUL(pid->b, pid->target_val) - actual_val;
+	pidq_t ed = PIDQ_MUL(pid->c, pid->target_val) - actual_val;
+
+	if (pid->first)
+	{
+		pid->ed_last = ed;
+		pid->first = 0;
+	}
+	pid->deriv = PIDQ_MUL(pid->alpha, pid->deriv) + PIDQ_MUL(pid->Kdf, ed - pid->ed_last);
+	pid->integral += PIDQ_MUL(pid->Ki, e);
+
+	pidq_t v = PIDQ_MUL(pid->Kp, ep) + pid->integral + pid->deriv;
+	pidq_t u = v;
+	if (u > pid->out_max)
+		u = pid->out_max;
+	if (u < pid->out_min)
+		u = pid->out_min;
+
+	if (pid->Ki != 0)
+		pid->integral += PIDQ_MUL(pid->Kt, u - v);
+	if (pid->integral > pid->out_max)
+		pid->integral = pid->out_max;
+	if (pid->integral < pid->out_min)
+		pid->integral = pid->out_min;
+
+	pid->ep_last = ep;
+	pid->ed_last = ed;
+	pid->output = u;
+	return u;
+}
@@ -0,0 +1,101 @@
+/*
+ * bsp_pid_q.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * 定点PID：与bsp_PID_motor.c中的增量式、位置式和偏航角PID以及bsp_pid2.c中的
+ * 两自由度PID语义相同，全部用32位整数计算，乘法取64位乘积后移位。
+ * Cortex-M3没有FPU，浮点版每次调用要进软浮点库二十来次，定点版一次也不用。
+ * Fixed-point PID with the same semantics as the incremental, positional
+ * and yaw PIDs in bsp_PID_motor.c and the two-degree-of-freedom PID in
+ * bsp_pid2.c, computed entirely in 32-bit integers; multiplies take the
+ * 64-bit product and shift. The Cortex-M3 has no FPU: the float version
+ * enters the soft-float library about twenty times per call, this one
+ * never does.
+ *
+ * 默认Q16.16，可定义PIDQ_FRAC改变小数位数。整数部分需容纳误差、积分和
+ * PWM输出(数千)，PIDQ_FRAC不宜超过18。
+ * Q16.16 by default; define PIDQ_FRAC to change the fraction bits. The
+ * integer part must hold errors, integrals and PWM outputs (thousands), so
+ * keep PIDQ_FRAC at 18 or below.
+ */
+
+#ifndef BSP_PID_Q_H_
+#define BSP_PID_Q_H_
+
+#include <stdint.h>
+
+#ifndef PIDQ_FRAC
+#define PIDQ_FRAC (16)
+#endif
+
+typedef int32_t pidq_t;
+
+#define PIDQ_ONE ((pidq_t)1 << PIDQ_FRAC)
+#define PIDQ_MAX ((pidq_t)0x7FFFFFFF)
+
+// 常数换算在编译期完成；浮点变量换算时仍调用软浮点库。PIDQ_FROM_FLOAT对x求值两次
+// Constants convert at compile time; converting a float variable still calls the
+// soft-float library. PIDQ_FROM_FLOAT evaluates x twice
+#define PIDQ_FROM_INT(x)   ((pidq_t)(x) * PIDQ_ONE)
+#define PIDQ_FROM_FLOAT(x) ((pidq_t)((x) * (float)PIDQ_ONE + ((x) >= 0 ? 0.5f : -0.5f)))
+#define PIDQ_TO_FLOAT(q)   ((float)(q) * (1.0f / PIDQ_ONE))
+// 向0取整，与浮点转整数相同 Truncates toward zero like a float to integer conversion
+#define PIDQ_TO_INT(q)     ((int32_t)((q) / PIDQ_ONE))
+#define PIDQ_MUL(a, b)     ((pidq_t)(((int64_t)(a) * (b)) >> PIDQ_FRAC))
+
+// 字段与PID_t一一对应 Fields match PID_t one to one
+typedef struct
+{
+    pidq_t target_val; // 目标值
+    pidq_t output_val; // 输出值
+    pidq_t pwm_output; // PWM输出值
+    pidq_t Kp, Ki, Kd; // 比例、积分、微分系数
+    pidq_t err;        // 偏差值
+    pidq_t err_last;   // 上一个偏差值
+    pidq_t err_next;   // 下一个偏差值, 增量式
+    pidq_t integral;   // 积分值，位置式
+} PIDQ_t;
+
+// 字段与偏航角PID一一对应 Fields match the yaw PID one to one
+typedef struct
+{
+    pidq_t SetPoint;   // 设定目标Desired value
+    pidq_t Proportion; // 比例常数Proportional Const
+    pidq_t Integral;   // 积分常数Integral Const
+    pidq_t Derivative; // 微分常数Derivative Const
+    pidq_t LastError;  // Error[-1]
+    pidq_t PrevError;  // Error[-2]
+    pidq_t SumError;   // Sums of Errors
+} PIDQ_Yaw_t;
+
+// 字段与PID2_t一一对应 Fields match PID2_t one to one
+typedef struct
+{
+    pidq_t target_val;       // 设定值r Setpoint r
+    pidq_t Kp, Ki, Kd;       // 每拍系数 Per-tick coefficients
+    pidq_t b, c;             // 比例、微分项的设定值权重 Setpoint weights of the P and D terms
+    pidq_t alpha;            // 微分滤波系数 Derivative filter coefficient
+    pidq_t Kdf;              // (1-alpha)*Kd
+    pidq_t Kt;               // 反算增益 Back-calculation gain
+    pidq_t out_min, out_max; // 输出限幅 Output limits
+    pidq_t integral;         // 积分项 Integral term
+    pidq_t deriv;            // 滤波后的微分项 Filtered derivative term
+    pidq_t ep_last;          // 上一拍的b*r-y b*r - y of the last tick
+    pidq_t ed_last;          // 上一拍的c*r-y c*r - y of the last tick
+    pidq_t output;           // 上一拍限幅后的输出 Limited output of the last tick
+    uint8_t first;           // 复位后第一拍 First tick after a reset
+} PIDQ2_t;
+
+pidq_t PIDQ_Incre_Calc(PIDQ_t *pid, pidq_t actual_val);
+pidq_t PIDQ_Location_Calc(PIDQ_t *pid, pidq_t actual_val);
+pidq_t PIDQ_Yaw_Calc(PIDQ_Yaw_t *pid, pidq_t next_point);
+
+void PIDQ2_Reset(PIDQ2_t *pid);
+void PIDQ2_Set_Gains(PIDQ2_t *pid, pidq_t kp, pidq_t ki, pidq_t kd);
+void PIDQ2_Set_Shape(PIDQ2_t *pid, float b, float c, float tf, float tt);
+void PIDQ2_Set_Limit(PIDQ2_t *pid, pidq_t out_min, pidq_t out_max);
+pidq_t PIDQ2_Calc(PIDQ2_t *pid, pidq_t actual_val);
+
+#endif /* BSP_PID_Q_H_ */
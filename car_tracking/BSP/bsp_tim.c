@@ -12,6 +12,11 @@
 void Bsp_Tim_Init(void)
 
 {
+#if ENCODER_SYNC_LATCH
+	// 主从触发须在TIM1/TIM8启动前配置 Master/slave triggers must be set before TIM1/TIM8 start
+	Encoder_Sync_Init();
+#endif
+
 	// 启动tim1的pwm输出 Start the pwm output of tim1
 	HAL_TIM_PWM_Start(&htim1, TIM_CHANNEL_1);
 	HAL_TIM_PWM_Start(&htim1, TIM_CHANNEL_2);
@@ -41,6 +46,24 @@ void Bsp_Tim_Init(void)
 	HAL_TIM_Encoder_Start(&htim5, TIM_CHANNEL_1 | TIM_CHANNEL_2);
 
 
+	// 计数器自由运行，以启动时的CNT为起点 The counters free-run from their CNT at start-up
+	Encoder_Init();
+
+	// 按ENCODER_MT_MASK打开M/T测速 Enable M/T speed estimation per ENCODER_MT_MASK
+	for (uint8_t i = 0; i < MAX_MOTOR; i++)
+	{
+		Encoder_MT_Enable(i, (ENCODER_MT_MASK >> i) & 1);
+	}
+
+	// TIM6计数频率10kHz(72MHz/7200)，周期按CTRL_PERIOD_MS设置
+	// TIM6 counts at 10 kHz (72 MHz / 7200); the period follows CTRL_PERIOD_MS
+	__HAL_TIM_SET_AUTORELOAD(&htim6, CTRL_PERIOD_MS * 10 - 1);
+
+#if ENCODER_SYNC_LATCH
+	// TIM6紧跟一次TIM1更新启动，中断总在锁存后的同一相位读取 Start TIM6 just after a TIM1 update so the ISR always reads the latch at the same phase
+	Encoder_Sync_Align();
+#endif
+
 	//启动定时6中断 Start timer 6 interrupt
 	HAL_TIM_Base_Start_IT(&htim6);
 }
@@ -58,9 +81,10 @@ void Bsp_Tim_Init(void)
  * */
 void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
 {
-	if (htim->Instance == TIM6)//10ms
+	if (htim->Instance == TIM6)//CTRL_PERIOD_MS
 	{
-		Encoder_Update_Count();//10ms测速 10ms speed test
+		TRACE_ISR();//输入记录 Input trace
+		Encoder_Update_Count();//每周期测速 Speed measurement every period
 		Motion_Handle();//调用PID控制速度 Call PID to control speed
 
 	}
@@ -69,5 +93,13 @@ void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
 
 }
 
-
-
+/*
+ * 输入捕获回调：编码器TI1上升沿，用于M/T测速
+ *
+ * Input capture callback: encoder TI1 rising edge, for M/T speed estimation
+ *
+ * */
+void HAL_TIM_IC_CaptureCallback(TIM_HandleTypeDef *htim)
+{
+	Encoder_MT_Capture(htim);
+}
@@ -0,0 +1,158 @@
+/*
+ * bsp_trace.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * 实车上记录写入RAM缓冲区，停车后用调试器导出g_trace.buf的前
+ * g_trace.count个字即可在主机上回放。
+ * On the car the log goes to a RAM buffer; after the run, dump the first
+ * g_trace.count words of g_trace.buf with the debugger and replay them on
+ * the host.
+ */
+
+#include "bsp_trace.h"
+
+#ifdef BSP_TRACE
+
+BspTrace_t g_trace = {0};
+
+static uint32_t s_trace_buf[BSP_TRACE_LEN];
+
+static void Trace_Write(uint32_t rec)
+{
+	if (g_trace.buf == NULL || g_trace.full)
+		return;
+	if (g_trace.count >= g_trace.len)
+	{
+		g_trace.full = 1;
+		return;
+	}
+	g_trace.buf[g_trace.count++] = rec;
+}
+
+// 追加一条记录，先写出之前未记录的读取次数 Append one record, preceded by the unlogged read count
+static void Trace_Put(uint32_t rec)
+{
+	g_trace.loop_open = 0;
+	while (g_trace.skip > 0)
+	{
+		uint32_t n = g_trace.skip < 0xFFFFFFu ? g_trace.skip : 0xFFFFFFu;
+		Trace_Write(TRACE_MAKE(TRACE_KIND_SKIP, 0, n));
+		g_trace.skip -= n;
+	}
+	Trace_Write(rec);
+}
+
+/**
+ * @brief  清空记录并开始记录到buf，替换钩子保持不变
+ *         Clear the log and start recording into buf. The hook is kept.
+ * @param  buf: 记录缓冲区，NULL用内部的BSP_TRACE_LEN字缓冲区
+ *              Log buffer, NULL for the internal BSP_TRACE_LEN-word buffer
+ * @param  len: 缓冲区字数 Buffer length in words
+ * @retval 无
+ */
+void BSP_Trace_Start(uint32_t *buf, uint32_t len)
+{
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	if (buf == NULL)
+	{
+		buf = s_trace_buf;
+		len = BSP_TRACE_LEN;
+	}
+	g_trace.buf = buf;
+	g_trace.len = len;
+	g_trace.count = 0;
+	g_trace.full = 0;
+	g_trace.loop_open = 0;
+	g_trace.tick = 0xFFFFFFFFu;
+	g_trace.skip = 0;
+	for (uint8_t i = 0; i < TRACE_PINS; i++)
+		g_trace.pin[i] = 0xFF;
+
+	__set_PRIMASK(primask);
+}
+
+// 每次BSP_Loop开始时调用 Called at the start of every BSP_Loop pass
+void BSP_Trace_Loop(void)
+{
+	if (g_trace.hook != NULL)
+		g_trace.hook(TRACE_KIND_LOOP, 0, 0);
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	g_trace.skip = 0; // 上一遍末尾的读取无需定位 Reads at the end of the last pass need no position
+	if (g_trace.loop_open && g_trace.count > 0 && TRACE_VALUE(g_trace.buf[g_trace.count - 1]) < 0xFFFFFFu)
+	{
+		g_trace.buf[g_trace.count - 1]++;
+	}
+	else
+	{
+		Trace_Put(TRACE_MAKE(TRACE_KIND_LOOP, 0, 1));
+		g_trace.loop_open = !g_trace.full && g_trace.buf != NULL;
+	}
+	__set_PRIMASK(primask);
+}
+
+// 进入TIM6中断时调用 Called on TIM6 interrupt entry
+void BSP_Trace_Isr(void)
+{
+	if (g_trace.hook != NULL)
+		g_trace.hook(TRACE_KIND_ISR, 0, 0);
+	Trace_Put(TRACE_MAKE(TRACE_KIND_ISR, 0, 0));
+}
+
+// 记录HAL_GetTick，只在变化时写入 Log HAL_GetTick, written only when it changes
+uint32_t BSP_Trace_Tick(uint32_t tick)
+{
+	if (g_trace.hook != NULL)
+		tick = g_trace.hook(TRACE_KIND_TICK, 0, tick);
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	if (tick != g_trace.tick)
+	{
+		g_trace.tick = tick;
+		Trace_Put(TRACE_MAKE(TRACE_KIND_TICK, 0, tick));
+	}
+	else
+	{
+		g_trace.skip++;
+	}
+	__set_PRIMASK(primask);
+	return tick;
+}
+
+// 记录输入引脚，只在变化时写入 Log an input pin, written only when it changes
+GPIO_PinState BSP_Trace_In(uint8_t pin, GPIO_PinState level)
+{
+	if (g_trace.hook != NULL)
+		level = (GPIO_PinState)g_trace.hook(TRACE_KIND_IN, pin, level);
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	if (pin < TRACE_PINS && g_trace.pin[pin] != (uint8_t)level)
+	{
+		g_trace.pin[pin] = (uint8_t)level;
+		Trace_Put(TRACE_MAKE(TRACE_KIND_IN, pin, level));
+	}
+	else
+	{
+		g_trace.skip++;
+	}
+	__set_PRIMASK(primask);
+	return level;
+}
+
+// 记录编码器计数，每次都写入 Log an encoder count, always written
+uint32_t BSP_Trace_Cnt(uint8_t motor, uint32_t cnt)
+{
+	if (g_trace.hook != NULL)
+		cnt = g_trace.hook(TRACE_KIND_CNT, motor, cnt);
+	Trace_Put(TRACE_MAKE(TRACE_KIND_CNT, motor, cnt & 0xFFFFu));
+	return cnt;
+}
+
+#endif /* BSP_TRACE */
@@ -0,0 +1,111 @@
+/*
+ * bsp_trace.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * 输入记录：记下固件从外部读到的每个值——巡线传感器IN_X1..X4、按键、
+ * 编码器计数TIM2..TIM5->CNT和HAL_GetTick，主机端可把记录原样喂回
+ * APP_Path_Loop/Motion_Handle，逐位复现一次实车运行。
+ * Input trace: logs every value the firmware reads from outside — the
+ * IN_X1..X4 line sensors, the keys, the TIM2..TIM5->CNT encoder counts and
+ * HAL_GetTick — so the host can feed a real run back into
+ * APP_Path_Loop/Motion_Handle bit for bit.
+ *
+ * 定义BSP_TRACE时生效，否则各宏展开为原来的读操作，不增加任何开销。
+ * Active when BSP_TRACE is defined; otherwise every macro expands to the
+ * plain read and costs nothing.
+ *
+ * 记录为32位字：位31..28类型，27..24序号，23..0数值。为节省RAM，
+ * 节拍和引脚只在数值变化时记录，其前的SKIP记下本遍中自上一条记录起
+ * 未记录的读取次数，回放据此把变化放回原来那次读取；连续无变化的主循环
+ * 合并为一条LOOP计数；编码器计数每次都记录。
+ * Records are 32-bit words: bits 31..28 kind, 27..24 index, 23..0 value.
+ * To save RAM the tick and the pins are logged only when they change. A
+ * SKIP ahead of a record holds how many reads in this pass went unlogged
+ * since the previous record, so replay puts each change back on the read
+ * that saw it. Consecutive main-loop passes without a change collapse into
+ * one LOOP count; encoder counts are always logged.
+ */
+
+#ifndef BSP_TRACE_H_
+#define BSP_TRACE_H_
+
+#include <stdint.h>
+#include "main.h"
+
+#ifndef BSP_TRACE_LEN
+#define BSP_TRACE_LEN (8192) // 实车记录缓冲区，32KB On-car log buffer, 32 KB
+#endif
+
+#define TRACE_KIND_LOOP (1u) // 一次或多次BSP_Loop，数值为次数 One or more BSP_Loop passes, value = count
+#define TRACE_KIND_ISR  (2u) // 进入TIM6中断 TIM6 interrupt entry
+#define TRACE_KIND_TICK (3u) // HAL_GetTick的低24位 Low 24 bits of HAL_GetTick
+#define TRACE_KIND_IN   (4u) // 输入引脚电平，序号见TRACE_PIN_* Input pin level, index is TRACE_PIN_*
+#define TRACE_KIND_CNT  (5u) // 编码器计数，序号为电机ID Encoder count, index is the motor ID
+#define TRACE_KIND_SKIP (6u) // 之前未记录的主循环读取次数 Unlogged main-loop reads before the next record
+
+#define TRACE_PIN_X1   (0u)
+#define TRACE_PIN_X2   (1u)
+#define TRACE_PIN_X3   (2u)
+#define TRACE_PIN_X4   (3u)
+#define TRACE_PIN_KEY1 (4u)
+#define TRACE_PIN_KEY2 (5u)
+#define TRACE_PIN_KEY3 (6u)
+#define TRACE_PINS     (7u)
+
+#define TRACE_MAKE(kind, index, value) (((uint32_t)(kind) << 28) | ((uint32_t)(index) << 24) | ((uint32_t)(value) & 0xFFFFFFu))
+#define TRACE_KIND(rec)  ((rec) >> 28)
+#define TRACE_INDEX(rec) (((rec) >> 24) & 0x0Fu)
+#define TRACE_VALUE(rec) ((rec) & 0xFFFFFFu)
+
+/*
+ * 替换钩子：非空时每次读取先交给它，返回值代替实际读数并照常记录。
+ * 主机回放用它注入记录的值，实车上保持为空。
+ * Substitution hook: when set, every read goes through it first and its
+ * result replaces the live value before being logged as usual. Host replay
+ * uses it to inject recorded values; it stays NULL on the car.
+ */
+typedef uint32_t (*BspTraceHook_t)(uint8_t kind, uint8_t index, uint32_t live);
+
+typedef struct
+{
+    uint32_t *buf;
+    uint32_t len;
+    uint32_t count;
+    uint8_t full;                 // 缓冲区已满，之后的记录被丢弃 Buffer filled up; later records are dropped
+    uint8_t loop_open;            // 最后一条是可累加的LOOP The last record is a LOOP that can still count up
+    uint32_t tick;                // 最后记录的节拍 Last logged tick
+    uint8_t pin[TRACE_PINS];      // 最后记录的电平，0xFF为未记录 Last logged level, 0xFF = none yet
+    uint32_t skip;                // 上一条记录后未记录的读取 Unlogged reads since the previous record
+    BspTraceHook_t hook;
+} BspTrace_t;
+
+#ifdef BSP_TRACE
+
+extern BspTrace_t g_trace;
+
+void BSP_Trace_Start(uint32_t *buf, uint32_t len);
+void BSP_Trace_Loop(void);
+void BSP_Trace_Isr(void);
+uint32_t BSP_Trace_Tick(uint32_t tick);
+GPIO_PinState BSP_Trace_In(uint8_t pin, GPIO_PinState level);
+uint32_t BSP_Trace_Cnt(uint8_t motor, uint32_t cnt);
+
+#define TRACE_LOOP() BSP_Trace_Loop()
+#define TRACE_ISR() BSP_Trace_Isr()
+#define TRACE_TICK() BSP_Trace_Tick(HAL_GetTick())
+#define TRACE_IN(pin, level) BSP_Trace_In((pin), (level))
+#define TRACE_CNT(motor, cnt) BSP_Trace_Cnt((motor), (cnt))
+
+#else
+
+#define TRACE_LOOP() ((void)0)
+#define TRACE_ISR() ((void)0)
+#define TRACE_TICK() HAL_GetTick()
+#define TRACE_IN(pin, level) (level)
+#define TRACE_CNT(motor, cnt) (cnt)
+
+#endif /* BSP_TRACE */
+
+#endif /* BSP_TRACE_H_ */
@@ -0,0 +1,42 @@
+/*
+ * hal_shim.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * 主机端HAL替身的控制接口，供仿真器和主机工具使用，固件代码不应包含此文件。
+ * Control interface of the host HAL shim, used by the simulator and host
+ * tools. Firmware sources must not include this file.
+ */
+
+#ifndef HOST_HAL_SHIM_H_
+#define HOST_HAL_SHIM_H_
+
+#include "stm32f1xx_hal.h"
+
+// 虚拟时钟每次前进后调用，仿真器借此推进物理模型和TIM6中断
+// Called after every virtual clock advance; the simulator uses it to step
+// the physics and fire TIM6
+typedef void (*ShimClockHook_t)(void *ctx);
+
+void Shim_Reset(void);
+
+void Shim_GPIO_Set_Input(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state);
+GPIO_PinState Shim_GPIO_Get_Output(GPIO_TypeDef *port, uint16_t pin);
+
+uint64_t Shim_Clock_Us(void);
+void Shim_Clock_Set_Virtual(uint8_t enable);
+void Shim_Clock_Set_Hook(ShimClockHook_t hook, void *ctx);
+void Shim_Clock_Advance_Us(uint32_t us);
+
+#define SHIM_HCLK_MHZ (72u)
+
+void Shim_TIM6_Elapsed(void);
+void Shim_Cycles_Set_Us(double us);
+void Shim_TIM_Capture(TIM_HandleTypeDef *htim, double us);
+
+void Shim_Flash_Blank(void);
+void Shim_Flash_Cut_After(int32_t ops);
+uint32_t Shim_Flash_Erase_Count(uint32_t page_addr);
+
+#endif /* HOST_HAL_SHIM_H_ */
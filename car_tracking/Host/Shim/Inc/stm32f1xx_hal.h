@@ -0,0 +1,250 @@
+/*
+ * stm32f1xx_hal.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * 主机端HAL替身，只提供BSP层用到的类型、寄存器和函数，
+ * 使BSP/app代码无需修改即可在Linux上编译运行。
+ * Host-side HAL shim. Provides only the types, registers and functions
+ * the BSP layer uses, so the BSP/app sources build unchanged on Linux.
+ */
+
+#ifndef HOST_STM32F1XX_HAL_H_
+#define HOST_STM32F1XX_HAL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define __IO volatile
+
+typedef enum
+{
+    HAL_OK = 0x00U,
+    HAL_ERROR = 0x01U,
+    HAL_BUSY = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+#define HAL_MAX_DELAY 0xFFFFFFFFU
+
+/* GPIO寄存器块，与stm32f103xe.h布局一致 GPIO register block, same layout as stm32f103xe.h */
+typedef struct
+{
+    __IO uint32_t CRL;
+    __IO uint32_t CRH;
+    __IO uint32_t IDR;
+    __IO uint32_t ODR;
+    __IO uint32_t BSRR;
+    __IO uint32_t BRR;
+    __IO uint32_t LCKR;
+} GPIO_TypeDef;
+
+/* 定时器寄存器块，与stm32f103xe.h布局一致 TIM register block, same layout as stm32f103xe.h */
+typedef struct
+{
+    __IO uint32_t CR1;
+    __IO uint32_t CR2;
+    __IO uint32_t SMCR;
+    __IO uint32_t DIER;
+    __IO uint32_t SR;
+    __IO uint32_t EGR;
+    __IO uint32_t CCMR1;
+    __IO uint32_t CCMR2;
+    __IO uint32_t CCER;
+    __IO uint32_t CNT;
+    __IO uint32_t PSC;
+    __IO uint32_t ARR;
+    __IO uint32_t RCR;
+    __IO uint32_t CCR1;
+    __IO uint32_t CCR2;
+    __IO uint32_t CCR3;
+    __IO uint32_t CCR4;
+    __IO uint32_t BDTR;
+    __IO uint32_t DCR;
+    __IO uint32_t DMAR;
+    __IO uint32_t OR;
+} TIM_TypeDef;
+
+#define TIM_CR1_CEN (0x1U << 0)
+#define TIM_CR2_MMS (0x7U << 4)
+#define TIM_SMCR_SMS (0x7U << 0)
+#define TIM_SMCR_TS (0x7U << 4)
+#define TIM_CCMR2_CC3S (0x3U << 0)
+#define TIM_CCMR2_IC3PSC (0x3U << 2)
+#define TIM_CCMR2_IC3F (0xFU << 4)
+#define TIM_CCER_CC3E (0x1U << 8)
+
+/* 假寄存器块，下标即端口号/定时器编号 Fake register blocks, indexed by port / timer number */
+#define SHIM_GPIO_PORTS (7)
+#define SHIM_TIM_COUNT (9)
+extern GPIO_TypeDef Shim_GPIO_Regs[SHIM_GPIO_PORTS];
+extern TIM_TypeDef Shim_TIM_Regs[SHIM_TIM_COUNT];
+
+#define GPIOA (&Shim_GPIO_Regs[0])
+#define GPIOB (&Shim_GPIO_Regs[1])
+#define GPIOC (&Shim_GPIO_Regs[2])
+#define GPIOD (&Shim_GPIO_Regs[3])
+#define GPIOE (&Shim_GPIO_Regs[4])
+#define GPIOF (&Shim_GPIO_Regs[5])
+#define GPIOG (&Shim_GPIO_Regs[6])
+
+#define TIM1 (&Shim_TIM_Regs[1])
+#define TIM2 (&Shim_TIM_Regs[2])
+#define TIM3 (&Shim_TIM_Regs[3])
+#define TIM4 (&Shim_TIM_Regs[4])
+#define TIM5 (&Shim_TIM_Regs[5])
+#define TIM6 (&Shim_TIM_Regs[6])
+#define TIM7 (&Shim_TIM_Regs[7])
+#define TIM8 (&Shim_TIM_Regs[8])
+
+/* GPIO */
+typedef enum
+{
+    GPIO_PIN_RESET = 0u,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+#define GPIO_PIN_0 ((uint16_t)0x0001)
+#define GPIO_PIN_1 ((uint16_t)0x0002)
+#define GPIO_PIN_2 ((uint16_t)0x0004)
+#define GPIO_PIN_3 ((uint16_t)0x0008)
+#define GPIO_PIN_4 ((uint16_t)0x0010)
+#define GPIO_PIN_5 ((uint16_t)0x0020)
+#define GPIO_PIN_6 ((uint16_t)0x0040)
+#define GPIO_PIN_7 ((uint16_t)0x0080)
+#define GPIO_PIN_8 ((uint16_t)0x0100)
+#define GPIO_PIN_9 ((uint16_t)0x0200)
+#define GPIO_PIN_10 ((uint16_t)0x0400)
+#define GPIO_PIN_11 ((uint16_t)0x0800)
+#define GPIO_PIN_12 ((uint16_t)0x1000)
+#define GPIO_PIN_13 ((uint16_t)0x2000)
+#define GPIO_PIN_14 ((uint16_t)0x4000)
+#define GPIO_PIN_15 ((uint16_t)0x8000)
+#define GPIO_PIN_All ((uint16_t)0xFFFF)
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+
+/* TIM */
+#define TIM_CHANNEL_1 0x00000000U
+#define TIM_CHANNEL_2 0x00000004U
+#define TIM_CHANNEL_3 0x00000008U
+#define TIM_CHANNEL_4 0x0000000CU
+#define TIM_CHANNEL_ALL 0x0000003CU
+
+typedef struct
+{
+    uint32_t Prescaler;
+    uint32_t CounterMode;
+    uint32_t Period;
+    uint32_t ClockDivision;
+    uint32_t RepetitionCounter;
+    uint32_t AutoReloadPreload;
+} TIM_Base_InitTypeDef;
+
+typedef struct
+{
+    TIM_TypeDef *Instance;
+    TIM_Base_InitTypeDef Init;
+} TIM_HandleTypeDef;
+
+// 同HAL库 As in the HAL
+#define __HAL_TIM_SET_AUTORELOAD(__HANDLE__, __AUTORELOAD__) \
+    do                                                      \
+    {                                                       \
+        (__HANDLE__)->Instance->ARR = (__AUTORELOAD__);     \
+        (__HANDLE__)->Init.Period = (__AUTORELOAD__);       \
+    } while (0)
+
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef *htim, uint32_t Channel);
+HAL_StatusTypeDef HAL_TIM_Encoder_Start(TIM_HandleTypeDef *htim, uint32_t Channel);
+#define TIM_IT_CC1 0x00000002U
+#define __HAL_TIM_ENABLE_IT(__HANDLE__, __INTERRUPT__) ((__HANDLE__)->Instance->DIER |= (__INTERRUPT__))
+#define __HAL_TIM_DISABLE_IT(__HANDLE__, __INTERRUPT__) ((__HANDLE__)->Instance->DIER &= ~(__INTERRUPT__))
+#define __HAL_TIM_CLEAR_IT(__HANDLE__, __INTERRUPT__) ((__HANDLE__)->Instance->SR = ~(__INTERRUPT__))
+#define TIM_FLAG_UPDATE 0x00000001U
+#define __HAL_TIM_GET_FLAG(__HANDLE__, __FLAG__) (((__HANDLE__)->Instance->SR & (__FLAG__)) == (__FLAG__))
+#define __HAL_TIM_CLEAR_FLAG(__HANDLE__, __FLAG__) ((__HANDLE__)->Instance->SR = ~(__FLAG__))
+
+/* 主从触发 Master/slave triggers */
+#define TIM_TRGO_UPDATE (0x2U << 4)
+#define TIM_TS_ITR0 0x00000000U
+#define TIM_TS_ITR3 0x00000030U
+#define TIM_SLAVEMODE_TRIGGER 0x00000006U
+#define TIM_ICSELECTION_TRC 0x00000003U
+
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim);
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim);
+void HAL_TIM_IC_CaptureCallback(TIM_HandleTypeDef *htim);
+
+/* DWT周期计数器，仿真器按虚拟时间写入CYCCNT DWT cycle counter; the simulator writes CYCCNT from the virtual time */
+typedef struct
+{
+    __IO uint32_t CTRL;
+    __IO uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct
+{
+    __IO uint32_t DEMCR;
+} CoreDebug_Type;
+
+extern DWT_Type Shim_DWT_Regs;
+extern CoreDebug_Type Shim_CoreDebug_Regs;
+
+#define DWT (&Shim_DWT_Regs)
+#define CoreDebug (&Shim_CoreDebug_Regs)
+#define DWT_CTRL_CYCCNTENA_Msk (1UL)
+#define CoreDebug_DEMCR_TRCENA_Msk (1UL << 24)
+
+/* 中断屏蔽，主机上只有仿真器在读操作之间调用中断回调，无需屏蔽
+   Interrupt masking. On the host the simulator only calls the interrupt
+   callback between reads, so there is nothing to mask. */
+static inline uint32_t __get_PRIMASK(void) { return 0u; }
+static inline void __set_PRIMASK(uint32_t primask) { (void)primask; }
+static inline void __disable_irq(void) {}
+static inline void __enable_irq(void) {}
+
+/* Flash，与stm32f103xe.h和HAL库相同；替身把整片512KB映射到主机数组
+   Flash, as in stm32f103xe.h and the HAL; the shim maps the whole 512 KB to a
+   host array */
+#define FLASH_BASE 0x08000000UL
+#define FLASH_BANK1_END 0x0807FFFFUL
+#define FLASH_PAGE_SIZE 0x800U
+#define FLASH_BANK_1 1U
+#define FLASH_TYPEERASE_PAGES 0x00U
+#define FLASH_TYPEPROGRAM_HALFWORD 0x01U
+#define FLASH_TYPEPROGRAM_WORD 0x02U
+
+typedef struct
+{
+    uint32_t TypeErase;
+    uint32_t Banks;
+    uint32_t PageAddress;
+    uint32_t NbPages;
+} FLASH_EraseInitTypeDef;
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void);
+HAL_StatusTypeDef HAL_FLASH_Lock(void);
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t TypeProgram, uint32_t Address, uint64_t Data);
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *pEraseInit, uint32_t *PageError);
+
+// 固件按地址读Flash时经此宏，目标上为直接转换指针 Firmware reads flash by address through this; on the target it is a plain cast
+const void *Shim_Flash_Ptr(uint32_t addr);
+#define FLASH_READ_PTR(addr) Shim_Flash_Ptr(addr)
+
+/* 系统时基 System time base */
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t Delay);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_STM32F1XX_HAL_H_ */
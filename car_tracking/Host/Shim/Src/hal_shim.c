@@ -0,0 +1,378 @@
+/*
+ * hal_shim.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hal_shim.h"
+#include "main.h"
+#include "tim.h"
+
+GPIO_TypeDef Shim_GPIO_Regs[SHIM_GPIO_PORTS];
+TIM_TypeDef Shim_TIM_Regs[SHIM_TIM_COUNT];
+DWT_Type Shim_DWT_Regs;
+CoreDebug_Type Shim_CoreDebug_Regs;
+
+// 与Core/Src/tim.c中的配置保持一致
+// Same configuration as Core/Src/tim.c
+TIM_HandleTypeDef htim1 = {TIM1, {0, 0, 3600 - 1, 0, 0, 0}};
+TIM_HandleTypeDef htim2 = {TIM2, {0, 0, 65535, 0, 0, 0}};
+TIM_HandleTypeDef htim3 = {TIM3, {0, 0, 65535, 0, 0, 0}};
+TIM_HandleTypeDef htim4 = {TIM4, {0, 0, 65535, 0, 0, 0}};
+TIM_HandleTypeDef htim5 = {TIM5, {0, 0, 65535, 0, 0, 0}};
+TIM_HandleTypeDef htim6 = {TIM6, {7199, 0, 99, 0, 0, 0}};
+TIM_HandleTypeDef htim8 = {TIM8, {0, 0, 3600 - 1, 0, 0, 0}};
+
+static uint64_t g_clock_start_us = 0;
+
+// 虚拟时钟：HAL_GetTick、HAL_Delay和TIM6都由它推进，不再等待真实时间
+// Virtual clock: HAL_GetTick, HAL_Delay and TIM6 all advance from it
+// instead of waiting on wall time
+static uint8_t g_clock_virtual = 0;
+static uint64_t g_clock_virtual_us = 0;
+static ShimClockHook_t g_clock_hook = NULL;
+static void *g_clock_hook_ctx = NULL;
+
+static uint64_t Shim_Wall_Us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+/**
+ * @brief  复位所有假寄存器并重新开始计时，时钟钩子被清除，时钟模式保持不变
+ *         Reset all fake registers and restart the clock. The clock hook is
+ *         cleared; the clock mode is kept.
+ * @note   按键引脚按MX_GPIO_Init配置为上拉，复位后为松开状态
+ *         Key pins are pulled up as in MX_GPIO_Init, so they read released
+ */
+void Shim_Reset(void)
+{
+    for (int i = 0; i < SHIM_GPIO_PORTS; i++)
+    {
+        Shim_GPIO_Regs[i] = (GPIO_TypeDef){0};
+    }
+    for (int i = 0; i < SHIM_TIM_COUNT; i++)
+    {
+        Shim_TIM_Regs[i] = (TIM_TypeDef){0};
+        Shim_TIM_Regs[i].ARR = 0xFFFF;
+    }
+    Shim_DWT_Regs = (DWT_Type){0};
+    Shim_CoreDebug_Regs = (CoreDebug_Type){0};
+    KEY_GPIO_Port->IDR |= KEY1_Pin | KEY2_Pin | KEY3_Pin;
+
+    g_clock_start_us = Shim_Wall_Us();
+    g_clock_virtual_us = 0;
+    g_clock_hook = NULL;
+    g_clock_hook_ctx = NULL;
+}
+
+// 设置输入引脚电平（传感器、按键） Drive an input pin (sensors, keys)
+void Shim_GPIO_Set_Input(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state)
+{
+    if (state != GPIO_PIN_RESET)
+        port->IDR |= pin;
+    else
+        port->IDR &= ~(uint32_t)pin;
+}
+
+// 读取固件写出的输出引脚电平（蜂鸣器、LED） Read back an output pin (buzzer, LEDs)
+GPIO_PinState Shim_GPIO_Get_Output(GPIO_TypeDef *port, uint16_t pin)
+{
+    return (port->ODR & pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+// 复位以来的微秒数 Microseconds since Shim_Reset
+uint64_t Shim_Clock_Us(void)
+{
+    if (g_clock_virtual)
+        return g_clock_virtual_us;
+    return Shim_Wall_Us() - g_clock_start_us;
+}
+
+// 选择虚拟时钟(1)或真实时间(0) Select the virtual clock (1) or wall time (0)
+void Shim_Clock_Set_Virtual(uint8_t enable)
+{
+    g_clock_virtual = enable != 0;
+}
+
+void Shim_Clock_Set_Hook(ShimClockHook_t hook, void *ctx)
+{
+    g_clock_hook = hook;
+    g_clock_hook_ctx = ctx;
+}
+
+/**
+ * @brief  推进虚拟时钟并调用钩子；真实时间模式下只调用钩子
+ *         Advance the virtual clock and run the hook. In wall-time mode
+ *         only the hook runs.
+ * @param  us: 前进的微秒数 Microseconds to advance
+ * @retval 无
+ */
+void Shim_Clock_Advance_Us(uint32_t us)
+{
+    if (g_clock_virtual)
+        g_clock_virtual_us += us;
+    if (g_clock_hook != NULL)
+        g_clock_hook(g_clock_hook_ctx);
+}
+
+/**
+ * @brief  模拟TIM6更新中断。固件中TIM6紧跟TIM1更新启动，中断前的那次TIM1/TIM8更新
+ *         把CC3使能的编码器定时器的CNT锁存到CCR3(ENCODER_SYNC_LATCH)
+ *         Emulate the TIM6 update interrupt. The firmware starts TIM6 right
+ *         after a TIM1 update, so the TIM1/TIM8 update just before the
+ *         interrupt latches CNT into CCR3 on the encoder timers with CC3
+ *         enabled (ENCODER_SYNC_LATCH)
+ * @retval 无
+ */
+void Shim_TIM6_Elapsed(void)
+{
+    for (int i = 2; i <= 5; i++)
+    {
+        if (Shim_TIM_Regs[i].CCER & TIM_CCER_CC3E)
+            Shim_TIM_Regs[i].CCR3 = Shim_TIM_Regs[i].CNT;
+    }
+    HAL_TIM_PeriodElapsedCallback(&htim6);
+}
+
+// 把DWT周期计数器设为某时刻的值，72MHz Set the DWT cycle counter to its value at a given time, 72 MHz
+void Shim_Cycles_Set_Us(double us)
+{
+    DWT->CYCCNT = (uint32_t)(uint64_t)(us * SHIM_HCLK_MHZ);
+}
+
+/**
+ * @brief  模拟编码器TI1捕获：CCR1锁存CNT，CC1中断使能时调用捕获回调
+ *         Emulate an encoder TI1 capture: CCR1 latches CNT and the capture
+ *         callback runs when the CC1 interrupt is enabled
+ * @param  htim: 编码器定时器 Encoder timer
+ * @param  us: 沿的时刻，写入DWT周期计数器 Time of the edge, written to the DWT cycle counter
+ * @retval 无
+ */
+void Shim_TIM_Capture(TIM_HandleTypeDef *htim, double us)
+{
+    htim->Instance->CCR1 = htim->Instance->CNT;
+    if (!(htim->Instance->DIER & TIM_IT_CC1))
+        return;
+    Shim_Cycles_Set_Us(us);
+    HAL_TIM_IC_CaptureCallback(htim);
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    return (GPIOx->IDR & GPIO_Pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+    if (PinState != GPIO_PIN_RESET)
+        GPIOx->ODR |= GPIO_Pin;
+    else
+        GPIOx->ODR &= ~(uint32_t)GPIO_Pin;
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    GPIOx->ODR ^= GPIO_Pin;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+    (void)Channel;
+    htim->Instance->ARR = htim->Init.Period;
+    htim->Instance->CR1 |= TIM_CR1_CEN;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Encoder_Start(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+    (void)Channel;
+    htim->Instance->ARR = htim->Init.Period;
+    htim->Instance->CR1 |= TIM_CR1_CEN;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim)
+{
+    htim->Instance->PSC = htim->Init.Prescaler;
+    htim->Instance->ARR = htim->Init.Period;
+    htim->Instance->CR1 |= TIM_CR1_CEN;
+    return HAL_OK;
+}
+
+uint32_t HAL_GetTick(void)
+{
+    return (uint32_t)(Shim_Clock_Us() / 1000u);
+}
+
+// 与HAL库相同，额外等待1个节拍保证最小延时
+// As in the HAL, one extra tick guarantees the minimum wait
+void HAL_Delay(uint32_t Delay)
+{
+    uint32_t tickstart = HAL_GetTick();
+    uint32_t wait = Delay;
+
+    if (wait < HAL_MAX_DELAY)
+    {
+        wait += 1u;
+    }
+
+    // 虚拟时钟下直接前进，期间的TIM6中断和物理步由钩子补上
+    // On the virtual clock just jump ahead; the hook runs the TIM6
+    // interrupts and physics steps that fall inside the delay
+    if (g_clock_virtual)
+    {
+        uint64_t end_us = ((uint64_t)tickstart + wait) * 1000u;
+        if (end_us > g_clock_virtual_us)
+            Shim_Clock_Advance_Us((uint32_t)(end_us - g_clock_virtual_us));
+        return;
+    }
+
+    // 真实时间下边等边让钩子追赶 In wall time let the hook catch up while waiting
+    while ((HAL_GetTick() - tickstart) < wait)
+    {
+        struct timespec ts = {0, 100000};
+        nanosleep(&ts, NULL);
+        Shim_Clock_Advance_Us(0);
+    }
+}
+
+/* Flash：不随Shim_Reset清除，和实物一样跨"上电"保留 Flash survives Shim_Reset, like the real part across power cycles */
+#define SHIM_FLASH_SIZE (FLASH_BANK1_END + 1u - FLASH_BASE)
+#define SHIM_FLASH_PAGES (SHIM_FLASH_SIZE / FLASH_PAGE_SIZE)
+
+static uint8_t g_flash[SHIM_FLASH_SIZE];
+static uint32_t g_flash_erases[SHIM_FLASH_PAGES];
+static uint8_t g_flash_ready = 0;
+static uint8_t g_flash_locked = 1;
+static int32_t g_flash_cut = -1; // 掉电前还能完成的操作数，-1不掉电 Operations left before the power cut, -1 = none
+
+// 又一次编程或擦除，返回0表示已掉电，这次操作被打断 One more program or erase; returns 0 once the power is cut and this operation is interrupted
+static uint8_t Shim_Flash_Powered(void)
+{
+    if (g_flash_cut == -1)
+        return 1;
+    if (g_flash_cut <= 0)
+        return 0;
+    g_flash_cut--;
+    return 1;
+}
+
+static void Shim_Flash_Ready(void)
+{
+    if (!g_flash_ready)
+        Shim_Flash_Blank();
+}
+
+// 整片擦除并清零擦除计数 Erase the whole part and clear the erase counts
+void Shim_Flash_Blank(void)
+{
+    memset(g_flash, 0xFF, sizeof(g_flash));
+    memset(g_flash_erases, 0, sizeof(g_flash_erases));
+    g_flash_ready = 1;
+    g_flash_locked = 1;
+    g_flash_cut = -1;
+}
+
+/**
+ * @brief  模拟掉电：再完成ops次半字编程或页擦除后，之后的操作不再生效，
+ *         掉电时正在擦除的页只擦掉前一半。ops为-1时恢复供电
+ *         Simulate a power cut: after ops more halfword programs or page
+ *         erases, further operations have no effect, and a page being erased
+ *         at the cut loses only its first half. ops = -1 restores power
+ */
+void Shim_Flash_Cut_After(int32_t ops)
+{
+    Shim_Flash_Ready();
+    g_flash_cut = ops;
+}
+
+// 某页被擦除的次数 Number of times a page has been erased
+uint32_t Shim_Flash_Erase_Count(uint32_t page_addr)
+{
+    Shim_Flash_Ready();
+    return g_flash_erases[(page_addr - FLASH_BASE) / FLASH_PAGE_SIZE];
+}
+
+const void *Shim_Flash_Ptr(uint32_t addr)
+{
+    Shim_Flash_Ready();
+    if (addr < FLASH_BASE || addr - FLASH_BASE >= SHIM_FLASH_SIZE)
+        abort();
+    return &g_flash[addr - FLASH_BASE];
+}
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void)
+{
+    g_flash_locked = 0;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Lock(void)
+{
+    g_flash_locked = 1;
+    return HAL_OK;
+}
+
+// 与STM32F1相同，只能对0xFFFF的半字编程(写0除外)，否则PGERR
+// As on the STM32F1, only an erased halfword can be programmed (except with 0), otherwise PGERR
+static HAL_StatusTypeDef Shim_Flash_Halfword(uint32_t addr, uint16_t data)
+{
+    uint8_t *p = (uint8_t *)Shim_Flash_Ptr(addr);
+    uint16_t old = (uint16_t)(p[0] | p[1] << 8);
+
+    if (g_flash_locked || (addr & 1u))
+        return HAL_ERROR;
+    if (!Shim_Flash_Powered())
+        return HAL_OK;
+    if (old != 0xFFFFu && data != 0)
+        return HAL_ERROR;
+    p[0] = (uint8_t)data;
+    p[1] = (uint8_t)(data >> 8);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t TypeProgram, uint32_t Address, uint64_t Data)
+{
+    uint32_t n = TypeProgram == FLASH_TYPEPROGRAM_HALFWORD ? 1u : TypeProgram == FLASH_TYPEPROGRAM_WORD ? 2u : 4u;
+
+    Shim_Flash_Ready();
+    for (uint32_t i = 0; i < n; i++)
+    {
+        HAL_StatusTypeDef ret = Shim_Flash_Halfword(Address + 2u * i, (uint16_t)(Data >> (16u * i)));
+        if (ret != HAL_OK)
+            return ret;
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *pEraseInit, uint32_t *PageError)
+{
+    Shim_Flash_Ready();
+    *PageError = 0xFFFFFFFFu;
+    if (g_flash_locked || pEraseInit->TypeErase != FLASH_TYPEERASE_PAGES)
+        return HAL_ERROR;
+    for (uint32_t i = 0; i < pEraseInit->NbPages; i++)
+    {
+        uint32_t addr = pEraseInit->PageAddress + i * FLASH_PAGE_SIZE;
+        uint8_t *p = (uint8_t *)Shim_Flash_Ptr(addr);
+        if (!Shim_Flash_Powered())
+        {
+            // 掉电时正在擦的页只擦掉一半 The page being erased at the cut is only half erased
+            if (g_flash_cut == 0)
+                memset(p, 0xFF, FLASH_PAGE_SIZE / 2);
+            g_flash_cut = INT32_MIN;
+            return HAL_OK;
+        }
+        memset(p, 0xFF, FLASH_PAGE_SIZE);
+        g_flash_erases[(addr - FLASH_BASE) / FLASH_PAGE_SIZE]++;
+    }
+    return HAL_OK;
+}
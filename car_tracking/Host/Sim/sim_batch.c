@@ -0,0 +1,371 @@
+/*
+ * sim_batch.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim_batch.h"
+#include "bsp.h"
+
+#define FIELDS_PER_WHEEL (12 + PID_USE_2DOF)
+#define FIELDS_PER_CAR (9)
+
+// 按目标速度换算一个轮子的每拍增益，同PID_Sched_Apply的浮点版；目标或增益变化时调用
+// Per-tick gains of one wheel for its target speed, as the float PID_Sched_Apply; called
+// when the target or the gains change
+static void Batch_Schedule(SimBatch_t *batch, int car, int w)
+{
+    uint16_t scale[3] = {256, 256, 256};
+
+#if PID_USE_SCHED
+    PID_Get_Sched_Scale((int16_t)batch->target[w][car], scale);
+#endif
+    // 增益为连续时间单位，同PID_Set_Motor_Parm换算为每拍系数
+    // Gains are in continuous-time units, converted per tick as in PID_Set_Motor_Parm
+    float kp = batch->kp[car] * (scale[0] * (1.0f / 256));
+    float ki = PID_KI_TICK(batch->ki[car]) * (scale[1] * (1.0f / 256));
+    float kd = PID_KD_TICK(batch->kd[car]) * (scale[2] * (1.0f / 256));
+#if PID_USE_2DOF
+    // 同PID2_Set_Gains：微分状态按新Kd缩放，积分补偿比例项和微分项的变化
+    // As PID2_Set_Gains: the D state follows the new Kd, the integral absorbs the change of the P and D terms
+    batch->integral[w][car] += (batch->kp_tick[w][car] - kp) * batch->ep_last[w][car];
+    if (batch->kd_tick[w][car] != 0)
+    {
+        float deriv = batch->deriv[w][car] * (kd / batch->kd_tick[w][car]);
+        batch->integral[w][car] += batch->deriv[w][car] - deriv;
+        batch->deriv[w][car] = deriv;
+    }
+#endif
+    batch->kp_tick[w][car] = kp;
+    batch->ki_tick[w][car] = ki;
+    batch->kd_tick[w][car] = kd;
+}
+
+/**
+ * @brief  为count台车分配SoA状态并复位
+ *         Allocate SoA state for count cars and reset it
+ * @retval 0成功，-1内存不足 0 on success, -1 when out of memory
+ */
+int Sim_Batch_Alloc(SimBatch_t *batch, int count, const SimCarParam_t *param)
+{
+    // 所有数组放在一块内存中，每个按double大小分配并按64字节对齐
+    // All arrays share one block, each sized for doubles and aligned to 64 bytes
+    size_t stride = ((size_t)count * sizeof(double) + 63u) & ~(size_t)63u;
+    size_t fields = FIELDS_PER_WHEEL * SIM_MOTORS + FIELDS_PER_CAR;
+    void *block;
+    if (posix_memalign(&block, 64, stride * fields) != 0)
+        return -1;
+
+    // 增益在复位时就要换算，先全部清零 Gains are rescheduled as early as the reset, so clear everything first
+    memset(block, 0, stride * fields);
+    memset(batch, 0, sizeof(*batch));
+    batch->count = count;
+    batch->param = *param;
+
+    char *p = block;
+#define TAKE(type) ((type *)(p += stride, p - stride))
+    batch->kp = TAKE(float);
+    batch->ki = TAKE(float);
+    batch->kd = TAKE(float);
+    batch->x_mm = TAKE(float);
+    batch->y_mm = TAKE(float);
+    batch->yaw_rad = TAKE(float);
+    batch->heading_x = TAKE(float);
+    batch->heading_y = TAKE(float);
+    batch->iae = TAKE(float);
+    for (int w = 0; w < SIM_MOTORS; w++)
+    {
+        batch->target[w] = TAKE(float);
+        batch->wheel_mm_s[w] = TAKE(float);
+        batch->enc_frac[w] = TAKE(double);
+        batch->enc_delta[w] = TAKE(int32_t);
+        batch->speed_mm_s[w] = TAKE(float);
+        batch->kp_tick[w] = TAKE(float);
+        batch->ki_tick[w] = TAKE(float);
+        batch->kd_tick[w] = TAKE(float);
+#if PID_USE_2DOF
+        batch->integral[w] = TAKE(float);
+        batch->deriv[w] = TAKE(float);
+        batch->ed_last[w] = TAKE(float);
+        batch->ep_last[w] = TAKE(float);
+#else
+        batch->pwm_output[w] = TAKE(float);
+        batch->err_next[w] = TAKE(float);
+        batch->err_last[w] = TAKE(float);
+#endif
+        batch->duty[w] = TAKE(float);
+    }
+#undef TAKE
+
+    Sim_Batch_Reset(batch);
+    for (int i = 0; i < count; i++)
+        Sim_Batch_Set_Gains(batch, i, PID_DEF_KP, PID_DEF_KI, PID_DEF_KD);
+    return 0;
+}
+
+void Sim_Batch_Free(SimBatch_t *batch)
+{
+    free(batch->kp); // 整块内存的起点 Start of the shared block
+    memset(batch, 0, sizeof(*batch));
+}
+
+// 所有车回到原点静止，增益保留 Put every car at rest at the origin; gains are kept
+void Sim_Batch_Reset(SimBatch_t *batch)
+{
+    size_t bytes = (size_t)batch->count * sizeof(float);
+
+    batch->steps = 0;
+    memset(batch->x_mm, 0, bytes);
+    memset(batch->y_mm, 0, bytes);
+    memset(batch->yaw_rad, 0, bytes);
+    memset(batch->heading_y, 0, bytes);
+    memset(batch->iae, 0, bytes);
+    for (int i = 0; i < batch->count; i++)
+        batch->heading_x[i] = 1.0f;
+    for (int w = 0; w < SIM_MOTORS; w++)
+    {
+        memset(batch->target[w], 0, bytes);
+        memset(batch->wheel_mm_s[w], 0, bytes);
+        memset(batch->enc_frac[w], 0, bytes);
+        memset(batch->enc_delta[w], 0, bytes);
+        memset(batch->speed_mm_s[w], 0, bytes);
+#if PID_USE_2DOF
+        memset(batch->integral[w], 0, bytes);
+        memset(batch->deriv[w], 0, bytes);
+        memset(batch->ed_last[w], 0, bytes);
+        memset(batch->ep_last[w], 0, bytes);
+#else
+        memset(batch->pwm_output[w], 0, bytes);
+        memset(batch->err_next[w], 0, bytes);
+        memset(batch->err_last[w], 0, bytes);
+#endif
+        memset(batch->duty[w], 0, bytes);
+    }
+    for (int i = 0; i < batch->count; i++)
+    {
+        for (int w = 0; w < SIM_MOTORS; w++)
+            Batch_Schedule(batch, i, w);
+    }
+}
+
+void Sim_Batch_Set_Gains(SimBatch_t *batch, int car, float kp, float ki, float kd)
+{
+    batch->kp[car] = kp;
+    batch->ki[car] = ki;
+    batch->kd[car] = kd;
+    for (int w = 0; w < SIM_MOTORS; w++)
+        Batch_Schedule(batch, car, w);
+}
+
+// 同Motion_Set_Speed，只改目标，不清PID状态 As Motion_Set_Speed: sets targets, keeps PID state
+void Sim_Batch_Set_Speed(SimBatch_t *batch, int car, int16_t m1, int16_t m2, int16_t m3, int16_t m4)
+{
+    batch->target[0][car] = m1;
+    batch->target[1][car] = m2;
+    batch->target[2][car] = m3;
+    batch->target[3][car] = m4;
+    for (int w = 0; w < SIM_MOTORS; w++)
+        Batch_Schedule(batch, car, w);
+}
+
+// 一个轮子的电机与编码器推进1ms，同Sim_Car_Step
+// Advance one wheel's motor and encoder by 1 ms, as in Sim_Car_Step
+static void Batch_Motor_Step(SimBatch_t *batch, int w, float dt_s)
+{
+    const SimMotorParam_t *m = &batch->param.motor[w];
+    const float counts_per_mm = batch->param.encoder_circle / batch->param.circle_mm;
+    const float alpha = dt_s / (m->tau_s + dt_s);
+    const float max_mm_s = m->max_mm_s;
+    const float dead = m->dead_pulse;
+    const int n = batch->count;
+    const float *restrict duty = batch->duty[w];
+    const float *restrict target = batch->target[w];
+    float *restrict wheel = batch->wheel_mm_s[w];
+    double *restrict frac = batch->enc_frac[w];
+    int32_t *restrict delta = batch->enc_delta[w];
+    float *restrict iae = batch->iae;
+
+#pragma GCC ivdep
+    for (int i = 0; i < n; i++)
+    {
+        // 分支写成选择以便向量化，结果与Sim_Car_Step逐位相同
+        // Branches written as selects so the loop vectorises; bit-identical to Sim_Car_Step
+        float over = fabsf(duty[i]) - dead;
+        over = over > 0 ? over : 0.0f;
+        float drive = over / (MOTOR_MAX_PULSE - dead) * max_mm_s;
+        drive = duty[i] < 0 ? -drive : drive;
+        float v = wheel[i] + (drive - wheel[i]) * alpha;
+        wheel[i] = v;
+
+        // 向下取整写成截断加修正，以便向量化 Floor as truncate-and-fix so it vectorises
+        double pos = frac[i] + v * dt_s * counts_per_mm;
+        double whole = (double)(int32_t)pos;
+        whole -= whole > pos ? 1.0 : 0.0;
+        frac[i] = pos - whole;
+        delta[i] += (int32_t)whole;
+
+        iae[i] += fabsf(target[i] - v) * dt_s;
+    }
+}
+
+// 一个轮子的TIM6中断：测速、速度环PID、摩擦前馈和限幅，同Motion_Handle
+// TIM6 interrupt for one wheel: speed measurement, speed-loop PID, friction
+// feedforward and limiting, as in Motion_Handle
+static void Batch_Motor_Control(SimBatch_t *batch, int w)
+{
+    const float circle_mm = batch->param.circle_mm;
+    const float circle_pulse = batch->param.encoder_circle;
+    const int n = batch->count;
+    const float *restrict kp = batch->kp_tick[w];
+    const float *restrict ki = batch->ki_tick[w];
+    const float *restrict kd = batch->kd_tick[w];
+    const float *restrict target = batch->target[w];
+    int32_t *restrict delta = batch->enc_delta[w];
+    float *restrict speed = batch->speed_mm_s[w];
+    float *restrict duty = batch->duty[w];
+#if PID_USE_2DOF
+    // 设定值权重、微分滤波和跟踪时间取app_tune.h的默认值，同PID_Param_Init
+    // Setpoint weights, derivative filter and tracking time at their app_tune.h defaults, as PID_Param_Init
+    const float tf = PID_S_TICKS(PID_DEF_TF);
+    const float tt = PID_S_TICKS(PID_DEF_TT);
+    const float alpha = tf > 0 ? tf / (tf + 1.0f) : 0.0f;
+    const float kt = tt > 0 ? 1.0f / tt : 0.0f;
+    // 复位后第一拍不算微分，同PID2_t.first No derivative on the first tick after a reset, as PID2_t.first
+    const int first = batch->steps == SIM_BATCH_ISR_STEPS;
+    float *restrict integral = batch->integral[w];
+    float *restrict deriv = batch->deriv[w];
+    float *restrict ed_last = batch->ed_last[w];
+    float *restrict ep_last = batch->ep_last[w];
+#else
+    const float out_max = MOTOR_PID_LIMIT;
+    float *restrict out = batch->pwm_output[w];
+    float *restrict err_next = batch->err_next[w];
+    float *restrict err_last = batch->err_last[w];
+#endif
+
+#pragma GCC ivdep
+    for (int i = 0; i < n; i++)
+    {
+        float s = (float)(delta[i] * CTRL_RATE_HZ) * circle_mm / circle_pulse;
+        delta[i] = 0;
+        speed[i] = s;
+
+        // Motor_Friction_Init的默认摩擦前馈(按目标方向) The Motor_Friction_Init default feedforward for the target direction
+        float bias = (target[i] > 0 ? (float)MOTOR_IGNORE_PULSE : 0.0f) - (target[i] < 0 ? (float)MOTOR_IGNORE_PULSE : 0.0f);
+
+        // 增益已按目标速度调度并换算为每拍系数 Gains are already scheduled and per tick
+#if PID_USE_2DOF
+        // 同PID2_Calc，输出限在前馈之外的PWM余量内 As PID2_Calc, limited to the PWM left over by the feedforward
+        float err = target[i] - s;
+        float ep = PID_DEF_B * target[i] - s;
+        float ed = PID_DEF_C * target[i] - s;
+        float ed_prev = first ? ed : ed_last[i];
+        float d = alpha * deriv[i] + (1.0f - alpha) * kd[i] * (ed - ed_prev);
+        float in = integral[i] + ki[i] * err;
+        float v = kp[i] * ep + in + d;
+        float hi = MOTOR_MAX_PULSE - bias;
+        float lo = -MOTOR_MAX_PULSE - bias;
+        float o = v > hi ? hi : v;
+        o = o < lo ? lo : o;
+        in += ki[i] != 0 ? kt * (o - v) : 0.0f;
+        in = in > hi ? hi : in;
+        in = in < lo ? lo : in;
+        integral[i] = in;
+        deriv[i] = d;
+        ed_last[i] = ed;
+        ep_last[i] = ep;
+#else
+        float err = target[i] - s;
+        // 增量先求和再累加，与PID_Incre_Calc的运算顺序一致 The increment is summed first, in PID_Incre_Calc's order
+        float o = out[i] + (kp[i] * (err - err_next[i]) + ki[i] * err +
+                            kd[i] * (err - 2 * err_next[i] + err_last[i]));
+        o = o > out_max ? out_max : o;
+        o = o < -out_max ? -out_max : o;
+        // 同PID_Motor_Step，再限在前馈之外的PWM余量内 As PID_Motor_Step, then within the PWM left by the feedforward
+        float hi = MOTOR_MAX_PULSE - bias;
+        float lo = -MOTOR_MAX_PULSE - bias;
+        o = o > hi ? hi : o;
+        o = o < lo ? lo : o;
+        out[i] = o;
+        err_last[i] = err_next[i];
+        err_next[i] = err;
+#endif
+
+        // 按int16_t截断，加上前馈，再由Motor_Set_Duty限幅
+        // Truncated to int16_t, plus the feedforward, then limited as in Motor_Set_Duty
+        float pulse = (float)(int32_t)o + bias;
+        pulse = pulse > MOTOR_MAX_PULSE ? MOTOR_MAX_PULSE : pulse;
+        pulse = pulse < -MOTOR_MAX_PULSE ? -MOTOR_MAX_PULSE : pulse;
+        duty[i] = pulse;
+    }
+}
+
+// 差速位姿积分，同Sim_Car_Step。航向保存为单位向量，每步按小角度旋转，
+// 以免逐车调用sinf/cosf阻碍向量化；每步角度误差约为dθ^4/384
+// Differential pose integration as in Sim_Car_Step. The heading is kept as a
+// unit vector rotated by a small angle each step, so no per-car sinf/cosf
+// call blocks vectorisation; the angle error is about dθ^4/384 per step
+static void Batch_Pose_Step(SimBatch_t *batch, float dt_s)
+{
+    const float k_w = batch->param.yaw_gain / (2.0f * batch->param.apb_mm);
+    const int n = batch->count;
+    const float *restrict m1 = batch->wheel_mm_s[MOTOR_ID_M1];
+    const float *restrict m2 = batch->wheel_mm_s[MOTOR_ID_M2];
+    const float *restrict m3 = batch->wheel_mm_s[MOTOR_ID_M3];
+    const float *restrict m4 = batch->wheel_mm_s[MOTOR_ID_M4];
+    float *restrict x = batch->x_mm;
+    float *restrict y = batch->y_mm;
+    float *restrict yaw = batch->yaw_rad;
+    float *restrict hx = batch->heading_x;
+    float *restrict hy = batch->heading_y;
+
+#pragma GCC ivdep
+    for (int i = 0; i < n; i++)
+    {
+        float v_l = (m1[i] + m2[i]) * 0.5f;
+        float v_r = (m3[i] + m4[i]) * 0.5f;
+        float v = (v_l + v_r) * 0.5f;
+        float d = (v_r - v_l) * k_w * dt_s;
+
+        // 半步旋转 Half-step rotation: cos(d/2), sin(d/2)
+        float c = 1.0f - d * d * 0.125f;
+        float s = d * 0.5f - d * d * d * (1.0f / 48.0f);
+        float mx = hx[i] * c - hy[i] * s;
+        float my = hy[i] * c + hx[i] * s;
+        x[i] += v * mx * dt_s;
+        y[i] += v * my * dt_s;
+        hx[i] = mx * c - my * s;
+        hy[i] = my * c + mx * s;
+        yaw[i] += d;
+    }
+}
+
+/**
+ * @brief  所有车推进1ms，每SIM_BATCH_ISR_STEPS步运行一次速度环
+ *         Advance every car by 1 ms, running the speed loop every
+ *         SIM_BATCH_ISR_STEPS steps
+ * @note   顺序同Sim_Board_Sync：先推进物理，再在周期边界触发中断
+ *         Same order as Sim_Board_Sync: physics first, then the interrupt
+ *         on the period boundary
+ * @retval 无
+ */
+void Sim_Batch_Step(SimBatch_t *batch)
+{
+    const float dt_s = 1e-3f;
+
+    for (int w = 0; w < SIM_MOTORS; w++)
+        Batch_Motor_Step(batch, w, dt_s);
+    Batch_Pose_Step(batch, dt_s);
+
+    batch->steps++;
+    if (batch->steps % SIM_BATCH_ISR_STEPS == 0)
+    {
+        for (int w = 0; w < SIM_MOTORS; w++)
+            Batch_Motor_Control(batch, w);
+    }
+}
@@ -0,0 +1,73 @@
+/*
+ * sim_batch.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * 批量仿真核：以结构数组(SoA)布局同时推进N台小车的电机、编码器、
+ * 速度环PID和位姿，内层循环按车连续存取，便于编译器向量化。
+ * 速度环与Encoder_Update_Count/Motion_Get_Speed/PID2_Calc(PID_USE_2DOF为0时
+ * PID_Incre_Calc)/Motor_Friction_FF逐步等价，底盘模型与Sim_Car_Step相同；不运行巡线等应用层代码。
+ * Batch simulation kernel: steps the motors, encoders, speed-loop PID and
+ * pose of N cars at once in structure-of-arrays layout, with inner loops
+ * running over contiguous per-car arrays so the compiler can vectorise them.
+ * The speed loop matches Encoder_Update_Count/Motion_Get_Speed/PID2_Calc
+ * (PID_Incre_Calc with PID_USE_2DOF at 0)/Motor_Friction_FF step for step
+ * and the chassis model is the one in Sim_Car_Step; application code such as
+ * line following is not run.
+ * 不使用SimImperfect_t中的非理想因素。
+ * The SimImperfect_t imperfections are not applied.
+ */
+
+#ifndef HOST_SIM_BATCH_H_
+#define HOST_SIM_BATCH_H_
+
+#include "app_tune.h"
+#include "sim_car.h"
+
+#define SIM_BATCH_ISR_STEPS (CTRL_PERIOD_MS) // TIM6周期内的物理步数 Physics steps per TIM6 period
+
+typedef struct
+{
+    int count;
+    SimCarParam_t param; // 所有车共用的底盘参数 Chassis parameters shared by all cars
+    uint32_t steps;      // 已推进的1ms步数 1 ms steps taken so far
+
+    // 每车增益 Per-car gains
+    float *kp, *ki, *kd;
+
+    // 每轮一组长度为count的数组 One count-long array per wheel
+    float *target[SIM_MOTORS];    // PID目标，即Motion_Set_Speed PID target, as Motion_Set_Speed
+    float *wheel_mm_s[SIM_MOTORS];// 实际轮速 True wheel speed
+    double *enc_frac[SIM_MOTORS];  // 未满一个计数的编码器位置 Encoder position below one count
+    int32_t *enc_delta[SIM_MOTORS];// 本周期累计计数 Counts this TIM6 period
+    float *speed_mm_s[SIM_MOTORS];// 固件测得速度 Speed measured by the firmware
+    float *kp_tick[SIM_MOTORS];   // 按目标速度调度后的每拍增益 Per-tick gains scheduled for the target speed
+    float *ki_tick[SIM_MOTORS];
+    float *kd_tick[SIM_MOTORS];
+#if PID_USE_2DOF
+    float *integral[SIM_MOTORS];  // PID2_t状态 PID2_t state
+    float *deriv[SIM_MOTORS];
+    float *ed_last[SIM_MOTORS];
+    float *ep_last[SIM_MOTORS];
+#else
+    float *pwm_output[SIM_MOTORS];// PID_t状态 PID_t state
+    float *err_next[SIM_MOTORS];
+    float *err_last[SIM_MOTORS];
+#endif
+    float *duty[SIM_MOTORS];      // 施加的PWM，正为前进 Applied PWM, positive = forward
+
+    float *x_mm, *y_mm, *yaw_rad;
+    float *heading_x, *heading_y; // 航向单位向量 Heading as a unit vector
+    float *iae;                   // 各轮|目标-实际|积分 Integral of |target - wheel| over wheels, mm
+} SimBatch_t;
+
+int Sim_Batch_Alloc(SimBatch_t *batch, int count, const SimCarParam_t *param);
+void Sim_Batch_Free(SimBatch_t *batch);
+void Sim_Batch_Reset(SimBatch_t *batch);
+// 单位同PID_Set_Motor_Parm：ki为1/s，kd为s Units as in PID_Set_Motor_Parm: ki per second, kd in seconds
+void Sim_Batch_Set_Gains(SimBatch_t *batch, int car, float kp, float ki, float kd);
+void Sim_Batch_Set_Speed(SimBatch_t *batch, int car, int16_t m1, int16_t m2, int16_t m3, int16_t m4);
+void Sim_Batch_Step(SimBatch_t *batch);
+
+#endif /* HOST_SIM_BATCH_H_ */
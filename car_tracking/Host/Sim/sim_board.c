@@ -0,0 +1,231 @@
+/*
+ * sim_board.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "sim_board.h"
+#include "hal_shim.h"
+#include "bsp.h"
+
+// 按车体位姿采样四路传感器，加噪声和迟滞，得到延迟之前的读数
+// Sample the four sensors at the current pose with noise and hysteresis, giving the reading before latency
+static uint8_t Sim_Board_Sample_Sensors(SimBoard_t *board)
+{
+    SimCar_t *car = &board->car;
+    const SimCarParam_t *p = &car->param;
+    const SimImperfect_t *imp = &p->imperfect;
+    double c = cos(car->yaw_rad), s = sin(car->yaw_rad);
+    uint8_t raw = 0;
+
+    if (board->track == NULL)
+        return 0;
+    for (int i = 0; i < SIM_SENSORS; i++)
+    {
+        int bit = SIM_SENSORS - 1 - i;
+        double x = car->x_mm + p->sensor_ahead_mm * c - p->sensor_left_mm[i] * s;
+        double y = car->y_mm + p->sensor_ahead_mm * s + p->sensor_left_mm[i] * c;
+        uint8_t level = Sim_Track_Sample(board->track, x, y);
+        uint8_t on_line;
+        if (imp->ir_noise > 0 || imp->ir_hysteresis > 0)
+        {
+            // 已在线上时阈值上移，需更白才离线 Once on the line the threshold moves up, so leaving needs a whiter reading
+            float threshold = p->sensor_threshold;
+            threshold += (board->sensor_raw >> bit & 1) ? imp->ir_hysteresis : -imp->ir_hysteresis;
+            on_line = level + imp->ir_noise * Sim_Car_Gauss(car) < threshold;
+        }
+        else
+        {
+            on_line = level < p->sensor_threshold;
+        }
+        raw |= on_line << bit;
+    }
+    return raw;
+}
+
+// 读数经过延迟后写入GPIO输入寄存器 Pass the reading through the latency and drive the GPIO inputs
+static void Sim_Board_Update_Sensors(SimBoard_t *board)
+{
+    static GPIO_TypeDef *const port[SIM_SENSORS] = {X1_GPIO_Port, X2_GPIO_Port, X3_GPIO_Port, X4_GPIO_Port};
+    static const uint16_t pin[SIM_SENSORS] = {X1_Pin, X2_Pin, X3_Pin, X4_Pin};
+    uint32_t delay = board->car.param.imperfect.ir_latency_us / SIM_STEP_US;
+    if (delay >= SIM_SENSOR_HIST)
+        delay = SIM_SENSOR_HIST - 1;
+
+    board->sensor_raw = Sim_Board_Sample_Sensors(board);
+    board->sensor_hist[board->sensor_head % SIM_SENSOR_HIST] = board->sensor_raw;
+    uint8_t status = board->sensor_hist[(board->sensor_head - delay) % SIM_SENSOR_HIST];
+    board->sensor_head++;
+
+    for (int i = 0; i < SIM_SENSORS; i++)
+    {
+        uint8_t on_line = status >> (SIM_SENSORS - 1 - i) & 1;
+        Shim_GPIO_Set_Input(port[i], pin[i], on_line ? GPIO_PIN_SET : GPIO_PIN_RESET);
+    }
+    board->sensor_status = status;
+}
+
+/**
+ * @brief  本步内每个TI1上升沿(编码器位置跨过ENCODER_MT_EDGE_COUNTS的整数倍)触发一次
+ *         输入捕获，沿的时刻在步内线性插值
+ *         Fire one input capture per TI1 rising edge in this step (the encoder
+ *         position crossing a multiple of ENCODER_MT_EDGE_COUNTS), with the
+ *         edge time interpolated linearly within the step
+ * @note   只有打开M/T测速的电机使能了CC1中断，其余只更新CCR1
+ *         Only motors with M/T estimation enable the CC1 interrupt; the rest
+ *         just update CCR1
+ * @retval 无
+ */
+static void Sim_Board_Capture(SimBoard_t *board)
+{
+    TIM_HandleTypeDef *htim[SIM_MOTORS] = {&htim4, &htim2, &htim5, &htim3};
+    const SimCar_t *car = &board->car;
+    const double edge = ENCODER_MT_EDGE_COUNTS;
+
+    for (int i = 0; i < SIM_MOTORS; i++)
+    {
+        double p0 = car->enc_prev[i], p1 = car->enc_pos[i];
+        double e0 = floor(p0 / edge), e1 = floor(p1 / edge);
+        if (e0 == e1)
+            continue;
+
+        // 正转时跨过(e0, e1]，反转时跨过(e1, e0] Forward crosses (e0, e1], reverse (e1, e0]
+        double dir = e1 > e0 ? 1.0 : -1.0;
+        for (double e = dir > 0 ? e0 + 1 : e0; dir > 0 ? e <= e1 : e > e1; e += dir)
+        {
+            double frac = (e * edge - p0) / (p1 - p0);
+            Shim_TIM_Capture(htim[i], board->now_us + frac * SIM_STEP_US);
+        }
+    }
+}
+
+// 一个物理步：底盘运动，编码器捕获，传感器采样 One physics step: move the chassis, encoder captures, sensor sampling
+static void Sim_Board_Physics(SimBoard_t *board)
+{
+    Sim_Car_Step(&board->car, SIM_STEP_US * 1e-6f);
+    Sim_Board_Capture(board);
+    Sim_Board_Update_Sensors(board);
+    board->now_us += SIM_STEP_US;
+}
+
+static void Sim_Board_Clock_Hook(void *ctx)
+{
+    Sim_Board_Sync((SimBoard_t *)ctx);
+}
+
+/**
+ * @brief  复位HAL替身和底盘模型，不挂时钟也不初始化固件
+ *         Reset the shim and the chassis model without hooking the clock or
+ *         initialising the firmware
+ * @note   指令级仿真(sim_fil)用它单独驱动底盘，由仿真的固件自己初始化
+ *         The instruction-level simulation (sim_fil) drives the chassis on
+ *         its own this way and lets the emulated firmware initialise itself
+ * @param  param: 底盘参数 Chassis parameters
+ * @retval 无
+ */
+void Sim_Board_Reset(SimBoard_t *board, const SimCarParam_t *param)
+{
+    Shim_Reset();
+    Sim_Car_Init(&board->car, param, 0.0, 0.0, 0.0);
+    board->track = NULL;
+    board->sensor_status = 0;
+    board->sensor_raw = 0;
+    memset(board->sensor_hist, 0, sizeof(board->sensor_hist));
+    board->sensor_head = 0;
+    board->now_us = 0;
+    board->next_isr_us = SIM_TIM6_US;
+    board->isr_count = 0;
+    board->loop_us = SIM_LOOP_US;
+    board->on_step = NULL;
+    board->on_step_ctx = NULL;
+}
+
+/**
+ * @brief  复位HAL替身并上电初始化固件，仿真挂到HAL时钟上
+ *         Reset the shim, hook the simulation to the HAL clock and run the
+ *         firmware power-on init
+ * @param  param: 底盘参数 Chassis parameters
+ * @retval 无
+ */
+void Sim_Board_Init(SimBoard_t *board, const SimCarParam_t *param)
+{
+    Sim_Board_Reset(board, param);
+    Shim_Clock_Set_Hook(Sim_Board_Clock_Hook, board);
+
+    BSP_Init();
+}
+
+// 把小车放到赛道起点 Place the car at the track start pose
+void Sim_Board_Set_Track(SimBoard_t *board, const SimTrack_t *track)
+{
+    board->track = track;
+    board->car.x_mm = track->start_x;
+    board->car.y_mm = track->start_y;
+    board->car.yaw_rad = track->start_heading;
+
+    // 延迟缓冲以起点读数填满 Fill the latency buffer with the reading at the start
+    board->sensor_raw = Sim_Board_Sample_Sensors(board);
+    memset(board->sensor_hist, board->sensor_raw, sizeof(board->sensor_hist));
+    Sim_Board_Update_Sensors(board);
+}
+
+/**
+ * @brief  以固定步长把仿真推进到当前HAL时钟，途中按时触发TIM6中断
+ *         Step the simulation up to the current HAL clock in fixed steps,
+ *         firing TIM6 on schedule along the way
+ * @note   由时钟钩子在每遍主循环之后和HAL_Delay期间调用，中断只在这些时刻发生
+ *         Called from the clock hook after each main-loop pass and inside
+ *         HAL_Delay; interrupts only land at those points
+ * @retval 无
+ */
+void Sim_Board_Sync(SimBoard_t *board)
+{
+    uint64_t target_us = Shim_Clock_Us();
+
+    while (board->now_us + SIM_STEP_US <= target_us)
+    {
+        Sim_Board_Physics(board);
+
+        if (board->now_us >= board->next_isr_us)
+        {
+            board->next_isr_us += SIM_TIM6_US;
+            board->isr_count++;
+            Shim_Cycles_Set_Us(board->now_us);
+            Shim_TIM6_Elapsed();
+        }
+
+        if (board->on_step != NULL)
+            board->on_step(board, board->on_step_ctx);
+    }
+}
+
+/**
+ * @brief  推进一个物理步但不触发中断，中断由调用者自己的定时器模型产生
+ *         Advance one physics step without firing TIM6; the caller's own
+ *         timer model raises the interrupt
+ * @retval 无
+ */
+void Sim_Board_Step(SimBoard_t *board)
+{
+    Sim_Board_Physics(board);
+    if (board->on_step != NULL)
+        board->on_step(board, board->on_step_ctx);
+}
+
+/**
+ * @brief  跑一遍主循环并让时钟前进loop_us
+ *         Run one main-loop pass and advance the clock by loop_us
+ * @note   虚拟时钟下仿真不受真实时间限制；真实时间模式下只追赶到当前时刻
+ *         On the virtual clock this runs as fast as the host allows; in
+ *         wall-time mode it only catches up with the present
+ * @retval 无
+ */
+void Sim_Board_Pass(SimBoard_t *board)
+{
+    BSP_Loop();
+    Shim_Clock_Advance_Us(board->loop_us);
+}
@@ -0,0 +1,54 @@
+/*
+ * sim_board.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * 仿真主板：把底盘模型接到HAL替身的寄存器上，并按CTRL_PERIOD_MS节拍触发
+ * TIM6中断，使真实的Motion_Handle/PID代码闭环运行。
+ * Simulated board: wires the chassis model to the shim registers and
+ * fires the TIM6 interrupt every CTRL_PERIOD_MS, closing the loop through
+ * the real Motion_Handle/PID code.
+ */
+
+#ifndef HOST_SIM_BOARD_H_
+#define HOST_SIM_BOARD_H_
+
+#include "app_tune.h"
+#include "sim_car.h"
+#include "sim_track.h"
+
+#define SIM_STEP_US (1000u)
+#define SIM_TIM6_US (CTRL_PERIOD_MS * 1000u) // 与固件的TIM6周期相同 Same as the firmware TIM6 period
+#define SIM_LOOP_US (50u) // 默认主循环一遍的耗时 Default cost of one main-loop pass
+#define SIM_SENSOR_HIST (64) // 传感器延迟缓冲，按物理步 Sensor latency buffer, in physics steps
+
+typedef struct _sim_board SimBoard_t;
+
+// 每个物理步之后调用，用于采集指标 Called after every physics step, e.g. to collect metrics
+typedef void (*SimStepHook_t)(SimBoard_t *board, void *ctx);
+
+struct _sim_board
+{
+    SimCar_t car;
+    const SimTrack_t *track; // 可为NULL，此时传感器全为0 May be NULL, sensors then read 0
+    uint8_t sensor_status;   // 当前X1..X4电平，位序同get_sensor_status Current X1..X4, bits as get_sensor_status
+    uint8_t sensor_raw;      // 延迟之前的读数，也是迟滞的状态 Reading before latency, also the hysteresis state
+    uint8_t sensor_hist[SIM_SENSOR_HIST];
+    uint32_t sensor_head;
+    uint64_t now_us;      // 已仿真到的时刻 Time simulated so far
+    uint64_t next_isr_us; // 下一次TIM6中断时刻 Next TIM6 interrupt
+    uint32_t isr_count;
+    uint32_t loop_us;          // 每遍BSP_Loop推进的虚拟时间 Virtual time per BSP_Loop pass
+    SimStepHook_t on_step;
+    void *on_step_ctx;
+};
+
+void Sim_Board_Reset(SimBoard_t *board, const SimCarParam_t *param);
+void Sim_Board_Init(SimBoard_t *board, const SimCarParam_t *param);
+void Sim_Board_Set_Track(SimBoard_t *board, const SimTrack_t *track);
+void Sim_Board_Sync(SimBoard_t *board);
+void Sim_Board_Step(SimBoard_t *board);
+void Sim_Board_Pass(SimBoard_t *board);
+
+#endif /* HOST_SIM_BOARD_H_ */
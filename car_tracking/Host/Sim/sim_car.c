@@ -0,0 +1,287 @@
+/*
+ * sim_car.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "sim_car.h"
+#include "bsp.h"
+
+// 默认参数按450RPM电机和实车尺寸估计
+// Defaults estimated from the 450 RPM motors and the real chassis
+void Sim_Car_Default_Param(SimCarParam_t *param)
+{
+    for (int i = 0; i < SIM_MOTORS; i++)
+    {
+        param->motor[i].max_mm_s = 1400.0f;
+        param->motor[i].dead_pulse = 1800.0f;
+        param->motor[i].tau_s = 0.08f;
+        param->motor[i].brake_tau_s = 0.03f;
+    }
+    param->circle_mm = MECANUM_CIRCLE_MM;
+    param->encoder_circle = ENCODER_CIRCLE_450;
+    param->apb_mm = STM32Car_APB;
+    param->yaw_gain = 1.0f;
+
+    // car_irtrack遇0x08(仅X1)向右转，故X1在最右，X4在最左
+    // car_irtrack turns right on 0x08 (X1 only), so X1 is rightmost and X4 leftmost
+    param->sensor_ahead_mm = 100.0f;
+    param->sensor_left_mm[0] = -24.0f;
+    param->sensor_left_mm[1] = -8.0f;
+    param->sensor_left_mm[2] = 8.0f;
+    param->sensor_left_mm[3] = 24.0f;
+    param->sensor_threshold = 128;
+
+    // 理想模型；电池参数按2S锂电池和520电机填好，设置内阻后生效
+    // Ideal model; battery values are for a 2S Li-ion pack and 520 motors and take effect once a resistance is set
+    memset(&param->imperfect, 0, sizeof(param->imperfect));
+    param->imperfect.batt_v_full = 8.4f;
+    param->imperfect.batt_v_empty = 6.6f;
+    param->imperfect.batt_v_cal = 8.4f;
+    param->imperfect.batt_mah = 2200.0f;
+    param->imperfect.batt_soc = 1.0f;
+    param->imperfect.motor_r_ohm = 2.5f;
+    param->imperfect.seed = 1;
+}
+
+/**
+ * @brief  按名称叠加一组非理想因素，多个名称用逗号分隔，按顺序应用
+ *         Apply named imperfection profiles, comma separated, in order
+ * @note   ideal  恢复理想模型 back to the ideal model
+ *         noisy  传感器噪声、迟滞、2ms延迟和丢计数 sensor noise, hysteresis, 2 ms latency and lost counts
+ *         coarse 编码器按单倍频计数 encoders decoded x1 instead of x4
+ *         asym   M1..M4增益和死区不一致 uneven gain and dead band across M1..M4
+ *         sag    满电但有负载压降 full battery with sag under load
+ *         tired  电量15%且有压降，即任务4跑完时 15% charge with sag, as at the end of Task4
+ *         worst  noisy+asym+tired
+ * @retval 0成功，-1有未知名称 0 on success, -1 on an unknown name
+ */
+int Sim_Car_Apply_Profile(SimCarParam_t *param, const char *names)
+{
+    static const float gain[SIM_MOTORS] = {1.00f, 0.94f, 1.04f, 0.90f};
+    static const float dead[SIM_MOTORS] = {1800.0f, 1900.0f, 1750.0f, 1950.0f};
+    SimImperfect_t *imp = &param->imperfect;
+    const char *p = names;
+
+    while (*p)
+    {
+        size_t n = strcspn(p, ",");
+        char name[16] = {0};
+        if (n >= sizeof(name))
+            return -1;
+        memcpy(name, p, n);
+        p += n + (p[n] == ',');
+
+        int worst = strcmp(name, "worst") == 0;
+        if (strcmp(name, "ideal") == 0)
+        {
+            Sim_Car_Default_Param(param);
+            continue;
+        }
+        if (worst || strcmp(name, "noisy") == 0)
+        {
+            imp->ir_noise = 30.0f;
+            imp->ir_hysteresis = 10.0f;
+            imp->ir_latency_us = 2000;
+            imp->enc_miss_prob = 0.005f;
+        }
+        if (strcmp(name, "coarse") == 0)
+        {
+            imp->enc_step = 4;
+        }
+        if (worst || strcmp(name, "asym") == 0)
+        {
+            for (int i = 0; i < SIM_MOTORS; i++)
+            {
+                param->motor[i].max_mm_s *= gain[i];
+                param->motor[i].dead_pulse = dead[i];
+            }
+        }
+        if (strcmp(name, "sag") == 0)
+        {
+            imp->batt_r_ohm = 0.25f;
+        }
+        if (worst || strcmp(name, "tired") == 0)
+        {
+            imp->batt_r_ohm = 0.35f;
+            imp->batt_soc = 0.15f;
+        }
+        if (!worst && strcmp(name, "noisy") && strcmp(name, "coarse") && strcmp(name, "asym") &&
+            strcmp(name, "sag") && strcmp(name, "tired"))
+            return -1;
+    }
+    return 0;
+}
+
+void Sim_Car_Init(SimCar_t *car, const SimCarParam_t *param, double x_mm, double y_mm, double yaw_rad)
+{
+    const SimImperfect_t *imp = &param->imperfect;
+
+    *car = (SimCar_t){0};
+    car->param = *param;
+    car->x_mm = x_mm;
+    car->y_mm = y_mm;
+    car->yaw_rad = yaw_rad;
+    car->batt_soc = imp->batt_soc;
+    car->batt_v = imp->batt_v_empty + (imp->batt_v_full - imp->batt_v_empty) * imp->batt_soc;
+    car->rng = imp->seed ? imp->seed : 1;
+}
+
+// xorshift32，结果在[0,1) xorshift32, result in [0,1)
+static float Sim_Car_Rand(SimCar_t *car)
+{
+    car->rng ^= car->rng << 13;
+    car->rng ^= car->rng >> 17;
+    car->rng ^= car->rng << 5;
+    return (car->rng >> 8) * (1.0f / 16777216.0f);
+}
+
+// 标准正态噪声，供传感器模型使用 Standard normal noise for the sensor model
+float Sim_Car_Gauss(SimCar_t *car)
+{
+    float u = 1.0f - Sim_Car_Rand(car), v = Sim_Car_Rand(car);
+    return sqrtf(-2.0f * logf(u)) * cosf(6.2831853f * v);
+}
+
+// 从PWM寄存器读回占空比，方向与Motor_Set_Pwm一致：M1/M2前进时B路输出，M3/M4前进时A路输出
+// Read duty back from the PWM registers. Matches Motor_Set_Pwm: M1/M2 drive
+// the B leg when going forward, M3/M4 drive the A leg.
+static void Sim_Car_Read_Pwm(SimCar_t *car)
+{
+    uint32_t a[SIM_MOTORS] = {PWM_M1_A, PWM_M2_A, PWM_M3_A, PWM_M4_A};
+    uint32_t b[SIM_MOTORS] = {PWM_M1_B, PWM_M2_B, PWM_M3_B, PWM_M4_B};
+
+    for (int i = 0; i < SIM_MOTORS; i++)
+    {
+        car->brake[i] = (a[i] >= MOTOR_MAX_PULSE && b[i] >= MOTOR_MAX_PULSE);
+        if (i < MOTOR_ID_M3)
+            car->duty[i] = (float)b[i] - (float)a[i];
+        else
+            car->duty[i] = (float)a[i] - (float)b[i];
+    }
+}
+
+// 把编码器整数计数推到对应定时器，方向与Encoder_Update_Count一致
+// Push whole encoder counts into the timers, signs as in Encoder_Update_Count
+static void Sim_Car_Write_Encoder(SimCar_t *car)
+{
+    TIM_TypeDef *tim[SIM_MOTORS] = {TIM4, TIM2, TIM5, TIM3};
+    const SimImperfect_t *imp = &car->param.imperfect;
+    int32_t step = imp->enc_step > 1 ? imp->enc_step : 1;
+
+    for (int i = 0; i < SIM_MOTORS; i++)
+    {
+        int32_t count = (int32_t)floor(car->enc_pos[i] / step) * step;
+        int32_t delta = count - car->enc_count[i];
+        if (delta == 0)
+            continue;
+        car->enc_count[i] = count;
+
+        // 丢失的计数不再补回 Lost counts are never recovered
+        if (imp->enc_miss_prob > 0)
+        {
+            int32_t lost = 0;
+            for (int32_t k = delta < 0 ? -delta : delta; k > 0; k--)
+                lost += Sim_Car_Rand(car) < imp->enc_miss_prob;
+            delta += delta < 0 ? lost : -lost;
+        }
+        if (i < MOTOR_ID_M3)
+            tim[i]->CNT = (tim[i]->CNT + (uint32_t)delta) & 0xFFFF;
+        else
+            tim[i]->CNT = (tim[i]->CNT - (uint32_t)delta) & 0xFFFF;
+    }
+}
+
+/**
+ * @brief  由本步各电机电流更新电池电压和电量，下一步使用
+ *         Update battery voltage and charge from this step's motor currents,
+ *         for use on the next step
+ */
+static void Sim_Car_Battery(SimCar_t *car, float dt_s)
+{
+    const SimCarParam_t *p = &car->param;
+    const SimImperfect_t *imp = &p->imperfect;
+    double current = 0.0;
+
+    for (int i = 0; i < SIM_MOTORS; i++)
+    {
+        if (car->brake[i])
+            continue;
+        // 施加电压减反电动势，反电动势按标定电压下的空载转速折算
+        // Applied voltage minus back EMF, scaled from the no-load speed at the calibration voltage
+        double applied = fabsf(car->duty[i]) / MOTOR_MAX_PULSE * car->batt_v;
+        double emf = fabsf(car->wheel_mm_s[i]) / p->motor[i].max_mm_s * imp->batt_v_cal;
+        if (applied > emf)
+            current += (applied - emf) / imp->motor_r_ohm;
+    }
+
+    car->batt_soc -= current * dt_s / (imp->batt_mah * 3.6);
+    if (car->batt_soc < 0.0)
+        car->batt_soc = 0.0;
+    double open_v = imp->batt_v_empty + (imp->batt_v_full - imp->batt_v_empty) * car->batt_soc;
+    car->batt_a = current;
+    car->batt_v = open_v - current * imp->batt_r_ohm;
+    if (car->batt_v < 0.0)
+        car->batt_v = 0.0;
+}
+
+/**
+ * @brief  推进底盘状态dt秒
+ *         Advance the chassis by dt seconds
+ * @param  dt_s: 步长，建议不大于1ms Step size, 1 ms or less recommended
+ * @retval 无
+ */
+void Sim_Car_Step(SimCar_t *car, float dt_s)
+{
+    const SimCarParam_t *p = &car->param;
+    float counts_per_mm = p->encoder_circle / p->circle_mm;
+    int battery = p->imperfect.batt_r_ohm > 0;
+    // 轮速与电池电压成正比 Wheel speed scales with the battery voltage
+    float supply = battery ? (float)(car->batt_v / p->imperfect.batt_v_cal) : 1.0f;
+
+    Sim_Car_Read_Pwm(car);
+
+    for (int i = 0; i < SIM_MOTORS; i++)
+    {
+        const SimMotorParam_t *m = &p->motor[i];
+        float target = 0.0f;
+        float tau = m->tau_s;
+        float mag = fabsf(car->duty[i]);
+
+        if (car->brake[i])
+        {
+            tau = m->brake_tau_s;
+        }
+        else if (mag > m->dead_pulse)
+        {
+            target = (mag - m->dead_pulse) / (MOTOR_MAX_PULSE - m->dead_pulse) * m->max_mm_s * supply;
+            if (car->duty[i] < 0)
+                target = -target;
+        }
+
+        car->wheel_mm_s[i] += (target - car->wheel_mm_s[i]) * (dt_s / (tau + dt_s));
+        car->enc_prev[i] = car->enc_pos[i];
+        car->enc_pos[i] += car->wheel_mm_s[i] * dt_s * counts_per_mm;
+    }
+
+    Sim_Car_Write_Encoder(car);
+    if (battery)
+        Sim_Car_Battery(car, dt_s);
+
+    // 左右两侧取平均，差速模型与Motion_Get_Speed中的Vz一致
+    // Average each side; the differential model matches Vz in Motion_Get_Speed
+    double v_l = (car->wheel_mm_s[MOTOR_ID_M1] + car->wheel_mm_s[MOTOR_ID_M2]) * 0.5;
+    double v_r = (car->wheel_mm_s[MOTOR_ID_M3] + car->wheel_mm_s[MOTOR_ID_M4]) * 0.5;
+    double v = (v_l + v_r) * 0.5;
+    double w = (v_r - v_l) / (2.0 * p->apb_mm) * p->yaw_gain;
+
+    double yaw_mid = car->yaw_rad + w * dt_s * 0.5;
+    car->x_mm += v * cos(yaw_mid) * dt_s;
+    car->y_mm += v * sin(yaw_mid) * dt_s;
+    car->yaw_rad += w * dt_s;
+    car->odo_mm += fabs(v) * dt_s;
+}
@@ -0,0 +1,99 @@
+/*
+ * sim_car.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * 四轮底盘动力学模型：电机一阶响应、死区、编码器和位姿积分。
+ * Four-wheel chassis model: first-order motor response, dead band,
+ * encoders and pose integration.
+ *
+ * SimImperfect_t描述传感器和执行器的非理想因素，全为0时即理想模型。
+ * 各电机参数本身按M1..M4分开，可直接设置不对称。
+ * SimImperfect_t describes sensor and actuator imperfections; all zero is
+ * the ideal model. Motor parameters are already per M1..M4, so gain
+ * asymmetry is set there directly.
+ */
+
+#ifndef HOST_SIM_CAR_H_
+#define HOST_SIM_CAR_H_
+
+#include <stdint.h>
+
+#define SIM_MOTORS (4)
+#define SIM_SENSORS (4)
+
+// 单个电机参数 Parameters of one motor
+typedef struct
+{
+    float max_mm_s;   // 满占空比时的稳态轮速 Steady wheel speed at full duty, mm/s
+    float dead_pulse; // 静摩擦死区，PWM计数 Static friction dead band, PWM counts
+    float tau_s;      // 机械时间常数 Mechanical time constant, s
+    float brake_tau_s;// 刹车(两路PWM全高)时间常数 Time constant with both PWM legs high
+} SimMotorParam_t;
+
+// 非理想因素 Imperfections
+typedef struct
+{
+    // 巡线传感器 IR sensors
+    float ir_noise;          // 反射率读数的高斯噪声标准差 Std dev of Gaussian noise on reflectance
+    float ir_hysteresis;     // 阈值迟滞带半宽 Half-width of the threshold hysteresis band
+    uint32_t ir_latency_us;  // 从地面到GPIO的延迟 Delay from the floor to the GPIO input
+
+    // 编码器 Encoders
+    uint16_t enc_step;       // 计数按此粒度输出，0或1为逐个计数 Counts come in steps of this size, 0 or 1 = every count
+    float enc_miss_prob;     // 每个计数丢失的概率 Chance each count is lost
+
+    // 电池，batt_r_ohm为0时不建模 Battery, not modelled while batt_r_ohm is 0
+    float batt_v_full;       // 满电开路电压 Open-circuit voltage when full
+    float batt_v_empty;      // 放空开路电压 Open-circuit voltage when empty
+    float batt_v_cal;        // 标定max_mm_s时的电压 Voltage max_mm_s was measured at
+    float batt_r_ohm;        // 电池内阻 Internal resistance
+    float batt_mah;          // 容量 Capacity
+    float batt_soc;          // 初始电量0..1 Initial state of charge 0..1
+    float motor_r_ohm;       // 电机绕组电阻 Motor winding resistance
+
+    uint32_t seed;           // 噪声随机数种子 Noise random seed
+} SimImperfect_t;
+
+typedef struct
+{
+    SimMotorParam_t motor[SIM_MOTORS];
+    float circle_mm;      // 轮子周长 Wheel circumference, MECANUM_CIRCLE_MM
+    float encoder_circle; // 每圈编码器计数 Encoder counts per wheel turn, ENCODER_CIRCLE_450
+    float apb_mm;         // 半轮距 Half track, STM32Car_APB
+    float yaw_gain;       // 打滑导致的转向效率 Skid-steer yaw efficiency, 1 = no slip
+
+    // 巡线传感器X1..X4相对车体中心的位置 IR sensors X1..X4 relative to the chassis centre
+    float sensor_ahead_mm;
+    float sensor_left_mm[SIM_SENSORS];
+    uint8_t sensor_threshold; // 反射率低于此值读为1(黑线) Reflectance below this reads 1 (line)
+
+    SimImperfect_t imperfect;
+} SimCarParam_t;
+
+typedef struct
+{
+    SimCarParam_t param;
+    float wheel_mm_s[SIM_MOTORS]; // 实际轮速 True wheel speed
+    float duty[SIM_MOTORS];       // 当前占空比，正为前进 Applied duty, positive = forward
+    uint8_t brake[SIM_MOTORS];    // 两路PWM全高 Both PWM legs high
+    double enc_pos[SIM_MOTORS];   // 编码器连续位置 Continuous encoder position, counts
+    double enc_prev[SIM_MOTORS];  // 本步开始时的enc_pos enc_pos at the start of this step
+    int32_t enc_count[SIM_MOTORS];// 已输出到TIMx->CNT的计数 Counts already pushed to TIMx->CNT
+    double x_mm, y_mm, yaw_rad;   // 位姿，x前 y左 逆时针为正 Pose, x forward, y left, CCW positive
+    double odo_mm;                // 车体中心行驶里程 Distance travelled by the chassis centre
+
+    double batt_v;                // 电池端电压 Battery terminal voltage
+    double batt_a;                // 电池电流 Battery current
+    double batt_soc;              // 剩余电量 State of charge
+    uint32_t rng;                 // 噪声随机数状态 Noise random state
+} SimCar_t;
+
+void Sim_Car_Default_Param(SimCarParam_t *param);
+int Sim_Car_Apply_Profile(SimCarParam_t *param, const char *names);
+void Sim_Car_Init(SimCar_t *car, const SimCarParam_t *param, double x_mm, double y_mm, double yaw_rad);
+void Sim_Car_Step(SimCar_t *car, float dt_s);
+float Sim_Car_Gauss(SimCar_t *car);
+
+#endif /* HOST_SIM_CAR_H_ */
@@ -0,0 +1,2284 @@
+/*
+ * sim_cm3.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * 译码按ARMv7-M架构参考手册A5章的编码表组织，只实现Cortex-M3具有的
+ * 指令，没有FPU和DSP扩展。
+ * Decoding follows the encoding tables of chapter A5 of the ARMv7-M
+ * Architecture Reference Manual and covers the Cortex-M3 instructions only:
+ * no FPU and no DSP extension.
+ */
+
+#include <elf.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim_cm3.h"
+
+#define APSR_N (1u << 31)
+#define APSR_Z (1u << 30)
+#define APSR_C (1u << 29)
+#define APSR_V (1u << 28)
+#define APSR_Q (1u << 27)
+
+#define EXC_RETURN_HANDLER (0xFFFFFFF1u)
+#define EXC_RETURN_MSP     (0xFFFFFFF9u)
+#define EXC_RETURN_PSP     (0xFFFFFFFDu)
+
+#define CCR_STKALIGN (1u << 9)
+
+#define SYST_ENABLE    (1u << 0)
+#define SYST_TICKINT   (1u << 1)
+#define SYST_CLKSOURCE (1u << 2)
+#define SYST_COUNTFLAG (1u << 16)
+
+#define CYCLES_NEVER (~(uint64_t)0)
+
+enum
+{
+    SR_LSL,
+    SR_LSR,
+    SR_ASR,
+    SR_ROR,
+    SR_RRX,
+};
+
+static void Cm3_Halt(SimCm3_t *c, const char *fmt, ...)
+{
+    va_list ap;
+    if (c->halted)
+        return;
+    va_start(ap, fmt);
+    vsnprintf(c->error, sizeof(c->error), fmt, ap);
+    va_end(ap);
+    c->halted = 1;
+}
+
+/* ---------------------------------------------------------------------------
+ * 存储器 Memory
+ * ------------------------------------------------------------------------- */
+
+static uint32_t Le_Read(const uint8_t *p, uint32_t size)
+{
+    if (size == 1)
+        return p[0];
+    if (size == 2)
+        return p[0] | (uint32_t)p[1] << 8;
+    return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void Le_Write(uint8_t *p, uint32_t value, uint32_t size)
+{
+    p[0] = (uint8_t)value;
+    if (size >= 2)
+        p[1] = (uint8_t)(value >> 8);
+    if (size == 4)
+    {
+        p[2] = (uint8_t)(value >> 16);
+        p[3] = (uint8_t)(value >> 24);
+    }
+}
+
+// Flash在0x08000000，从Flash启动时也映射到0 Flash at 0x08000000, aliased at 0 when booting from flash
+static uint8_t *Flash_Ptr(SimCm3_t *c, uint32_t addr, uint32_t size)
+{
+    uint32_t off = addr - SIM_CM3_FLASH_BASE;
+    if (off <= SIM_CM3_FLASH_SIZE - size)
+        return &c->flash[off];
+    if (addr <= SIM_CM3_FLASH_SIZE - size)
+        return &c->flash[addr];
+    return NULL;
+}
+
+static uint8_t *Sram_Ptr(SimCm3_t *c, uint32_t addr, uint32_t size)
+{
+    uint32_t off = addr - SIM_CM3_SRAM_BASE;
+    return off <= SIM_CM3_SRAM_SIZE - size ? &c->sram[off] : NULL;
+}
+
+static int In_Flash(uint32_t addr)
+{
+    return addr - SIM_CM3_FLASH_BASE < SIM_CM3_FLASH_SIZE || addr < SIM_CM3_FLASH_SIZE;
+}
+
+static void Cm3_Pend(SimCm3_t *c, uint32_t exc)
+{
+    if (exc < SIM_CM3_EXCS && !c->pending[exc])
+    {
+        c->pending[exc] = 1;
+        c->irq_check = 1;
+    }
+}
+
+void Sim_Cm3_Set_Pending(SimCm3_t *cpu, uint32_t exc)
+{
+    Cm3_Pend(cpu, exc);
+}
+
+static uint32_t Syst_Scale(const SimCm3_t *c)
+{
+    return (c->syst_ctrl & SYST_CLKSOURCE) ? 1u : 8u;
+}
+
+static uint32_t Syst_Val(const SimCm3_t *c)
+{
+    if (!(c->syst_ctrl & SYST_ENABLE) || c->syst_next == CYCLES_NEVER)
+        return c->syst_val;
+    uint64_t left = c->syst_next > c->cycles ? c->syst_next - c->cycles : 0;
+    return (uint32_t)(left / Syst_Scale(c));
+}
+
+// 处理已到期的SysTick归零 Handle the SysTick counts to zero that are due
+static void Syst_Update(SimCm3_t *c)
+{
+    uint64_t period = (uint64_t)(c->syst_load + 1u) * Syst_Scale(c);
+
+    while (c->syst_next <= c->cycles)
+    {
+        c->syst_ctrl |= SYST_COUNTFLAG;
+        if (c->syst_ctrl & SYST_TICKINT)
+            Cm3_Pend(c, SIM_CM3_EXC_SYSTICK);
+        c->syst_next = c->syst_load != 0 ? c->syst_next + period : CYCLES_NEVER;
+    }
+}
+
+static void Syst_Restart(SimCm3_t *c, uint32_t from)
+{
+    if (!(c->syst_ctrl & SYST_ENABLE))
+        return;
+    // 计到0后下一个时钟重装LOAD From 0 the next clock reloads LOAD
+    uint64_t count = from != 0 ? from : (uint64_t)c->syst_load + 1u;
+    c->syst_next = from == 0 && c->syst_load == 0 ? CYCLES_NEVER : c->cycles + count * Syst_Scale(c);
+}
+
+void Sim_Cm3_Update_Event(SimCm3_t *cpu)
+{
+    uint64_t next = cpu->board_event;
+    if ((cpu->syst_ctrl & SYST_ENABLE) && cpu->syst_next < next)
+        next = cpu->syst_next;
+    cpu->next_event = next;
+}
+
+static uint32_t Exc_Pending_Best(const SimCm3_t *c, int *group);
+
+// 系统控制空间内的一个字 One word of the system control space
+static uint32_t Scs_Read_Word(SimCm3_t *c, uint32_t a)
+{
+    uint32_t v = 0;
+
+    if (a >= 0xE000E100u && a < 0xE000E400u)
+    {
+        // ISER/ICER/ISPR/ICPR/IABR
+        uint32_t base = 16u + ((a & 0x7Fu) >> 2) * 32u;
+        const uint8_t *bits = a < 0xE000E200u ? c->enabled : a < 0xE000E300u ? c->pending : c->active;
+        for (uint32_t i = 0; i < 32 && base + i < SIM_CM3_EXCS; i++)
+            v |= (uint32_t)bits[base + i] << i;
+        return v;
+    }
+    if (a >= 0xE000E400u && a < 0xE000E400u + SIM_CM3_IRQS)
+        return Le_Read(&c->prio[16 + (a - 0xE000E400u)], 4);
+    if (a >= 0xE000ED18u && a < 0xE000ED24u)
+        return Le_Read(&c->prio[4 + (a - 0xE000ED18u)], 4);
+
+    switch (a)
+    {
+    case 0xE000E004u: // ICTR
+        return (SIM_CM3_IRQS - 1) / 32;
+    case 0xE000E010u:
+        v = c->syst_ctrl;
+        c->syst_ctrl &= ~SYST_COUNTFLAG;
+        return v;
+    case 0xE000E014u:
+        return c->syst_load;
+    case 0xE000E018u:
+        return Syst_Val(c);
+    case 0xE000E01Cu: // CALIB：HCLK/8下10ms为9000 10 ms is 9000 at HCLK/8
+        return 9000u;
+    case 0xE000ED00u: // CPUID, r1p1
+        return 0x411FC231u;
+    case 0xE000ED04u:
+    {
+        int group;
+        uint32_t best = Exc_Pending_Best(c, &group);
+        v = c->ipsr | best << 12;
+        if (best >= 16)
+            v |= 1u << 22;
+        if (c->pending[14])
+            v |= 1u << 28;
+        if (c->pending[15])
+            v |= 1u << 26;
+        return v;
+    }
+    case 0xE000ED08u:
+        return c->vtor;
+    case 0xE000ED0Cu:
+        return 0xFA050000u | c->prigroup << 8;
+    case 0xE000ED10u:
+        return c->scr;
+    case 0xE000ED14u:
+        return c->ccr;
+    case 0xE000EDFCu:
+        return c->demcr;
+    case 0xE0001000u:
+        return c->dwt_ctrl;
+    case 0xE0001004u: // DWT_CYCCNT
+        return (uint32_t)c->cycles;
+    default:
+        return 0;
+    }
+}
+
+static void Scs_Write(SimCm3_t *c, uint32_t addr, uint32_t value, uint32_t size)
+{
+    uint32_t a = addr & ~3u;
+
+    // 优先级寄存器可按字节写 Priority registers take byte writes
+    if ((addr >= 0xE000E400u && addr < 0xE000E400u + SIM_CM3_IRQS) || (addr >= 0xE000ED18u && addr < 0xE000ED24u))
+    {
+        for (uint32_t i = 0; i < size; i++)
+        {
+            uint32_t b = addr + i;
+            uint32_t exc = b >= 0xE000ED18u ? 4u + (b - 0xE000ED18u) : 16u + (b - 0xE000E400u);
+            if (exc < SIM_CM3_EXCS)
+                c->prio[exc] = (uint8_t)(value >> (i * 8)) & 0xF0u; // 实现了高4位 Upper 4 bits implemented
+        }
+        c->irq_check = 1;
+        return;
+    }
+    if (size < 4)
+        value <<= (addr & 3u) * 8u;
+
+    if (a >= 0xE000E100u && a < 0xE000E300u)
+    {
+        uint32_t base = 16u + ((a & 0x7Fu) >> 2) * 32u;
+        uint8_t set = (a & 0x80u) == 0;
+        uint8_t *bits = a < 0xE000E200u ? c->enabled : c->pending;
+        for (uint32_t i = 0; i < 32 && base + i < SIM_CM3_EXCS; i++)
+            if (value >> i & 1u)
+                bits[base + i] = set;
+        c->irq_check = 1;
+        return;
+    }
+
+    switch (a)
+    {
+    case 0xE000E010u:
+    {
+        uint32_t was = c->syst_ctrl & SYST_ENABLE;
+        uint32_t val = Syst_Val(c);
+        c->syst_ctrl = (c->syst_ctrl & SYST_COUNTFLAG) | (value & 7u);
+        if (!was && (value & SYST_ENABLE))
+            Syst_Restart(c, val);
+        else if (was && !(value & SYST_ENABLE))
+            c->syst_val = val;
+        break;
+    }
+    case 0xE000E014u:
+        c->syst_load = value & 0xFFFFFFu;
+        break;
+    case 0xE000E018u: // 写任意值清零 Any write clears
+        c->syst_val = 0;
+        c->syst_ctrl &= ~SYST_COUNTFLAG;
+        Syst_Restart(c, 0);
+        break;
+    case 0xE000ED04u:
+        if (value & (1u << 28))
+            Cm3_Pend(c, 14);
+        if (value & (1u << 27))
+            c->pending[14] = 0;
+        if (value & (1u << 26))
+            Cm3_Pend(c, SIM_CM3_EXC_SYSTICK);
+        if (value & (1u << 25))
+            c->pending[SIM_CM3_EXC_SYSTICK] = 0;
+        break;
+    case 0xE000ED08u:
+        c->vtor = value & 0x3FFFFF80u;
+        break;
+    case 0xE000ED0Cu:
+        if ((value >> 16) == 0x05FAu)
+        {
+            c->prigroup = (value >> 8) & 7u;
+            c->irq_check = 1;
+            if (value & (1u << 2))
+                Cm3_Halt(c, "system reset requested at 0x%08x", c->r[15]);
+        }
+        break;
+    case 0xE000ED10u:
+        c->scr = value;
+        break;
+    case 0xE000ED14u:
+        c->ccr = value;
+        break;
+    case 0xE000EDFCu:
+        c->demcr = value;
+        break;
+    case 0xE000EF00u: // STIR
+        Cm3_Pend(c, 16u + (value & 0x1FFu));
+        break;
+    case 0xE0001000u:
+        c->dwt_ctrl = value;
+        break;
+    default:
+        break;
+    }
+    Sim_Cm3_Update_Event(c);
+}
+
+// 不计时序的读，供工具读取固件变量 Untimed read, for tools reading firmware variables
+uint32_t Sim_Cm3_Read(SimCm3_t *cpu, uint32_t addr, uint32_t size)
+{
+    uint8_t *p;
+
+    if ((p = Sram_Ptr(cpu, addr, size)) != NULL || (p = Flash_Ptr(cpu, addr, size)) != NULL)
+        return Le_Read(p, size);
+
+    // 位带别名 Bit-band aliases
+    if (addr - 0x22000000u < 0x02000000u || addr - 0x42000000u < 0x02000000u)
+    {
+        uint32_t off = addr & 0x01FFFFFFu;
+        uint32_t byte = (addr & 0xF0000000u) | (off >> 5);
+        return Sim_Cm3_Read(cpu, byte & ~3u, 4) >> ((byte & 3u) * 8u + ((off >> 2) & 7u)) & 1u;
+    }
+    if (addr >= 0xE0000000u && addr < 0xE0100000u)
+        return Scs_Read_Word(cpu, addr & ~3u) >> ((addr & 3u) * 8u) & (size == 4 ? ~0u : (1u << (size * 8u)) - 1u);
+    if (cpu->bus_read != NULL)
+        return cpu->bus_read(cpu, addr, size);
+    return 0;
+}
+
+static void Cm3_Write(SimCm3_t *c, uint32_t addr, uint32_t value, uint32_t size)
+{
+    uint8_t *p;
+
+    if ((p = Sram_Ptr(c, addr, size)) != NULL)
+    {
+        Le_Write(p, value, size);
+        return;
+    }
+    if (addr - 0x22000000u < 0x02000000u || addr - 0x42000000u < 0x02000000u)
+    {
+        uint32_t off = addr & 0x01FFFFFFu;
+        uint32_t byte = (addr & 0xF0000000u) | (off >> 5);
+        uint32_t bit = (byte & 3u) * 8u + ((off >> 2) & 7u);
+        uint32_t word = Sim_Cm3_Read(c, byte & ~3u, 4);
+        word = (value & 1u) ? word | 1u << bit : word & ~(1u << bit);
+        Cm3_Write(c, byte & ~3u, word, 4);
+        return;
+    }
+    if (addr >= 0xE0000000u && addr < 0xE0100000u)
+    {
+        Scs_Write(c, addr, value, size);
+        return;
+    }
+    if (Flash_Ptr(c, addr, size) != NULL)
+        return; // Flash只能经FPEC编程 Flash is programmed through the FPEC only
+    if (c->bus_write != NULL)
+        c->bus_write(c, addr, value, size);
+}
+
+// 不计时序的写，供工具设置固件变量 Untimed write, for tools setting firmware variables
+void Sim_Cm3_Write(SimCm3_t *cpu, uint32_t addr, uint32_t value, uint32_t size)
+{
+    Cm3_Write(cpu, addr, value, size);
+}
+
+// 数据读：Flash上的文字池要等待周期 Data read: literal pools in flash pay the wait states
+static uint32_t Cm3_Load(SimCm3_t *c, uint32_t addr, uint32_t size)
+{
+    if (In_Flash(addr))
+        c->cycles += c->flash_ws;
+    return Sim_Cm3_Read(c, addr, size);
+}
+
+static uint32_t Cm3_Fetch16(SimCm3_t *c, uint32_t addr)
+{
+    uint8_t *p = Flash_Ptr(c, addr, 2);
+    if (p == NULL)
+        p = Sram_Ptr(c, addr, 2);
+    if (p == NULL)
+    {
+        Cm3_Halt(c, "instruction fetch from 0x%08x", addr);
+        return 0xBF00u; // NOP
+    }
+    return p[0] | (uint32_t)p[1] << 8;
+}
+
+/* ---------------------------------------------------------------------------
+ * 取指时序 Fetch timing
+ * ------------------------------------------------------------------------- */
+
+// 顺序执行进入新的64位行时，若预取尚未完成则等待
+// Entering a new 64-bit line in sequence waits for the prefetch if it is not done
+static void Fetch_Timing(SimCm3_t *c, uint32_t pc, uint32_t len)
+{
+    if (c->flash_ws == 0 || !In_Flash(pc))
+        return;
+    uint32_t line = (pc + len - 2u) >> 3;
+    if (line == c->fetch_line)
+        return;
+    if (c->fetch_ready > c->cycles)
+        c->cycles = c->fetch_ready;
+    c->fetch_line = line;
+    c->fetch_ready = c->cycles + c->flash_ws + 1u;
+}
+
+// 跳转：重填流水线P=1，从Flash取目标行另加等待周期 Branch: refill P = 1, plus the wait states to fetch the target line
+static void Fetch_Branch(SimCm3_t *c, uint32_t target)
+{
+    c->cycles += 1u;
+    if (!In_Flash(target))
+        return;
+    c->cycles += c->flash_ws;
+    c->fetch_line = target >> 3;
+    c->fetch_ready = c->cycles + c->flash_ws + 1u;
+}
+
+/* ---------------------------------------------------------------------------
+ * 异常 Exceptions
+ * ------------------------------------------------------------------------- */
+
+static int Exc_Group(const SimCm3_t *c, uint32_t exc)
+{
+    if (exc <= 3)
+        return exc == 1 ? -3 : exc == 2 ? -2 : -1;
+    uint32_t mask = c->prigroup >= 7 ? 0u : (0xFFu << (c->prigroup + 1u)) & 0xFFu;
+    return c->prio[exc] & mask;
+}
+
+static int Exec_Priority(const SimCm3_t *c)
+{
+    int prio = 256;
+    for (uint32_t i = 0; i < c->depth; i++)
+    {
+        int g = Exc_Group(c, c->stack[i]);
+        if (g < prio)
+            prio = g;
+    }
+    if (c->basepri != 0)
+    {
+        uint32_t mask = c->prigroup >= 7 ? 0u : (0xFFu << (c->prigroup + 1u)) & 0xFFu;
+        int b = c->basepri & mask;
+        if (b < prio)
+            prio = b;
+    }
+    if (c->primask && prio > 0)
+        prio = 0;
+    if (c->faultmask && prio > -1)
+        prio = -1;
+    return prio;
+}
+
+// 挂起的异常中优先级最高的，组优先级相同时比子优先级再比异常号
+// The highest-priority pending exception: group, then subpriority, then number
+static uint32_t Exc_Pending_Best(const SimCm3_t *c, int *group)
+{
+    uint32_t best = 0;
+    int best_group = 256, best_prio = 256;
+
+    for (uint32_t exc = 2; exc < SIM_CM3_EXCS; exc++)
+    {
+        if (!c->pending[exc] || (exc >= 16 && !c->enabled[exc]))
+            continue;
+        int g = Exc_Group(c, exc);
+        int p = exc <= 3 ? g : c->prio[exc];
+        if (g < best_group || (g == best_group && p < best_prio))
+        {
+            best = exc;
+            best_group = g;
+            best_prio = p;
+        }
+    }
+    *group = best_group;
+    return best;
+}
+
+static void Exc_Enter(SimCm3_t *c, uint32_t exc, int tail)
+{
+    uint64_t start = c->cycles;
+
+    if (!tail)
+    {
+        if (c->depth < SIM_CM3_DEPTH)
+            c->entry_at[c->depth + 1] = start;
+        uint32_t sp = c->r[13];
+        uint32_t align = (c->ccr & CCR_STKALIGN) && (sp & 4u) ? 1u : 0u;
+        uint32_t xpsr = (c->apsr & 0xF8000000u) | c->ipsr | align << 9 | 1u << 24 |
+                        (uint32_t)(c->itstate & 3u) << 25 | (uint32_t)(c->itstate >> 2) << 10;
+        uint32_t frame[8] = {c->r[0], c->r[1], c->r[2], c->r[3], c->r[12], c->r[14], c->r[15], xpsr};
+        sp -= 32u + align * 4u;
+        for (int i = 0; i < 8; i++)
+            Cm3_Write(c, sp + i * 4u, frame[i], 4);
+        c->r[13] = sp;
+
+        if (c->ipsr != 0)
+        {
+            c->r[14] = EXC_RETURN_HANDLER;
+        }
+        else if (c->spsel)
+        {
+            // 线程用PSP时切到MSP Threads on the PSP switch to the MSP
+            c->r[14] = EXC_RETURN_PSP;
+            uint32_t psp = c->r[13];
+            c->r[13] = c->sp_other;
+            c->sp_other = psp;
+            c->spsel = 0;
+        }
+        else
+        {
+            c->r[14] = EXC_RETURN_MSP;
+        }
+        c->cycles += 12u;
+    }
+    else
+    {
+        c->cycles += 6u;
+    }
+
+    c->ipsr = exc;
+    c->itstate = 0;
+    c->active[exc] = 1;
+    c->pending[exc] = 0;
+    if (c->depth < SIM_CM3_DEPTH)
+        c->stack[c->depth] = (uint8_t)exc;
+    c->depth++;
+    c->sleeping = 0;
+    c->ls_prev = 0;
+    c->irq_check = 1;
+    c->r[15] = Sim_Cm3_Read(c, c->vtor + exc * 4u, 4) & ~1u;
+    if (In_Flash(c->r[15]))
+    {
+        c->fetch_line = c->r[15] >> 3;
+        c->fetch_ready = c->cycles + c->flash_ws + 1u;
+    }
+    if (c->on_exception != NULL)
+        c->on_exception(c, exc, 1, start);
+}
+
+static void Exc_Return(SimCm3_t *c, uint32_t exc_return)
+{
+    uint32_t exc = c->ipsr;
+    uint32_t mode = exc_return & 0xFu;
+
+    if (mode != 0x1u && mode != 0x9u && mode != 0xDu)
+    {
+        Cm3_Halt(c, "bad EXC_RETURN 0x%08x at 0x%08x", exc_return, c->r[15]);
+        return;
+    }
+    c->active[exc] = 0;
+    if (c->depth > 0)
+        c->depth--;
+    c->exc_flow = 1;
+    c->irq_check = 1;
+
+    // 有可抢占返回目标的挂起异常时咬尾，不出栈 Tail-chain into a pending exception that would preempt the return target
+    int group;
+    uint32_t best = Exc_Pending_Best(c, &group);
+    if (best != 0 && group < Exec_Priority(c))
+    {
+        if (c->on_exception != NULL)
+            c->on_exception(c, exc, 0, c->cycles);
+        Exc_Enter(c, best, 1);
+        c->r[14] = exc_return;
+        c->next_pc = c->r[15];
+        return;
+    }
+
+    if (mode == 0xDu)
+    {
+        uint32_t msp = c->r[13];
+        c->r[13] = c->sp_other;
+        c->sp_other = msp;
+        c->spsel = 1;
+    }
+    uint32_t sp = c->r[13];
+    uint32_t frame[8];
+    for (int i = 0; i < 8; i++)
+        frame[i] = Sim_Cm3_Read(c, sp + i * 4u, 4);
+    c->r[0] = frame[0];
+    c->r[1] = frame[1];
+    c->r[2] = frame[2];
+    c->r[3] = frame[3];
+    c->r[12] = frame[4];
+    c->r[14] = frame[5];
+    c->apsr = frame[7] & 0xF8000000u;
+    c->itstate = (uint8_t)((frame[7] >> 25 & 3u) | (frame[7] >> 10 & 0x3Fu) << 2);
+    c->ipsr = mode == 0x1u ? frame[7] & 0x1FFu : 0u;
+    c->r[13] = sp + 32u + ((frame[7] >> 9 & 1u) ? 4u : 0u);
+    c->next_pc = frame[6] & ~1u;
+    c->cycles += 10u;
+
+    if (c->depth <= SIM_CM3_DEPTH)
+        c->nested[c->depth] += c->cycles - c->entry_at[c->depth + 1];
+    if (In_Flash(c->next_pc))
+    {
+        c->fetch_line = c->next_pc >> 3;
+        c->fetch_ready = c->cycles + c->flash_ws + 1u;
+    }
+    if (c->on_exception != NULL)
+        c->on_exception(c, exc, 0, c->cycles);
+}
+
+static void Cm3_Check_Irq(SimCm3_t *c)
+{
+    int group;
+    uint32_t best = Exc_Pending_Best(c, &group);
+    if (best != 0 && group < Exec_Priority(c))
+        Exc_Enter(c, best, 0);
+    else
+        c->irq_check = 0;
+}
+
+/* ---------------------------------------------------------------------------
+ * 运算辅助 ALU helpers
+ * ------------------------------------------------------------------------- */
+
+static uint32_t Add_C(uint32_t x, uint32_t y, uint32_t carry_in, uint32_t *carry, uint32_t *overflow)
+{
+    uint64_t sum = (uint64_t)x + y + carry_in;
+    uint32_t r = (uint32_t)sum;
+    *carry = (uint32_t)(sum >> 32);
+    *overflow = (~(x ^ y) & (x ^ r)) >> 31;
+    return r;
+}
+
+static uint32_t Shift_C(uint32_t v, int type, uint32_t n, uint32_t carry_in, uint32_t *carry)
+{
+    *carry = carry_in;
+    if (type == SR_RRX)
+    {
+        *carry = v & 1u;
+        return v >> 1 | carry_in << 31;
+    }
+    if (n == 0)
+        return v;
+    switch (type)
+    {
+    case SR_LSL:
+        if (n < 32)
+        {
+            *carry = v >> (32 - n) & 1u;
+            return v << n;
+        }
+        *carry = n == 32 ? v & 1u : 0u;
+        return 0;
+    case SR_LSR:
+        if (n < 32)
+        {
+            *carry = v >> (n - 1) & 1u;
+            return v >> n;
+        }
+        *carry = n == 32 ? v >> 31 : 0u;
+        return 0;
+    case SR_ASR:
+        if (n < 32)
+        {
+            *carry = (uint32_t)((int32_t)v >> (n - 1)) & 1u;
+            return (uint32_t)((int32_t)v >> n);
+        }
+        *carry = v >> 31;
+        return (uint32_t)((int32_t)v >> 31);
+    default:
+    {
+        n &= 31u;
+        uint32_t r = n == 0 ? v : (v >> n | v << (32 - n));
+        *carry = r >> 31;
+        return r;
+    }
+    }
+}
+
+static uint32_t Ror(uint32_t v, uint32_t n)
+{
+    n &= 31u;
+    return n == 0 ? v : (v >> n | v << (32 - n));
+}
+
+// 移位立即数编码 DecodeImmShift
+static void Decode_Imm_Shift(uint32_t type, uint32_t imm5, int *sr_type, uint32_t *amount)
+{
+    *sr_type = (int)type;
+    *amount = imm5;
+    if (type == SR_LSR || type == SR_ASR)
+        *amount = imm5 == 0 ? 32u : imm5;
+    else if (type == SR_ROR && imm5 == 0)
+    {
+        *sr_type = SR_RRX;
+        *amount = 1;
+    }
+}
+
+static uint32_t Thumb_Expand_Imm_C(uint32_t imm12, uint32_t carry_in, uint32_t *carry)
+{
+    *carry = carry_in;
+    if ((imm12 >> 10) == 0)
+    {
+        uint32_t imm8 = imm12 & 0xFFu;
+        switch (imm12 >> 8 & 3u)
+        {
+        case 0:
+            return imm8;
+        case 1:
+            return imm8 << 16 | imm8;
+        case 2:
+            return imm8 << 24 | imm8 << 8;
+        default:
+            return imm8 * 0x01010101u;
+        }
+    }
+    uint32_t v = Ror(0x80u | (imm12 & 0x7Fu), imm12 >> 7);
+    *carry = v >> 31;
+    return v;
+}
+
+static int Cond_Pass(uint32_t apsr, uint32_t cond)
+{
+    int n = !!(apsr & APSR_N), z = !!(apsr & APSR_Z), cy = !!(apsr & APSR_C), v = !!(apsr & APSR_V);
+    int r;
+    switch (cond >> 1)
+    {
+    case 0:
+        r = z;
+        break;
+    case 1:
+        r = cy;
+        break;
+    case 2:
+        r = n;
+        break;
+    case 3:
+        r = v;
+        break;
+    case 4:
+        r = cy && !z;
+        break;
+    case 5:
+        r = n == v;
+        break;
+    case 6:
+        r = !z && n == v;
+        break;
+    default:
+        return 1;
+    }
+    return (cond & 1u) ? !r : r;
+}
+
+static void Set_NZ(SimCm3_t *c, uint32_t r)
+{
+    c->apsr = (c->apsr & ~(APSR_N | APSR_Z)) | (r & APSR_N) | (r == 0 ? APSR_Z : 0u);
+}
+
+static void Set_NZC(SimCm3_t *c, uint32_t r, uint32_t carry)
+{
+    Set_NZ(c, r);
+    c->apsr = (c->apsr & ~APSR_C) | (carry ? APSR_C : 0u);
+}
+
+static void Set_NZCV(SimCm3_t *c, uint32_t r, uint32_t carry, uint32_t overflow)
+{
+    Set_NZC(c, r, carry);
+    c->apsr = (c->apsr & ~APSR_V) | (overflow ? APSR_V : 0u);
+}
+
+static uint32_t Carry(const SimCm3_t *c)
+{
+    return c->apsr >> 29 & 1u;
+}
+
+// 读寄存器，PC读出当前指令地址+4 Read a register; PC reads as this instruction + 4
+static uint32_t Reg(const SimCm3_t *c, uint32_t n)
+{
+    return n == 15 ? c->r[15] + 4u : c->r[n];
+}
+
+static uint32_t Align4_Pc(const SimCm3_t *c)
+{
+    return (c->r[15] + 4u) & ~3u;
+}
+
+static void Branch(SimCm3_t *c, uint32_t target)
+{
+    c->next_pc = target & ~1u;
+    c->branched = 1;
+}
+
+// BXWritePC/LoadWritePC：处理模式下的EXC_RETURN触发异常返回
+// BXWritePC/LoadWritePC: an EXC_RETURN in handler mode returns from the exception
+static void Branch_Exchange(SimCm3_t *c, uint32_t target)
+{
+    if (c->ipsr != 0 && (target >> 28) == 0xFu)
+    {
+        Exc_Return(c, target);
+        return;
+    }
+    if ((target & 1u) == 0)
+    {
+        Cm3_Halt(c, "INVSTATE: branch to 0x%08x without the Thumb bit at 0x%08x", target, c->r[15]);
+        return;
+    }
+    Branch(c, target);
+}
+
+static void Write_Reg(SimCm3_t *c, uint32_t rd, uint32_t v)
+{
+    if (rd == 15)
+        Branch(c, v);
+    else if (rd == 13)
+        c->r[13] = v & ~3u;
+    else
+        c->r[rd] = v;
+}
+
+/* ---------------------------------------------------------------------------
+ * 访存 Loads and stores
+ * ------------------------------------------------------------------------- */
+
+// 单次访存2周期，紧跟另一次单次访存时流水为1 A single load/store is 2 cycles, 1 when pipelined behind another
+static void Ls_Cycles(SimCm3_t *c)
+{
+    c->cycles += c->ls_prev ? 1u : 2u;
+    c->ls_now = 1;
+}
+
+static void Load_Single(SimCm3_t *c, uint32_t rt, uint32_t addr, uint32_t size, int sign)
+{
+    Ls_Cycles(c);
+    uint32_t v = Cm3_Load(c, addr, size);
+    if (sign && size == 1)
+        v = (uint32_t)(int32_t)(int8_t)v;
+    else if (sign && size == 2)
+        v = (uint32_t)(int32_t)(int16_t)v;
+    if (rt == 15)
+    {
+        c->ls_now = 0;
+        Branch_Exchange(c, v);
+    }
+    else
+    {
+        Write_Reg(c, rt, v);
+    }
+}
+
+static void Store_Single(SimCm3_t *c, uint32_t rt, uint32_t addr, uint32_t size)
+{
+    Ls_Cycles(c);
+    Cm3_Write(c, addr, Reg(c, rt), size);
+}
+
+// LDM/STM升序访问，1+N周期 LDM/STM in ascending order, 1+N cycles
+static void Load_Multiple(SimCm3_t *c, uint32_t addr, uint32_t list)
+{
+    uint32_t pc = 0, load_pc = 0;
+    c->cycles += 1u;
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        if (!(list >> i & 1u))
+            continue;
+        uint32_t v = Cm3_Load(c, addr, 4);
+        c->cycles += 1u;
+        addr += 4u;
+        if (i == 15)
+        {
+            pc = v;
+            load_pc = 1;
+        }
+        else
+        {
+            Write_Reg(c, i, v);
+        }
+    }
+    if (load_pc)
+        Branch_Exchange(c, pc);
+}
+
+static void Store_Multiple(SimCm3_t *c, uint32_t addr, uint32_t list)
+{
+    c->cycles += 1u;
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        if (!(list >> i & 1u))
+            continue;
+        Cm3_Write(c, addr, Reg(c, i), 4);
+        c->cycles += 1u;
+        addr += 4u;
+    }
+}
+
+static uint32_t Bit_Count(uint32_t v)
+{
+    return (uint32_t)__builtin_popcount(v);
+}
+
+/* ---------------------------------------------------------------------------
+ * 16位指令 16-bit instructions
+ * ------------------------------------------------------------------------- */
+
+static void Undefined(SimCm3_t *c, uint32_t hw1, uint32_t hw2)
+{
+    const SimCm3Sym_t *s = Sim_Cm3_Sym_At(c, c->r[15]);
+    Cm3_Halt(c, "undefined instruction %04x %04x at 0x%08x (%s)", hw1, hw2, c->r[15], s ? s->name : "?");
+}
+
+static void Exec16_Data(SimCm3_t *c, uint32_t op, int setflags)
+{
+    uint32_t rdn = op & 7u, rm = op >> 3 & 7u;
+    uint32_t a = c->r[rdn], b = c->r[rm], r, cy = Carry(c), v;
+
+    c->cycles += 1u;
+    switch (op >> 6 & 0xFu)
+    {
+    case 0x0: // AND
+        r = a & b;
+        break;
+    case 0x1: // EOR
+        r = a ^ b;
+        break;
+    case 0x2: // LSL
+        r = Shift_C(a, SR_LSL, b & 0xFFu, cy, &cy);
+        break;
+    case 0x3: // LSR
+        r = Shift_C(a, SR_LSR, b & 0xFFu, cy, &cy);
+        break;
+    case 0x4: // ASR
+        r = Shift_C(a, SR_ASR, b & 0xFFu, cy, &cy);
+        break;
+    case 0x5: // ADC
+        c->r[rdn] = r = Add_C(a, b, cy, &cy, &v);
+        if (setflags)
+            Set_NZCV(c, r, cy, v);
+        return;
+    case 0x6: // SBC
+        c->r[rdn] = r = Add_C(a, ~b, cy, &cy, &v);
+        if (setflags)
+            Set_NZCV(c, r, cy, v);
+        return;
+    case 0x7: // ROR
+        r = Shift_C(a, SR_ROR, b & 0xFFu, cy, &cy);
+        break;
+    case 0x8: // TST
+        Set_NZ(c, a & b);
+        return;
+    case 0x9: // RSB #0
+        c->r[rdn] = r = Add_C(~b, 0, 1, &cy, &v);
+        if (setflags)
+            Set_NZCV(c, r, cy, v);
+        return;
+    case 0xA: // CMP
+        r = Add_C(a, ~b, 1, &cy, &v);
+        Set_NZCV(c, r, cy, v);
+        return;
+    case 0xB: // CMN
+        r = Add_C(a, b, 0, &cy, &v);
+        Set_NZCV(c, r, cy, v);
+        return;
+    case 0xC: // ORR
+        r = a | b;
+        break;
+    case 0xD: // MUL
+        c->r[rdn] = r = a * b;
+        if (setflags)
+            Set_NZ(c, r);
+        return;
+    case 0xE: // BIC
+        r = a & ~b;
+        break;
+    default: // MVN
+        r = ~b;
+        break;
+    }
+    c->r[rdn] = r;
+    if (setflags)
+        Set_NZC(c, r, cy);
+}
+
+static void Exec16_Misc(SimCm3_t *c, uint32_t op)
+{
+    uint32_t rd = op & 7u, rm = op >> 3 & 7u;
+
+    if ((op & 0xFF00u) == 0xB000u) // ADD/SUB SP, #imm7
+    {
+        uint32_t imm = (op & 0x7Fu) << 2;
+        c->r[13] = (op & 0x80u) ? c->r[13] - imm : c->r[13] + imm;
+        c->cycles += 1u;
+    }
+    else if ((op & 0xF500u) == 0xB100u) // CBZ/CBNZ
+    {
+        uint32_t imm = (op >> 9 & 1u) << 6 | (op >> 3 & 0x1Fu) << 1;
+        c->cycles += 1u;
+        if ((c->r[rd] == 0) != !!(op & 0x800u))
+            Branch(c, c->r[15] + 4u + imm);
+    }
+    else if ((op & 0xFF00u) == 0xB200u) // SXTH/SXTB/UXTH/UXTB
+    {
+        uint32_t v = c->r[rm];
+        switch (op >> 6 & 3u)
+        {
+        case 0:
+            v = (uint32_t)(int32_t)(int16_t)v;
+            break;
+        case 1:
+            v = (uint32_t)(int32_t)(int8_t)v;
+            break;
+        case 2:
+            v &= 0xFFFFu;
+            break;
+        default:
+            v &= 0xFFu;
+            break;
+        }
+        c->r[rd] = v;
+        c->cycles += 1u;
+    }
+    else if ((op & 0xFE00u) == 0xB400u) // PUSH
+    {
+        uint32_t list = (op & 0xFFu) | ((op & 0x100u) ? 1u << 14 : 0u);
+        uint32_t addr = c->r[13] - 4u * Bit_Count(list);
+        Store_Multiple(c, addr, list);
+        c->r[13] = addr;
+    }
+    else if ((op & 0xFFE8u) == 0xB660u) // CPS
+    {
+        uint8_t disable = (op >> 4) & 1u;
+        if (op & 2u)
+            c->primask = disable;
+        if (op & 1u)
+            c->faultmask = disable;
+        c->irq_check = 1;
+        c->cycles += 1u;
+    }
+    else if ((op & 0xFF00u) == 0xBA00u) // REV/REV16/REVSH
+    {
+        uint32_t v = c->r[rm];
+        switch (op >> 6 & 3u)
+        {
+        case 0:
+            v = __builtin_bswap32(v);
+            break;
+        case 1:
+            v = (v >> 8 & 0x00FF00FFu) | (v << 8 & 0xFF00FF00u);
+            break;
+        case 3:
+            v = (uint32_t)(int32_t)(int16_t)(uint16_t)((v & 0xFFu) << 8 | (v >> 8 & 0xFFu));
+            break;
+        default:
+            Undefined(c, op, 0);
+            return;
+        }
+        c->r[rd] = v;
+        c->cycles += 1u;
+    }
+    else if ((op & 0xFE00u) == 0xBC00u) // POP
+    {
+        uint32_t list = (op & 0xFFu) | ((op & 0x100u) ? 1u << 15 : 0u);
+        uint32_t addr = c->r[13];
+        c->r[13] = addr + 4u * Bit_Count(list);
+        Load_Multiple(c, addr, list);
+    }
+    else if ((op & 0xFF00u) == 0xBE00u) // BKPT
+    {
+        Cm3_Halt(c, "BKPT 0x%02x at 0x%08x", op & 0xFFu, c->r[15]);
+    }
+    else if ((op & 0xFF00u) == 0xBF00u)
+    {
+        if (op & 0xFu) // IT
+            c->itstate = (uint8_t)op;
+        else if ((op & 0xF0u) == 0x30u) // WFI
+            c->sleeping = 1;
+        c->cycles += 1u;
+    }
+    else
+    {
+        Undefined(c, op, 0);
+    }
+}
+
+static void Exec16(SimCm3_t *c, uint32_t op)
+{
+    int setflags = c->itstate == 0;
+    uint32_t cy, v, r;
+
+    switch (op >> 12)
+    {
+    case 0x0:
+    case 0x1:
+    {
+        uint32_t rd = op & 7u, rm = op >> 3 & 7u, opc = op >> 11 & 3u;
+        c->cycles += 1u;
+        if (opc == 3) // ADD/SUB register or imm3
+        {
+            uint32_t b = (op & 0x400u) ? (op >> 6 & 7u) : c->r[op >> 6 & 7u];
+            r = (op & 0x200u) ? Add_C(c->r[rm], ~b, 1, &cy, &v) : Add_C(c->r[rm], b, 0, &cy, &v);
+            c->r[rd] = r;
+            if (setflags)
+                Set_NZCV(c, r, cy, v);
+        }
+        else // LSL/LSR/ASR imm5, LSL #0为MOVS LSL #0 is MOVS
+        {
+            int type;
+            uint32_t n;
+            Decode_Imm_Shift(opc, op >> 6 & 0x1Fu, &type, &n);
+            r = Shift_C(c->r[rm], type, n, Carry(c), &cy);
+            c->r[rd] = r;
+            if (setflags)
+                Set_NZC(c, r, cy);
+        }
+        return;
+    }
+    case 0x2:
+    case 0x3:
+    {
+        uint32_t rdn = op >> 8 & 7u, imm = op & 0xFFu;
+        c->cycles += 1u;
+        switch (op >> 11 & 3u)
+        {
+        case 0: // MOV
+            c->r[rdn] = imm;
+            if (setflags)
+                Set_NZ(c, imm);
+            break;
+        case 1: // CMP
+            r = Add_C(c->r[rdn], ~imm, 1, &cy, &v);
+            Set_NZCV(c, r, cy, v);
+            break;
+        case 2: // ADD
+            c->r[rdn] = r = Add_C(c->r[rdn], imm, 0, &cy, &v);
+            if (setflags)
+                Set_NZCV(c, r, cy, v);
+            break;
+        default: // SUB
+            c->r[rdn] = r = Add_C(c->r[rdn], ~imm, 1, &cy, &v);
+            if (setflags)
+                Set_NZCV(c, r, cy, v);
+            break;
+        }
+        return;
+    }
+    case 0x4:
+        if ((op & 0xFC00u) == 0x4000u)
+        {
+            Exec16_Data(c, op, setflags);
+        }
+        else if ((op & 0xFC00u) == 0x4400u)
+        {
+            uint32_t rm = op >> 3 & 0xFu, rdn = (op & 7u) | (op >> 4 & 8u);
+            c->cycles += 1u;
+            switch (op >> 8 & 3u)
+            {
+            case 0: // ADD (高寄存器 high registers)
+                Write_Reg(c, rdn, Reg(c, rdn) + Reg(c, rm));
+                break;
+            case 1: // CMP
+                r = Add_C(Reg(c, rdn), ~Reg(c, rm), 1, &cy, &v);
+                Set_NZCV(c, r, cy, v);
+                break;
+            case 2: // MOV
+                Write_Reg(c, rdn, Reg(c, rm));
+                break;
+            default: // BX/BLX
+            {
+                uint32_t target = Reg(c, rm);
+                if (op & 0x80u)
+                    c->r[14] = (c->r[15] + 2u) | 1u;
+                Branch_Exchange(c, target);
+                break;
+            }
+            }
+        }
+        else // LDR literal
+        {
+            Load_Single(c, op >> 8 & 7u, Align4_Pc(c) + ((op & 0xFFu) << 2), 4, 0);
+        }
+        return;
+    case 0x5:
+    {
+        static const uint8_t size[8] = {4, 2, 1, 1, 4, 2, 1, 2};
+        uint32_t opb = op >> 9 & 7u;
+        uint32_t addr = c->r[op >> 3 & 7u] + c->r[op >> 6 & 7u];
+        if (opb < 3)
+            Store_Single(c, op & 7u, addr, size[opb]);
+        else
+            Load_Single(c, op & 7u, addr, size[opb], opb == 3 || opb == 7);
+        return;
+    }
+    case 0x6:
+    case 0x7:
+    case 0x8:
+    {
+        uint32_t size = (op >> 12) == 0x6 ? 4u : (op >> 12) == 0x7 ? 1u : 2u;
+        uint32_t addr = c->r[op >> 3 & 7u] + (op >> 6 & 0x1Fu) * size;
+        if (op & 0x800u)
+            Load_Single(c, op & 7u, addr, size, 0);
+        else
+            Store_Single(c, op & 7u, addr, size);
+        return;
+    }
+    case 0x9: // LDR/STR SP相对 SP-relative
+    {
+        uint32_t addr = c->r[13] + ((op & 0xFFu) << 2);
+        if (op & 0x800u)
+            Load_Single(c, op >> 8 & 7u, addr, 4, 0);
+        else
+            Store_Single(c, op >> 8 & 7u, addr, 4);
+        return;
+    }
+    case 0xA: // ADR / ADD Rd, SP, #imm
+        c->r[op >> 8 & 7u] = ((op & 0x800u) ? c->r[13] : Align4_Pc(c)) + ((op & 0xFFu) << 2);
+        c->cycles += 1u;
+        return;
+    case 0xB:
+        Exec16_Misc(c, op);
+        return;
+    case 0xC: // STMIA/LDMIA
+    {
+        uint32_t rn = op >> 8 & 7u, list = op & 0xFFu, addr = c->r[rn];
+        if (op & 0x800u)
+        {
+            if (!(list >> rn & 1u))
+                c->r[rn] = addr + 4u * Bit_Count(list);
+            Load_Multiple(c, addr, list);
+        }
+        else
+        {
+            Store_Multiple(c, addr, list);
+            c->r[rn] = addr + 4u * Bit_Count(list);
+        }
+        return;
+    }
+    case 0xD:
+    {
+        uint32_t cond = op >> 8 & 0xFu;
+        if (cond == 0xE)
+        {
+            Undefined(c, op, 0);
+        }
+        else if (cond == 0xF) // SVC
+        {
+            Cm3_Pend(c, 11);
+            c->cycles += 1u;
+        }
+        else
+        {
+            c->cycles += 1u;
+            if (Cond_Pass(c->apsr, cond))
+                Branch(c, c->r[15] + 4u + (uint32_t)((int32_t)(int8_t)(op & 0xFFu) * 2));
+        }
+        return;
+    }
+    case 0xE: // B imm11
+    {
+        int32_t imm = (int32_t)((op & 0x7FFu) << 21) >> 20;
+        c->cycles += 1u;
+        Branch(c, c->r[15] + 4u + (uint32_t)imm);
+        return;
+    }
+    default:
+        Undefined(c, op, 0);
+        return;
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * 32位指令 32-bit instructions
+ * ------------------------------------------------------------------------- */
+
+// 数据处理的共用部分，TST/TEQ/CMN/CMP为Rd=15且S=1 Shared data processing; TST/TEQ/CMN/CMP have Rd=15 with S=1
+static void Dp_Op(SimCm3_t *c, uint32_t hw1, uint32_t hw2, uint32_t b, uint32_t carry)
+{
+    uint32_t op = hw1 >> 5 & 0xFu, s = hw1 >> 4 & 1u, rn = hw1 & 0xFu, rd = hw2 >> 8 & 0xFu;
+    uint32_t a = (rn == 15 && (op == 2 || op == 3)) ? 0u : Reg(c, rn);
+    uint32_t r, cy = carry, v = c->apsr >> 28 & 1u;
+    int arith = 0;
+
+    switch (op)
+    {
+    case 0x0:
+        r = a & b;
+        break;
+    case 0x1:
+        r = a & ~b;
+        break;
+    case 0x2:
+        r = a | b;
+        break;
+    case 0x3:
+        r = a | ~b;
+        break;
+    case 0x4:
+        r = a ^ b;
+        break;
+    case 0x8:
+        r = Add_C(a, b, 0, &cy, &v);
+        arith = 1;
+        break;
+    case 0xA:
+        r = Add_C(a, b, Carry(c), &cy, &v);
+        arith = 1;
+        break;
+    case 0xB:
+        r = Add_C(a, ~b, Carry(c), &cy, &v);
+        arith = 1;
+        break;
+    case 0xD:
+        r = Add_C(a, ~b, 1, &cy, &v);
+        arith = 1;
+        break;
+    case 0xE:
+        r = Add_C(b, ~a, 1, &cy, &v);
+        arith = 1;
+        break;
+    default:
+        Undefined(c, hw1, hw2);
+        return;
+    }
+    c->cycles += 1u;
+    if (!(rd == 15 && s))
+        Write_Reg(c, rd, r);
+    if (s && arith)
+        Set_NZCV(c, r, cy, v);
+    else if (s)
+        Set_NZC(c, r, cy);
+}
+
+static void Exec32_Plain_Imm(SimCm3_t *c, uint32_t hw1, uint32_t hw2)
+{
+    uint32_t rn = hw1 & 0xFu, rd = hw2 >> 8 & 0xFu;
+    uint32_t imm12 = (hw1 >> 10 & 1u) << 11 | (hw2 >> 12 & 7u) << 8 | (hw2 & 0xFFu);
+    uint32_t imm16 = (hw1 & 0xFu) << 12 | imm12;
+    uint32_t lsb = (hw2 >> 12 & 7u) << 2 | (hw2 >> 6 & 3u);
+    uint32_t width = (hw2 & 0x1Fu) + 1u;
+
+    c->cycles += 1u;
+    switch (hw1 >> 4 & 0x1Fu)
+    {
+    case 0x00: // ADDW/ADR
+        Write_Reg(c, rd, (rn == 15 ? Align4_Pc(c) : c->r[rn]) + imm12);
+        break;
+    case 0x0A: // SUBW/ADR
+        Write_Reg(c, rd, (rn == 15 ? Align4_Pc(c) : c->r[rn]) - imm12);
+        break;
+    case 0x04: // MOVW
+        Write_Reg(c, rd, imm16);
+        break;
+    case 0x0C: // MOVT
+        Write_Reg(c, rd, (c->r[rd] & 0xFFFFu) | imm16 << 16);
+        break;
+    case 0x10:
+    case 0x12: // SSAT
+    case 0x18:
+    case 0x1A: // USAT
+    {
+        int type;
+        uint32_t n, cy;
+        Decode_Imm_Shift((hw1 >> 5 & 1u) << 1, lsb, &type, &n);
+        int64_t x = (int32_t)Shift_C(c->r[rn], type, n, 0, &cy);
+        int64_t lo, hi;
+        if ((hw1 >> 4 & 0x1Fu) < 0x18)
+        {
+            lo = -((int64_t)1 << (width - 1));
+            hi = ((int64_t)1 << (width - 1)) - 1;
+        }
+        else
+        {
+            lo = 0;
+            hi = ((int64_t)1 << (width - 1)) - 1; // USAT的位数为sat_imm USAT saturates to sat_imm bits
+        }
+        if (x < lo || x > hi)
+        {
+            x = x < lo ? lo : hi;
+            c->apsr |= APSR_Q;
+        }
+        Write_Reg(c, rd, (uint32_t)x);
+        break;
+    }
+    case 0x14: // SBFX
+        Write_Reg(c, rd, lsb + width > 32 ? 0u : (uint32_t)((int32_t)(c->r[rn] << (32 - lsb - width)) >> (32 - width)));
+        break;
+    case 0x1C: // UBFX
+        Write_Reg(c, rd, lsb + width > 32 ? 0u : (c->r[rn] >> lsb) & (width == 32 ? ~0u : (1u << width) - 1u));
+        break;
+    case 0x16: // BFI/BFC
+    {
+        uint32_t msb = hw2 & 0x1Fu;
+        if (msb < lsb)
+            break;
+        uint32_t mask = (msb - lsb == 31 ? ~0u : ((1u << (msb - lsb + 1)) - 1u)) << lsb;
+        uint32_t src = rn == 15 ? 0u : c->r[rn] << lsb;
+        Write_Reg(c, rd, (c->r[rd] & ~mask) | (src & mask));
+        break;
+    }
+    default:
+        Undefined(c, hw1, hw2);
+        break;
+    }
+}
+
+static void Exec32_Msr(SimCm3_t *c, uint32_t hw1, uint32_t hw2)
+{
+    uint32_t v = c->r[hw1 & 0xFu], sysm = hw2 & 0xFFu;
+
+    c->cycles += 1u;
+    if (sysm < 8)
+    {
+        if (hw2 & 0x800u)
+            c->apsr = v & 0xF8000000u;
+        return;
+    }
+    int thread_psp = c->ipsr == 0 && c->spsel;
+    switch (sysm)
+    {
+    case 8: // MSP
+        if (thread_psp)
+            c->sp_other = v & ~3u;
+        else
+            c->r[13] = v & ~3u;
+        break;
+    case 9: // PSP
+        if (thread_psp)
+            c->r[13] = v & ~3u;
+        else
+            c->sp_other = v & ~3u;
+        break;
+    case 16:
+        c->primask = v & 1u;
+        break;
+    case 17:
+        c->basepri = (uint8_t)(v & 0xF0u);
+        break;
+    case 18: // BASEPRI_MAX只会提高屏蔽 BASEPRI_MAX only raises the mask
+        if ((v & 0xF0u) != 0 && (c->basepri == 0 || (v & 0xF0u) < c->basepri))
+            c->basepri = (uint8_t)(v & 0xF0u);
+        break;
+    case 19:
+        c->faultmask = v & 1u;
+        break;
+    case 20: // CONTROL
+        c->npriv = v & 1u;
+        if (c->ipsr == 0 && c->spsel != (v >> 1 & 1u))
+        {
+            uint32_t sp = c->r[13];
+            c->r[13] = c->sp_other;
+            c->sp_other = sp;
+            c->spsel = v >> 1 & 1u;
+        }
+        break;
+    default:
+        break;
+    }
+    c->irq_check = 1;
+}
+
+static void Exec32_Mrs(SimCm3_t *c, uint32_t hw2)
+{
+    uint32_t sysm = hw2 & 0xFFu, v = 0;
+    int thread_psp = c->ipsr == 0 && c->spsel;
+
+    c->cycles += 1u;
+    if (sysm < 8)
+    {
+        if (!(sysm & 4u))
+            v |= c->apsr & 0xF8000000u;
+        if (sysm & 1u)
+            v |= c->ipsr;
+    }
+    else if (sysm == 8)
+        v = thread_psp ? c->sp_other : c->r[13];
+    else if (sysm == 9)
+        v = thread_psp ? c->r[13] : c->sp_other;
+    else if (sysm == 16)
+        v = c->primask;
+    else if (sysm == 17 || sysm == 18)
+        v = c->basepri;
+    else if (sysm == 19)
+        v = c->faultmask;
+    else if (sysm == 20)
+        v = c->npriv | (uint32_t)c->spsel << 1;
+    Write_Reg(c, hw2 >> 8 & 0xFu, v);
+}
+
+static void Exec32_Branch_Misc(SimCm3_t *c, uint32_t hw1, uint32_t hw2)
+{
+    uint32_t op1 = hw2 >> 12 & 7u, op = hw1 >> 4 & 0x7Fu;
+    uint32_t s = hw1 >> 10 & 1u, j1 = hw2 >> 13 & 1u, j2 = hw2 >> 11 & 1u;
+
+    if ((op1 & 5u) == 0)
+    {
+        if ((op & 0x38u) != 0x38u) // B<c>.W
+        {
+            uint32_t imm = s << 20 | j2 << 19 | j1 << 18 | (hw1 & 0x3Fu) << 12 | (hw2 & 0x7FFu) << 1;
+            c->cycles += 1u;
+            if (Cond_Pass(c->apsr, hw1 >> 6 & 0xFu))
+                Branch(c, c->r[15] + 4u + (uint32_t)((int32_t)(imm << 11) >> 11));
+        }
+        else if ((op & 0x7Eu) == 0x38u)
+        {
+            Exec32_Msr(c, hw1, hw2);
+        }
+        else if (op == 0x3Au) // NOP.W/WFI.W等提示 Hints
+        {
+            if ((hw2 & 0xFFu) == 3u)
+                c->sleeping = 1;
+            c->cycles += 1u;
+        }
+        else if (op == 0x3Bu) // DSB/DMB/ISB/CLREX
+        {
+            c->cycles += 1u;
+        }
+        else if ((op & 0x7Eu) == 0x3Eu)
+        {
+            Exec32_Mrs(c, hw2);
+        }
+        else
+        {
+            Undefined(c, hw1, hw2);
+        }
+        return;
+    }
+
+    // B.W/BL
+    uint32_t i1 = !(j1 ^ s), i2 = !(j2 ^ s);
+    uint32_t imm = s << 24 | i1 << 23 | i2 << 22 | (hw1 & 0x3FFu) << 12 | (hw2 & 0x7FFu) << 1;
+    int32_t offset = (int32_t)(imm << 7) >> 7;
+    if ((op1 & 5u) == 5u)
+        c->r[14] = (c->r[15] + 4u) | 1u;
+    else if ((op1 & 5u) != 1u)
+    {
+        Undefined(c, hw1, hw2);
+        return;
+    }
+    c->cycles += 1u;
+    Branch(c, c->r[15] + 4u + (uint32_t)offset);
+}
+
+static void Exec32_Ldm_Stm(SimCm3_t *c, uint32_t hw1, uint32_t hw2)
+{
+    uint32_t rn = hw1 & 0xFu, list = hw2, n = Bit_Count(list);
+    uint32_t ia = (hw1 >> 7 & 3u) == 1u, wback = hw1 >> 5 & 1u, load = hw1 >> 4 & 1u;
+    uint32_t base = c->r[rn];
+    uint32_t addr = ia ? base : base - 4u * n;
+    uint32_t end = ia ? base + 4u * n : addr;
+
+    if ((hw1 >> 7 & 3u) == 0 || (hw1 >> 7 & 3u) == 3)
+    {
+        Undefined(c, hw1, hw2);
+        return;
+    }
+    if (load)
+    {
+        if (wback && !(list >> rn & 1u))
+            Write_Reg(c, rn, end);
+        Load_Multiple(c, addr, list);
+    }
+    else
+    {
+        Store_Multiple(c, addr, list);
+        if (wback)
+            Write_Reg(c, rn, end);
+    }
+}
+
+static void Exec32_Dual(SimCm3_t *c, uint32_t hw1, uint32_t hw2)
+{
+    uint32_t op1 = hw1 >> 7 & 3u, op2 = hw1 >> 4 & 3u, op3 = hw2 >> 4 & 0xFu;
+    uint32_t rn = hw1 & 0xFu, rt = hw2 >> 12 & 0xFu, rt2 = hw2 >> 8 & 0xFu;
+
+    if (op1 == 0 && op2 == 0) // STREX
+    {
+        Store_Single(c, rt, c->r[rn] + ((hw2 & 0xFFu) << 2), 4);
+        c->r[rt2] = 0; // 总是成功 Always succeeds
+        return;
+    }
+    if (op1 == 0 && op2 == 1) // LDREX
+    {
+        Load_Single(c, rt, c->r[rn] + ((hw2 & 0xFFu) << 2), 4, 0);
+        return;
+    }
+    if ((op1 & 2u) || (op2 & 2u)) // STRD/LDRD
+    {
+        uint32_t p = hw1 >> 8 & 1u, u = hw1 >> 7 & 1u, w = hw1 >> 5 & 1u, load = hw1 >> 4 & 1u;
+        uint32_t imm = (hw2 & 0xFFu) << 2;
+        uint32_t base = rn == 15 ? Align4_Pc(c) : c->r[rn];
+        uint32_t offset_addr = u ? base + imm : base - imm;
+        uint32_t addr = p ? offset_addr : base;
+        c->cycles += 3u;
+        if (load)
+        {
+            uint32_t lo = Cm3_Load(c, addr, 4), hi = Cm3_Load(c, addr + 4u, 4);
+            if (w)
+                c->r[rn] = offset_addr;
+            Write_Reg(c, rt, lo);
+            Write_Reg(c, rt2, hi);
+        }
+        else
+        {
+            Cm3_Write(c, addr, Reg(c, rt), 4);
+            Cm3_Write(c, addr + 4u, Reg(c, rt2), 4);
+            if (w)
+                c->r[rn] = offset_addr;
+        }
+        return;
+    }
+    if (op1 == 1 && op2 == 0 && (op3 == 4 || op3 == 5)) // STREXB/STREXH
+    {
+        Store_Single(c, rt, c->r[rn], op3 == 4 ? 1u : 2u);
+        c->r[hw2 & 0xFu] = 0;
+        return;
+    }
+    if (op1 == 1 && op2 == 1)
+    {
+        if (op3 == 0 || op3 == 1) // TBB/TBH，2+P
+        {
+            uint32_t base = Reg(c, rn), idx = c->r[hw2 & 0xFu];
+            uint32_t off = op3 == 0 ? Cm3_Load(c, base + idx, 1) : Cm3_Load(c, base + idx * 2u, 2);
+            c->cycles += 2u;
+            Branch(c, c->r[15] + 4u + off * 2u);
+            return;
+        }
+        if (op3 == 4 || op3 == 5) // LDREXB/LDREXH
+        {
+            Load_Single(c, rt, c->r[rn], op3 == 4 ? 1u : 2u, 0);
+            return;
+        }
+    }
+    Undefined(c, hw1, hw2);
+}
+
+// 单次LDR/STR的各种寻址方式 The addressing forms of single LDR/STR
+static void Exec32_Load_Store(SimCm3_t *c, uint32_t hw1, uint32_t hw2, uint32_t size, int load, int sign)
+{
+    uint32_t rn = hw1 & 0xFu, rt = hw2 >> 12 & 0xFu;
+    uint32_t addr, wb = 0, wb_addr = 0;
+
+    if (load && rn == 15) // 文字池 Literal
+    {
+        uint32_t imm = hw2 & 0xFFFu;
+        addr = (hw1 >> 7 & 1u) ? Align4_Pc(c) + imm : Align4_Pc(c) - imm;
+    }
+    else if (hw1 >> 7 & 1u) // imm12
+    {
+        addr = c->r[rn] + (hw2 & 0xFFFu);
+    }
+    else if (hw2 & 0x800u) // imm8，可前后变址 imm8 with pre/post index
+    {
+        uint32_t p = hw2 >> 10 & 1u, u = hw2 >> 9 & 1u, imm = hw2 & 0xFFu;
+        uint32_t offset_addr = u ? c->r[rn] + imm : c->r[rn] - imm;
+        addr = p ? offset_addr : c->r[rn];
+        wb = hw2 >> 8 & 1u;
+        wb_addr = offset_addr;
+    }
+    else if ((hw2 & 0xFC0u) == 0) // 寄存器偏移 Register offset
+    {
+        addr = c->r[rn] + (c->r[hw2 & 0xFu] << (hw2 >> 4 & 3u));
+    }
+    else
+    {
+        Undefined(c, hw1, hw2);
+        return;
+    }
+
+    if (load && rt == 15 && size < 4) // PLD/PLI
+    {
+        c->cycles += 1u;
+        return;
+    }
+    if (wb)
+        c->r[rn] = wb_addr;
+    if (load)
+        Load_Single(c, rt, addr, size, sign);
+    else
+        Store_Single(c, rt, addr, size);
+}
+
+static void Exec32_Dp_Register(SimCm3_t *c, uint32_t hw1, uint32_t hw2)
+{
+    uint32_t op1 = hw1 >> 4 & 0xFu, op2 = hw2 >> 4 & 0xFu;
+    uint32_t rn = hw1 & 0xFu, rd = hw2 >> 8 & 0xFu, rm = hw2 & 0xFu;
+    uint32_t v = c->r[rm], cy;
+
+    c->cycles += 1u;
+    if ((op1 & 8u) == 0 && op2 == 0) // LSL/LSR/ASR/ROR寄存器 by register
+    {
+        uint32_t r = Shift_C(c->r[rn], (int)(op1 >> 1 & 3u), v & 0xFFu, Carry(c), &cy);
+        Write_Reg(c, rd, r);
+        if (op1 & 1u)
+            Set_NZC(c, r, cy);
+        return;
+    }
+    if ((op1 & 8u) == 0 && (op2 & 8u) && rn == 15) // SXTH/UXTH/SXTB/UXTB，可旋转 with rotation
+    {
+        v = Ror(v, (hw2 >> 4 & 3u) * 8u);
+        switch (op1 >> 1 & 3u)
+        {
+        case 0:
+            v = (uint32_t)(int32_t)(int16_t)v;
+            break;
+        case 1:
+            v &= 0xFFFFu;
+            break;
+        case 2:
+            v = (uint32_t)(int32_t)(int8_t)v;
+            break;
+        default:
+            v &= 0xFFu;
+            break;
+        }
+        Write_Reg(c, rd, v);
+        return;
+    }
+    if ((op1 & 0xCu) == 0x8u && (op2 & 0xCu) == 0x8u)
+    {
+        switch ((op1 & 3u) << 2 | (op2 & 3u))
+        {
+        case 0x4: // REV
+            Write_Reg(c, rd, __builtin_bswap32(v));
+            return;
+        case 0x5: // REV16
+            Write_Reg(c, rd, (v >> 8 & 0x00FF00FFu) | (v << 8 & 0xFF00FF00u));
+            return;
+        case 0x6: // RBIT
+        {
+            uint32_t r = 0;
+            for (int i = 0; i < 32; i++)
+                r |= (v >> i & 1u) << (31 - i);
+            Write_Reg(c, rd, r);
+            return;
+        }
+        case 0x7: // REVSH
+            Write_Reg(c, rd, (uint32_t)(int32_t)(int16_t)(uint16_t)((v & 0xFFu) << 8 | (v >> 8 & 0xFFu)));
+            return;
+        case 0xC: // CLZ
+            Write_Reg(c, rd, v == 0 ? 32u : (uint32_t)__builtin_clz(v));
+            return;
+        default:
+            break;
+        }
+    }
+    Undefined(c, hw1, hw2);
+}
+
+// 长乘法按操作数有效位提前结束 Long multiplies terminate early on operand size
+static uint32_t Mull_Cycles(uint32_t a, uint32_t b)
+{
+    return 3u + (a > 0xFFFFu) + (b > 0xFFFFu);
+}
+
+static uint32_t Abs32(int32_t v)
+{
+    return v < 0 ? 0u - (uint32_t)v : (uint32_t)v;
+}
+
+// 除法每周期约4位商 Division retires about 4 quotient bits per cycle
+static uint32_t Div_Cycles(uint32_t n, uint32_t d)
+{
+    if (d == 0 || n < d)
+        return 2u;
+    uint32_t bits = (uint32_t)(__builtin_clz(d) - __builtin_clz(n)) + 1u;
+    uint32_t cyc = 2u + (bits + 3u) / 4u;
+    return cyc > 12u ? 12u : cyc;
+}
+
+static void Exec32_Multiply(SimCm3_t *c, uint32_t hw1, uint32_t hw2)
+{
+    uint32_t rn = hw1 & 0xFu, ra = hw2 >> 12 & 0xFu, rd = hw2 >> 8 & 0xFu, rm = hw2 & 0xFu;
+    uint32_t op1 = hw1 >> 4 & 7u, op2 = hw2 >> 4 & 0xFu;
+    uint32_t a = c->r[rn], b = c->r[rm];
+
+    if ((hw1 & 0x0080u) == 0) // 32位乘法 32-bit multiply
+    {
+        if (op1 != 0 || op2 > 1)
+        {
+            Undefined(c, hw1, hw2);
+            return;
+        }
+        if (op2 == 1) // MLS
+        {
+            Write_Reg(c, rd, c->r[ra] - a * b);
+            c->cycles += 2u;
+        }
+        else if (ra == 15) // MUL
+        {
+            Write_Reg(c, rd, a * b);
+            c->cycles += 1u;
+        }
+        else // MLA
+        {
+            Write_Reg(c, rd, c->r[ra] + a * b);
+            c->cycles += 2u;
+        }
+        return;
+    }
+
+    uint32_t lo = ra, hi = rd;
+    switch (op1 << 4 | op2)
+    {
+    case 0x00: // SMULL
+    {
+        int64_t r = (int64_t)(int32_t)a * (int32_t)b;
+        c->r[lo] = (uint32_t)r;
+        c->r[hi] = (uint32_t)((uint64_t)r >> 32);
+        c->cycles += Mull_Cycles(Abs32((int32_t)a), Abs32((int32_t)b));
+        return;
+    }
+    case 0x20: // UMULL
+    {
+        uint64_t r = (uint64_t)a * b;
+        c->r[lo] = (uint32_t)r;
+        c->r[hi] = (uint32_t)(r >> 32);
+        c->cycles += Mull_Cycles(a, b);
+        return;
+    }
+    case 0x40: // SMLAL
+    {
+        int64_t acc = (int64_t)((uint64_t)c->r[hi] << 32 | c->r[lo]);
+        int64_t r = acc + (int64_t)(int32_t)a * (int32_t)b;
+        c->r[lo] = (uint32_t)r;
+        c->r[hi] = (uint32_t)((uint64_t)r >> 32);
+        c->cycles += Mull_Cycles(Abs32((int32_t)a), Abs32((int32_t)b)) + 1u;
+        return;
+    }
+    case 0x60: // UMLAL
+    {
+        uint64_t r = ((uint64_t)c->r[hi] << 32 | c->r[lo]) + (uint64_t)a * b;
+        c->r[lo] = (uint32_t)r;
+        c->r[hi] = (uint32_t)(r >> 32);
+        c->cycles += Mull_Cycles(a, b) + 1u;
+        return;
+    }
+    case 0x1F: // SDIV，除0得0 Divide by zero gives 0
+    {
+        int32_t n = (int32_t)a, d = (int32_t)b;
+        int32_t q = d == 0 ? 0 : (n == INT32_MIN && d == -1) ? INT32_MIN : n / d;
+        Write_Reg(c, rd, (uint32_t)q);
+        c->cycles += Div_Cycles(Abs32(n), Abs32(d));
+        return;
+    }
+    case 0x3F: // UDIV
+        Write_Reg(c, rd, b == 0 ? 0u : a / b);
+        c->cycles += Div_Cycles(a, b);
+        return;
+    default:
+        Undefined(c, hw1, hw2);
+        return;
+    }
+}
+
+static void Exec32(SimCm3_t *c, uint32_t hw1, uint32_t hw2)
+{
+    uint32_t op1 = hw1 >> 11 & 3u, op2 = hw1 >> 4 & 0x7Fu;
+
+    if (op1 == 1)
+    {
+        if ((op2 & 0x64u) == 0x00u)
+            Exec32_Ldm_Stm(c, hw1, hw2);
+        else if ((op2 & 0x64u) == 0x04u)
+            Exec32_Dual(c, hw1, hw2);
+        else if ((op2 & 0x60u) == 0x20u) // 移位寄存器数据处理 Data processing, shifted register
+        {
+            int type;
+            uint32_t n, cy;
+            Decode_Imm_Shift(hw2 >> 4 & 3u, (hw2 >> 12 & 7u) << 2 | (hw2 >> 6 & 3u), &type, &n);
+            uint32_t b = Shift_C(c->r[hw2 & 0xFu], type, n, Carry(c), &cy);
+            Dp_Op(c, hw1, hw2, b, cy);
+        }
+        else
+            Undefined(c, hw1, hw2);
+    }
+    else if (op1 == 2)
+    {
+        if (hw2 & 0x8000u)
+            Exec32_Branch_Misc(c, hw1, hw2);
+        else if ((op2 & 0x20u) == 0) // 修改立即数 Modified immediate
+        {
+            uint32_t cy;
+            uint32_t imm12 = (hw1 >> 10 & 1u) << 11 | (hw2 >> 12 & 7u) << 8 | (hw2 & 0xFFu);
+            uint32_t b = Thumb_Expand_Imm_C(imm12, Carry(c), &cy);
+            Dp_Op(c, hw1, hw2, b, cy);
+        }
+        else
+            Exec32_Plain_Imm(c, hw1, hw2);
+    }
+    else
+    {
+        if ((op2 & 0x71u) == 0x00u)
+            Exec32_Load_Store(c, hw1, hw2, 1u << (op2 >> 1 & 3u), 0, 0);
+        else if ((op2 & 0x67u) == 0x01u)
+            Exec32_Load_Store(c, hw1, hw2, 1, 1, op2 >> 4 & 1u);
+        else if ((op2 & 0x67u) == 0x03u)
+            Exec32_Load_Store(c, hw1, hw2, 2, 1, op2 >> 4 & 1u);
+        else if ((op2 & 0x67u) == 0x05u)
+            Exec32_Load_Store(c, hw1, hw2, 4, 1, 0);
+        else if ((op2 & 0x70u) == 0x20u)
+            Exec32_Dp_Register(c, hw1, hw2);
+        else if ((op2 & 0x70u) == 0x30u)
+            Exec32_Multiply(c, hw1, hw2);
+        else
+            Undefined(c, hw1, hw2);
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * 执行 Execution
+ * ------------------------------------------------------------------------- */
+
+static void Cm3_Step(SimCm3_t *c)
+{
+    uint32_t pc = c->r[15];
+    uint32_t hw1 = Cm3_Fetch16(c, pc), hw2 = 0;
+    uint32_t len = (hw1 >> 11) >= 0x1Du ? 4u : 2u;
+    uint8_t it = c->itstate;
+
+    if (len == 4)
+        hw2 = Cm3_Fetch16(c, pc + 2u);
+    Fetch_Timing(c, pc, len);
+    c->next_pc = pc + len;
+    c->branched = 0;
+    c->ls_now = 0;
+    c->instructions++;
+
+    // IT块中条件不满足的指令按1周期跳过 Instructions failing their IT condition take one cycle
+    if (it != 0 && !Cond_Pass(c->apsr, it >> 4))
+        c->cycles += 1u;
+    else if (len == 4)
+        Exec32(c, hw1, hw2);
+    else
+        Exec16(c, hw1);
+
+    if (c->exc_flow)
+    {
+        c->exc_flow = 0;
+        c->ls_prev = 0;
+        c->r[15] = c->next_pc;
+        return;
+    }
+    if (it != 0)
+        c->itstate = (it & 7u) == 0 ? 0 : (uint8_t)((it & 0xE0u) | ((it << 1) & 0x1Fu));
+    c->ls_prev = c->ls_now;
+    c->r[15] = c->next_pc;
+    if (c->branched)
+    {
+        c->branches++;
+        Fetch_Branch(c, c->next_pc);
+    }
+}
+
+/**
+ * @brief  运行到指定周期、停机或出错
+ *         Run until the given cycle, a halt or an error
+ * @param  until: 绝对周期数 Absolute cycle count
+ * @retval 0正常，-1出错，原因见error 0 normally, -1 on an error described in error
+ */
+int Sim_Cm3_Run(SimCm3_t *cpu, uint64_t until)
+{
+    SimCm3_t *c = cpu;
+
+    while (!c->halted && c->cycles < until)
+    {
+        if (c->cycles >= c->next_event)
+        {
+            Syst_Update(c);
+            if (c->cycles >= c->board_event && c->on_event != NULL)
+                c->on_event(c);
+            Sim_Cm3_Update_Event(c);
+        }
+        if (c->irq_check)
+            Cm3_Check_Irq(c);
+        if (c->sleeping)
+        {
+            // WFI：直接跳到下一个外设事件 WFI: skip straight to the next peripheral event
+            uint64_t wake = c->next_event < until ? c->next_event : until;
+            c->cycles = wake > c->cycles ? wake : c->cycles + 1u;
+            continue;
+        }
+        if (c->watch != NULL)
+        {
+            uint32_t off = c->r[15] - SIM_CM3_FLASH_BASE;
+            if (off < SIM_CM3_FLASH_SIZE && c->watch[off >> 1])
+                c->on_watch(c, c->r[15]);
+        }
+        if (c->r[15] == c->stop_pc)
+            break;
+        Cm3_Step(c);
+    }
+    return c->halted && c->error[0] != '\0' ? -1 : 0;
+}
+
+/**
+ * @brief  在线程模式下调用固件中的一个函数，返回后恢复原来的寄存器
+ *         Call a firmware function from thread mode and restore the
+ *         registers once it returns
+ * @note   周期包括返回指令；中断是否打断取决于PRIMASK等当前状态
+ *         Cycles include the return; whether interrupts preempt it depends
+ *         on PRIMASK and the rest of the current state
+ * @param  args: 放入R0..R3的参数，float按位传入 Arguments for R0..R3, floats passed as bits
+ * @param  max_cycles: 超过即放弃 Give up after this many cycles
+ * @param  ret: R0的返回值，可为NULL R0 on return, may be NULL
+ * @retval 0成功，-1不在线程模式、超时或出错 0 on success, -1 outside thread mode, on timeout or error
+ */
+int Sim_Cm3_Call(SimCm3_t *cpu, uint32_t func, const uint32_t *args, int nargs, uint64_t max_cycles, uint32_t *ret)
+{
+    SimCm3_t *c = cpu;
+    uint32_t saved[16], apsr = c->apsr;
+    uint8_t itstate = c->itstate;
+
+    if (c->depth != 0 || c->halted || nargs > 4)
+        return -1;
+    memcpy(saved, c->r, sizeof(saved));
+    for (int i = 0; i < nargs; i++)
+        c->r[i] = args[i];
+    c->r[14] = SIM_CM3_CALL_RETURN | 1u;
+    c->r[15] = func & ~1u;
+    c->itstate = 0;
+    c->ls_prev = 0;
+    Fetch_Branch(c, c->r[15]);
+    c->stop_pc = SIM_CM3_CALL_RETURN;
+
+    int err = Sim_Cm3_Run(c, c->cycles + max_cycles);
+    int done = err == 0 && c->r[15] == SIM_CM3_CALL_RETURN && c->depth == 0;
+    if (done && ret != NULL)
+        *ret = c->r[0];
+
+    c->stop_pc = SIM_CM3_NO_STOP;
+    memcpy(c->r, saved, sizeof(saved));
+    c->apsr = apsr;
+    c->itstate = itstate;
+    Fetch_Branch(c, c->r[15]);
+    return done ? 0 : -1;
+}
+
+/**
+ * @brief  标记或取消一个Flash地址，执行到时调用on_watch，可叠加
+ *         Mark or unmark a flash address so on_watch runs before it; marks nest
+ */
+void Sim_Cm3_Watch(SimCm3_t *cpu, uint32_t addr, int add)
+{
+    uint32_t off = addr - SIM_CM3_FLASH_BASE;
+    if (off >= SIM_CM3_FLASH_SIZE)
+        return;
+    if (cpu->watch == NULL)
+    {
+        cpu->watch = calloc(SIM_CM3_FLASH_SIZE / 2u, 1);
+        if (cpu->watch == NULL)
+            return;
+    }
+    if (add)
+        cpu->watch[off >> 1]++;
+    else if (cpu->watch[off >> 1] > 0)
+        cpu->watch[off >> 1]--;
+}
+
+// 上电复位：从向量表取MSP和复位向量 Power-on reset: MSP and the reset vector come from the vector table
+void Sim_Cm3_Reset(SimCm3_t *cpu)
+{
+    SimCm3_t *c = cpu;
+
+    memset(c->r, 0, sizeof(c->r));
+    memset(c->sram, 0, sizeof(c->sram));
+    memset(c->enabled, 0, sizeof(c->enabled));
+    memset(c->pending, 0, sizeof(c->pending));
+    memset(c->active, 0, sizeof(c->active));
+    memset(c->prio, 0, sizeof(c->prio));
+    memset(c->nested, 0, sizeof(c->nested));
+    memset(c->entry_at, 0, sizeof(c->entry_at));
+    c->apsr = 0;
+    c->ipsr = 0;
+    c->itstate = 0;
+    c->spsel = 0;
+    c->npriv = 0;
+    c->primask = 0;
+    c->faultmask = 0;
+    c->basepri = 0;
+    c->sp_other = 0;
+    c->cycles = 0;
+    c->instructions = 0;
+    c->branches = 0;
+    c->stop_pc = SIM_CM3_NO_STOP;
+    c->flash_ws = 0;
+    c->prigroup = 0;
+    c->vtor = 0;
+    c->ccr = 0; // r1p1复位时STKALIGN为0 STKALIGN resets to 0 on r1p1
+    c->scr = 0;
+    c->depth = 0;
+    c->irq_check = 0;
+    c->syst_ctrl = 0;
+    c->syst_load = 0;
+    c->syst_val = 0;
+    c->syst_next = CYCLES_NEVER;
+    c->dwt_ctrl = 0;
+    c->demcr = 0;
+    c->ls_prev = 0;
+    c->exc_flow = 0;
+    c->sleeping = 0;
+    c->fetch_line = ~0u;
+    c->fetch_ready = 0;
+    c->board_event = CYCLES_NEVER;
+    c->halted = 0;
+    c->error[0] = '\0';
+    Sim_Cm3_Update_Event(c);
+
+    c->r[13] = Sim_Cm3_Read(c, 0, 4) & ~3u;
+    c->r[15] = Sim_Cm3_Read(c, 4, 4) & ~1u;
+}
+
+SimCm3_t *Sim_Cm3_Create(void)
+{
+    SimCm3_t *cpu = calloc(1, sizeof(*cpu));
+    if (cpu != NULL)
+        memset(cpu->flash, 0xFF, sizeof(cpu->flash));
+    return cpu;
+}
+
+void Sim_Cm3_Destroy(SimCm3_t *cpu)
+{
+    if (cpu == NULL)
+        return;
+    for (uint32_t i = 0; i < cpu->sym_count; i++)
+        free(cpu->sym[i].name);
+    free(cpu->sym);
+    free(cpu->watch);
+    free(cpu);
+}
+
+/* ---------------------------------------------------------------------------
+ * ELF
+ * ------------------------------------------------------------------------- */
+
+static int Sym_Compare(const void *a, const void *b)
+{
+    const SimCm3Sym_t *x = a, *y = b;
+    return x->addr < y->addr ? -1 : x->addr > y->addr;
+}
+
+static void Load_Symbols(SimCm3_t *c, const uint8_t *img, size_t size, const Elf32_Ehdr *eh)
+{
+    if (eh->e_shoff == 0 || eh->e_shoff + (size_t)eh->e_shnum * sizeof(Elf32_Shdr) > size)
+        return;
+    const Elf32_Shdr *sh = (const Elf32_Shdr *)(img + eh->e_shoff);
+
+    for (uint32_t i = 0; i < eh->e_shnum; i++)
+    {
+        if (sh[i].sh_type != SHT_SYMTAB || sh[i].sh_link >= eh->e_shnum)
+            continue;
+        const Elf32_Shdr *str = &sh[sh[i].sh_link];
+        if (sh[i].sh_offset + sh[i].sh_size > size || str->sh_offset + str->sh_size > size)
+            continue;
+        const Elf32_Sym *st = (const Elf32_Sym *)(img + sh[i].sh_offset);
+        uint32_t n = sh[i].sh_size / sizeof(Elf32_Sym);
+
+        c->sym = realloc(c->sym, (c->sym_count + n) * sizeof(SimCm3Sym_t));
+        if (c->sym == NULL)
+        {
+            c->sym_count = 0;
+            return;
+        }
+        for (uint32_t k = 0; k < n; k++)
+        {
+            uint32_t type = ELF32_ST_TYPE(st[k].st_info);
+            if ((type != STT_FUNC && type != STT_OBJECT) || st[k].st_name >= str->sh_size)
+                continue;
+            const char *name = (const char *)img + str->sh_offset + st[k].st_name;
+            if (name[0] == '\0' || name[0] == '$' || name[0] == '.')
+                continue;
+            SimCm3Sym_t *s = &c->sym[c->sym_count++];
+            s->name = strdup(name);
+            s->func = type == STT_FUNC;
+            s->addr = s->func ? st[k].st_value & ~1u : st[k].st_value;
+            s->size = st[k].st_size;
+        }
+    }
+    qsort(c->sym, c->sym_count, sizeof(SimCm3Sym_t), Sym_Compare);
+}
+
+/**
+ * @brief  把ELF的可加载段按加载地址写入Flash/SRAM，并读入符号表
+ *         Copy the ELF loadable segments to flash/SRAM at their load
+ *         addresses and read the symbol table
+ * @note   Keil的RW初值放在Flash中，由__scatterload在启动时复制，因此按物理
+ *         地址(p_paddr)加载
+ *         Keil keeps the RW initial values in flash and __scatterload copies
+ *         them at startup, so segments load at their physical address
+ * @retval 0成功，-1失败 0 on success, -1 on failure
+ */
+int Sim_Cm3_Load_Elf(SimCm3_t *cpu, const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL)
+    {
+        perror(path);
+        return -1;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *img = size > 0 ? malloc((size_t)size) : NULL;
+    int ok = img != NULL && fread(img, 1, (size_t)size, f) == (size_t)size;
+    fclose(f);
+
+    const Elf32_Ehdr *eh = (const Elf32_Ehdr *)img;
+    if (!ok || (size_t)size < sizeof(*eh) || memcmp(eh->e_ident, ELFMAG, SELFMAG) != 0 ||
+        eh->e_ident[EI_CLASS] != ELFCLASS32 || eh->e_ident[EI_DATA] != ELFDATA2LSB || eh->e_machine != EM_ARM ||
+        eh->e_phoff + (size_t)eh->e_phnum * sizeof(Elf32_Phdr) > (size_t)size)
+    {
+        fprintf(stderr, "%s: not a 32-bit little-endian ARM ELF file\n", path);
+        free(img);
+        return -1;
+    }
+
+    const Elf32_Phdr *ph = (const Elf32_Phdr *)(img + eh->e_phoff);
+    for (uint32_t i = 0; i < eh->e_phnum; i++)
+    {
+        if (ph[i].p_type != PT_LOAD || ph[i].p_filesz == 0)
+            continue;
+        uint8_t *dst = Flash_Ptr(cpu, ph[i].p_paddr, ph[i].p_filesz);
+        if (dst == NULL)
+            dst = Sram_Ptr(cpu, ph[i].p_paddr, ph[i].p_filesz);
+        if (dst == NULL || ph[i].p_offset + ph[i].p_filesz > (size_t)size)
+        {
+            fprintf(stderr, "%s: segment at 0x%08x does not fit the STM32F103ZE memory map\n", path, ph[i].p_paddr);
+            free(img);
+            return -1;
+        }
+        memcpy(dst, img + ph[i].p_offset, ph[i].p_filesz);
+    }
+    Load_Symbols(cpu, img, (size_t)size, eh);
+    free(img);
+    return 0;
+}
+
+const SimCm3Sym_t *Sim_Cm3_Find_Sym(const SimCm3_t *cpu, const char *name)
+{
+    for (uint32_t i = 0; i < cpu->sym_count; i++)
+        if (strcmp(cpu->sym[i].name, name) == 0)
+            return &cpu->sym[i];
+    return NULL;
+}
+
+// 包含该地址的函数或变量 The function or object containing the address
+const SimCm3Sym_t *Sim_Cm3_Sym_At(const SimCm3_t *cpu, uint32_t addr)
+{
+    const SimCm3Sym_t *best = NULL;
+    uint32_t lo = 0, hi = cpu->sym_count;
+
+    while (lo < hi)
+    {
+        uint32_t mid = (lo + hi) / 2;
+        if (cpu->sym[mid].addr <= addr)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    for (uint32_t i = lo; i-- > 0;)
+    {
+        const SimCm3Sym_t *s = &cpu->sym[i];
+        if (addr < s->addr + (s->size ? s->size : 1u))
+        {
+            best = s;
+            break;
+        }
+        if (addr - s->addr > 0x10000u)
+            break;
+    }
+    return best;
+}
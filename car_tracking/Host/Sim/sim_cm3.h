@@ -0,0 +1,153 @@
+/*
+ * sim_cm3.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * Cortex-M3指令级仿真核：执行Keil编出的car_tracking.axf中的Thumb/Thumb-2
+ * 代码，带NVIC、SysTick和异常进出栈。片上外设之外的地址交给bus_read/
+ * bus_write，由sim_fil接到仿真主板上。
+ * Cortex-M3 instruction-level core: executes the Thumb/Thumb-2 code of the
+ * Keil-built car_tracking.axf, with the NVIC, SysTick and exception
+ * stacking. Addresses outside the core go to bus_read/bus_write, which
+ * sim_fil wires to the simulated board.
+ *
+ * 周期数按Cortex-M3 TRM的指令时序表计：LDR/STR为2，相邻的单次访存流水
+ * 为1，LDM/STM为1+N，跳转为1+P，乘除法按操作数提前结束，异常进入12、
+ * 退出10、咬尾6；取指按STM32F1的64位预取缓冲和FLASH_ACR等待周期建模。
+ * 这是时序表模型而非门级模型，不含总线争用，与实物可能差几个百分点。
+ * Cycles follow the instruction timing table of the Cortex-M3 TRM: LDR/STR
+ * 2, neighbouring single loads/stores pipeline to 1, LDM/STM 1+N, branches
+ * 1+P, multiply and divide terminate early on operand size, exception entry
+ * 12, exit 10, tail-chain 6. Fetch models the STM32F1 64-bit prefetch
+ * buffer with the FLASH_ACR wait states. It is a timing-table model, not a
+ * gate-level one: there is no bus contention and silicon may differ by a
+ * few percent.
+ */
+
+#ifndef HOST_SIM_CM3_H_
+#define HOST_SIM_CM3_H_
+
+#include <stdint.h>
+
+#define SIM_CM3_FLASH_BASE (0x08000000u)
+#define SIM_CM3_FLASH_SIZE (512u * 1024u) // STM32F103ZE
+#define SIM_CM3_SRAM_BASE  (0x20000000u)
+#define SIM_CM3_SRAM_SIZE  (64u * 1024u)
+
+#define SIM_CM3_IRQS  (60)
+#define SIM_CM3_EXCS  (16 + SIM_CM3_IRQS)
+#define SIM_CM3_DEPTH (16) // 跟踪的最大异常嵌套 Deepest exception nesting tracked
+
+#define SIM_CM3_EXC_SYSTICK (15)
+#define SIM_CM3_CALL_RETURN (SIM_CM3_FLASH_BASE + SIM_CM3_FLASH_SIZE - 2u) // Sim_Cm3_Call的返回地址 Return address for Sim_Cm3_Call
+#define SIM_CM3_NO_STOP     (0xFFFFFFFFu)
+#define SIM_CM3_EXC_IRQ(n)  (16 + (n))
+
+typedef struct _sim_cm3 SimCm3_t;
+
+// 片外访问，size为1、2或4字节 Off-core access, size is 1, 2 or 4 bytes
+typedef uint32_t (*SimCm3Read_t)(SimCm3_t *cpu, uint32_t addr, uint32_t size);
+typedef void (*SimCm3Write_t)(SimCm3_t *cpu, uint32_t addr, uint32_t value, uint32_t size);
+// 到达next_event时调用，应推进外设并重设next_event When next_event is reached: step the peripherals and move next_event
+typedef void (*SimCm3Event_t)(SimCm3_t *cpu);
+// 执行watch中标记的地址之前调用 Called before executing an address marked in watch
+typedef void (*SimCm3Watch_t)(SimCm3_t *cpu, uint32_t pc);
+// 异常进入(enter=1)和退出(enter=0)，at为开始进栈或出栈完成的周期
+// Exception entry (enter=1) and exit (enter=0); at is the cycle stacking starts or unstacking ends
+typedef void (*SimCm3Exc_t)(SimCm3_t *cpu, uint32_t exc, int enter, uint64_t at);
+
+typedef struct
+{
+    char *name;
+    uint32_t addr; // 函数已去掉Thumb位 Thumb bit cleared for functions
+    uint32_t size;
+    uint8_t func;
+} SimCm3Sym_t;
+
+struct _sim_cm3
+{
+    uint32_t r[16];
+    uint32_t apsr;      // 位31..27为NZCVQ NZCVQ in bits 31..27
+    uint32_t ipsr;      // 当前异常号，0为线程模式 Current exception, 0 in thread mode
+    uint8_t itstate;
+    uint8_t spsel;      // CONTROL.SPSEL
+    uint8_t npriv;      // CONTROL.nPRIV
+    uint8_t primask;
+    uint8_t faultmask;
+    uint8_t basepri;
+    uint32_t sp_other;  // 未选中的栈指针 The banked stack pointer not in use
+    uint64_t cycles;
+
+    uint8_t flash[SIM_CM3_FLASH_SIZE];
+    uint8_t sram[SIM_CM3_SRAM_SIZE];
+    uint8_t flash_ws;   // 取指和读Flash的等待周期 Wait states for flash fetch and reads
+
+    // NVIC/SCB
+    uint8_t enabled[SIM_CM3_EXCS];
+    uint8_t pending[SIM_CM3_EXCS];
+    uint8_t active[SIM_CM3_EXCS];
+    uint8_t prio[SIM_CM3_EXCS];
+    uint32_t prigroup;
+    uint32_t vtor;
+    uint32_t ccr;
+    uint32_t scr;
+    uint8_t stack[SIM_CM3_DEPTH]; // 嵌套中的异常，由外到内 Active exceptions, outermost first
+    uint32_t depth;
+    uint64_t nested[SIM_CM3_DEPTH + 1]; // 各嵌套层被更高层占用的周期 Cycles taken from each level by deeper ones
+    uint64_t entry_at[SIM_CM3_DEPTH + 1];
+    uint8_t irq_check;  // 挂起或屏蔽状态有变，需重新判断 Pending or masking changed, re-evaluate
+
+    // SysTick
+    uint32_t syst_ctrl;
+    uint32_t syst_load;
+    uint32_t syst_val;  // 停止时的当前值 Current value while stopped
+    uint64_t syst_next; // 下一次减到0的周期 Cycle of the next count to zero
+    uint32_t dwt_ctrl;
+    uint32_t demcr;
+
+    // 执行状态 Execution state
+    uint32_t next_pc;
+    uint8_t branched;
+    uint8_t ls_prev;    // 上一条是单次访存，本条可流水 The previous instruction was a single load/store
+    uint8_t ls_now;
+    uint8_t exc_flow;   // 本条指令引发了异常返回 This instruction returned from an exception
+    uint8_t sleeping;
+    uint32_t fetch_line;
+    uint64_t fetch_ready;
+    uint32_t stop_pc;   // 执行到此地址时Sim_Cm3_Run返回 Sim_Cm3_Run returns on reaching this address
+    uint64_t instructions; // 已执行的指令，含IT中跳过的 Instructions executed, IT-skipped included
+    uint64_t branches;  // 改变程序流的指令(流水线重新填充) Taken branches (pipeline refills)
+
+    uint64_t next_event;
+    uint64_t board_event;
+    SimCm3Event_t on_event;
+    SimCm3Read_t bus_read;
+    SimCm3Write_t bus_write;
+    SimCm3Exc_t on_exception;
+    SimCm3Watch_t on_watch;
+    uint8_t *watch;     // 每个Flash半字一个计数，非0时调用on_watch One count per flash halfword
+    void *ctx;
+
+    SimCm3Sym_t *sym;
+    uint32_t sym_count;
+
+    int halted;
+    char error[128];
+};
+
+SimCm3_t *Sim_Cm3_Create(void);
+void Sim_Cm3_Destroy(SimCm3_t *cpu);
+int Sim_Cm3_Load_Elf(SimCm3_t *cpu, const char *path);
+const SimCm3Sym_t *Sim_Cm3_Find_Sym(const SimCm3_t *cpu, const char *name);
+const SimCm3Sym_t *Sim_Cm3_Sym_At(const SimCm3_t *cpu, uint32_t addr);
+void Sim_Cm3_Reset(SimCm3_t *cpu);
+int Sim_Cm3_Run(SimCm3_t *cpu, uint64_t until);
+void Sim_Cm3_Set_Pending(SimCm3_t *cpu, uint32_t exc);
+void Sim_Cm3_Update_Event(SimCm3_t *cpu);
+uint32_t Sim_Cm3_Read(SimCm3_t *cpu, uint32_t addr, uint32_t size);
+void Sim_Cm3_Write(SimCm3_t *cpu, uint32_t addr, uint32_t value, uint32_t size);
+int Sim_Cm3_Call(SimCm3_t *cpu, uint32_t func, const uint32_t *args, int nargs, uint64_t max_cycles, uint32_t *ret);
+void Sim_Cm3_Watch(SimCm3_t *cpu, uint32_t addr, int add);
+
+#endif /* HOST_SIM_CM3_H_ */
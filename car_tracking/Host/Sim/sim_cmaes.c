@@ -0,0 +1,262 @@
+/*
+ * sim_cmaes.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * 更新公式按Hansen的CMA-ES教程(arXiv:1604.00772)中的标准参数设置。
+ * Update equations and default strategy parameters follow Hansen's CMA-ES
+ * tutorial (arXiv:1604.00772).
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "sim_cmaes.h"
+
+// xorshift64*，结果在[0,1) xorshift64*, result in [0,1)
+static double Rand_Uniform(SimCmaes_t *es)
+{
+    es->rng ^= es->rng >> 12;
+    es->rng ^= es->rng << 25;
+    es->rng ^= es->rng >> 27;
+    return ((es->rng * 0x2545F4914F6CDD1DULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Box-Muller标准正态 Standard normal by Box-Muller
+static double Rand_Gauss(SimCmaes_t *es)
+{
+    if (es->has_spare)
+    {
+        es->has_spare = 0;
+        return es->gauss_spare;
+    }
+    double u = 1.0 - Rand_Uniform(es), v = Rand_Uniform(es);
+    double r = sqrt(-2.0 * log(u));
+    es->gauss_spare = r * sin(2.0 * M_PI * v);
+    es->has_spare = 1;
+    return r * cos(2.0 * M_PI * v);
+}
+
+/**
+ * @brief  Jacobi迭代求C的特征分解，结果写入B和D
+ *         Eigendecomposition of C by cyclic Jacobi rotations into B and D
+ */
+static void Eigen_Update(SimCmaes_t *es)
+{
+    int n = es->dim;
+    double a[SIM_CMAES_MAX_DIM][SIM_CMAES_MAX_DIM];
+
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            a[i][j] = es->C[i][j];
+            es->B[i][j] = i == j;
+        }
+    }
+
+    for (int sweep = 0; sweep < 64; sweep++)
+    {
+        double off = 0.0;
+        for (int p = 0; p < n; p++)
+            for (int q = p + 1; q < n; q++)
+                off += a[p][q] * a[p][q];
+        if (off < 1e-30)
+            break;
+
+        for (int p = 0; p < n; p++)
+        {
+            for (int q = p + 1; q < n; q++)
+            {
+                if (fabs(a[p][q]) < 1e-300)
+                    continue;
+                double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+                double t = (theta >= 0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+                double c = 1.0 / sqrt(t * t + 1.0), s = t * c;
+
+                for (int k = 0; k < n; k++)
+                {
+                    double akp = a[k][p], akq = a[k][q];
+                    a[k][p] = c * akp - s * akq;
+                    a[k][q] = s * akp + c * akq;
+                }
+                for (int k = 0; k < n; k++)
+                {
+                    double apk = a[p][k], aqk = a[q][k];
+                    a[p][k] = c * apk - s * aqk;
+                    a[q][k] = s * apk + c * aqk;
+                }
+                for (int k = 0; k < n; k++)
+                {
+                    double bkp = es->B[k][p], bkq = es->B[k][q];
+                    es->B[k][p] = c * bkp - s * bkq;
+                    es->B[k][q] = s * bkp + c * bkq;
+                }
+            }
+        }
+    }
+
+    // 数值误差可能产生极小的负特征值 Rounding can leave tiny negative eigenvalues
+    for (int i = 0; i < n; i++)
+        es->D[i] = sqrt(a[i][i] > 1e-20 ? a[i][i] : 1e-20);
+}
+
+/**
+ * @brief  初始化优化器
+ *         Initialise the optimiser
+ * @param  x0: 初始均值 Initial mean
+ * @param  sigma: 初始步长 Initial step size
+ * @param  lambda: 每代候选数，<=0用默认值4+3ln(dim) Candidates per generation, <=0 for 4+3ln(dim)
+ * @retval 0成功，-1参数超出范围 0 on success, -1 when dim or lambda is out of range
+ */
+int Sim_Cmaes_Init(SimCmaes_t *es, int dim, const double *x0, double sigma, int lambda, uint64_t seed)
+{
+    if (lambda <= 0)
+        lambda = 4 + (int)(3.0 * log((double)dim));
+    if (dim < 1 || dim > SIM_CMAES_MAX_DIM || lambda < 2 || lambda > SIM_CMAES_MAX_POP)
+        return -1;
+
+    memset(es, 0, sizeof(*es));
+    es->dim = dim;
+    es->lambda = lambda;
+    es->mu = lambda / 2;
+    es->sigma = sigma;
+    es->rng = seed ? seed : 0x9E3779B97F4A7C15ULL;
+
+    double sum = 0.0, sum_sq = 0.0;
+    for (int i = 0; i < es->mu; i++)
+    {
+        es->weights[i] = log(es->mu + 0.5) - log(i + 1.0);
+        sum += es->weights[i];
+    }
+    for (int i = 0; i < es->mu; i++)
+    {
+        es->weights[i] /= sum;
+        sum_sq += es->weights[i] * es->weights[i];
+    }
+    es->mueff = 1.0 / sum_sq;
+
+    double n = dim;
+    es->cc = (4.0 + es->mueff / n) / (n + 4.0 + 2.0 * es->mueff / n);
+    es->cs = (es->mueff + 2.0) / (n + es->mueff + 5.0);
+    es->c1 = 2.0 / ((n + 1.3) * (n + 1.3) + es->mueff);
+    es->cmu = 2.0 * (es->mueff - 2.0 + 1.0 / es->mueff) / ((n + 2.0) * (n + 2.0) + es->mueff);
+    if (es->cmu > 1.0 - es->c1)
+        es->cmu = 1.0 - es->c1;
+    double d = sqrt((es->mueff - 1.0) / (n + 1.0)) - 1.0;
+    es->damps = 1.0 + 2.0 * (d > 0.0 ? d : 0.0) + es->cs;
+    es->chi_n = sqrt(n) * (1.0 - 1.0 / (4.0 * n) + 1.0 / (21.0 * n * n));
+
+    for (int i = 0; i < dim; i++)
+    {
+        es->mean[i] = x0[i];
+        es->C[i][i] = 1.0;
+        es->B[i][i] = 1.0;
+        es->D[i] = 1.0;
+    }
+    return 0;
+}
+
+/**
+ * @brief  采样本代lambda个候选点到es->x
+ *         Sample this generation's lambda candidates into es->x
+ */
+void Sim_Cmaes_Ask(SimCmaes_t *es)
+{
+    int n = es->dim;
+    for (int k = 0; k < es->lambda; k++)
+    {
+        double z[SIM_CMAES_MAX_DIM];
+        for (int i = 0; i < n; i++)
+            z[i] = es->D[i] * Rand_Gauss(es);
+        for (int i = 0; i < n; i++)
+        {
+            double y = 0.0;
+            for (int j = 0; j < n; j++)
+                y += es->B[i][j] * z[j];
+            es->x[k][i] = es->mean[i] + es->sigma * y;
+        }
+    }
+}
+
+/**
+ * @brief  按各候选的代价更新分布
+ *         Update the distribution from the cost of each candidate
+ * @param  cost: lambda个代价，越小越好 lambda costs, lower is better
+ */
+void Sim_Cmaes_Tell(SimCmaes_t *es, const double *cost)
+{
+    int n = es->dim;
+    int order[SIM_CMAES_MAX_POP];
+
+    // 候选数很少，插入排序即可 Few candidates, insertion sort is enough
+    for (int k = 0; k < es->lambda; k++)
+    {
+        int j = k;
+        while (j > 0 && cost[order[j - 1]] > cost[k])
+        {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = k;
+    }
+
+    double old[SIM_CMAES_MAX_DIM], yw[SIM_CMAES_MAX_DIM];
+    for (int i = 0; i < n; i++)
+    {
+        old[i] = es->mean[i];
+        es->mean[i] = 0.0;
+        for (int k = 0; k < es->mu; k++)
+            es->mean[i] += es->weights[k] * es->x[order[k]][i];
+        yw[i] = (es->mean[i] - old[i]) / es->sigma;
+    }
+
+    // ps沿C^-1/2 * yw = B D^-1 B' yw更新 ps uses C^-1/2 * yw = B D^-1 B' yw
+    double t[SIM_CMAES_MAX_DIM];
+    for (int j = 0; j < n; j++)
+    {
+        double s = 0.0;
+        for (int i = 0; i < n; i++)
+            s += es->B[i][j] * yw[i];
+        t[j] = s / es->D[j];
+    }
+    double ps_norm = 0.0, cs_gain = sqrt(es->cs * (2.0 - es->cs) * es->mueff);
+    for (int i = 0; i < n; i++)
+    {
+        double s = 0.0;
+        for (int j = 0; j < n; j++)
+            s += es->B[i][j] * t[j];
+        es->ps[i] = (1.0 - es->cs) * es->ps[i] + cs_gain * s;
+        ps_norm += es->ps[i] * es->ps[i];
+    }
+    ps_norm = sqrt(ps_norm);
+
+    es->generation++;
+    double h_den = sqrt(1.0 - pow(1.0 - es->cs, 2.0 * es->generation));
+    int hsig = ps_norm / h_den / es->chi_n < 1.4 + 2.0 / (n + 1.0);
+    double cc_gain = sqrt(es->cc * (2.0 - es->cc) * es->mueff);
+    for (int i = 0; i < n; i++)
+        es->pc[i] = (1.0 - es->cc) * es->pc[i] + hsig * cc_gain * yw[i];
+
+    // 秩一与秩mu更新 Rank-one and rank-mu update
+    double keep = 1.0 - es->c1 - es->cmu + (1 - hsig) * es->c1 * es->cc * (2.0 - es->cc);
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j <= i; j++)
+        {
+            double rank_mu = 0.0;
+            for (int k = 0; k < es->mu; k++)
+            {
+                const double *x = es->x[order[k]];
+                rank_mu += es->weights[k] * (x[i] - old[i]) * (x[j] - old[j]);
+            }
+            rank_mu /= es->sigma * es->sigma;
+            es->C[i][j] = keep * es->C[i][j] + es->c1 * es->pc[i] * es->pc[j] + es->cmu * rank_mu;
+            es->C[j][i] = es->C[i][j];
+        }
+    }
+
+    es->sigma *= exp(es->cs / es->damps * (ps_norm / es->chi_n - 1.0));
+    Eigen_Update(es);
+}
@@ -0,0 +1,52 @@
+/*
+ * sim_cmaes.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * CMA-ES黑盒优化器（协方差矩阵自适应进化策略）。每代先用Ask取出
+ * lambda个候选点，外部评估后把代价交给Tell更新均值、步长和协方差。
+ * 只负责采样与更新，边界和约束由调用者处理。
+ * CMA-ES black-box optimiser (covariance matrix adaptation evolution
+ * strategy). Each generation Ask hands out lambda candidates; once the caller
+ * has evaluated them, Tell takes the costs and updates the mean, step size
+ * and covariance. Bounds and constraints are left to the caller.
+ */
+
+#ifndef HOST_SIM_CMAES_H_
+#define HOST_SIM_CMAES_H_
+
+#include <stdint.h>
+
+#define SIM_CMAES_MAX_DIM (16)
+#define SIM_CMAES_MAX_POP (64)
+
+typedef struct
+{
+    int dim;
+    int lambda;       // 每代候选数 Candidates per generation
+    int mu;           // 参与重组的最优个数 Best candidates recombined
+    double weights[SIM_CMAES_MAX_POP];
+    double mueff;
+    double cc, cs, c1, cmu, damps, chi_n;
+
+    double sigma;     // 全局步长 Global step size
+    double mean[SIM_CMAES_MAX_DIM];
+    double pc[SIM_CMAES_MAX_DIM];   // 协方差进化路径 Covariance evolution path
+    double ps[SIM_CMAES_MAX_DIM];   // 步长进化路径 Step-size evolution path
+    double C[SIM_CMAES_MAX_DIM][SIM_CMAES_MAX_DIM];
+    double B[SIM_CMAES_MAX_DIM][SIM_CMAES_MAX_DIM]; // C的特征向量(列) Eigenvectors of C, by column
+    double D[SIM_CMAES_MAX_DIM];    // 特征值的平方根 Square roots of the eigenvalues
+
+    double x[SIM_CMAES_MAX_POP][SIM_CMAES_MAX_DIM]; // 本代候选 Current candidates
+    int generation;
+    uint64_t rng;
+    double gauss_spare;
+    uint8_t has_spare;
+} SimCmaes_t;
+
+int Sim_Cmaes_Init(SimCmaes_t *es, int dim, const double *x0, double sigma, int lambda, uint64_t seed);
+void Sim_Cmaes_Ask(SimCmaes_t *es);
+void Sim_Cmaes_Tell(SimCmaes_t *es, const double *cost);
+
+#endif /* HOST_SIM_CMAES_H_ */
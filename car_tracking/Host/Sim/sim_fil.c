@@ -0,0 +1,486 @@
+/*
+ * sim_fil.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim_fil.h"
+#include "hal_shim.h"
+
+#define PERIPH_BASE   (0x40000000u)
+#define PERIPH_SIZE   (0x30000u)
+#define GPIOA_BASE    (0x40010800u)
+#define RCC_BASE      (0x40021000u)
+#define FLASH_R_BASE  (0x40022000u)
+#define TIM6_INDEX    (6u)
+
+#define RCC_CR   (0x00u / 4u)
+#define RCC_CFGR (0x04u / 4u)
+#define RCC_BDCR (0x20u / 4u)
+#define RCC_CSR  (0x24u / 4u)
+
+#define TIM_CR1_URS (1u << 2)
+#define TIM_SR_UIF  (1u << 0)
+#define TIM_DIER_UIE (1u << 0)
+
+#define NEVER (~(uint64_t)0)
+
+// 定时器编号与基地址，编号即Shim_TIM_Regs下标 Timer number and base; the number indexes Shim_TIM_Regs
+static const struct
+{
+    uint32_t base;
+    uint32_t index;
+} s_tim_map[] = {
+    {0x40000000u, 2}, {0x40000400u, 3}, {0x40000800u, 4}, {0x40000C00u, 5},
+    {0x40001000u, 6}, {0x40001400u, 7}, {0x40012C00u, 1}, {0x40013400u, 8},
+};
+
+static volatile uint32_t *Fil_Tim(uint32_t addr, uint32_t *index)
+{
+    for (size_t i = 0; i < sizeof(s_tim_map) / sizeof(s_tim_map[0]); i++)
+    {
+        if ((addr & ~0x3FFu) == s_tim_map[i].base && (addr & 0x3FFu) < sizeof(TIM_TypeDef))
+        {
+            *index = s_tim_map[i].index;
+            return (volatile uint32_t *)&Shim_TIM_Regs[s_tim_map[i].index];
+        }
+    }
+    return NULL;
+}
+
+static GPIO_TypeDef *Fil_Gpio(uint32_t addr)
+{
+    uint32_t off = addr - GPIOA_BASE;
+    if (off < SHIM_GPIO_PORTS * 0x400u && (off & 0x3FFu) < sizeof(GPIO_TypeDef))
+        return &Shim_GPIO_Regs[off >> 10];
+    return NULL;
+}
+
+// CRL/CRH中MODE非0的引脚为输出 Pins whose CRL/CRH MODE is non-zero are outputs
+static uint32_t Gpio_Output_Mask(const GPIO_TypeDef *port)
+{
+    uint32_t mask = 0;
+    for (uint32_t pin = 0; pin < 16; pin++)
+    {
+        uint32_t cfg = (pin < 8 ? port->CRL >> (pin * 4u) : port->CRH >> ((pin - 8u) * 4u)) & 0xFu;
+        if (cfg & 3u)
+            mask |= 1u << pin;
+    }
+    return mask;
+}
+
+/* ---------------------------------------------------------------------------
+ * TIM6
+ * ------------------------------------------------------------------------- */
+
+// 72MHz的APB1经/2分频，定时器时钟倍频回72MHz APB1 runs at 36 MHz, so the timer clock doubles back to 72 MHz
+static uint64_t Tim6_Tick(const SimFil_t *fil)
+{
+    return (uint64_t)fil->tim6_psc + 1u;
+}
+
+static uint32_t Tim6_Count(const SimFil_t *fil)
+{
+    const TIM_TypeDef *t = &Shim_TIM_Regs[TIM6_INDEX];
+    if (!(t->CR1 & TIM_CR1_CEN))
+        return t->CNT;
+    return (uint32_t)((fil->cpu->cycles - fil->tim6_origin) / Tim6_Tick(fil)) & 0xFFFFu;
+}
+
+static void Fil_Update_Event(SimFil_t *fil)
+{
+    fil->cpu->board_event = fil->next_step < fil->tim6_next ? fil->next_step : fil->tim6_next;
+    Sim_Cm3_Update_Event(fil->cpu);
+}
+
+static void Tim6_Schedule(SimFil_t *fil)
+{
+    const TIM_TypeDef *t = &Shim_TIM_Regs[TIM6_INDEX];
+    fil->tim6_next = (t->CR1 & TIM_CR1_CEN) ? fil->tim6_origin + ((t->ARR & 0xFFFFu) + 1u) * Tim6_Tick(fil) : NEVER;
+    Fil_Update_Event(fil);
+}
+
+// 计数溢出：装载预分频，置UIF，允许时挂起中断 Overflow: load the prescaler, set UIF and pend the IRQ if enabled
+static void Tim6_Update(SimFil_t *fil)
+{
+    TIM_TypeDef *t = &Shim_TIM_Regs[TIM6_INDEX];
+    fil->tim6_origin = fil->tim6_next;
+    fil->tim6_psc = t->PSC & 0xFFFFu;
+    fil->tim6_updates++;
+    t->SR |= TIM_SR_UIF;
+    if (t->DIER & TIM_DIER_UIE)
+        Sim_Cm3_Set_Pending(fil->cpu, SIM_CM3_EXC_IRQ(SIM_FIL_TIM6_IRQ));
+    Tim6_Schedule(fil);
+}
+
+static void Tim_Write(SimFil_t *fil, uint32_t index, volatile uint32_t *reg, uint32_t off, uint32_t v)
+{
+    TIM_TypeDef *t = &Shim_TIM_Regs[index];
+    uint32_t running = index == TIM6_INDEX && (t->CR1 & TIM_CR1_CEN);
+
+    if (index == TIM6_INDEX && running)
+        t->CNT = Tim6_Count(fil);
+    switch (off)
+    {
+    case offsetof(TIM_TypeDef, SR): // rc_w0
+        t->SR &= v;
+        return;
+    case offsetof(TIM_TypeDef, EGR):
+        if (v & 1u) // UG：计数清零，装载预分频 UG: clear the count, load the prescaler
+        {
+            t->CNT = 0;
+            if (!(t->CR1 & TIM_CR1_URS))
+                t->SR |= TIM_SR_UIF;
+            if (index == TIM6_INDEX)
+                fil->tim6_psc = t->PSC & 0xFFFFu;
+        }
+        t->SR |= v & 0x1Eu;
+        break;
+    default:
+        *reg = v;
+        break;
+    }
+    if (index == TIM6_INDEX)
+    {
+        fil->tim6_origin = fil->cpu->cycles - (uint64_t)(t->CNT & 0xFFFFu) * Tim6_Tick(fil);
+        Tim6_Schedule(fil);
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * 总线 Bus
+ * ------------------------------------------------------------------------- */
+
+static uint32_t Fil_Read_Word(SimFil_t *fil, uint32_t a)
+{
+    volatile uint32_t *tim;
+    GPIO_TypeDef *gpio;
+    uint32_t index;
+
+    if ((gpio = Fil_Gpio(a)) != NULL)
+    {
+        uint32_t off = a & 0x3FFu;
+        if (off == offsetof(GPIO_TypeDef, IDR))
+        {
+            // 输出引脚读回ODR；按键接地，按下时即使引脚被配成输出也读到低电平
+            // (MX_GPIO_Init把PG3/PG4与RGB引脚一起配成了推挽输出)
+            // Output pins read back their ODR; keys short to ground, so a pressed key
+            // reads low even on a pin configured as output (MX_GPIO_Init sets PG3/PG4
+            // push-pull together with the RGB pins)
+            uint32_t out = Gpio_Output_Mask(gpio);
+            uint32_t ext = gpio == KEY_GPIO_Port ? KEY1_Pin | KEY2_Pin | KEY3_Pin : 0u;
+            return ((gpio->IDR & ~out) | (gpio->ODR & out & (gpio->IDR | ~ext))) & 0xFFFFu;
+        }
+        if (off == offsetof(GPIO_TypeDef, BSRR) || off == offsetof(GPIO_TypeDef, BRR))
+            return 0;
+        return ((volatile uint32_t *)gpio)[off / 4u];
+    }
+    if ((tim = Fil_Tim(a, &index)) != NULL)
+    {
+        uint32_t off = a & 0x3FFu;
+        if (index == TIM6_INDEX && off == offsetof(TIM_TypeDef, CNT))
+            return Tim6_Count(fil);
+        return off == offsetof(TIM_TypeDef, EGR) ? 0u : tim[off / 4u];
+    }
+    if (a - RCC_BASE < sizeof(fil->rcc))
+    {
+        // 振荡器和PLL立即就绪，时钟切换立即生效 Oscillators and the PLL are ready at once; clock switches apply at once
+        uint32_t i = (a - RCC_BASE) / 4u, v = fil->rcc[i];
+        if (i == RCC_CR)
+            v |= (v & 1u) << 1 | (v & (1u << 16)) << 1 | (v & (1u << 24)) << 1;
+        else if (i == RCC_CFGR)
+            v = (v & ~0xCu) | (v & 3u) << 2;
+        else if (i == RCC_BDCR || i == RCC_CSR)
+            v |= (v & 1u) << 1;
+        return v;
+    }
+    if (a == FLASH_R_BASE)
+        return fil->flash_acr;
+    if (a - PERIPH_BASE < PERIPH_SIZE)
+        return *(uint32_t *)&fil->periph[a - PERIPH_BASE];
+    return 0;
+}
+
+static uint32_t Fil_Bus_Read(SimCm3_t *cpu, uint32_t addr, uint32_t size)
+{
+    uint32_t word = Fil_Read_Word(cpu->ctx, addr & ~3u);
+    word >>= (addr & 3u) * 8u;
+    return size == 4 ? word : word & ((1u << (size * 8u)) - 1u);
+}
+
+static void Fil_Bus_Write(SimCm3_t *cpu, uint32_t addr, uint32_t value, uint32_t size)
+{
+    SimFil_t *fil = cpu->ctx;
+    uint32_t a = addr & ~3u, shift = (addr & 3u) * 8u;
+    volatile uint32_t *tim;
+    GPIO_TypeDef *gpio;
+    uint32_t index;
+
+    // 半字/字节写并入所在的字 Halfword/byte writes merge into their word
+    uint32_t mask = size == 4 ? ~0u : ((1u << (size * 8u)) - 1u) << shift;
+    value = (value << shift) & mask;
+
+    if ((gpio = Fil_Gpio(a)) != NULL)
+    {
+        uint32_t off = a & 0x3FFu;
+        if (off == offsetof(GPIO_TypeDef, BSRR))
+            gpio->ODR = ((gpio->ODR & ~(value >> 16)) | (value & 0xFFFFu)) & 0xFFFFu;
+        else if (off == offsetof(GPIO_TypeDef, BRR))
+            gpio->ODR &= ~(value & 0xFFFFu);
+        else if (off != offsetof(GPIO_TypeDef, IDR))
+            ((volatile uint32_t *)gpio)[off / 4u] = (((volatile uint32_t *)gpio)[off / 4u] & ~mask) | value;
+        return;
+    }
+    if ((tim = Fil_Tim(a, &index)) != NULL)
+    {
+        uint32_t off = a & 0x3FFu;
+        // SR写1无效，未写到的位按1处理 Writing 1 to SR has no effect, so unwritten bits count as 1
+        uint32_t v = off == offsetof(TIM_TypeDef, SR) ? value | ~mask : (tim[off / 4u] & ~mask) | value;
+        Tim_Write(fil, index, &tim[off / 4u], off, v);
+        return;
+    }
+    if (a - RCC_BASE < sizeof(fil->rcc))
+    {
+        uint32_t i = (a - RCC_BASE) / 4u;
+        fil->rcc[i] = (fil->rcc[i] & ~mask) | value;
+        return;
+    }
+    if (a == FLASH_R_BASE)
+    {
+        fil->flash_acr = (fil->flash_acr & ~mask) | value;
+        cpu->flash_ws = fil->flash_acr & 7u;
+        return;
+    }
+    if (a - PERIPH_BASE < PERIPH_SIZE)
+    {
+        uint32_t *p = (uint32_t *)&fil->periph[a - PERIPH_BASE];
+        *p = (*p & ~mask) | value;
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * 外设事件 Peripheral events
+ * ------------------------------------------------------------------------- */
+
+static void Fil_On_Event(SimCm3_t *cpu)
+{
+    SimFil_t *fil = cpu->ctx;
+
+    while (cpu->cycles >= fil->next_step)
+    {
+        Sim_Board_Step(&fil->board);
+        fil->next_step += (uint64_t)SIM_STEP_US * SIM_FIL_CYCLES_PER_US;
+    }
+    while (cpu->cycles >= fil->tim6_next)
+        Tim6_Update(fil);
+    Fil_Update_Event(fil);
+}
+
+/* ---------------------------------------------------------------------------
+ * 探针 Probes
+ * ------------------------------------------------------------------------- */
+
+static void Probe_Add(SimFil_t *fil, int idx, uint64_t at, uint32_t cycles)
+{
+    SimFilProbe_t *p = &fil->probe[idx];
+    p->calls++;
+    p->total += cycles;
+    if (p->calls == 1 || cycles < p->min)
+        p->min = cycles;
+    if (cycles > p->max)
+        p->max = cycles;
+    if (fil->on_sample != NULL)
+        fil->on_sample(fil, idx, at, cycles, fil->on_sample_ctx);
+}
+
+static void Frame_Close(SimFil_t *fil, uint64_t end)
+{
+    SimCm3_t *cpu = fil->cpu;
+    SimFilFrame_t *f = &fil->frame[--fil->frame_count];
+    uint64_t nested = f->depth <= SIM_CM3_DEPTH ? cpu->nested[f->depth] - f->nested : 0;
+
+    if ((f->ret >> 28) != 0xFu)
+        Sim_Cm3_Watch(cpu, f->ret, 0);
+    Probe_Add(fil, f->probe, f->start, (uint32_t)(end - f->start - nested));
+}
+
+static void Fil_On_Watch(SimCm3_t *cpu, uint32_t pc)
+{
+    SimFil_t *fil = cpu->ctx;
+
+    // 回到调用者且栈已恢复即调用结束 A call ends when control is back at the caller with the stack restored
+    while (fil->frame_count > 0)
+    {
+        const SimFilFrame_t *f = &fil->frame[fil->frame_count - 1];
+        if (f->ret != pc || f->sp != cpu->r[13] || f->depth != cpu->depth)
+            break;
+        Frame_Close(fil, cpu->cycles);
+    }
+
+    for (int i = 0; i < fil->probe_count; i++)
+    {
+        if (fil->probe[i].addr != pc || fil->frame_count >= SIM_FIL_FRAMES)
+            continue;
+        SimFilFrame_t *f = &fil->frame[fil->frame_count++];
+        f->probe = i;
+        f->ret = (cpu->r[14] >> 28) == 0xFu ? cpu->r[14] : cpu->r[14] & ~1u;
+        f->sp = cpu->r[13];
+        f->depth = cpu->depth;
+        f->start = cpu->cycles;
+        f->nested = cpu->depth <= SIM_CM3_DEPTH ? cpu->nested[cpu->depth] : 0;
+        if ((f->ret >> 28) != 0xFu)
+            Sim_Cm3_Watch(cpu, f->ret, 1);
+    }
+}
+
+static void Fil_On_Exception(SimCm3_t *cpu, uint32_t exc, int enter, uint64_t at)
+{
+    SimFil_t *fil = cpu->ctx;
+
+    if (!enter)
+    {
+        // 异常处理函数本身以EXC_RETURN返回 Handlers themselves return through EXC_RETURN
+        while (fil->frame_count > 0 && fil->frame[fil->frame_count - 1].depth > cpu->depth)
+            Frame_Close(fil, at);
+    }
+    for (int i = 0; i < fil->probe_count; i++)
+    {
+        SimFilProbe_t *p = &fil->probe[i];
+        if (p->addr != 0 || p->exc != exc)
+            continue;
+        if (enter)
+            p->open_at = at;
+        else
+            Probe_Add(fil, i, p->open_at, (uint32_t)(at - p->open_at));
+    }
+}
+
+/**
+ * @brief  为函数加探针
+ *         Add a probe on a function
+ * @retval 探针序号，找不到符号或探针已满时为-1 Probe index, -1 if the symbol is missing or the probes are full
+ */
+int Sim_Fil_Probe(SimFil_t *fil, const char *func)
+{
+    const SimCm3Sym_t *s = Sim_Cm3_Find_Sym(fil->cpu, func);
+    if (s == NULL || !s->func || fil->probe_count >= SIM_FIL_PROBES)
+        return -1;
+    SimFilProbe_t *p = &fil->probe[fil->probe_count];
+    memset(p, 0, sizeof(*p));
+    snprintf(p->name, sizeof(p->name), "%s", func);
+    p->addr = s->addr;
+    Sim_Cm3_Watch(fil->cpu, s->addr, 1);
+    return fil->probe_count++;
+}
+
+// 为外设中断加探针，含进栈和出栈 Add a probe on a peripheral interrupt, stacking included
+int Sim_Fil_Probe_Irq(SimFil_t *fil, uint32_t irq, const char *name)
+{
+    if (fil->probe_count >= SIM_FIL_PROBES)
+        return -1;
+    SimFilProbe_t *p = &fil->probe[fil->probe_count];
+    memset(p, 0, sizeof(*p));
+    snprintf(p->name, sizeof(p->name), "%s", name);
+    p->exc = SIM_CM3_EXC_IRQ(irq);
+    return fil->probe_count++;
+}
+
+/* ---------------------------------------------------------------------------
+ * 接口 Interface
+ * ------------------------------------------------------------------------- */
+
+/**
+ * @brief  载入固件映像并上电复位，底盘模型接到HAL替身寄存器上
+ *         Load the firmware image and power it up, with the chassis model
+ *         on the shim registers
+ * @param  axf: Keil生成的ELF映像 ELF image built by Keil
+ * @param  param: 底盘参数 Chassis parameters
+ * @retval 0成功，-1失败 0 on success, -1 on failure
+ */
+int Sim_Fil_Init(SimFil_t *fil, const char *axf, const SimCarParam_t *param)
+{
+    memset(fil, 0, sizeof(*fil));
+    fil->cpu = Sim_Cm3_Create();
+    fil->periph = calloc(PERIPH_SIZE, 1);
+    if (fil->cpu == NULL || fil->periph == NULL || Sim_Cm3_Load_Elf(fil->cpu, axf) != 0)
+    {
+        Sim_Fil_Free(fil);
+        return -1;
+    }
+
+    Sim_Board_Reset(&fil->board, param);
+    fil->rcc[RCC_CR] = 0x00000083u;
+    fil->rcc[RCC_CSR] = 0x0C000000u;
+    fil->flash_acr = 0x30u;
+    fil->tim6_next = NEVER;
+    fil->next_step = (uint64_t)SIM_STEP_US * SIM_FIL_CYCLES_PER_US;
+
+    SimCm3_t *cpu = fil->cpu;
+    cpu->ctx = fil;
+    cpu->bus_read = Fil_Bus_Read;
+    cpu->bus_write = Fil_Bus_Write;
+    cpu->on_event = Fil_On_Event;
+    cpu->on_watch = Fil_On_Watch;
+    cpu->on_exception = Fil_On_Exception;
+    Sim_Cm3_Reset(cpu);
+    Fil_Update_Event(fil);
+    return 0;
+}
+
+void Sim_Fil_Free(SimFil_t *fil)
+{
+    Sim_Cm3_Destroy(fil->cpu);
+    free(fil->periph);
+    fil->cpu = NULL;
+    fil->periph = NULL;
+}
+
+/**
+ * @brief  把固件和底盘一起推进us微秒
+ *         Advance the firmware and the chassis together by us microseconds
+ * @retval 0正常，-1固件停机或执行出错 0 normally, -1 when the firmware halted or faulted
+ */
+int Sim_Fil_Run_Us(SimFil_t *fil, uint64_t us)
+{
+    SimCm3_t *cpu = fil->cpu;
+    if (Sim_Cm3_Run(cpu, cpu->cycles + us * SIM_FIL_CYCLES_PER_US) != 0 || cpu->halted)
+        return -1;
+    return 0;
+}
+
+// 按符号名读固件变量，1、2或4字节 Read a firmware variable by symbol name; 1, 2 or 4 bytes
+int Sim_Fil_Read_Var(SimFil_t *fil, const char *name, uint32_t *value)
+{
+    const SimCm3Sym_t *s = Sim_Cm3_Find_Sym(fil->cpu, name);
+    if (s == NULL || s->func || (s->size != 1 && s->size != 2 && s->size != 4))
+        return -1;
+    *value = Sim_Cm3_Read(fil->cpu, s->addr, s->size);
+    return 0;
+}
+
+uint64_t Sim_Fil_Us(const SimFil_t *fil)
+{
+    return fil->cpu->cycles / SIM_FIL_CYCLES_PER_US;
+}
+
+/**
+ * @brief  按实车操作选择任务：上电SIM_FIL_PRESS_US后按下对应按键，
+ *         任务1、2和任务3按100ms，任务4长按越过500ms的确认延时
+ *         Select a task the way it is done on the car: press its key
+ *         SIM_FIL_PRESS_US after power-on; tasks 1, 2 and 3 hold it 100 ms,
+ *         task 4 holds KEY3 past the 500 ms confirmation delay
+ * @note   在每次Sim_Fil_Run_Us之前调用 Call before every Sim_Fil_Run_Us
+ */
+void Sim_Fil_Task_Key(const SimFil_t *fil, CarMode_t mode)
+{
+    uint16_t pin = mode == MODE_TASK1 ? KEY1_Pin : mode == MODE_TASK2 ? KEY2_Pin : KEY3_Pin;
+    uint64_t hold_us = mode == MODE_TASK4 ? 800000u : 100000u;
+    uint64_t now = Sim_Fil_Us(fil);
+    int down = now >= SIM_FIL_PRESS_US && now < SIM_FIL_PRESS_US + hold_us;
+    Shim_GPIO_Set_Input(KEY_GPIO_Port, pin, down ? GPIO_PIN_RESET : GPIO_PIN_SET);
+}
@@ -0,0 +1,97 @@
+/*
+ * sim_fil.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * 固件在环：在sim_cm3上运行编译好的car_tracking.axf，GPIO、TIM1..TIM8
+ * 的寄存器访问落到HAL替身的寄存器块上，因此底盘模型、传感器和编码器
+ * 与主机构建共用同一套代码；TIM6按固件写入的PSC/ARR计数并产生中断。
+ * Firmware in the loop: runs the compiled car_tracking.axf on sim_cm3. GPIO
+ * and TIM1..TIM8 register accesses land on the HAL shim register blocks, so
+ * the chassis model, sensors and encoders are the same code as in the host
+ * build; TIM6 counts with the PSC/ARR the firmware wrote and raises its
+ * interrupt.
+ *
+ * 探针记录函数每次调用的周期数，不含期间被中断占用的周期；中断探针记录
+ * 从进栈到出栈完成的周期。
+ * Probes record the cycles of every call of a function, less the cycles
+ * interrupts took meanwhile; interrupt probes record the cycles from
+ * stacking to the end of unstacking.
+ */
+
+#ifndef HOST_SIM_FIL_H_
+#define HOST_SIM_FIL_H_
+
+#include "sim_board.h"
+#include "sim_cm3.h"
+
+#define SIM_FIL_HZ (72000000u) // 固件把PLL配到72MHz，时间按此折算 The firmware runs the PLL at 72 MHz; time is counted at that rate
+#define SIM_FIL_CYCLES_PER_US (SIM_FIL_HZ / 1000000u)
+#define SIM_FIL_PROBES (16)
+#define SIM_FIL_FRAMES (64)
+
+#define SIM_FIL_TIM6_IRQ (54) // STM32F103xE的TIM6_IRQn
+#define SIM_FIL_PRESS_US (500000u) // Sim_Fil_Task_Key按下按键的时间 Time Sim_Fil_Task_Key presses the key
+
+typedef struct _sim_fil SimFil_t;
+
+// 每次调用结束时调用 Called as each call completes
+typedef void (*SimFilSample_t)(SimFil_t *fil, int probe, uint64_t at, uint32_t cycles, void *ctx);
+
+typedef struct
+{
+    char name[48];
+    uint32_t addr;      // 函数入口，中断探针为0 Function entry, 0 for an interrupt probe
+    uint32_t exc;       // 中断探针的异常号 Exception number of an interrupt probe
+    uint64_t open_at;
+    uint32_t calls;
+    uint64_t total;
+    uint32_t min;
+    uint32_t max;
+} SimFilProbe_t;
+
+typedef struct
+{
+    int probe;
+    uint32_t ret;       // 返回地址，EXC_RETURN表示异常处理函数本身 Return address; EXC_RETURN for a handler itself
+    uint32_t sp;
+    uint32_t depth;
+    uint64_t start;
+    uint64_t nested;
+} SimFilFrame_t;
+
+struct _sim_fil
+{
+    SimCm3_t *cpu;
+    SimBoard_t board;
+    uint64_t next_step;  // 下一个物理步的周期 Cycle of the next physics step
+
+    // TIM6计数模型 TIM6 counter model
+    uint64_t tim6_origin; // 计数为0的周期 Cycle at which the count was 0
+    uint64_t tim6_next;   // 下一次更新事件 Next update event
+    uint32_t tim6_psc;    // 生效中的预分频，更新事件时装载 Active prescaler, loaded on update
+    uint32_t tim6_updates;
+
+    uint32_t rcc[16];
+    uint32_t flash_acr;
+    uint8_t *periph;      // 其余APB/AHB外设的寄存器存储 Register storage for the other APB/AHB peripherals
+
+    SimFilProbe_t probe[SIM_FIL_PROBES];
+    int probe_count;
+    SimFilFrame_t frame[SIM_FIL_FRAMES];
+    int frame_count;
+    SimFilSample_t on_sample;
+    void *on_sample_ctx;
+};
+
+int Sim_Fil_Init(SimFil_t *fil, const char *axf, const SimCarParam_t *param);
+void Sim_Fil_Free(SimFil_t *fil);
+int Sim_Fil_Probe(SimFil_t *fil, const char *func);
+int Sim_Fil_Probe_Irq(SimFil_t *fil, uint32_t irq, const char *name);
+int Sim_Fil_Run_Us(SimFil_t *fil, uint64_t us);
+int Sim_Fil_Read_Var(SimFil_t *fil, const char *name, uint32_t *value);
+uint64_t Sim_Fil_Us(const SimFil_t *fil);
+void Sim_Fil_Task_Key(const SimFil_t *fil, CarMode_t mode);
+
+#endif /* HOST_SIM_FIL_H_ */
@@ -0,0 +1,413 @@
+/*
+ * sim_run.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "sim_run.h"
+#include "sim_trace.h"
+#include "hal_shim.h"
+#include "bsp.h"
+
+#ifndef HOST_TRACK_DIR
+#define HOST_TRACK_DIR "Tracks"
+#endif
+
+#define SETTLE_MS (1000u)
+
+typedef struct
+{
+    const SimTrack_t *track;
+    double last_s;
+    int lap;
+    double progress;    // 展开后的路径进度 Unwrapped path progress
+    double xte_sq;
+    double xte_max;
+    uint32_t steps;
+    uint32_t sat_steps;
+} RunStats_t;
+
+static void Run_On_Step(SimBoard_t *board, void *ctx)
+{
+    RunStats_t *st = ctx;
+    const SimCar_t *car = &board->car;
+    double s;
+    double xte = Sim_Track_Locate(st->track, car->x_mm, car->y_mm, &s);
+
+    // 环形赛道按圈展开 Unwrap laps on closed tracks
+    if (st->track->closed)
+    {
+        double len = st->track->length;
+        if (s - st->last_s < -len * 0.5)
+            st->lap++;
+        else if (s - st->last_s > len * 0.5)
+            st->lap--;
+    }
+    st->last_s = s;
+    st->progress = st->lap * st->track->length + s;
+
+    st->xte_sq += xte * xte;
+    if (xte > st->xte_max)
+        st->xte_max = xte;
+    st->steps++;
+
+    for (int i = 0; i < SIM_MOTORS; i++)
+    {
+        if (!car->brake[i] && fabsf(car->duty[i]) >= MOTOR_MAX_PULSE)
+        {
+            st->sat_steps++;
+            break;
+        }
+    }
+}
+
+static void Add_Event(SimRunResult_t *res, PathPoint_t point, uint32_t t_ms, double s_mm)
+{
+    if (res->event_count >= SIM_RUN_MAX_EVENTS)
+        return;
+    SimRunEvent_t *ev = &res->event[res->event_count++];
+    ev->point = point;
+    ev->t_ms = t_ms;
+    ev->s_mm = s_mm;
+    ev->hit = 0;
+}
+
+// 把固件判定与实际经过的关键点对应，统计误判和漏判
+// Match firmware detections to the markers actually passed; count false positives and misses
+static void Match_Events(const SimTrack_t *track, double sensor_s, SimRunResult_t *res)
+{
+    int laps = track->closed ? (int)(sensor_s / track->length) + 1 : 1;
+
+    res->false_positives = 0;
+    res->misses = 0;
+    for (int k = 0; k < laps; k++)
+    {
+        for (int m = 0; m < track->marker_count; m++)
+        {
+            const SimMarker_t *mk = &track->marker[m];
+            if (mk->s < 1.0) // 起点标记由上一圈终点代表 Start marker is the previous lap's end
+                continue;
+            double at = k * track->length + mk->s;
+            if (at > sensor_s + SIM_RUN_MATCH_MM)
+                continue;
+
+            int found = 0;
+            for (int e = 0; e < res->event_count && !found; e++)
+            {
+                SimRunEvent_t *ev = &res->event[e];
+                if (!ev->hit && ev->point == mk->point && fabs(ev->s_mm - at) <= SIM_RUN_MATCH_MM)
+                {
+                    ev->hit = 1;
+                    found = 1;
+                }
+            }
+            if (!found && at < sensor_s - SIM_RUN_MATCH_MM)
+                res->misses++;
+        }
+    }
+    for (int e = 0; e < res->event_count; e++)
+        res->false_positives += !res->event[e].hit;
+}
+
+/**
+ * @brief  任务的默认赛道文件，任务4沿用任务3的赛道
+ *         Default track file for a task; Task4 reuses the Task3 track
+ * @retval 路径，无效任务返回NULL Path, or NULL for an invalid task
+ */
+const char *Sim_Run_Default_Track(CarMode_t mode)
+{
+    static const char *const track[] = {
+        NULL,
+        HOST_TRACK_DIR "/task1.trk",
+        HOST_TRACK_DIR "/task2.trk",
+        HOST_TRACK_DIR "/task3.trk",
+        HOST_TRACK_DIR "/task3.trk",
+    };
+    return mode <= MODE_TASK4 ? track[mode] : NULL;
+}
+
+/**
+ * @brief  任务的时间要求
+ *         Time limit the task must finish within
+ * @retval 毫秒，0为无要求 Milliseconds, 0 = none
+ */
+uint32_t Sim_Run_Time_Limit(CarMode_t mode)
+{
+    return mode == MODE_TASK3 ? 40000u : 0u;
+}
+
+void Sim_Run_Default_Config(SimRunConfig_t *cfg, CarMode_t mode, const SimTrack_t *track)
+{
+    static const uint32_t timeout_ms[] = {0, 10000, 30000, 60000, 240000};
+
+    cfg->mode = mode;
+    cfg->track = track;
+    Sim_Car_Default_Param(&cfg->car);
+    cfg->tune.kp = PID_DEF_KP;
+    cfg->tune.ki = PID_DEF_KI;
+    cfg->tune.kd = PID_DEF_KD;
+    cfg->tune.line_speed = LINE_SPEED_DEF;
+    cfg->tune.arc_radius = ARC_TURN_RADIUS_DEF;
+    cfg->tune.app = (AppTune_t)APP_TUNE_DEFAULT;
+    cfg->timeout_ms = timeout_ms[mode <= MODE_TASK4 ? mode : 0];
+    cfg->realtime = 0;
+    cfg->trace_path = NULL;
+}
+
+/**
+ * @brief  在本进程中运行一次任务
+ *         Run one task in this process
+ * @note   固件静态变量不会复位，每个进程只能调用一次，多次运行请用Sim_Run_Isolated
+ *         Firmware statics are not reset: call once per process, or use Sim_Run_Isolated
+ * @retval 0成功 0 on success
+ */
+int Sim_Run(const SimRunConfig_t *cfg, SimRunResult_t *res)
+{
+    static SimBoard_t board;
+    RunStats_t st = {0};
+    const SimTrack_t *track = cfg->track;
+
+    memset(res, 0, sizeof(*res));
+    st.track = track;
+
+    Shim_Clock_Set_Virtual(!cfg->realtime);
+    Sim_Board_Init(&board, &cfg->car);
+    Sim_Board_Set_Track(&board, track);
+    PID_Set_Motor_Parm(MAX_MOTOR, cfg->tune.kp, cfg->tune.ki, cfg->tune.kd);
+    set_line_speed(cfg->tune.line_speed);
+    APP_Set_Arc_Radius(cfg->tune.arc_radius);
+    g_app_tune = cfg->tune.app;
+    board.on_step = Run_On_Step;
+    board.on_step_ctx = &st;
+
+    // 从设定任务前开始记录，回放时在同一位置调用APP_Set_Mode
+    // Record from just before the task is set; replay calls APP_Set_Mode at the same point
+    uint32_t *trace_buf = NULL;
+    if (cfg->trace_path != NULL)
+    {
+        trace_buf = malloc(SIM_RUN_TRACE_LEN * sizeof(uint32_t));
+        if (trace_buf != NULL)
+            BSP_Trace_Start(trace_buf, SIM_RUN_TRACE_LEN);
+    }
+
+    uint32_t start_ms = HAL_GetTick();
+    APP_Set_Mode(cfg->mode);
+
+    double ahead = cfg->car.sensor_ahead_mm;
+    PathPoint_t last_point = APP_Get_Point();
+    uint32_t done_ms = 0;
+
+    for (;;)
+    {
+        Sim_Board_Pass(&board);
+
+        uint32_t t_ms = HAL_GetTick() - start_ms;
+        PathPoint_t point = APP_Get_Point();
+        if (point != last_point)
+        {
+            Add_Event(res, point, t_ms, st.progress + ahead);
+            last_point = point;
+        }
+
+        if (!res->completed && APP_Get_Task_Completed())
+        {
+            res->completed = 1;
+            res->total_ms = t_ms;
+            done_ms = t_ms;
+        }
+
+        if (res->completed && t_ms - done_ms >= SETTLE_MS)
+        {
+            // 任务1、2不经current_point报告终点，以停车位置作为终点判定
+            // Tasks 1 and 2 do not report their final point via current_point;
+            // the stop position stands in for it
+            if (cfg->mode == MODE_TASK1)
+                Add_Event(res, POINT_B, done_ms, st.progress);
+            else if (cfg->mode == MODE_TASK2)
+                Add_Event(res, POINT_A, done_ms, st.progress);
+            break;
+        }
+        if (!res->completed && t_ms >= cfg->timeout_ms)
+        {
+            res->total_ms = t_ms;
+            break;
+        }
+    }
+
+    if (trace_buf != NULL)
+    {
+        if (g_trace.full)
+            fprintf(stderr, "%s: trace buffer full, the replay stops early\n", cfg->trace_path);
+        Sim_Trace_Save(cfg->trace_path, cfg->mode, g_trace.buf, g_trace.count);
+        BSP_Trace_Start(NULL, 0);
+        free(trace_buf);
+    }
+
+    res->progress_mm = st.progress;
+    res->xte_rms_mm = st.steps ? sqrt(st.xte_sq / st.steps) : 0.0;
+    res->xte_max_mm = st.xte_max;
+    res->sat_frac = st.steps ? (double)st.sat_steps / st.steps : 0.0;
+    Match_Events(track, st.progress + ahead, res);
+
+    // 停车点到目标关键点(任务1为B，其余为A)的距离
+    // Distance from the stop position to the target marker (B for task 1, A otherwise)
+    PathPoint_t target = cfg->mode == MODE_TASK1 ? POINT_B : POINT_A;
+    res->stop_error_mm = -1.0;
+    for (int m = track->marker_count - 1; m >= 0; m--)
+    {
+        if (track->marker[m].point == target)
+        {
+            res->stop_error_mm = hypot(board.car.x_mm - track->marker[m].x, board.car.y_mm - track->marker[m].y);
+            break;
+        }
+    }
+    return 0;
+}
+
+// 派生子进程运行一次任务，结果写入管道；结果小于管道缓冲区，子进程不会阻塞
+// Fork a child that runs one task and writes the result to a pipe; the
+// result fits in the pipe buffer, so the child never blocks on the parent
+static pid_t Run_Spawn(const SimRunConfig_t *cfg, int *read_fd)
+{
+    int fd[2];
+    if (pipe(fd) != 0)
+        return -1;
+
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        close(fd[0]);
+        close(fd[1]);
+        return -1;
+    }
+    if (pid == 0)
+    {
+        SimRunResult_t child;
+        close(fd[0]);
+        Sim_Run(cfg, &child);
+        ssize_t n = write(fd[1], &child, sizeof(child));
+        _exit(n == (ssize_t)sizeof(child) ? 0 : 1);
+    }
+
+    close(fd[1]);
+    *read_fd = fd[0];
+    return pid;
+}
+
+// 读出已退出子进程的结果 Collect the result of a child that has exited
+static int Run_Collect(int fd, int status, SimRunResult_t *res)
+{
+    size_t got = 0;
+    while (got < sizeof(*res))
+    {
+        ssize_t n = read(fd, (char *)res + got, sizeof(*res) - got);
+        if (n <= 0)
+            break;
+        got += (size_t)n;
+    }
+    close(fd);
+
+    if (got != sizeof(*res) || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        return -1;
+    return 0;
+}
+
+/**
+ * @brief  在子进程中运行一次任务，结果经管道返回
+ *         Run one task in a child process and return the result over a pipe
+ * @retval 0成功，-1失败 0 on success, -1 on failure
+ */
+int Sim_Run_Isolated(const SimRunConfig_t *cfg, SimRunResult_t *res)
+{
+    int fd, status = 0;
+    pid_t pid = Run_Spawn(cfg, &fd);
+    if (pid < 0)
+        return -1;
+    waitpid(pid, &status, 0);
+    return Run_Collect(fd, status, res);
+}
+
+/**
+ * @brief  同时最多jobs个子进程，运行count个互相独立的任务
+ *         Run count independent tasks with up to jobs child processes at once
+ * @note   固件状态是进程内全局的，因此用进程而不是线程并行
+ *         Firmware state is process-global, so runs are parallel processes
+ *         rather than threads
+ * @param  ok: 每项运行成功置1，可为NULL Set to 1 per successful run, may be NULL
+ * @param  jobs: 并行进程数，<=0时取Sim_Run_Jobs() Parallel processes, <=0 for Sim_Run_Jobs()
+ * @retval 失败的运行数 Number of failed runs
+ */
+int Sim_Run_Parallel(const SimRunConfig_t *cfg, SimRunResult_t *res, int *ok, int count, int jobs)
+{
+    if (jobs <= 0)
+        jobs = Sim_Run_Jobs();
+    if (jobs > SIM_RUN_MAX_JOBS)
+        jobs = SIM_RUN_MAX_JOBS;
+
+    pid_t pid[SIM_RUN_MAX_JOBS];
+    int fd[SIM_RUN_MAX_JOBS];
+    int index[SIM_RUN_MAX_JOBS];
+    int running = 0, next = 0, failed = 0;
+
+    while (next < count || running > 0)
+    {
+        while (next < count && running < jobs)
+        {
+            pid_t p = Run_Spawn(&cfg[next], &fd[running]);
+            if (p < 0)
+            {
+                if (running > 0)
+                    break; // 资源不足时等已有子进程退出 Wait for a child to free resources
+                if (ok != NULL)
+                    ok[next] = 0;
+                failed++;
+                next++;
+                continue;
+            }
+            pid[running] = p;
+            index[running] = next++;
+            running++;
+        }
+        if (running == 0)
+            continue;
+
+        int status = 0;
+        pid_t done = waitpid(-1, &status, 0);
+        if (done < 0)
+            break;
+        for (int k = 0; k < running; k++)
+        {
+            if (pid[k] != done)
+                continue;
+            int i = index[k];
+            int r = Run_Collect(fd[k], status, &res[i]) == 0;
+            if (ok != NULL)
+                ok[i] = r;
+            failed += !r;
+            running--;
+            pid[k] = pid[running];
+            fd[k] = fd[running];
+            index[k] = index[running];
+            break;
+        }
+    }
+    return failed;
+}
+
+/**
+ * @brief  默认并行进程数：在线CPU核数
+ *         Default number of parallel processes: the online CPU count
+ */
+int Sim_Run_Jobs(void)
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
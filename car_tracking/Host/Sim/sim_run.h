@@ -0,0 +1,83 @@
+/*
+ * sim_run.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * 端到端运行一个CarMode_t任务并统计圈速指标。
+ * Runs one CarMode_t task end to end and collects lap metrics.
+ *
+ * 固件用了大量文件/函数内静态变量，一个进程只能干净地跑一次任务，
+ * 因此Sim_Run_Isolated在子进程中运行。
+ * The firmware keeps its state in file and function statics, so a process
+ * can only run one task cleanly; Sim_Run_Isolated runs it in a child.
+ * Sim_Run_Parallel按同样方式同时运行多个子进程，用满所有核。
+ * Sim_Run_Parallel does the same with several children at once to use
+ * every core.
+ */
+
+#ifndef HOST_SIM_RUN_H_
+#define HOST_SIM_RUN_H_
+
+#include "sim_board.h"
+
+#define SIM_RUN_MAX_EVENTS (64)
+#define SIM_RUN_MAX_JOBS (256)
+#define SIM_RUN_MATCH_MM (200.0) // 检测位置与关键点的容差 Detection-to-marker tolerance
+#define SIM_RUN_TRACE_LEN (1u << 22) // 输入记录的最大字数 Input trace capacity in words
+
+// 可调的固件常数 Tunable firmware constants
+typedef struct
+{
+    float kp, ki, kd;     // 电机速度环PID，默认PID_DEF_KP/KI/KD Motor speed PID
+    int16_t line_speed;   // set_line_speed，默认LINE_SPEED_DEF
+    uint8_t arc_radius;   // 弧线巡线弯曲半径，默认ARC_TURN_RADIUS_DEF Arc tracking radius
+    AppTune_t app;        // 巡线各状态速度和判定时间，默认APP_TUNE_DEFAULT Per-state speeds and detection timing
+} SimRunTune_t;
+
+typedef struct
+{
+    CarMode_t mode;
+    const SimTrack_t *track;
+    SimCarParam_t car;
+    SimRunTune_t tune;
+    uint32_t timeout_ms;
+    uint8_t realtime;     // 1按真实时间运行，0用虚拟时钟 1 = wall time, 0 = virtual clock
+    const char *trace_path; // 非NULL时把输入记录写到此文件，见sim_trace.h Write the input trace here when set, see sim_trace.h
+} SimRunConfig_t;
+
+// 固件的一次关键点判定 One point detection reported by the firmware
+typedef struct
+{
+    PathPoint_t point;
+    uint32_t t_ms;    // 距任务开始 Since task start
+    double s_mm;      // 传感器处的路径进度 Path progress at the sensor bar
+    uint8_t hit;      // 与实际关键点吻合 Matched a physical marker
+} SimRunEvent_t;
+
+typedef struct
+{
+    uint8_t completed;    // 固件置位task_completed Firmware set task_completed
+    uint32_t total_ms;    // 任务开始到完成或超时 Task start to completion or timeout
+    double progress_mm;   // 车体中心路径进度 Chassis centre progress along the path
+    double stop_error_mm; // 终点与目标关键点的距离 Final position to the target marker
+
+    SimRunEvent_t event[SIM_RUN_MAX_EVENTS];
+    int event_count;
+    int false_positives;
+    int misses;
+
+    double xte_rms_mm;    // 横向偏差 Cross-track error
+    double xte_max_mm;
+    double sat_frac;      // PWM饱和时间占比 Fraction of time at PWM saturation
+} SimRunResult_t;
+
+const char *Sim_Run_Default_Track(CarMode_t mode);
+uint32_t Sim_Run_Time_Limit(CarMode_t mode);
+void Sim_Run_Default_Config(SimRunConfig_t *cfg, CarMode_t mode, const SimTrack_t *track);
+int Sim_Run(const SimRunConfig_t *cfg, SimRunResult_t *res);
+int Sim_Run_Isolated(const SimRunConfig_t *cfg, SimRunResult_t *res);
+int Sim_Run_Parallel(const SimRunConfig_t *cfg, SimRunResult_t *res, int *ok, int count, int jobs);
+int Sim_Run_Jobs(void);
+
+#endif /* HOST_SIM_RUN_H_ */
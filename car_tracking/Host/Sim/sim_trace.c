@@ -0,0 +1,343 @@
+/*
+ * sim_trace.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim_trace.h"
+#include "hal_shim.h"
+
+// 钩子没有上下文参数，一个进程同时只回放一份记录 The hook has no context: one replay per process
+static SimReplay_t *s_replay = NULL;
+
+/**
+ * @brief  写出记录文件
+ *         Write a trace file
+ * @retval 0成功，-1失败 0 on success, -1 on failure
+ */
+int Sim_Trace_Save(const char *path, CarMode_t mode, const uint32_t *rec, uint32_t count)
+{
+    SimTraceHeader_t hdr;
+    memcpy(hdr.magic, SIM_TRACE_MAGIC, sizeof(hdr.magic));
+    hdr.version = SIM_TRACE_VERSION;
+    hdr.mode = (uint32_t)mode;
+    hdr.count = count;
+
+    FILE *f = fopen(path, "wb");
+    if (f == NULL)
+    {
+        perror(path);
+        return -1;
+    }
+    int ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1 && fwrite(rec, sizeof(*rec), count, f) == count;
+    if (fclose(f) != 0 || !ok)
+    {
+        fprintf(stderr, "%s: write failed\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief  读入记录文件；没有文件头时按调试器导出的g_trace.buf原始字处理
+ *         Read a trace file. Without a header the file is taken as raw
+ *         g_trace.buf words dumped by the debugger.
+ * @retval 0成功，-1失败 0 on success, -1 on failure
+ */
+int Sim_Trace_Load(const char *path, SimTraceFile_t *trace)
+{
+    memset(trace, 0, sizeof(*trace));
+    FILE *f = fopen(path, "rb");
+    if (f == NULL)
+    {
+        perror(path);
+        return -1;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    SimTraceHeader_t hdr;
+    long offset = 0;
+    trace->mode = MODE_IDLE;
+    if (size >= (long)sizeof(hdr) && fread(&hdr, sizeof(hdr), 1, f) == 1 &&
+        memcmp(hdr.magic, SIM_TRACE_MAGIC, sizeof(hdr.magic)) == 0)
+    {
+        if (hdr.version != SIM_TRACE_VERSION ||
+            (long)(sizeof(hdr) + (size_t)hdr.count * sizeof(uint32_t)) > size)
+        {
+            fprintf(stderr, "%s: unsupported or truncated trace\n", path);
+            fclose(f);
+            return -1;
+        }
+        offset = sizeof(hdr);
+        trace->mode = (CarMode_t)hdr.mode;
+        trace->count = hdr.count;
+    }
+    else
+    {
+        trace->count = (uint32_t)(size / (long)sizeof(uint32_t));
+    }
+
+    trace->rec = malloc((size_t)(trace->count ? trace->count : 1) * sizeof(uint32_t));
+    fseek(f, offset, SEEK_SET);
+    if (trace->rec == NULL || fread(trace->rec, sizeof(uint32_t), trace->count, f) != trace->count)
+    {
+        fprintf(stderr, "%s: read failed\n", path);
+        fclose(f);
+        Sim_Trace_Free(trace);
+        return -1;
+    }
+    fclose(f);
+    return 0;
+}
+
+void Sim_Trace_Free(SimTraceFile_t *trace)
+{
+    free(trace->rec);
+    trace->rec = NULL;
+    trace->count = 0;
+}
+
+static void Replay_Apply(SimReplay_t *rp, uint32_t rec)
+{
+    if (TRACE_KIND(rec) == TRACE_KIND_TICK)
+    {
+        // 记录只存低24位，按单调递增展开 Only the low 24 bits are stored; unwrap monotonically
+        uint32_t tick = (rp->tick & ~0xFFFFFFu) | TRACE_VALUE(rec);
+        if (rp->tick_valid && tick < rp->tick)
+            tick += 0x1000000u;
+        rp->tick = tick;
+        rp->tick_valid = 1;
+    }
+    else if (TRACE_INDEX(rec) < TRACE_PINS)
+    {
+        rp->pin[TRACE_INDEX(rec)] = (uint8_t)TRACE_VALUE(rec);
+    }
+}
+
+// 按记录的位置触发TIM6中断 Fire TIM6 where the trace recorded it
+static void Replay_Fire_Isr(SimReplay_t *rp)
+{
+    uint32_t at = rp->cursor;
+    rp->in_isr = 1;
+    Shim_TIM6_Elapsed();
+    rp->in_isr = 0;
+    // 固件不再进入记录钩子时也要越过这条记录 Step past the record even if the firmware skipped the hook
+    if (rp->cursor == at)
+        rp->cursor++;
+}
+
+/**
+ * @brief  主循环中的一次节拍或引脚读取：先用掉SKIP计数，再触发记录在此处的
+ *         中断，最后若下一条正是这个输入的变化则取用
+ *         One tick or pin read in the main loop: use up the SKIP count
+ *         first, then fire the interrupts recorded here, then take the next
+ *         record if it is a change of this input
+ */
+static void Replay_Read(SimReplay_t *rp, uint8_t kind, uint8_t index)
+{
+    if (rp->in_isr || rp->loop_left)
+        return;
+
+    for (;;)
+    {
+        if (rp->skip_left)
+        {
+            rp->skip_left--;
+            return;
+        }
+        if (rp->cursor >= rp->count)
+            return;
+
+        uint32_t rec = rp->rec[rp->cursor];
+        switch (TRACE_KIND(rec))
+        {
+        case TRACE_KIND_SKIP:
+            rp->skip_left = TRACE_VALUE(rec);
+            rp->cursor++;
+            break;
+        case TRACE_KIND_ISR:
+            Replay_Fire_Isr(rp);
+            break;
+        case TRACE_KIND_TICK:
+        case TRACE_KIND_IN:
+            if (TRACE_KIND(rec) == kind && (kind == TRACE_KIND_TICK || TRACE_INDEX(rec) == index))
+            {
+                Replay_Apply(rp, rec);
+                rp->cursor++;
+            }
+            else
+            {
+                rp->mismatched++;
+            }
+            return;
+        default:
+            // 本遍记录已用完，之后的读取都未变化 This pass's records are used up; later reads saw no change
+            return;
+        }
+    }
+}
+
+/**
+ * @brief  走完上一遍剩下的记录：触发中断，补上没读到的变化
+ *         Drain what is left of the previous pass: fire its interrupts and
+ *         apply the changes nobody read
+ */
+static void Replay_Drain(SimReplay_t *rp)
+{
+    rp->skip_left = 0;
+    while (rp->cursor < rp->count)
+    {
+        uint32_t rec = rp->rec[rp->cursor];
+        switch (TRACE_KIND(rec))
+        {
+        case TRACE_KIND_LOOP:
+            return;
+        case TRACE_KIND_ISR:
+            Replay_Fire_Isr(rp);
+            break;
+        case TRACE_KIND_TICK:
+        case TRACE_KIND_IN:
+            Replay_Apply(rp, rec);
+            rp->cursor++;
+            rp->unread++;
+            break;
+        case TRACE_KIND_SKIP:
+            rp->cursor++;
+            break;
+        default:
+            rp->cursor++;
+            rp->missing++;
+            break;
+        }
+    }
+}
+
+static uint32_t Replay_Hook(uint8_t kind, uint8_t index, uint32_t live)
+{
+    SimReplay_t *rp = s_replay;
+
+    switch (kind)
+    {
+    case TRACE_KIND_LOOP:
+        rp->passes++;
+        if (rp->loop_left)
+        {
+            rp->loop_left--;
+            return 0;
+        }
+        Replay_Drain(rp);
+        if (rp->cursor < rp->count)
+            rp->loop_left = TRACE_VALUE(rp->rec[rp->cursor++]) - 1;
+        return 0;
+
+    case TRACE_KIND_ISR:
+        if (rp->in_isr && rp->cursor < rp->count && TRACE_KIND(rp->rec[rp->cursor]) == TRACE_KIND_ISR)
+        {
+            rp->cursor++;
+            rp->isrs++;
+        }
+        return 0;
+
+    case TRACE_KIND_CNT:
+        if (rp->in_isr && rp->cursor < rp->count && TRACE_KIND(rp->rec[rp->cursor]) == TRACE_KIND_CNT &&
+            TRACE_INDEX(rp->rec[rp->cursor]) == index)
+        {
+            return TRACE_VALUE(rp->rec[rp->cursor++]);
+        }
+        rp->missing++;
+        return live;
+
+    case TRACE_KIND_TICK:
+        Replay_Read(rp, kind, index);
+        return rp->tick_valid ? rp->tick : live;
+
+    case TRACE_KIND_IN:
+        Replay_Read(rp, kind, index);
+        return index < TRACE_PINS && rp->pin[index] != 0xFF ? rp->pin[index] : live;
+
+    default:
+        return live;
+    }
+}
+
+/**
+ * @brief  开始回放，之后固件的每次读操作都从记录中取值
+ *         Start a replay; every firmware read then takes its value from the trace
+ * @note   在BSP_Init之后调用，与记录开始的位置一致。重新记录写入新的缓冲区，
+ *         结束后用Sim_Replay_Compare与原记录比较
+ *         Call after BSP_Init, where recording starts. The re-recorded trace
+ *         goes to a fresh buffer; compare it with Sim_Replay_Compare.
+ * @retval 0成功，-1内存不足 0 on success, -1 when out of memory
+ */
+int Sim_Replay_Start(SimReplay_t *rp, const uint32_t *rec, uint32_t count)
+{
+    memset(rp, 0, sizeof(*rp));
+    rp->rec = rec;
+    rp->count = count;
+    memset(rp->pin, 0xFF, sizeof(rp->pin));
+    for (uint32_t i = 0; i < count; i++)
+        if (TRACE_KIND(rec[i]) == TRACE_KIND_LOOP)
+            rp->last_loop = i + 1;
+
+    // 改动过的固件可能多记录，留出余量 Modified firmware may log more, leave headroom
+    rp->out_len = count * 2u + 1024u;
+    rp->out = malloc(rp->out_len * sizeof(uint32_t));
+    if (rp->out == NULL)
+    {
+        Sim_Replay_Stop(rp);
+        return -1;
+    }
+
+    s_replay = rp;
+    BSP_Trace_Start(rp->out, rp->out_len);
+    g_trace.hook = Replay_Hook;
+    return 0;
+}
+
+// 最后一条LOOP已开始且其中的无变化遍已跑完 The last LOOP has begun and its change-free passes are done
+int Sim_Replay_Done(const SimReplay_t *rp)
+{
+    return rp->cursor >= rp->last_loop && rp->loop_left == 0;
+}
+
+// 不再跑新的一遍，处理掉最后一遍之后剩下的记录 Consume what follows the last pass without running another
+void Sim_Replay_Finish(SimReplay_t *rp)
+{
+    Replay_Drain(rp);
+}
+
+/**
+ * @brief  比较重新记录的结果与原记录
+ *         Compare the re-recorded trace with the original
+ * @param  first_diff: 第一处不同的记录序号，可为NULL Index of the first differing record, may be NULL
+ * @retval 0完全相同 0 when identical
+ */
+int Sim_Replay_Compare(const SimReplay_t *rp, uint32_t *first_diff)
+{
+    uint32_t n = g_trace.count < rp->count ? g_trace.count : rp->count;
+    uint32_t i = 0;
+    while (i < n && g_trace.buf[i] == rp->rec[i])
+        i++;
+    if (first_diff != NULL)
+        *first_diff = i;
+    return i == rp->count && g_trace.count == rp->count && !g_trace.full ? 0 : -1;
+}
+
+void Sim_Replay_Stop(SimReplay_t *rp)
+{
+    if (s_replay == rp)
+    {
+        g_trace.hook = NULL;
+        BSP_Trace_Start(NULL, 0);
+        s_replay = NULL;
+    }
+    free(rp->out);
+    rp->out = NULL;
+}
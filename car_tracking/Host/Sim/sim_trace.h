@@ -0,0 +1,88 @@
+/*
+ * sim_trace.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * 输入记录文件的读写和回放，记录格式见BSP/bsp_trace.h。
+ * Reading, writing and replaying input traces; the record format is in
+ * BSP/bsp_trace.h.
+ *
+ * 回放通过g_trace.hook把记录的值交给固件，按记录的顺序在读操作之间
+ * 触发TIM6中断，因此未修改的固件会逐位重现原来的运行，重新记录的
+ * 结果与原记录相同。
+ * Replay hands the recorded values to the firmware through g_trace.hook
+ * and fires TIM6 between reads in the recorded order, so unchanged firmware
+ * reproduces the original run bit for bit and re-records an identical trace.
+ *
+ * 修改过的固件读操作的次数或顺序会变：变化仍按SKIP计数交给对应的
+ * 读取，类型不符时留到该输入下一次被读到，本遍没有读到的在下一遍开始前
+ * 补上。这样APP_Check_Points等判定逻辑的改动仍能在同一组输入上比较；
+ * 但记录的输入不会随小车动作的改变而改变。
+ * Modified firmware may read more, fewer or in another order: changes are
+ * still handed out by the SKIP counts, a change waits while reads of other
+ * inputs come by, and changes nobody read are applied before the next pass
+ * starts. Changes to decision logic such as APP_Check_Points can so be
+ * compared on the same inputs; the recorded inputs of course do not react
+ * if the car would have moved differently.
+ */
+
+#ifndef HOST_SIM_TRACE_H_
+#define HOST_SIM_TRACE_H_
+
+#include <stdint.h>
+
+#include "bsp.h"
+
+#define SIM_TRACE_MAGIC "CTRC"
+#define SIM_TRACE_VERSION (1u)
+
+// 文件头之后是count个记录字 The header is followed by count record words
+typedef struct
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t mode;        // 记录开始时由主机设置的任务，0为由按键选择 Task set by the host at the start, 0 = chosen by key
+    uint32_t count;
+} SimTraceHeader_t;
+
+typedef struct
+{
+    uint32_t *rec;
+    uint32_t count;
+    CarMode_t mode;
+} SimTraceFile_t;
+
+typedef struct
+{
+    const uint32_t *rec;
+    uint32_t count;
+    uint32_t cursor;
+    uint32_t last_loop;   // 最后一条LOOP的位置 Index of the last LOOP record
+    uint32_t *out;        // 回放时重新记录的结果 The trace re-recorded during replay
+    uint32_t out_len;
+    uint32_t loop_left;   // 当前LOOP记录剩余的无变化遍数 Change-free passes left in the current LOOP
+    uint32_t skip_left;   // 下一条记录之前还应有的未记录读取 Unlogged reads still due before the next record
+    uint32_t tick;
+    uint8_t tick_valid;
+    uint8_t pin[TRACE_PINS];
+    uint8_t in_isr;
+
+    uint32_t passes;
+    uint32_t isrs;
+    uint32_t mismatched;  // 与下一条记录类型不符的读取 Reads that did not match the next record
+    uint32_t unread;      // 整遍都没有读到的变化 Changes no read picked up in their pass
+    uint32_t missing;     // 找不到对应记录的编码器读数等 Reads with no record, e.g. an encoder read
+} SimReplay_t;
+
+int Sim_Trace_Save(const char *path, CarMode_t mode, const uint32_t *rec, uint32_t count);
+int Sim_Trace_Load(const char *path, SimTraceFile_t *trace);
+void Sim_Trace_Free(SimTraceFile_t *trace);
+
+int Sim_Replay_Start(SimReplay_t *rp, const uint32_t *rec, uint32_t count);
+int Sim_Replay_Done(const SimReplay_t *rp);
+void Sim_Replay_Finish(SimReplay_t *rp);
+int Sim_Replay_Compare(const SimReplay_t *rp, uint32_t *first_diff);
+void Sim_Replay_Stop(SimReplay_t *rp);
+
+#endif /* HOST_SIM_TRACE_H_ */
@@ -0,0 +1,424 @@
+/*
+ * sim_track.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim_track.h"
+
+#define TRACK_MARGIN_MM (200.0)
+
+static double Wrap_Pi(double a)
+{
+    while (a > M_PI)
+        a -= 2.0 * M_PI;
+    while (a <= -M_PI)
+        a += 2.0 * M_PI;
+    return a;
+}
+
+// 线段上离(px, py)最近点的距离和参数t Distance to a line segment and parameter t
+static double Dist_Segment(double ax, double ay, double bx, double by, double px, double py, double *t_out)
+{
+    double dx = bx - ax, dy = by - ay;
+    double len2 = dx * dx + dy * dy;
+    double t = len2 > 0 ? ((px - ax) * dx + (py - ay) * dy) / len2 : 0.0;
+    if (t < 0)
+        t = 0;
+    if (t > 1)
+        t = 1;
+    if (t_out)
+        *t_out = t;
+    return hypot(px - (ax + t * dx), py - (ay + t * dy));
+}
+
+// 点到一段路径中心线的距离，s_out为沿该段的长度
+// Distance from a point to one segment's centre line; s_out is the length along it
+static double Seg_Distance(const SimSeg_t *seg, double px, double py, double *s_out)
+{
+    if (seg->type == SEG_STRAIGHT)
+    {
+        double t;
+        double d = Dist_Segment(seg->x0, seg->y0,
+                                seg->x0 + seg->length * cos(seg->h0), seg->y0 + seg->length * sin(seg->h0),
+                                px, py, &t);
+        *s_out = t * seg->length;
+        return d;
+    }
+
+    double rel = Wrap_Pi(atan2(py - seg->cy, px - seg->cx) - seg->a0);
+    if (seg->sweep > 0 && rel < 0)
+        rel += 2.0 * M_PI;
+    if (seg->sweep < 0 && rel > 0)
+        rel -= 2.0 * M_PI;
+    if (fabs(rel) <= fabs(seg->sweep))
+    {
+        *s_out = fabs(rel) * seg->radius;
+        return fabs(hypot(px - seg->cx, py - seg->cy) - seg->radius);
+    }
+
+    // 超出弧线范围，取较近的端点 Outside the sweep, take the nearer end point
+    double ex = seg->cx + seg->radius * cos(seg->a0 + seg->sweep);
+    double ey = seg->cy + seg->radius * sin(seg->a0 + seg->sweep);
+    double d0 = hypot(px - seg->x0, py - seg->y0);
+    double d1 = hypot(px - ex, py - ey);
+    *s_out = d0 <= d1 ? 0.0 : seg->length;
+    return d0 <= d1 ? d0 : d1;
+}
+
+static void Seg_End_Pose(const SimSeg_t *seg, double *x, double *y, double *h)
+{
+    if (seg->type == SEG_STRAIGHT)
+    {
+        *x = seg->x0 + seg->length * cos(seg->h0);
+        *y = seg->y0 + seg->length * sin(seg->h0);
+        *h = seg->h0;
+    }
+    else
+    {
+        *x = seg->cx + seg->radius * cos(seg->a0 + seg->sweep);
+        *y = seg->cy + seg->radius * sin(seg->a0 + seg->sweep);
+        *h = seg->h0 + seg->sweep;
+    }
+}
+
+// 沿路径取样点，用于计算包围盒 Points along a segment, for bounding boxes
+static void Seg_Point(const SimSeg_t *seg, double u, double *x, double *y)
+{
+    if (seg->type == SEG_STRAIGHT)
+    {
+        *x = seg->x0 + u * seg->length * cos(seg->h0);
+        *y = seg->y0 + u * seg->length * sin(seg->h0);
+    }
+    else
+    {
+        *x = seg->cx + seg->radius * cos(seg->a0 + u * seg->sweep);
+        *y = seg->cy + seg->radius * sin(seg->a0 + u * seg->sweep);
+    }
+}
+
+static void Seg_Bounds(const SimSeg_t *seg, double *x0, double *y0, double *x1, double *y1)
+{
+    *x0 = *y0 = INFINITY;
+    *x1 = *y1 = -INFINITY;
+    for (int k = 0; k <= 64; k++)
+    {
+        double x, y;
+        Seg_Point(seg, k / 64.0, &x, &y);
+        if (x < *x0) *x0 = x;
+        if (y < *y0) *y0 = y;
+        if (x > *x1) *x1 = x;
+        if (y > *y1) *y1 = y;
+    }
+}
+
+// 把到中心线距离不超过half的像素涂黑 Paint pixels within half of the centre line
+static void Paint_Seg(SimTrack_t *track, const SimSeg_t *seg, double half)
+{
+    double bx0, by0, bx1, by1;
+    Seg_Bounds(seg, &bx0, &by0, &bx1, &by1);
+
+    int ix0 = (int)floor((bx0 - half - track->origin_x) * track->inv_res);
+    int iy0 = (int)floor((by0 - half - track->origin_y) * track->inv_res);
+    int ix1 = (int)ceil((bx1 + half - track->origin_x) * track->inv_res);
+    int iy1 = (int)ceil((by1 + half - track->origin_y) * track->inv_res);
+    if (ix0 < 0) ix0 = 0;
+    if (iy0 < 0) iy0 = 0;
+    if (ix1 >= track->width) ix1 = track->width - 1;
+    if (iy1 >= track->height) iy1 = track->height - 1;
+
+    for (int iy = iy0; iy <= iy1; iy++)
+    {
+        double py = track->origin_y + (iy + 0.5) * track->resolution;
+        for (int ix = ix0; ix <= ix1; ix++)
+        {
+            double px = track->origin_x + (ix + 0.5) * track->resolution;
+            double s;
+            if (Seg_Distance(seg, px, py, &s) <= half)
+                track->pixels[iy * track->width + ix] = SIM_TRACK_BLACK;
+        }
+    }
+}
+
+static int Sim_Track_Rasterise(SimTrack_t *track)
+{
+    double x0 = INFINITY, y0 = INFINITY, x1 = -INFINITY, y1 = -INFINITY;
+    for (int i = 0; i < track->seg_count; i++)
+    {
+        double a, b, c, d;
+        Seg_Bounds(&track->seg[i], &a, &b, &c, &d);
+        if (a < x0) x0 = a;
+        if (b < y0) y0 = b;
+        if (c > x1) x1 = c;
+        if (d > y1) y1 = d;
+    }
+    if (track->seg_count == 0)
+        x0 = y0 = x1 = y1 = 0.0;
+
+    track->origin_x = x0 - TRACK_MARGIN_MM;
+    track->origin_y = y0 - TRACK_MARGIN_MM;
+    track->inv_res = 1.0 / track->resolution;
+    track->width = (int)ceil((x1 - x0 + 2 * TRACK_MARGIN_MM) * track->inv_res) + 1;
+    track->height = (int)ceil((y1 - y0 + 2 * TRACK_MARGIN_MM) * track->inv_res) + 1;
+    track->pixels = malloc((size_t)track->width * track->height);
+    if (track->pixels == NULL)
+        return -1;
+    memset(track->pixels, SIM_TRACK_WHITE, (size_t)track->width * track->height);
+
+    double half = track->line_width * 0.5;
+    for (int i = 0; i < track->seg_count; i++)
+    {
+        if (track->seg[i].drawn)
+            Paint_Seg(track, &track->seg[i], half);
+    }
+
+    // 关键点横线，厚度等于线宽 Marker cross bars, as thick as the line
+    for (int i = 0; i < track->marker_count; i++)
+    {
+        const SimMarker_t *m = &track->marker[i];
+        if (m->bar_mm <= 0)
+            continue;
+        SimSeg_t bar = {0};
+        bar.type = SEG_STRAIGHT;
+        bar.h0 = m->heading + M_PI / 2;
+        bar.length = m->bar_mm;
+        bar.x0 = m->x - cos(bar.h0) * m->bar_mm * 0.5;
+        bar.y0 = m->y - sin(bar.h0) * m->bar_mm * 0.5;
+        Paint_Seg(track, &bar, half);
+    }
+
+    for (int i = 0; i < track->cross_count; i++)
+    {
+        const SimCross_t *c = &track->cross[i];
+        SimSeg_t line = {0};
+        line.type = SEG_STRAIGHT;
+        line.h0 = c->angle;
+        line.length = c->length;
+        line.x0 = c->x - cos(c->angle) * c->length * 0.5;
+        line.y0 = c->y - sin(c->angle) * c->length * 0.5;
+        Paint_Seg(track, &line, half);
+    }
+    return 0;
+}
+
+static int Add_Seg(SimTrack_t *track, SimSegType_t type, uint8_t drawn, double length, double radius,
+                   double sweep, double *x, double *y, double *h)
+{
+    if (track->seg_count >= SIM_TRACK_MAX_SEGS)
+        return -1;
+
+    SimSeg_t *seg = &track->seg[track->seg_count++];
+    seg->type = type;
+    seg->drawn = drawn;
+    seg->x0 = *x;
+    seg->y0 = *y;
+    seg->h0 = *h;
+    seg->s0 = track->length;
+    if (type == SEG_ARC)
+    {
+        double side = sweep > 0 ? 1.0 : -1.0;
+        seg->radius = radius;
+        seg->sweep = sweep;
+        seg->length = radius * fabs(sweep);
+        seg->cx = *x - side * radius * sin(*h);
+        seg->cy = *y + side * radius * cos(*h);
+        seg->a0 = atan2(*y - seg->cy, *x - seg->cx);
+    }
+    else
+    {
+        seg->length = length;
+    }
+    track->length += seg->length;
+    Seg_End_Pose(seg, x, y, h);
+    return 0;
+}
+
+/**
+ * @brief  解析赛道描述文本并栅格化
+ *         Parse a track description and rasterise it
+ * @param  text: 赛道文本 Track text
+ * @param  source: 出错时显示的来源名 Source name used in error messages
+ * @retval 0成功，-1失败 0 on success, -1 on error
+ */
+int Sim_Track_Parse(SimTrack_t *track, const char *text, const char *source)
+{
+    memset(track, 0, sizeof(*track));
+    strcpy(track->name, "track");
+    track->line_width = 25.0;
+    track->resolution = 1.0;
+
+    double x = 0, y = 0, h = 0;
+    int line_no = 0;
+    const char *p = text;
+
+    while (*p)
+    {
+        char line[256];
+        size_t n = strcspn(p, "\n");
+        if (n >= sizeof(line))
+            n = sizeof(line) - 1;
+        memcpy(line, p, n);
+        line[n] = '\0';
+        p += strcspn(p, "\n");
+        if (*p == '\n')
+            p++;
+        line_no++;
+
+        char *hash = strchr(line, '#');
+        if (hash)
+            *hash = '\0';
+
+        char cmd[32] = {0}, arg[32] = {0};
+        double a = 0, b = 0, c = 0;
+        int argc = sscanf(line, "%31s", cmd);
+        if (argc <= 0)
+            continue;
+
+        int ok = 1;
+        if (strcmp(cmd, "name") == 0)
+        {
+            ok = sscanf(line, "%*s %31s", track->name) == 1;
+        }
+        else if (strcmp(cmd, "line_width") == 0)
+        {
+            ok = sscanf(line, "%*s %lf", &track->line_width) == 1 && track->line_width > 0;
+        }
+        else if (strcmp(cmd, "resolution") == 0)
+        {
+            ok = sscanf(line, "%*s %lf", &track->resolution) == 1 && track->resolution > 0;
+        }
+        else if (strcmp(cmd, "start") == 0)
+        {
+            ok = sscanf(line, "%*s %lf %lf %lf", &a, &b, &c) == 3 && track->seg_count == 0;
+            x = track->start_x = a;
+            y = track->start_y = b;
+            h = track->start_heading = c * M_PI / 180.0;
+        }
+        else if (strcmp(cmd, "straight") == 0 || strcmp(cmd, "gap") == 0)
+        {
+            ok = sscanf(line, "%*s %lf", &a) == 1 && a > 0 &&
+                 Add_Seg(track, SEG_STRAIGHT, cmd[0] == 's', a, 0, 0, &x, &y, &h) == 0;
+        }
+        else if (strcmp(cmd, "arc") == 0)
+        {
+            ok = sscanf(line, "%*s %lf %lf", &a, &b) == 2 && a > 0 && b != 0 &&
+                 Add_Seg(track, SEG_ARC, 1, 0, a, b * M_PI / 180.0, &x, &y, &h) == 0;
+        }
+        else if (strcmp(cmd, "marker") == 0)
+        {
+            b = 0;
+            ok = sscanf(line, "%*s %31s %lf", arg, &b) >= 1 && arg[1] == '\0' &&
+                 arg[0] >= 'A' && arg[0] <= 'D' && track->marker_count < SIM_TRACK_MAX_MARKERS;
+            if (ok)
+            {
+                SimMarker_t *m = &track->marker[track->marker_count++];
+                m->point = (PathPoint_t)(POINT_A + (arg[0] - 'A'));
+                m->x = x;
+                m->y = y;
+                m->heading = h;
+                m->s = track->length;
+                m->bar_mm = b;
+            }
+        }
+        else if (strcmp(cmd, "cross") == 0)
+        {
+            ok = sscanf(line, "%*s %lf %lf", &a, &b) == 2 && b > 0 &&
+                 track->cross_count < SIM_TRACK_MAX_CROSSES;
+            if (ok)
+            {
+                SimCross_t *c = &track->cross[track->cross_count++];
+                c->x = x;
+                c->y = y;
+                c->angle = h + a * M_PI / 180.0;
+                c->length = b;
+            }
+        }
+        else
+        {
+            fprintf(stderr, "%s:%d: unknown command '%s'\n", source, line_no, cmd);
+            return -1;
+        }
+
+        if (!ok)
+        {
+            fprintf(stderr, "%s:%d: bad '%s' line\n", source, line_no, cmd);
+            return -1;
+        }
+    }
+
+    track->closed = track->seg_count > 0 &&
+                    hypot(x - track->start_x, y - track->start_y) < 1.0;
+
+    if (Sim_Track_Rasterise(track) != 0)
+    {
+        fprintf(stderr, "%s: out of memory\n", source);
+        return -1;
+    }
+    return 0;
+}
+
+// 从文件加载赛道 Load a track file
+int Sim_Track_Load(SimTrack_t *track, const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL)
+    {
+        perror(path);
+        return -1;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    char *text = malloc((size_t)size + 1);
+    if (text == NULL || fread(text, 1, (size_t)size, f) != (size_t)size)
+    {
+        fclose(f);
+        free(text);
+        fprintf(stderr, "%s: read error\n", path);
+        return -1;
+    }
+    text[size] = '\0';
+    fclose(f);
+
+    int ret = Sim_Track_Parse(track, text, path);
+    free(text);
+    return ret;
+}
+
+void Sim_Track_Free(SimTrack_t *track)
+{
+    free(track->pixels);
+    track->pixels = NULL;
+}
+
+/**
+ * @brief  求点到路径中心线的最近距离（几何计算，每个仿真步最多调用一次）
+ *         Nearest distance from a point to the path centre line. Geometric,
+ *         so call it at most once per simulation step, not per sensor.
+ * @param  s_out: 最近点处的路径长度，可为NULL Path length at the nearest point, may be NULL
+ * @retval 距离，单位mm Distance in mm
+ */
+double Sim_Track_Locate(const SimTrack_t *track, double x, double y, double *s_out)
+{
+    double best = INFINITY, best_s = 0;
+    for (int i = 0; i < track->seg_count; i++)
+    {
+        double s;
+        double d = Seg_Distance(&track->seg[i], x, y, &s);
+        if (d < best)
+        {
+            best = d;
+            best_s = track->seg[i].s0 + s;
+        }
+    }
+    if (s_out)
+        *s_out = best_s;
+    return best;
+}
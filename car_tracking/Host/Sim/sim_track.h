@@ -0,0 +1,114 @@
+/*
+ * sim_track.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * 赛道描述与栅格化。赛道文件按行描述直线、弧线和A/B/C/D关键点，
+ * 加载后栅格化为反射率位图，传感器采样为O(1)查表。
+ * Track description and rasterisation. A track file lists straights,
+ * arcs and the A/B/C/D markers line by line; the loader rasterises it
+ * into a reflectance bitmap so each sensor sample is an O(1) lookup.
+ *
+ * 文件格式 File format (one command per line, '#' starts a comment):
+ *   name <text>
+ *   line_width <mm>            黑线宽度 line width, default 25
+ *   resolution <mm>            像素尺寸 pixel size, default 1
+ *   start <x> <y> <deg>        起点位姿 start pose
+ *   straight <mm>              画线直线 drawn straight
+ *   gap <mm>                   无线直线 blank straight
+ *   arc <radius> <deg>         弧线，正为左转 arc, positive turns left
+ *   marker <A|B|C|D> [bar_mm]  关键点，可选横线长度 marker, optional cross bar
+ *   cross <deg> <mm>           横穿干扰线，与航向成deg角，不是关键点
+ *                              distractor line across the path at deg to the
+ *                              heading, not a marker
+ */
+
+#ifndef HOST_SIM_TRACK_H_
+#define HOST_SIM_TRACK_H_
+
+#include <stdint.h>
+
+#include "app_path.h"
+
+#define SIM_TRACK_MAX_SEGS (512)
+#define SIM_TRACK_MAX_MARKERS (64)
+#define SIM_TRACK_MAX_CROSSES (64)
+
+#define SIM_TRACK_WHITE (230) // 白底反射率 Reflectance of the white board
+#define SIM_TRACK_BLACK (20)  // 黑线反射率 Reflectance of the black line
+
+typedef enum
+{
+    SEG_STRAIGHT = 0,
+    SEG_ARC
+} SimSegType_t;
+
+typedef struct
+{
+    SimSegType_t type;
+    uint8_t drawn;       // 是否画黑线 Whether the line is painted
+    double x0, y0, h0;   // 起点位姿 Start pose, h0 in rad
+    double length;       // 中心线长度 Centre line length, mm
+    double radius;       // 弧线半径 Arc radius, mm
+    double sweep;        // 弧线转角，正为左转 Arc sweep in rad, positive = left
+    double cx, cy, a0;   // 弧心与起始极角 Arc centre and start polar angle
+    double s0;           // 起点处的路径长度 Path length at the segment start
+} SimSeg_t;
+
+typedef struct
+{
+    PathPoint_t point;
+    double x, y, heading;
+    double s;            // 路径长度 Path length at the marker
+    double bar_mm;       // 横线长度，0为无横线 Cross bar length, 0 = none
+} SimMarker_t;
+
+// 横穿路径的干扰线 Distractor line crossing the path
+typedef struct
+{
+    double x, y;         // 与路径的交点 Where it crosses the path
+    double angle;        // 绝对方向 Absolute direction, rad
+    double length;
+} SimCross_t;
+
+typedef struct
+{
+    char name[32];
+    double line_width;
+    double resolution;
+    double start_x, start_y, start_heading;
+    double length;       // 总路径长度 Total path length
+    uint8_t closed;      // 终点回到起点 Path ends where it starts
+
+    SimSeg_t seg[SIM_TRACK_MAX_SEGS];
+    int seg_count;
+    SimMarker_t marker[SIM_TRACK_MAX_MARKERS];
+    int marker_count;
+    SimCross_t cross[SIM_TRACK_MAX_CROSSES];
+    int cross_count;
+
+    // 栅格 Raster
+    double origin_x, origin_y;
+    double inv_res;
+    int width, height;
+    uint8_t *pixels;
+} SimTrack_t;
+
+int Sim_Track_Parse(SimTrack_t *track, const char *text, const char *source);
+int Sim_Track_Load(SimTrack_t *track, const char *path);
+void Sim_Track_Free(SimTrack_t *track);
+double Sim_Track_Locate(const SimTrack_t *track, double x, double y, double *s_out);
+
+// 取(x, y)处的反射率，超出位图按白底处理
+// Reflectance at (x, y); outside the bitmap reads as white board
+static inline uint8_t Sim_Track_Sample(const SimTrack_t *track, double x, double y)
+{
+    int ix = (int)((x - track->origin_x) * track->inv_res);
+    int iy = (int)((y - track->origin_y) * track->inv_res);
+    if ((unsigned)ix >= (unsigned)track->width || (unsigned)iy >= (unsigned)track->height)
+        return SIM_TRACK_WHITE;
+    return track->pixels[iy * track->width + ix];
+}
+
+#endif /* HOST_SIM_TRACK_H_ */
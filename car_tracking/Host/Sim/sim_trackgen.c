@@ -0,0 +1,280 @@
+/*
+ * sim_trackgen.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ */
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sim_trackgen.h"
+
+#define GEN_ATTEMPTS (1000)
+#define GEN_MIN_STRAIGHT_MM (100.0) // 解出的末段直线下限 Shortest acceptable solved straight
+#define GEN_MIN_RADIUS_MM (150.0)   // 解出的弧线半径下限 Smallest acceptable solved radius
+#define GEN_TAIL_MM (400.0)         // 任务1在B点后的余量 Run-out after B on task 1
+
+// 生成过程中的文本和位姿 Text and pose while generating
+typedef struct
+{
+    char *text;
+    size_t size, len;
+    uint32_t rng;
+    double x, y, h;
+} Gen_t;
+
+static double Gen_Rand(Gen_t *g)
+{
+    g->rng ^= g->rng << 13;
+    g->rng ^= g->rng >> 17;
+    g->rng ^= g->rng << 5;
+    return (g->rng >> 8) * (1.0 / 16777216.0);
+}
+
+static double Gen_Range(Gen_t *g, const SimGenRange_t *r)
+{
+    return r->lo + (r->hi - r->lo) * Gen_Rand(g);
+}
+
+static void Gen_Printf(Gen_t *g, const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(g->text + g->len, g->len < g->size ? g->size - g->len : 0, fmt, ap);
+    va_end(ap);
+    if (n > 0)
+        g->len += (size_t)n;
+}
+
+// 与赛道解析器保持一致：数值先按输出精度取整再推进位姿
+// Values are rounded to the printed precision before the pose moves, as the parser will see them
+static double Round_Mm(double v)
+{
+    return floor(v * 1000.0 + 0.5) / 1000.0;
+}
+
+static void Gen_Straight(Gen_t *g, double length, int drawn)
+{
+    length = Round_Mm(length);
+    Gen_Printf(g, "%s %.3f\n", drawn ? "straight" : "gap", length);
+    g->x += length * cos(g->h);
+    g->y += length * sin(g->h);
+}
+
+// 弧线终点，计算方法同Add_Seg End point of an arc, computed as in Add_Seg
+static void Arc_End(double x, double y, double h, double radius, double sweep, double *ex, double *ey)
+{
+    double side = sweep > 0 ? 1.0 : -1.0;
+    double cx = x - side * radius * sin(h);
+    double cy = y + side * radius * cos(h);
+    double a0 = atan2(y - cy, x - cx);
+    *ex = cx + radius * cos(a0 + sweep);
+    *ey = cy + radius * sin(a0 + sweep);
+}
+
+static void Gen_Arc(Gen_t *g, double radius, double sweep_deg)
+{
+    radius = Round_Mm(radius);
+    sweep_deg = Round_Mm(sweep_deg);
+    Gen_Printf(g, "arc %.3f %.3f\n", radius, sweep_deg);
+    double sweep = sweep_deg * M_PI / 180.0;
+    Arc_End(g->x, g->y, g->h, radius, sweep, &g->x, &g->y);
+    g->h += sweep;
+}
+
+static void Gen_Marker(Gen_t *g, char point, double bar_mm)
+{
+    if (bar_mm > 0)
+        Gen_Printf(g, "marker %c %.0f\n", point, bar_mm);
+    else
+        Gen_Printf(g, "marker %c\n", point);
+}
+
+static void Gen_Cross(Gen_t *g, const SimTrackGen_t *gen)
+{
+    double angle = Gen_Range(g, &gen->cross_deg);
+    double length = Gen_Range(g, &gen->cross_mm);
+    Gen_Printf(g, "cross %.1f %.0f\n", angle, length);
+}
+
+// 一段带断线和干扰线的直线 A straight with an optional gap and distractor
+static void Gen_Run(Gen_t *g, const SimTrackGen_t *gen, double length, int drawn)
+{
+    double cross_at = Gen_Rand(g) < gen->cross_prob ? length * (0.2 + 0.6 * Gen_Rand(g)) : -1.0;
+    double gap_len = drawn && Gen_Rand(g) < gen->gap_prob ? Gen_Range(g, &gen->gap_mm) : 0.0;
+    double gap_at = gap_len > 0 ? (length - gap_len) * (0.2 + 0.6 * Gen_Rand(g)) : -1.0;
+    if (gap_at < 0)
+        gap_len = 0;
+
+    double pos = 0.0;
+    while (pos < length)
+    {
+        double next = length;
+        if (cross_at > pos && cross_at < next)
+            next = cross_at;
+        if (gap_at >= pos && gap_at < next)
+            next = gap_at;
+
+        if (next > pos)
+            Gen_Straight(g, next - pos, drawn);
+        pos = next;
+        if (pos == cross_at)
+        {
+            Gen_Cross(g, gen);
+            cross_at = -1.0;
+        }
+        if (pos == gap_at)
+        {
+            Gen_Straight(g, gap_len, 0);
+            pos += gap_len;
+            gap_at = -1.0;
+        }
+    }
+}
+
+/**
+ * @brief  一段直线，有线时可在中部加S弯
+ *         One straight; lined straights may get an S-bend in the middle
+ */
+static void Gen_Leg(Gen_t *g, const SimTrackGen_t *gen, double length, int drawn)
+{
+    double bend = drawn ? Gen_Range(g, &gen->bend_deg) : 0.0;
+    double radius = Gen_Range(g, &gen->bend_radius_mm);
+    double forward = 2.0 * radius * sin(fabs(bend) * M_PI / 180.0);
+    if (bend < 1.0 || length - forward < 2.0 * GEN_MIN_STRAIGHT_MM)
+    {
+        Gen_Run(g, gen, length, drawn);
+        return;
+    }
+
+    double sign = Gen_Rand(g) < 0.5 ? 1.0 : -1.0;
+    double half = (length - forward) * 0.5;
+    Gen_Run(g, gen, half, drawn);
+    Gen_Arc(g, radius, sign * bend);
+    Gen_Arc(g, radius, -sign * bend);
+    Gen_Run(g, gen, half, drawn);
+}
+
+// 任务1：白底直行到带横线的B点 Task 1: blank run to a barred B
+static int Gen_Task1(Gen_t *g, const SimTrackGen_t *gen)
+{
+    Gen_Marker(g, 'A', 0);
+    Gen_Run(g, gen, Gen_Range(g, &gen->straight_mm), 0);
+    Gen_Marker(g, 'B', Gen_Range(g, &gen->bar_mm));
+    Gen_Straight(g, GEN_TAIL_MM, 0);
+    return 0;
+}
+
+/**
+ * @brief  环形布局：直线-右弧-直线-右弧，末段直线长度和第二段弧半径由闭合条件解出
+ *         Loop layout: straight, right arc, straight, right arc. The last
+ *         straight and the second arc radius are solved so the loop closes.
+ * @param  lined: 1为任务3/4全程黑线，0为任务2无线直线 1 = task 3/4 fully lined, 0 = task 2 blank straights
+ * @retval 0成功，-1本次抽样无法闭合 0 on success, -1 when this draw cannot close
+ */
+static int Gen_Loop(Gen_t *g, const SimTrackGen_t *gen, int lined)
+{
+    double sweep1 = 180.0 + Gen_Range(g, &gen->skew_deg);
+    double sweep2 = 360.0 - sweep1;
+    double leg2 = Gen_Range(g, &gen->straight_mm);
+    double bar_c = lined ? Gen_Range(g, &gen->bar_mm) : 0.0;
+    double bar_d = lined ? Gen_Range(g, &gen->bar_mm) : 0.0;
+
+    // 任务3/4顺序为A-C-B-D，任务2为A-B-C-D Tasks 3/4 run A-C-B-D, task 2 runs A-B-C-D
+    Gen_Marker(g, 'A', 0);
+    Gen_Leg(g, gen, Gen_Range(g, &gen->straight_mm), lined);
+    Gen_Marker(g, lined ? 'C' : 'B', bar_c);
+    Gen_Arc(g, Gen_Range(g, &gen->radius_mm), -sweep1);
+    Gen_Marker(g, lined ? 'B' : 'C', 0);
+    Gen_Leg(g, gen, leg2 * 0.5, lined);
+
+    // 解 L*u + R*c = 起点 - 当前点，u为航向，c为单位半径弧的弦
+    // Solve L*u + R*c = start - here, u the heading and c the chord of a unit-radius arc
+    double sweep = Round_Mm(-sweep2) * M_PI / 180.0;
+    double ux = cos(g->h), uy = sin(g->h);
+    double cx, cy;
+    Arc_End(0.0, 0.0, g->h, 1.0, sweep, &cx, &cy);
+    double dx = -g->x, dy = -g->y;
+    double det = ux * cy - uy * cx;
+    if (fabs(det) < 1e-9)
+        return -1;
+    double length = (dx * cy - dy * cx) / det;
+    double radius = (ux * dy - uy * dx) / det;
+    if (length < GEN_MIN_STRAIGHT_MM || radius < GEN_MIN_RADIUS_MM ||
+        radius > 2.0 * gen->radius_mm.hi)
+        return -1;
+
+    Gen_Straight(g, length, lined);
+    Gen_Marker(g, 'D', bar_d);
+    Gen_Arc(g, radius, -sweep2);
+    Gen_Marker(g, 'A', 0);
+    return 0;
+}
+
+/**
+ * @brief  各任务布局族的默认范围，以现有赛道为中心
+ *         Default ranges for each layout family, centred on the home tracks
+ */
+void Sim_Track_Gen_Default(SimTrackGen_t *gen, CarMode_t mode)
+{
+    memset(gen, 0, sizeof(*gen));
+    gen->mode = mode;
+    gen->line_width = 25.0;
+    gen->straight_mm = (SimGenRange_t){700.0, 1400.0};
+    gen->radius_mm = (SimGenRange_t){300.0, 500.0};
+    gen->skew_deg = (SimGenRange_t){-10.0, 10.0};
+    gen->bend_deg = (SimGenRange_t){0.0, 20.0};
+    gen->bend_radius_mm = (SimGenRange_t){400.0, 1000.0};
+    gen->bar_mm = (SimGenRange_t){100.0, 250.0};
+    gen->gap_prob = 0.3;
+    gen->gap_mm = (SimGenRange_t){20.0, 60.0};
+    gen->cross_prob = 0.3;
+    gen->cross_deg = (SimGenRange_t){30.0, 150.0};
+    gen->cross_mm = (SimGenRange_t){100.0, 300.0};
+}
+
+/**
+ * @brief  生成一条赛道的描述文本，格式同.trk文件
+ *         Generate the description of one track, in .trk format
+ * @param  seed: 同一种子总是得到同一条赛道 The same seed always gives the same track
+ * @retval 0成功，-1文本缓冲区不足或参数无法闭合 0 on success, -1 when the buffer is too small or the ranges cannot close
+ */
+int Sim_Track_Gen_Text(const SimTrackGen_t *gen, uint32_t seed, char *text, size_t size)
+{
+    Gen_t g;
+    g.text = text;
+    g.size = size;
+    g.rng = seed * 2654435761u ^ 0x5bd1e995u;
+    if (g.rng == 0)
+        g.rng = 1;
+
+    for (int attempt = 0; attempt < GEN_ATTEMPTS; attempt++)
+    {
+        g.len = 0;
+        g.x = g.y = g.h = 0.0;
+        Gen_Printf(&g, "# Sim_Track_Gen task %d seed %u\n", gen->mode, seed);
+        Gen_Printf(&g, "name gen%u\nline_width %.1f\nstart 0 0 0\n", seed, gen->line_width);
+
+        int ret = gen->mode == MODE_TASK1 ? Gen_Task1(&g, gen) : Gen_Loop(&g, gen, gen->mode != MODE_TASK2);
+        if (ret == 0)
+            return g.len < size ? 0 : -1;
+    }
+    return -1;
+}
+
+// 生成并栅格化一条赛道 Generate and rasterise one track
+int Sim_Track_Gen(SimTrack_t *track, const SimTrackGen_t *gen, uint32_t seed)
+{
+    char text[SIM_TRACKGEN_TEXT_MAX];
+    char source[32];
+    if (Sim_Track_Gen_Text(gen, seed, text, sizeof(text)) != 0)
+    {
+        fprintf(stderr, "track generator: no closed layout for seed %u\n", seed);
+        return -1;
+    }
+    snprintf(source, sizeof(source), "gen%u", seed);
+    return Sim_Track_Parse(track, text, source);
+}
@@ -0,0 +1,54 @@
+/*
+ * sim_trackgen.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * 赛道生成器：按给定范围随机生成与任务1..4关键点顺序一致的赛道族，
+ * 控制直线长度、弧线半径和转角、直线上的S弯、断线、关键点横线以及
+ * 干扰线的角度。同一组参数和种子总是得到同一条赛道。
+ * 环形赛道的第二段直线和第二段弧线半径由闭合条件解出。
+ * Track generator: draws families of tracks whose marker order matches
+ * tasks 1..4, with controlled straight lengths, arc radii and sweeps,
+ * S-bends on the straights, line gaps, marker cross bars and distractor
+ * crossing angles. The same parameters and seed always give the same track.
+ * On loop layouts the last straight and the second arc radius are solved so
+ * the path closes.
+ */
+
+#ifndef HOST_SIM_TRACKGEN_H_
+#define HOST_SIM_TRACKGEN_H_
+
+#include <stddef.h>
+
+#include "sim_track.h"
+
+#define SIM_TRACKGEN_TEXT_MAX (4096)
+
+typedef struct
+{
+    double lo, hi;
+} SimGenRange_t;
+
+typedef struct
+{
+    CarMode_t mode;               // 布局族 Layout family: TASK1 straight, TASK2 blank loop, TASK3/4 lined loop
+    double line_width;
+    SimGenRange_t straight_mm;    // 两段直线的标称长度 Nominal length of each straight
+    SimGenRange_t radius_mm;      // 第一段弧半径 First arc radius
+    SimGenRange_t skew_deg;       // 第一段弧转角与180度之差 First arc sweep minus 180 deg
+    SimGenRange_t bend_deg;       // 有线直线上S弯每段的转角，0为无 Per-arc angle of an S-bend on a lined straight, 0 = none
+    SimGenRange_t bend_radius_mm;
+    SimGenRange_t bar_mm;         // 关键点横线长度 Marker cross bar length
+    double gap_prob;              // 有线直线出现断线的概率 Chance of a line gap on a lined straight
+    SimGenRange_t gap_mm;
+    double cross_prob;            // 每段直线出现干扰线的概率 Chance of a distractor line per straight
+    SimGenRange_t cross_deg;      // 干扰线与航向的夹角 Distractor angle to the heading
+    SimGenRange_t cross_mm;
+} SimTrackGen_t;
+
+void Sim_Track_Gen_Default(SimTrackGen_t *gen, CarMode_t mode);
+int Sim_Track_Gen_Text(const SimTrackGen_t *gen, uint32_t seed, char *text, size_t size);
+int Sim_Track_Gen(SimTrack_t *track, const SimTrackGen_t *gen, uint32_t seed);
+
+#endif /* HOST_SIM_TRACKGEN_H_ */
@@ -0,0 +1,367 @@
+/*
+ * pid_q_test.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * 定点PID(bsp_pid_q.c)与浮点版本(bsp_PID_motor.c、bsp_pid2.c)的等价性检查：两者
+ * 每步得到相同的输入，逐步比较输出。输入为阶跃目标和一阶电机模型给出、
+ * 按编码器分辨率量化的实测速度，与速度环实际看到的一致。
+ * Equivalence check of the fixed-point PID (bsp_pid_q.c) against the float
+ * versions (bsp_PID_motor.c, bsp_pid2.c): both get the same input every step and their
+ * outputs are compared step by step. Inputs are step targets and measured
+ * speeds from a first-order motor model, quantised to the encoder
+ * resolution as the speed loop sees them.
+ *
+ * 容差 Tolerances:
+ *   增量式和位置式输出差小于1个PWM计数，且取整后的PWM相差不超过1
+ *   Incremental and positional outputs within 1 PWM count, truncated PWM
+ *   off by at most 1
+ *   偏航角输出差小于5e-3 rad(限幅PI/6的1%)，小积分常数的定点量化为主要误差
+ *   Yaw output within 5e-3 rad (1% of the PI/6 limit); quantising a small
+ *   integral constant is the main error
+ *   两自由度PID输出差小于4个PWM计数，限幅随前馈移动、运行中改增益。积分不饱和时
+ *   没有限幅把两者重新对齐，小积分常数的舍入随时间游走
+ *   Two-degree-of-freedom PID outputs within 4 PWM counts, with limits
+ *   moving with a feedforward and gains changed while running. While the
+ *   integral stays unsaturated no limit pulls the two back together, so the
+ *   rounding of a small integral constant random-walks over time
+ *   Ki为0时饱和后退出限幅，输出回到Kp*e，反算不留偏置
+ *   With Ki at 0 the output returns to Kp*e once out of saturation; the
+ *   back-calculation leaves no bias
+ *   改增益前后输出之差不超过积分和微分项一拍的变化，微分状态按新Kd缩放
+ *   A gain change moves the output by no more than one tick of the integral
+ *   and derivative terms, and rescales the derivative state to the new Kd
+ *   增益调度的倍率在调度点上取表值，点间线性插值误差不超过1(Q8)，两端之外取端点值
+ *   Gain schedule scales equal the table at its points, interpolate within 1
+ *   (Q8) between them and hold the end values beyond either end
+ *
+ * 用法 Usage: pid_q_test (由ctest运行 run by ctest)
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bsp.h"
+
+#define STEPS (20000)
+#define PWM_TOL (1.0)
+#define YAW_TOL (5e-3)
+#define PID2_TOL (4.0)
+
+// 两种实现都与CTRL_PERIOD_MS无关，按默认的10ms周期比较
+// Neither engine depends on CTRL_PERIOD_MS; they are compared at the default 10 ms period
+#define TEST_PERIOD_S (0.01f)
+
+// 编码器在一个10ms周期内一个计数对应的速度 Speed of one encoder count per 10 ms tick
+#define COUNT_MM_S (MECANUM_CIRCLE_MM / ENCODER_CIRCLE_450 / TEST_PERIOD_S)
+
+typedef struct
+{
+    const char *name;
+    float kp, ki, kd;
+} Gains_t;
+
+// 每拍系数，直接写入PID结构 Per-tick coefficients, written straight into the PID structures
+static const Gains_t s_gains[] = {
+    {"default", PID_DEF_KP, PID_DEF_KI * TEST_PERIOD_S, PID_DEF_KD / TEST_PERIOD_S},
+    {"stiff", 1.5f, PID_DEF_KI * TEST_PERIOD_S, PID_DEF_KD / TEST_PERIOD_S},
+    {"high", 3.0f, 0.3f, 1.0f},
+    {"low", 0.2f, 0.01f, 0.0f},
+};
+
+static uint32_t s_seed = 1;
+
+static uint32_t Rand_Next(void)
+{
+    s_seed ^= s_seed << 13;
+    s_seed ^= s_seed >> 17;
+    s_seed ^= s_seed << 5;
+    return s_seed;
+}
+
+static float Rand_Target(void)
+{
+    static const int16_t targets[] = {0, 150, -150, 300, -300, 500, -500, 700, -700, 1000, -1000};
+    return targets[Rand_Next() % (sizeof(targets) / sizeof(targets[0]))];
+}
+
+// 一阶电机：PWM(含死区补偿)到速度，按编码器计数量化 First-order motor: PWM (with dead-band lift) to speed, quantised to encoder counts
+static float Motor_Step(float *speed, float pwm)
+{
+    float drive = pwm > 0 ? pwm + MOTOR_IGNORE_PULSE : pwm < 0 ? pwm - MOTOR_IGNORE_PULSE : 0;
+    float target = drive / MOTOR_MAX_PULSE * 1500.0f;
+    *speed += (target - *speed) * 0.15f;
+    return (float)(int)(*speed / COUNT_MM_S) * (float)COUNT_MM_S;
+}
+
+static int Check_Incre(const Gains_t *g)
+{
+    PID_t ref = {0};
+    PIDQ_t fix = {0};
+    float speed = 0, actual = 0, max_diff = 0;
+    int pwm_diff = 0;
+
+    ref.Kp = g->kp;
+    ref.Ki = g->ki;
+    ref.Kd = g->kd;
+    fix.Kp = PIDQ_FROM_FLOAT(g->kp);
+    fix.Ki = PIDQ_FROM_FLOAT(g->ki);
+    fix.Kd = PIDQ_FROM_FLOAT(g->kd);
+    for (int i = 0; i < STEPS; i++)
+    {
+        if (i % 200 == 0)
+        {
+            ref.target_val = Rand_Target();
+            fix.target_val = PIDQ_FROM_FLOAT(ref.target_val);
+        }
+        float out = PID_Incre_Calc(&ref, actual);
+        float out_q = PIDQ_TO_FLOAT(PIDQ_Incre_Calc(&fix, PIDQ_FROM_FLOAT(actual)));
+        max_diff = fmaxf(max_diff, fabsf(out - out_q));
+        int d = abs((int)out - (int)PIDQ_TO_INT(fix.pwm_output));
+        if (d > pwm_diff)
+            pwm_diff = d;
+        actual = Motor_Step(&speed, out);
+    }
+    printf("incremental %-8s max diff %.5f, pwm diff %d\n", g->name, max_diff, pwm_diff);
+    return max_diff < PWM_TOL && pwm_diff <= 1;
+}
+
+static int Check_Location(const Gains_t *g)
+{
+    PID_t ref = {0};
+    PIDQ_t fix = {0};
+    float speed = 0, actual = 0, max_diff = 0;
+    int pwm_diff = 0;
+
+    ref.Kp = g->kp;
+    ref.Ki = g->ki;
+    ref.Kd = g->kd;
+    fix.Kp = PIDQ_FROM_FLOAT(g->kp);
+    fix.Ki = PIDQ_FROM_FLOAT(g->ki);
+    fix.Kd = PIDQ_FROM_FLOAT(g->kd);
+    for (int i = 0; i < STEPS; i++)
+    {
+        if (i % 200 == 0)
+        {
+            ref.target_val = Rand_Target();
+            fix.target_val = PIDQ_FROM_FLOAT(ref.target_val);
+        }
+        float out = PID_Location_Calc(&ref, actual);
+        pidq_t q = PIDQ_Location_Calc(&fix, PIDQ_FROM_FLOAT(actual));
+        max_diff = fmaxf(max_diff, fabsf(out - PIDQ_TO_FLOAT(q)));
+        int d = abs((int)out - (int)PIDQ_TO_INT(q));
+        if (d > pwm_diff)
+            pwm_diff = d;
+        // 位置式输出直接作为PWM，限幅后驱动电机 The positional output drives the motor as PWM, limited
+        actual = Motor_Step(&speed, fmaxf(-1600.0f, fminf(1600.0f, out)));
+    }
+    printf("positional  %-8s max diff %.5f, pwm diff %d\n", g->name, max_diff, pwm_diff);
+    return max_diff < PWM_TOL && pwm_diff <= 1;
+}
+
+static int Check_Yaw(const Gains_t *g)
+{
+    PID ref = {0};
+    PIDQ_Yaw_t fix = {0};
+    float yaw = 0, max_diff = 0;
+
+    ref.Proportion = g->kp;
+    ref.Integral = g->ki * 0.1f;
+    ref.Derivative = g->kd;
+    fix.Proportion = PIDQ_FROM_FLOAT(ref.Proportion);
+    fix.Integral = PIDQ_FROM_FLOAT(ref.Integral);
+    fix.Derivative = PIDQ_FROM_FLOAT(ref.Derivative);
+    for (int i = 0; i < STEPS; i++)
+    {
+        if (i % 500 == 0)
+        {
+            // 同PID_Yaw_Reset As PID_Yaw_Reset
+            ref.SetPoint = ((int)(Rand_Next() % 629) - 314) / 100.0f;
+            ref.SumError = ref.LastError = ref.PrevError = 0;
+            fix.SetPoint = PIDQ_FROM_FLOAT(ref.SetPoint);
+            fix.SumError = fix.LastError = fix.PrevError = 0;
+        }
+        float out = PID_Yaw_Step(&ref, yaw);
+        float out_q = PIDQ_TO_FLOAT(PIDQ_Yaw_Calc(&fix, PIDQ_FROM_FLOAT(yaw)));
+        max_diff = fmaxf(max_diff, fabsf(out - out_q));
+        // 航向按输出角速度转动并带小扰动 Heading turns at the output rate with a small disturbance
+        yaw += out * 0.05f + ((int)(Rand_Next() % 201) - 100) * 1e-5f;
+    }
+    printf("yaw         %-8s max diff %.6f rad\n", g->name, max_diff);
+    return max_diff < YAW_TOL;
+}
+
+// 限幅随目标方向的前馈移动，同Motion_Handle Limits follow a feedforward for the target direction, as in Motion_Handle
+#define FF_PULSE (800)
+
+static int Check_Two_Dof(const Gains_t *g)
+{
+    PID2_t ref = {0};
+    PIDQ2_t fix = {0};
+    float speed = 0, actual = 0, max_diff = 0;
+    int pwm_diff = 0;
+
+    PID2_Set_Shape(&ref, PID_DEF_B, PID_DEF_C, 2.0f, 2.0f);
+    PIDQ2_Set_Shape(&fix, PID_DEF_B, PID_DEF_C, 2.0f, 2.0f);
+    PID2_Reset(&ref);
+    PIDQ2_Reset(&fix);
+    for (int i = 0; i < STEPS; i++)
+    {
+        if (i % 200 == 0)
+        {
+            ref.target_val = Rand_Target();
+            fix.target_val = PIDQ_FROM_FLOAT(ref.target_val);
+        }
+        if (i % 700 == 0)
+        {
+            // 增益在0.5~1.5倍间换，同速度调度 Gains swapped between 0.5x and 1.5x, as a speed schedule would
+            float k = 0.5f + (Rand_Next() % 11) * 0.1f;
+            PID2_Set_Gains(&ref, g->kp * k, g->ki * k, g->kd * k);
+            PIDQ2_Set_Gains(&fix, PIDQ_FROM_FLOAT(g->kp * k), PIDQ_FROM_FLOAT(g->ki * k), PIDQ_FROM_FLOAT(g->kd * k));
+        }
+        int16_t ff = ref.target_val > 0 ? FF_PULSE : ref.target_val < 0 ? -FF_PULSE : 0;
+        PID2_Set_Limit(&ref, -MOTOR_PID_LIMIT - ff, MOTOR_PID_LIMIT - ff);
+        PIDQ2_Set_Limit(&fix, PIDQ_FROM_INT(-MOTOR_PID_LIMIT - ff), PIDQ_FROM_INT(MOTOR_PID_LIMIT - ff));
+
+        float out = PID2_Calc(&ref, actual);
+        pidq_t q = PIDQ2_Calc(&fix, PIDQ_FROM_FLOAT(actual));
+        max_diff = fmaxf(max_diff, fabsf(out - PIDQ_TO_FLOAT(q)));
+        int d = abs((int)out - (int)PIDQ_TO_INT(q));
+        if (d > pwm_diff)
+            pwm_diff = d;
+        actual = Motor_Step(&speed, out + ff);
+    }
+    printf("2-dof       %-8s max diff %.5f, pwm diff %d\n", g->name, max_diff, pwm_diff);
+    return max_diff < PID2_TOL && pwm_diff <= PID2_TOL;
+}
+
+// 稳态下改增益，同一测量值下输出只按积分和微分项一拍的变化而变
+// A gain change at steady state: for the same measurement the output only moves by one tick of I and D
+static int Check_Bumpless(const Gains_t *g)
+{
+    PID2_t pid = {0};
+    float speed = 0, actual = 0, out = 0;
+
+    PID2_Set_Shape(&pid, 0.8f, PID_DEF_C, 2.0f, 2.0f);
+    PID2_Set_Gains(&pid, g->kp, g->ki, g->kd);
+    PID2_Set_Limit(&pid, -MOTOR_PID_LIMIT, MOTOR_PID_LIMIT);
+    PID2_Reset(&pid);
+    pid.target_val = 500;
+    for (int i = 0; i < 300; i++)
+    {
+        out = PID2_Calc(&pid, actual);
+        actual = Motor_Step(&speed, out);
+    }
+    out = PID2_Calc(&pid, actual);
+    float deriv = pid.deriv;
+    PID2_Set_Gains(&pid, g->kp * 2.0f, g->ki, g->kd * 2.0f);
+    int scaled = g->kd == 0 || fabsf(pid.deriv - 2.0f * deriv) <= 1e-6f * fabsf(deriv);
+    // 定点版用32位除法算比值，缩放误差约2^-15 The fixed version takes the ratio with 32-bit divides, about 2^-15 off
+    PIDQ2_t fix = {0};
+    PIDQ2_Set_Gains(&fix, PIDQ_FROM_FLOAT(g->kp), PIDQ_FROM_FLOAT(g->ki), PIDQ_FROM_FLOAT(g->kd));
+    fix.deriv = PIDQ_FROM_FLOAT(deriv);
+    PIDQ2_Set_Gains(&fix, PIDQ_FROM_FLOAT(g->kp * 2.0f), PIDQ_FROM_FLOAT(g->ki), PIDQ_FROM_FLOAT(g->kd * 2.0f));
+    scaled &= g->kd == 0 || fabsf(PIDQ_TO_FLOAT(fix.deriv) - 2.0f * deriv) <= 1e-4f * fabsf(deriv) + 1e-4f;
+    float next = PID2_Calc(&pid, actual);
+    // 同一测量值下微分项只剩新增益下的衰减 For the same measurement D only decays, now at twice the gain
+    float bound = fabsf(g->ki * (pid.target_val - actual)) + 2.0f * (1.0f - pid.alpha) * fabsf(deriv) + 1e-2f;
+    printf("bumpless    %-8s jump %.4f, bound %.4f%s\n", g->name, fabsf(next - out), bound,
+           scaled ? "" : ", derivative state not rescaled");
+    return scaled && fabsf(next - out) <= bound;
+}
+
+// Ki为0(同偏航环)时先饱和再退出，输出应回到Kp*e
+// With Ki at 0, as in the yaw loop: saturate, then come out; the output must return to Kp*e
+static int Check_No_Integral(void)
+{
+    const float kp = 0.4f, limit = 0.5236f;
+    PID2_t ref = {0};
+    PIDQ2_t fix = {0};
+
+    PID2_Set_Shape(&ref, 1.0f, 1.0f, 0.0f, 2.0f);
+    PIDQ2_Set_Shape(&fix, 1.0f, 1.0f, 0.0f, 2.0f);
+    PID2_Set_Gains(&ref, kp, 0.0f, 0.0f);
+    PIDQ2_Set_Gains(&fix, PIDQ_FROM_FLOAT(kp), 0, 0);
+    PID2_Set_Limit(&ref, -limit, limit);
+    PIDQ2_Set_Limit(&fix, PIDQ_FROM_FLOAT(-limit), PIDQ_FROM_FLOAT(limit));
+    PID2_Reset(&ref);
+    PIDQ2_Reset(&fix);
+
+    ref.target_val = 2.0f;
+    fix.target_val = PIDQ_FROM_FLOAT(2.0f);
+    for (int i = 0; i < 50; i++)
+    {
+        PID2_Calc(&ref, 0.0f);
+        PIDQ2_Calc(&fix, 0);
+    }
+    ref.target_val = 0.5f;
+    fix.target_val = PIDQ_FROM_FLOAT(0.5f);
+    float out = PID2_Calc(&ref, 0.0f);
+    float q = PIDQ_TO_FLOAT(PIDQ2_Calc(&fix, 0));
+    float expect = kp * 0.5f;
+    printf("no integral out %.5f, fixed %.5f, expected %.5f\n", out, q, expect);
+    return fabsf(out - expect) <= 1e-6f && fabsf(q - expect) <= 1e-4f;
+}
+
+// 增益调度表的插值和方向，改表后基准增益不变
+// Interpolation and direction of the gain schedule; the base gains survive a table change
+static int Check_Schedule(void)
+{
+    const PID_Sched_t sched = {
+        {100, 300, 600, 1000},
+        {{128, 256, 512, 384}, {256, 256, 256, 256}},
+        {{256, 512, 256, 256}, {64, 64, 64, 64}},
+        {{256, 256, 256, 0}, {256, 256, 256, 256}},
+    };
+    // 目标速度和预期倍率kp/ki/kd Target speed and expected kp/ki/kd scales
+    static const int16_t cases[][4] = {
+        {0, 128, 256, 256},    {50, 128, 256, 256},   {100, 128, 256, 256},  {200, 192, 384, 256},
+        {300, 256, 512, 256},  {450, 384, 384, 256},  {800, 448, 256, 128},  {1000, 384, 256, 0},
+        {1500, 384, 256, 0},   {-200, 256, 64, 256},  {-1500, 256, 64, 256},
+    };
+    const PID_Sched_t saved = *PID_Get_Motor_Sched();
+    float kp0, ki0, kd0, kp1, ki1, kd1;
+    int ok = 1;
+
+    PID_Get_Motor_Parm(0, &kp0, &ki0, &kd0);
+    PID_Set_Motor_Sched(&sched);
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        uint16_t scale[3];
+        PID_Get_Sched_Scale(cases[i][0], scale);
+        for (int g = 0; g < 3; g++)
+            ok &= abs((int)scale[g] - cases[i][g + 1]) <= 1;
+        if (!ok)
+        {
+            printf("schedule    %5d mm/s: scale %u %u %u, expected %d %d %d\n", cases[i][0], scale[0], scale[1],
+                   scale[2], cases[i][1], cases[i][2], cases[i][3]);
+            break;
+        }
+    }
+    PID_Get_Motor_Parm(0, &kp1, &ki1, &kd1);
+    ok &= fabsf(kp1 - kp0) <= 1e-3f * fabsf(kp0) && fabsf(ki1 - ki0) <= 1e-3f * fabsf(ki0) &&
+          fabsf(kd1 - kd0) <= 1e-3f * fabsf(kd0);
+    PID_Set_Motor_Sched(&saved);
+    printf("schedule    %s\n", ok ? "ok" : "wrong");
+    return ok;
+}
+
+int main(void)
+{
+    int ok = 1;
+
+    for (size_t i = 0; i < sizeof(s_gains) / sizeof(s_gains[0]); i++)
+    {
+        ok &= Check_Incre(&s_gains[i]);
+        ok &= Check_Location(&s_gains[i]);
+        ok &= Check_Yaw(&s_gains[i]);
+        ok &= Check_Two_Dof(&s_gains[i]);
+        ok &= Check_Bumpless(&s_gains[i]);
+    }
+    ok &= Check_No_Integral();
+    ok &= Check_Schedule();
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,265 @@
+/*
+ * batch_bench.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * 批量速度环扫描：用SoA批量核同时仿真一组PID_DEF_KP/KI/KD网格的速度阶跃，
+ * 按轮速误差积分排序，并与逐车运行真实固件的标量仿真比较结果和吞吐量。
+ * Batched speed-loop sweep: the SoA batch kernel simulates a speed step for
+ * a PID_DEF_KP/KI/KD grid all at once and ranks the sets by integrated
+ * wheel speed error. A few sets are re-run through the real firmware on the
+ * scalar simulator to check the results and compare throughput.
+ *
+ * 用法 Usage: batch_bench [-p kp] [-i ki] [-d kd] [-v speed] [-T seconds]
+ *                         [-V verify] [-k top]
+ *   范围写作"下限:上限:点数" A range is "lo:hi:points"
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bsp.h"
+#include "hal_shim.h"
+#include "sim_batch.h"
+#include "sim_board.h"
+
+typedef struct
+{
+    float lo, hi;
+    int points;
+} Range_t;
+
+// 标量仿真的结果 Result of one scalar run
+typedef struct
+{
+    float wheel_mm_s[SIM_MOTORS];
+    float iae;
+    double x_mm;
+    double wall_s;
+} Scalar_t;
+
+typedef struct
+{
+    int16_t speed;
+    uint8_t started;
+    float iae;
+} ScalarRun_t;
+
+static double Now_S(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int Parse_Range(Range_t *r, const char *text)
+{
+    int n = sscanf(text, "%f:%f:%d", &r->lo, &r->hi, &r->points);
+    if (n == 1)
+    {
+        r->hi = r->lo;
+        r->points = 1;
+    }
+    else if (n != 3 || r->points < 1)
+    {
+        fprintf(stderr, "bad range: %s\n", text);
+        return -1;
+    }
+    return 0;
+}
+
+static float Range_At(const Range_t *r, int k)
+{
+    return r->points > 1 ? r->lo + (r->hi - r->lo) * k / (r->points - 1) : r->lo;
+}
+
+// 第一次TIM6中断后给出阶跃，与批量核的起点对齐
+// Step right after the first TIM6 interrupt so the start lines up with the batch kernel
+static void Scalar_On_Step(SimBoard_t *board, void *ctx)
+{
+    ScalarRun_t *run = ctx;
+    if (!run->started)
+    {
+        if (board->isr_count == 0)
+            return;
+        Motion_Set_Speed(run->speed, run->speed, run->speed, run->speed);
+        run->started = 1;
+        return;
+    }
+    for (int w = 0; w < SIM_MOTORS; w++)
+        run->iae += fabsf(run->speed - board->car.wheel_mm_s[w]) * 1e-3f;
+}
+
+// 在子进程中用真实固件跑一组增益 Run one gain set through the real firmware in a child
+static int Scalar_Run(float kp, float ki, float kd, int16_t speed, uint32_t steps, Scalar_t *out)
+{
+    int fd[2];
+    if (pipe(fd) != 0)
+        return -1;
+    pid_t pid = fork();
+    if (pid < 0)
+        return -1;
+    if (pid == 0)
+    {
+        static SimBoard_t board;
+        SimCarParam_t param;
+        ScalarRun_t run = {speed, 0, 0.0f};
+        Scalar_t res;
+
+        close(fd[0]);
+        Sim_Car_Default_Param(&param);
+        Shim_Clock_Set_Virtual(1);
+        Sim_Board_Init(&board, &param);
+        PID_Set_Motor_Parm(MAX_MOTOR, kp, ki, kd);
+        board.on_step = Scalar_On_Step;
+        board.on_step_ctx = &run;
+
+        double t0 = Now_S();
+        uint64_t end_us = SIM_TIM6_US + (uint64_t)steps * SIM_STEP_US;
+        while (board.now_us < end_us)
+            Sim_Board_Pass(&board);
+        res.wall_s = Now_S() - t0;
+
+        for (int w = 0; w < SIM_MOTORS; w++)
+            res.wheel_mm_s[w] = board.car.wheel_mm_s[w];
+        res.iae = run.iae;
+        res.x_mm = board.car.x_mm;
+        ssize_t n = write(fd[1], &res, sizeof(res));
+        _exit(n == (ssize_t)sizeof(res) ? 0 : 1);
+    }
+
+    close(fd[1]);
+    ssize_t n = read(fd[0], out, sizeof(*out));
+    close(fd[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return n == (ssize_t)sizeof(*out) && WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : -1;
+}
+
+static const float *g_sort_iae;
+
+static int Iae_Compare(const void *a, const void *b)
+{
+    float x = g_sort_iae[*(const int *)a], y = g_sort_iae[*(const int *)b];
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+int main(int argc, char **argv)
+{
+    Range_t kp = {0.2f, 2.0f, 16}, ki = {0.0f, 30.0f, 16}, kd = {0.0f, 0.01f, 16};
+    int speed = 700, verify = 4, top = 10;
+    double seconds = 2.0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "p:i:d:v:T:V:k:")) != -1)
+    {
+        int bad = 0;
+        switch (opt)
+        {
+        case 'p':
+            bad = Parse_Range(&kp, optarg);
+            break;
+        case 'i':
+            bad = Parse_Range(&ki, optarg);
+            break;
+        case 'd':
+            bad = Parse_Range(&kd, optarg);
+            break;
+        case 'v':
+            speed = atoi(optarg);
+            break;
+        case 'T':
+            seconds = atof(optarg);
+            break;
+        case 'V':
+            verify = atoi(optarg);
+            break;
+        case 'k':
+            top = atoi(optarg);
+            break;
+        default:
+            bad = 1;
+            break;
+        }
+        if (bad)
+        {
+            fprintf(stderr, "usage: %s [-p kp] [-i ki] [-d kd] [-v speed] [-T seconds] [-V verify] [-k top]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    int count = kp.points * ki.points * kd.points;
+    uint32_t steps = (uint32_t)(seconds * 1000.0);
+    SimCarParam_t param;
+    SimBatch_t batch;
+    Sim_Car_Default_Param(&param);
+    if (Sim_Batch_Alloc(&batch, count, &param) != 0)
+        return 1;
+
+    for (int n = 0; n < count; n++)
+    {
+        int a = n % kp.points, b = n / kp.points % ki.points, c = n / kp.points / ki.points;
+        Sim_Batch_Set_Gains(&batch, n, Range_At(&kp, a), Range_At(&ki, b), Range_At(&kd, c));
+        Sim_Batch_Set_Speed(&batch, n, speed, speed, speed, speed);
+    }
+
+    double t0 = Now_S();
+    for (uint32_t s = 0; s < steps; s++)
+        Sim_Batch_Step(&batch);
+    double batch_s = Now_S() - t0;
+
+    // 均匀抽取若干组与标量仿真比较 Compare evenly spread sets against the scalar simulator
+    double scalar_s = 0, max_dv = 0, max_diae = 0, max_dx = 0;
+    int verified = 0;
+    for (int k = 0; k < verify && k < count; k++)
+    {
+        int n = verify > 1 ? (int)((long)k * (count - 1) / (verify - 1)) : 0;
+        Scalar_t ref;
+        if (Scalar_Run(batch.kp[n], batch.ki[n], batch.kd[n], (int16_t)speed, steps, &ref) != 0)
+        {
+            fprintf(stderr, "scalar run %d failed\n", n);
+            continue;
+        }
+        for (int w = 0; w < SIM_MOTORS; w++)
+            max_dv = fmax(max_dv, fabs(ref.wheel_mm_s[w] - batch.wheel_mm_s[w][n]));
+        max_diae = fmax(max_diae, fabs(ref.iae - batch.iae[n]) / fmax(ref.iae, 1e-6));
+        max_dx = fmax(max_dx, fabs(ref.x_mm - batch.x_mm[n]));
+        scalar_s += ref.wall_s;
+        verified++;
+    }
+
+    int *order = malloc((size_t)count * sizeof(int));
+    if (order == NULL)
+        return 1;
+    for (int n = 0; n < count; n++)
+        order[n] = n;
+    g_sort_iae = batch.iae;
+    qsort(order, (size_t)count, sizeof(int), Iae_Compare);
+
+    printf("rank     kp     ki     kd   iae_mm  final_mm_s    x_mm\n");
+    for (int r = 0; r < top && r < count; r++)
+    {
+        int n = order[r];
+        float v = (batch.wheel_mm_s[0][n] + batch.wheel_mm_s[1][n] + batch.wheel_mm_s[2][n] + batch.wheel_mm_s[3][n]) * 0.25f;
+        printf("%4d %6.3f %6.2f %6.4f %8.1f  %10.1f %7.0f\n", r + 1,
+               batch.kp[n], batch.ki[n], batch.kd[n], batch.iae[n], v, batch.x_mm[n]);
+    }
+
+    double car_s = (double)count * steps * 1e-3;
+    printf("\nbatch : %d cars x %.1f s in %.3f s, %.0f car-s/s\n", count, seconds, batch_s, car_s / batch_s);
+    if (verified)
+    {
+        double scalar_rate = verified * steps * 1e-3 / scalar_s;
+        printf("scalar: %d cars, %.0f car-s/s, batch speedup %.1fx\n", verified, scalar_rate, car_s / batch_s / scalar_rate);
+        printf("check : max |dv| %.3f mm/s, max iae rel %.2e, max |dx| %.2f mm\n", max_dv, max_diae, max_dx);
+    }
+
+    free(order);
+    Sim_Batch_Free(&batch);
+    return 0;
+}
@@ -0,0 +1,220 @@
+/*
+ * fw_cycles.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * 固件周期计数：在Cortex-M3仿真核上运行Keil编出的car_tracking.axf，
+ * 底盘模型提供传感器和编码器，按键选择任务后跑到任务完成，报告TIM6
+ * 中断(含进出栈)、HAL_TIM_IRQHandler、HAL_TIM_PeriodElapsedCallback、
+ * Motion_Handle每次调用的周期数和每遍BSP_Loop(不含中断)的周期数，
+ * 以及CPU占用率。与主机构建不同，这里执行的是实际下载到板上的机器码，
+ * 编译器选项和库函数(软浮点)的开销都包含在内。
+ * Firmware cycle counts: runs the Keil-built car_tracking.axf on the
+ * Cortex-M3 core with the chassis model supplying sensors and encoders,
+ * selects the task with the keys and runs it to completion. Reports the
+ * cycles of every TIM6 interrupt (stacking included), HAL_TIM_IRQHandler,
+ * HAL_TIM_PeriodElapsedCallback and Motion_Handle call, of every BSP_Loop
+ * pass (interrupts excluded), and the CPU load. Unlike the host build this
+ * executes the machine code that is flashed to the board, so compiler
+ * options and library (soft-float) costs are all included.
+ *
+ * BSP_Loop的最大值包含在HAL_Delay中等待的那一遍(如选任务后的延时)。
+ * The BSP_Loop maximum includes passes that wait in HAL_Delay (such as the
+ * delay after a task is selected).
+ *
+ * -c把每次调用写成CSV：probe,at_us,cycles。-f可追加探针函数。
+ * -c writes every call as CSV: probe,at_us,cycles. -f adds probe functions.
+ *
+ * 用法 Usage: fw_cycles [-a car_tracking.axf] [-t task] [-s seconds]
+ *                       [-c calls.csv] [-f func ...]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sim_fil.h"
+#include "sim_run.h"
+
+#define MAX_EXTRA (8)
+
+static const char *const s_probe_funcs[] = {
+    "HAL_TIM_IRQHandler",
+    "HAL_TIM_PeriodElapsedCallback",
+    "Motion_Handle",
+    "BSP_Loop",
+};
+
+static char Point_Char(PathPoint_t point)
+{
+    return point >= POINT_A && point <= POINT_D ? (char)('A' + point - POINT_A) : '-';
+}
+
+static double Now_Ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec * 1e-6;
+}
+
+static void Csv_Sample(SimFil_t *fil, int probe, uint64_t at, uint32_t cycles, void *ctx)
+{
+    fprintf((FILE *)ctx, "%s,%.3f,%u\n", fil->probe[probe].name,
+            (double)at / SIM_FIL_CYCLES_PER_US, cycles);
+}
+
+int main(int argc, char **argv)
+{
+    const char *axf = HOST_AXF_PATH;
+    const char *csv_path = NULL;
+    const char *extra[MAX_EXTRA];
+    int extra_count = 0;
+    int task = MODE_TASK1;
+    double seconds = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "a:t:s:c:f:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'a':
+            axf = optarg;
+            break;
+        case 't':
+            task = atoi(optarg);
+            break;
+        case 's':
+            seconds = atof(optarg);
+            break;
+        case 'c':
+            csv_path = optarg;
+            break;
+        case 'f':
+            if (extra_count < MAX_EXTRA)
+                extra[extra_count++] = optarg;
+            break;
+        default:
+            optind = argc;
+            break;
+        }
+    }
+    if (optind != argc || task < MODE_TASK1 || task > MODE_TASK4)
+    {
+        fprintf(stderr, "usage: %s [-a car_tracking.axf] [-t task] [-s seconds] [-c calls.csv] [-f func ...]\n",
+                argv[0]);
+        return 2;
+    }
+
+    SimRunConfig_t cfg;
+    SimTrack_t track;
+    Sim_Run_Default_Config(&cfg, (CarMode_t)task, NULL);
+    if (Sim_Track_Load(&track, Sim_Run_Default_Track((CarMode_t)task)) != 0)
+        return 1;
+    if (seconds <= 0)
+        seconds = cfg.timeout_ms / 1000.0;
+
+    SimFil_t fil;
+    if (Sim_Fil_Init(&fil, axf, &cfg.car) != 0)
+    {
+        fprintf(stderr, "%s: cannot load firmware image\n", axf);
+        return 1;
+    }
+    Sim_Board_Set_Track(&fil.board, &track);
+
+    int tim6 = Sim_Fil_Probe_Irq(&fil, SIM_FIL_TIM6_IRQ, "TIM6_IRQHandler");
+    int loop = -1;
+    for (size_t i = 0; i < sizeof(s_probe_funcs) / sizeof(s_probe_funcs[0]); i++)
+    {
+        int p = Sim_Fil_Probe(&fil, s_probe_funcs[i]);
+        if (p < 0)
+            fprintf(stderr, "warning: no symbol %s\n", s_probe_funcs[i]);
+        if (strcmp(s_probe_funcs[i], "BSP_Loop") == 0)
+            loop = p;
+    }
+    for (int i = 0; i < extra_count; i++)
+    {
+        if (Sim_Fil_Probe(&fil, extra[i]) < 0)
+            fprintf(stderr, "warning: no function %s\n", extra[i]);
+    }
+
+    FILE *csv = NULL;
+    if (csv_path != NULL)
+    {
+        csv = fopen(csv_path, "w");
+        if (csv == NULL)
+        {
+            perror(csv_path);
+            return 1;
+        }
+        fprintf(csv, "probe,at_us,cycles\n");
+        fil.on_sample = Csv_Sample;
+        fil.on_sample_ctx = csv;
+    }
+
+    // 按1ms推进，在两步之间改按键并观察固件变量
+    // Advance in 1 ms steps, changing the keys and watching firmware variables in between
+    double t0 = Now_Ms();
+    uint64_t end_us = SIM_FIL_PRESS_US + (uint64_t)(seconds * 1e6);
+    uint64_t done_us = 0;
+    uint32_t last_point = POINT_A, value;
+    int failed = 0;
+    while (Sim_Fil_Us(&fil) < end_us)
+    {
+        Sim_Fil_Task_Key(&fil, (CarMode_t)task);
+
+        if (Sim_Fil_Run_Us(&fil, 1000) != 0)
+        {
+            fprintf(stderr, "firmware stopped at %.3f s: %s\n", Sim_Fil_Us(&fil) / 1e6,
+                    fil.cpu->error[0] ? fil.cpu->error : "halted");
+            failed = 1;
+            break;
+        }
+
+        if (Sim_Fil_Read_Var(&fil, "current_point", &value) == 0 && value != last_point)
+        {
+            printf("  %8.3f s  point %c\n", ((double)Sim_Fil_Us(&fil) - SIM_FIL_PRESS_US) / 1e6,
+                   Point_Char((PathPoint_t)value));
+            last_point = value;
+        }
+        if (Sim_Fil_Read_Var(&fil, "task_completed", &value) == 0 && value)
+        {
+            done_us = Sim_Fil_Us(&fil);
+            break;
+        }
+    }
+    double elapsed = Now_Ms() - t0;
+    uint64_t run_us = Sim_Fil_Us(&fil);
+
+    if (done_us)
+        printf("task %d completed at %.3f s after the key press\n", task, (done_us - SIM_FIL_PRESS_US) / 1e6);
+    else
+        printf("task %d not completed after %.3f s\n", task, (run_us - SIM_FIL_PRESS_US) / 1e6);
+
+    printf("%-32s %8s %8s %10s %8s\n", "cycles", "calls", "min", "mean", "max");
+    uint64_t busy = 0;
+    for (int i = 0; i < fil.probe_count; i++)
+    {
+        const SimFilProbe_t *p = &fil.probe[i];
+        printf("%-32s %8u %8u %10.1f %8u\n", p->name, p->calls, p->calls ? p->min : 0,
+               p->calls ? (double)p->total / p->calls : 0.0, p->max);
+        if (i == tim6)
+            busy = p->total;
+    }
+    if (loop >= 0 && fil.probe[loop].calls)
+        printf("BSP_Loop pass %.1f us mean, %.1f us max\n",
+               (double)fil.probe[loop].total / fil.probe[loop].calls / SIM_FIL_CYCLES_PER_US,
+               (double)fil.probe[loop].max / SIM_FIL_CYCLES_PER_US);
+    printf("TIM6 interrupt load %.2f %% of %.0f MHz, %u updates\n",
+           100.0 * busy / (double)fil.cpu->cycles, SIM_FIL_HZ / 1e6, fil.tim6_updates);
+    printf("emulated %.3f s (%llu cycles) in %.1f ms\n", run_us / 1e6,
+           (unsigned long long)fil.cpu->cycles, elapsed);
+
+    if (csv != NULL)
+        fclose(csv);
+    Sim_Fil_Free(&fil);
+    Sim_Track_Free(&track);
+    return failed;
+}
@@ -0,0 +1,86 @@
+/*
+ * host_loop.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * 在主机上按实时节拍运行BSP_Loop和TIM6中断，统计每次调用的耗时。
+ * Runs BSP_Loop and the TIM6 interrupt on the host at real-time cadence
+ * and reports the cost per call.
+ *
+ * 用法 Usage: host_loop [mode 0-4] [seconds] [sensor status hex]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "bsp.h"
+#include "hal_shim.h"
+
+static uint64_t Now_Ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// 按X1..X4对应的位设置传感器引脚 Drive the sensor pins from an X1..X4 bitmask
+static void Set_Sensors(uint8_t status)
+{
+    Shim_GPIO_Set_Input(X1_GPIO_Port, X1_Pin, (status & 0x08) ? GPIO_PIN_SET : GPIO_PIN_RESET);
+    Shim_GPIO_Set_Input(X2_GPIO_Port, X2_Pin, (status & 0x04) ? GPIO_PIN_SET : GPIO_PIN_RESET);
+    Shim_GPIO_Set_Input(X3_GPIO_Port, X3_Pin, (status & 0x02) ? GPIO_PIN_SET : GPIO_PIN_RESET);
+    Shim_GPIO_Set_Input(X4_GPIO_Port, X4_Pin, (status & 0x01) ? GPIO_PIN_SET : GPIO_PIN_RESET);
+}
+
+int main(int argc, char **argv)
+{
+    int mode = argc > 1 ? atoi(argv[1]) : MODE_TASK3;
+    double seconds = argc > 2 ? atof(argv[2]) : 2.0;
+    uint8_t status = argc > 3 ? (uint8_t)strtoul(argv[3], NULL, 16) : 0x06;
+
+    Shim_Reset();
+    Set_Sensors(status);
+    BSP_Init();
+    if (mode != MODE_IDLE)
+        APP_Set_Mode((CarMode_t)mode);
+
+    uint64_t loops = 0, loop_ns = 0, loop_max = 0;
+    uint64_t isrs = 0, isr_ns = 0, isr_max = 0;
+    uint64_t end_us = Shim_Clock_Us() + (uint64_t)(seconds * 1e6);
+    uint64_t next_isr_us = Shim_Clock_Us() + CTRL_PERIOD_MS * 1000u;
+
+    while (Shim_Clock_Us() < end_us)
+    {
+        uint64_t t0 = Now_Ns();
+        BSP_Loop();
+        uint64_t dt = Now_Ns() - t0;
+        loops++;
+        loop_ns += dt;
+        if (dt > loop_max)
+            loop_max = dt;
+
+        if (Shim_Clock_Us() >= next_isr_us)
+        {
+            next_isr_us += CTRL_PERIOD_MS * 1000u;
+            t0 = Now_Ns();
+            Shim_TIM6_Elapsed();
+            dt = Now_Ns() - t0;
+            isrs++;
+            isr_ns += dt;
+            if (dt > isr_max)
+                isr_max = dt;
+        }
+    }
+
+    printf("mode %d, sensors 0x%02X, %.1f s\n", mode, status, seconds);
+    printf("BSP_Loop : %10llu calls, mean %8.1f ns, max %8llu ns\n",
+           (unsigned long long)loops, loops ? (double)loop_ns / loops : 0.0, (unsigned long long)loop_max);
+    printf("TIM6 ISR : %10llu calls, mean %8.1f ns, max %8llu ns\n",
+           (unsigned long long)isrs, isrs ? (double)isr_ns / isrs : 0.0, (unsigned long long)isr_max);
+    printf("PWM M1..M4 (TIM8/TIM1 CCR): %u/%u %u/%u %u/%u %u/%u\n",
+           (unsigned)TIM8->CCR1, (unsigned)TIM8->CCR2, (unsigned)TIM8->CCR3, (unsigned)TIM8->CCR4,
+           (unsigned)TIM1->CCR1, (unsigned)TIM1->CCR2, (unsigned)TIM1->CCR3, (unsigned)TIM1->CCR4);
+    return 0;
+}
@@ -0,0 +1,287 @@
+/*
+ * lap_bench.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * 圈速基准：在仿真中端到端运行MODE_TASK1..MODE_TASK4，报告总时间、
+ * 关键点分段时间、误判/漏判、横向偏差RMS和PWM饱和时间占比。
+ * Lap benchmark: runs MODE_TASK1..MODE_TASK4 end to end in simulation and
+ * reports total time, A/B/C/D splits, false positives and misses of the
+ * point detection, RMS cross-track error and time at PWM saturation.
+ *
+ * 默认使用虚拟时钟，-r改为按真实时间运行。
+ * Runs on the virtual clock by default; -r runs in wall time instead.
+ *
+ * 给出多个赛道文件或用-g生成赛道时，对一个任务在整批赛道上并行运行，
+ * 最后汇总完成率和用时，用来判断调参是否只对主赛道有效。
+ * Given several track files, or -g to generate layouts, one task runs over
+ * the whole corpus in parallel and a summary of completion rate and times
+ * follows, to tell whether a change is robust beyond the home track.
+ *
+ * -D按名称叠加传感器和执行器的非理想因素，见Sim_Car_Apply_Profile。
+ * -D applies named sensor and actuator imperfections, see Sim_Car_Apply_Profile.
+ *
+ * -w把每个任务的输入记录写到目录下的task<N>.trc，可用trace_replay回放。
+ * -w writes each task's input trace to task<N>.trc in a directory, for trace_replay.
+ *
+ * 用法 Usage: lap_bench [-t task] [-f track.trk] [-T timeout_s] [-c] [-r]
+ *                       [-D profile] [-w trace_dir] [-g count] [-s seed] [-j jobs]
+ *                       [track.trk ...]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sim_run.h"
+#include "sim_trackgen.h"
+
+#define CORPUS_BATCH (32) // 每批同时载入的赛道数 Tracks held in memory at once
+
+static char Point_Char(PathPoint_t point)
+{
+    return point >= POINT_A && point <= POINT_D ? (char)('A' + point - POINT_A) : '-';
+}
+
+static void Print_Row(CarMode_t mode, const SimTrack_t *track, const SimRunResult_t *res, int csv)
+{
+    char splits[256] = "";
+    size_t len = 0;
+    uint32_t prev = 0;
+    for (int e = 0; e < res->event_count && len < sizeof(splits) - 16; e++)
+    {
+        const SimRunEvent_t *ev = &res->event[e];
+        len += snprintf(splits + len, sizeof(splits) - len, "%s%c%s%.2f",
+                        e ? (csv ? ";" : " ") : "", Point_Char(ev->point), ev->hit ? "" : "?",
+                        (ev->t_ms - prev) / 1000.0);
+        prev = ev->t_ms;
+    }
+
+    const char *state = res->completed ? "done" : "timeout";
+    uint32_t limit_ms = Sim_Run_Time_Limit(mode);
+    if (res->completed && limit_ms && res->total_ms > limit_ms)
+        state = "over";
+
+    if (csv)
+    {
+        printf("%d,%s,%s,%.3f,%s,%d,%d,%.2f,%.2f,%.4f,%.1f,%.1f\n",
+               mode, track->name, state, res->total_ms / 1000.0, splits,
+               res->false_positives, res->misses, res->xte_rms_mm, res->xte_max_mm,
+               res->sat_frac, res->stop_error_mm, res->progress_mm);
+    }
+    else
+    {
+        printf("%-4d %-8s %-7s %8.2f  %6d %4d  %7.1f %7.1f  %5.1f  %7.0f %8.0f   %s\n",
+               mode, track->name, state, res->total_ms / 1000.0,
+               res->false_positives, res->misses, res->xte_rms_mm, res->xte_max_mm,
+               res->sat_frac * 100.0, res->stop_error_mm, res->progress_mm, splits);
+    }
+}
+
+// 赛道集的汇总 Summary over a corpus
+typedef struct
+{
+    int runs;
+    int failed;     // 仿真或赛道加载失败 Simulation or track load failed
+    int done;       // 完成且满足时间要求 Completed within the time limit
+    int clean;      // 完成且无误判漏判 Done with no false positives or misses
+    double done_s;  // 完成赛道的用时之和 Sum of times over done tracks
+    double worst_s;
+} Corpus_t;
+
+/**
+ * @brief  在赛道集上并行运行一个任务
+ *         Run one task over a corpus of tracks in parallel
+ * @param  files: 赛道文件，为NULL时按种子生成gen_count条 Track files; NULL generates gen_count tracks from seed
+ */
+static int Run_Corpus(const SimRunConfig_t *base, char **files, int count, unsigned seed, int jobs, int csv)
+{
+    static SimTrack_t track[CORPUS_BATCH];
+    static SimRunConfig_t cfg[CORPUS_BATCH];
+    static SimRunResult_t res[CORPUS_BATCH];
+    static int ok[CORPUS_BATCH];
+    uint32_t limit_ms = Sim_Run_Time_Limit(base->mode);
+    Corpus_t sum = {0};
+    SimTrackGen_t gen;
+    Sim_Track_Gen_Default(&gen, base->mode);
+
+    for (int first = 0; first < count; first += CORPUS_BATCH)
+    {
+        int batch = count - first < CORPUS_BATCH ? count - first : CORPUS_BATCH;
+        int loaded = 0;
+        for (int n = 0; n < batch; n++)
+        {
+            int ret = files ? Sim_Track_Load(&track[loaded], files[first + n])
+                            : Sim_Track_Gen(&track[loaded], &gen, seed + (unsigned)(first + n));
+            if (ret != 0)
+            {
+                sum.runs++;
+                sum.failed++;
+                continue;
+            }
+            cfg[loaded] = *base;
+            cfg[loaded].track = &track[loaded];
+            loaded++;
+        }
+
+        Sim_Run_Parallel(cfg, res, ok, loaded, jobs);
+
+        for (int n = 0; n < loaded; n++)
+        {
+            sum.runs++;
+            if (!ok[n])
+            {
+                fprintf(stderr, "%s: simulation failed\n", track[n].name);
+                sum.failed++;
+            }
+            else
+            {
+                double t = res[n].total_ms / 1000.0;
+                int done = res[n].completed && (!limit_ms || res[n].total_ms <= limit_ms);
+                sum.done += done;
+                sum.clean += done && res[n].false_positives == 0 && res[n].misses == 0;
+                if (done)
+                    sum.done_s += t;
+                if (t > sum.worst_s)
+                    sum.worst_s = t;
+                Print_Row(base->mode, &track[n], &res[n], csv);
+            }
+            Sim_Track_Free(&track[n]);
+        }
+        fflush(stdout);
+    }
+
+    // CSV模式下汇总写到stderr，保持stdout为纯表格 In CSV mode the summary goes to stderr so stdout stays a table
+    fprintf(csv ? stderr : stdout,
+            "\ncorpus task%d: %d tracks, done %d (%.1f%%), clean %d (%.1f%%), failed %d, "
+            "mean done %.2f s, worst %.2f s\n",
+            base->mode, sum.runs, sum.done, 100.0 * sum.done / (sum.runs ? sum.runs : 1),
+            sum.clean, 100.0 * sum.clean / (sum.runs ? sum.runs : 1), sum.failed,
+            sum.done ? sum.done_s / sum.done : 0.0, sum.worst_s);
+    return sum.failed ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    int only_task = 0, csv = 0, realtime = 0, gen_count = 0, jobs = 0;
+    const char *track_path = NULL, *profile = NULL, *trace_dir = NULL;
+    double timeout_s = 0;
+    unsigned seed = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:f:T:crD:w:g:s:j:")) != -1)
+    {
+        switch (opt)
+        {
+        case 't':
+            only_task = atoi(optarg);
+            break;
+        case 'f':
+            track_path = optarg;
+            break;
+        case 'T':
+            timeout_s = atof(optarg);
+            break;
+        case 'c':
+            csv = 1;
+            break;
+        case 'r':
+            realtime = 1;
+            break;
+        case 'D':
+            profile = optarg;
+            break;
+        case 'w':
+            trace_dir = optarg;
+            break;
+        case 'g':
+            gen_count = atoi(optarg);
+            break;
+        case 's':
+            seed = (unsigned)strtoul(optarg, NULL, 10);
+            break;
+        case 'j':
+            jobs = atoi(optarg);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-t task] [-f track.trk] [-T timeout_s] [-c] [-r]\n"
+                            "       [-D profile] [-w trace_dir] [-g count] [-s seed] [-j jobs]\n"
+                            "       [track.trk ...]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    SimCarParam_t check;
+    Sim_Car_Default_Param(&check);
+    if (profile != NULL && Sim_Car_Apply_Profile(&check, profile) != 0)
+    {
+        fprintf(stderr, "unknown profile in '%s' (ideal, noisy, coarse, asym, sag, tired, worst)\n", profile);
+        return 2;
+    }
+
+    if (csv)
+        printf("task,track,result,total_s,splits,false_pos,misses,xte_rms_mm,xte_max_mm,sat_frac,stop_err_mm,progress_mm\n");
+    else
+        printf("task track    result   total_s  falsep miss  xte_rms xte_max  sat%%  stop_mm  prog_mm   splits (s, ?=no marker)\n");
+
+    int file_count = argc - optind;
+    if (file_count > 0 || gen_count > 0)
+    {
+        SimRunConfig_t base;
+        Sim_Run_Default_Config(&base, (CarMode_t)(only_task ? only_task : MODE_TASK3), NULL);
+        if (base.mode < MODE_TASK1 || base.mode > MODE_TASK4)
+        {
+            fprintf(stderr, "bad task: %d\n", only_task);
+            return 2;
+        }
+        if (timeout_s > 0)
+            base.timeout_ms = (uint32_t)(timeout_s * 1000.0);
+        base.realtime = (uint8_t)realtime;
+        if (profile != NULL)
+            Sim_Car_Apply_Profile(&base.car, profile);
+        return Run_Corpus(&base, file_count > 0 ? argv + optind : NULL,
+                          file_count > 0 ? file_count : gen_count, seed, jobs, csv);
+    }
+
+    int failed = 0;
+    for (int mode = MODE_TASK1; mode <= MODE_TASK4; mode++)
+    {
+        if (only_task && mode != only_task)
+            continue;
+
+        static SimTrack_t track;
+        if (Sim_Track_Load(&track, track_path ? track_path : Sim_Run_Default_Track((CarMode_t)mode)) != 0)
+            return 1;
+
+        SimRunConfig_t cfg;
+        SimRunResult_t res;
+        Sim_Run_Default_Config(&cfg, (CarMode_t)mode, &track);
+        if (timeout_s > 0)
+            cfg.timeout_ms = (uint32_t)(timeout_s * 1000.0);
+        cfg.realtime = (uint8_t)realtime;
+        if (profile != NULL)
+            Sim_Car_Apply_Profile(&cfg.car, profile);
+        char trace_path[1024];
+        if (trace_dir != NULL)
+        {
+            snprintf(trace_path, sizeof(trace_path), "%s/task%d.trc", trace_dir, mode);
+            cfg.trace_path = trace_path;
+        }
+
+        if (Sim_Run_Isolated(&cfg, &res) != 0)
+        {
+            fprintf(stderr, "task %d: simulation failed\n", mode);
+            failed = 1;
+        }
+        else
+        {
+            Print_Row((CarMode_t)mode, &track, &res, csv);
+            fflush(stdout);
+        }
+        Sim_Track_Free(&track);
+    }
+    return failed;
+}
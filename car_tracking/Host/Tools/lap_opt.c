@@ -0,0 +1,355 @@
+/*
+ * lap_opt.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * 圈速优化：用CMA-ES同时调整速度环PID、巡线速度、弧线半径、car_irtrack和
+ * car_arc_tracking的各状态速度以及APP_Check_Points的判定时间，在所选任务
+ * 均按时完成的约束下最小化总用时，并把最优结果写成固件可直接包含的
+ * app_tune_gen.h（编译固件时定义APP_TUNE_GENERATED）。
+ * Lap-time optimiser: CMA-ES tunes the speed-loop PID, line speed, arc
+ * radius, the per-state speeds of car_irtrack and car_arc_tracking and the
+ * APP_Check_Points timing together, minimising total time subject to every
+ * selected task finishing within its limit. The best set is written as an
+ * app_tune_gen.h the firmware includes directly when built with
+ * APP_TUNE_GENERATED defined.
+ *
+ * 参数归一化到[0,1]搜索，越界的候选按边界值运行并加罚。
+ * Parameters are searched in [0,1]; out-of-range candidates run clamped to
+ * the bounds and pay a penalty.
+ *
+ * 用法 Usage: lap_opt [-t tasks] [-g generations] [-l lambda] [-S sigma]
+ *                     [-s seed] [-j jobs] [-o header]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sim_cmaes.h"
+#include "sim_run.h"
+
+#define MAX_TASKS (4)
+#define FAIL_PENALTY_S (100.0)  // 未按时完成的附加代价 Extra cost for a task not done in time
+#define DETECT_PENALTY_S (10.0) // 每次误判或漏判 Per false positive or miss
+#define BOUND_PENALTY_S (100.0) // 越界距离平方的系数 Weight on squared distance outside the bounds
+
+typedef enum
+{
+    PARAM_KP = 0,
+    PARAM_KI,
+    PARAM_KD,
+    PARAM_SPEED,
+    PARAM_RADIUS,
+    PARAM_SOFT,
+    PARAM_HARD,
+    PARAM_SHARP,
+    PARAM_SLOW,
+    PARAM_ARC_CORRECT,
+    PARAM_ARC_LOST,
+    PARAM_DEBOUNCE,
+    PARAM_ARC_MIN,
+    PARAM_COUNT
+} Param_t;
+
+typedef struct
+{
+    const char *macro; // app_tune.h中的宏名 Macro name in app_tune.h
+    double lo, hi;
+    double def;
+    uint8_t integer;
+} ParamDef_t;
+
+static const ParamDef_t g_param[PARAM_COUNT] = {
+    {"PID_DEF_KP", 0.2, 2.0, PID_DEF_KP, 0},
+    {"PID_DEF_KI", 0.0, 30.0, PID_DEF_KI, 0},
+    {"PID_DEF_KD", 0.0, 0.01, PID_DEF_KD, 0},
+    {"LINE_SPEED_DEF", 300, 1000, LINE_SPEED_DEF, 1},
+    {"ARC_TURN_RADIUS_DEF", 0, 100, ARC_TURN_RADIUS_DEF, 1},
+    {"IRTRACK_SOFT_PCT", -50, 100, IRTRACK_SOFT_PCT, 1},
+    {"IRTRACK_HARD_PCT", -100, 100, IRTRACK_HARD_PCT, 1},
+    {"IRTRACK_SHARP_PCT", -100, 50, IRTRACK_SHARP_PCT, 1},
+    {"IRTRACK_SLOW_PCT", 10, 100, IRTRACK_SLOW_PCT, 1},
+    {"ARC_CORRECT_PCT", 0, 100, ARC_CORRECT_PCT, 1},
+    {"ARC_LOST_PCT", 0, 100, ARC_LOST_PCT, 1},
+    {"POINT_DEBOUNCE_MS", 200, 3000, POINT_DEBOUNCE_MS, 1},
+    {"ARC_MIN_MS", 500, 4000, ARC_MIN_MS, 1},
+};
+
+// 一组参数的评估结果 Evaluation of one parameter set
+typedef struct
+{
+    double value[PARAM_COUNT];
+    double cost;
+    double total_s;
+    int done;
+    int clean;
+    int runs;
+} Eval_t;
+
+static double Clamp01(double u)
+{
+    return u < 0.0 ? 0.0 : (u > 1.0 ? 1.0 : u);
+}
+
+// 归一化坐标转参数值，按头文件中的精度取整，使评估值与写出的值一致
+// Normalised coordinate to parameter value, rounded to the precision written to the header
+static double Param_Value(int p, double u)
+{
+    double v = g_param[p].lo + (g_param[p].hi - g_param[p].lo) * Clamp01(u);
+    return g_param[p].integer ? floor(v + 0.5) : floor(v * 1e4 + 0.5) * 1e-4;
+}
+
+static void Set_Tune(SimRunTune_t *tune, const double *v)
+{
+    tune->kp = (float)v[PARAM_KP];
+    tune->ki = (float)v[PARAM_KI];
+    tune->kd = (float)v[PARAM_KD];
+    tune->line_speed = (int16_t)v[PARAM_SPEED];
+    tune->arc_radius = (uint8_t)v[PARAM_RADIUS];
+    tune->app.irtrack_soft_pct = (int16_t)v[PARAM_SOFT];
+    tune->app.irtrack_hard_pct = (int16_t)v[PARAM_HARD];
+    tune->app.irtrack_sharp_pct = (int16_t)v[PARAM_SHARP];
+    tune->app.irtrack_slow_pct = (int16_t)v[PARAM_SLOW];
+    tune->app.arc_correct_pct = (int16_t)v[PARAM_ARC_CORRECT];
+    tune->app.arc_lost_pct = (int16_t)v[PARAM_ARC_LOST];
+    tune->app.point_debounce_ms = (uint16_t)v[PARAM_DEBOUNCE];
+    tune->app.arc_min_ms = (uint16_t)v[PARAM_ARC_MIN];
+}
+
+/**
+ * @brief  一次任务的代价：按时完成为用时，否则为时限加罚，并按进度给出梯度
+ *         Cost of one run: the time when done in time, otherwise the limit
+ *         plus a penalty that still rewards progress
+ */
+static void Score(Eval_t *e, const SimRunConfig_t *cfg, const SimRunResult_t *res, int ok)
+{
+    uint32_t limit_ms = Sim_Run_Time_Limit(cfg->mode);
+    double limit_s = (limit_ms ? limit_ms : cfg->timeout_ms) / 1000.0;
+    e->runs++;
+    if (!ok)
+    {
+        e->cost += limit_s + FAIL_PENALTY_S * 2.0;
+        return;
+    }
+    int done = res->completed && (!limit_ms || res->total_ms <= limit_ms);
+    int errors = res->false_positives + res->misses;
+    e->done += done;
+    e->clean += done && errors == 0;
+    e->total_s += res->total_ms / 1000.0;
+    if (done)
+        e->cost += res->total_ms / 1000.0;
+    else
+        e->cost += limit_s + FAIL_PENALTY_S - res->progress_mm / 1000.0;
+    e->cost += DETECT_PENALTY_S * errors;
+}
+
+// 对n组参数各跑所有任务 Run every task for n parameter sets
+static void Evaluate(Eval_t *eval, int n, const CarMode_t *mode, const SimTrack_t *track, int task_count, int jobs)
+{
+    static SimRunConfig_t cfg[SIM_CMAES_MAX_POP * MAX_TASKS];
+    static SimRunResult_t res[SIM_CMAES_MAX_POP * MAX_TASKS];
+    static int ok[SIM_CMAES_MAX_POP * MAX_TASKS];
+    int runs = 0;
+
+    for (int k = 0; k < n; k++)
+    {
+        for (int t = 0; t < task_count; t++)
+        {
+            Sim_Run_Default_Config(&cfg[runs], mode[t], &track[t]);
+            Set_Tune(&cfg[runs].tune, eval[k].value);
+            runs++;
+        }
+        eval[k].cost = eval[k].total_s = 0.0;
+        eval[k].done = eval[k].clean = eval[k].runs = 0;
+    }
+
+    Sim_Run_Parallel(cfg, res, ok, runs, jobs);
+
+    for (int r = 0; r < runs; r++)
+        Score(&eval[r / task_count], &cfg[r], &res[r], ok[r]);
+}
+
+static void Print_Eval(FILE *f, const char *label, const Eval_t *e)
+{
+    fprintf(f, "%-8s cost %8.2f  total %7.2f s  done %d/%d  clean %d/%d\n",
+            label, e->cost, e->total_s, e->done, e->runs, e->clean, e->runs);
+}
+
+static int Write_Header(const char *path, const Eval_t *e, const char *tasks, int generations, unsigned seed)
+{
+    FILE *f = fopen(path, "w");
+    if (f == NULL)
+    {
+        perror(path);
+        return -1;
+    }
+    fprintf(f, "/*\n * app_tune_gen.h\n *\n"
+               " * 由lap_opt生成，请勿手工修改 Generated by lap_opt, do not edit\n"
+               " * lap_opt -t %s -g %d -s %u: total %.2f s, done %d/%d, clean %d/%d\n"
+               " * 编译固件时定义APP_TUNE_GENERATED以使用 Define APP_TUNE_GENERATED to use it\n */\n\n",
+            tasks, generations, seed, e->total_s, e->done, e->runs, e->clean, e->runs);
+    fprintf(f, "#ifndef APP_TUNE_GEN_H_\n#define APP_TUNE_GEN_H_\n\n");
+    for (int p = 0; p < PARAM_COUNT; p++)
+    {
+        if (g_param[p].integer)
+            fprintf(f, "#define %s (%d)\n", g_param[p].macro, (int)e->value[p]);
+        else
+            fprintf(f, "#define %s (%.7ff)\n", g_param[p].macro, e->value[p]);
+    }
+    fprintf(f, "\n#endif /* APP_TUNE_GEN_H_ */\n");
+    fclose(f);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *tasks = "34", *out_path = "app_tune_gen.h";
+    int generations = 30, lambda = 0, jobs = 0;
+    double sigma = 0.05; // 默认值附近可行域窄 The feasible region around the defaults is narrow
+    unsigned seed = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:g:l:S:s:j:o:")) != -1)
+    {
+        switch (opt)
+        {
+        case 't':
+            tasks = optarg;
+            break;
+        case 'g':
+            generations = atoi(optarg);
+            break;
+        case 'l':
+            lambda = atoi(optarg);
+            break;
+        case 'S':
+            sigma = atof(optarg);
+            break;
+        case 's':
+            seed = (unsigned)strtoul(optarg, NULL, 10);
+            break;
+        case 'j':
+            jobs = atoi(optarg);
+            break;
+        case 'o':
+            out_path = optarg;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-t tasks] [-g generations] [-l lambda] [-S sigma]\n"
+                            "       [-s seed] [-j jobs] [-o header]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    static SimTrack_t track[MAX_TASKS];
+    CarMode_t mode[MAX_TASKS];
+    int task_count = 0;
+    for (const char *c = tasks; *c && task_count < MAX_TASKS; c++)
+    {
+        if (*c < '1' || *c > '4')
+        {
+            fprintf(stderr, "bad task: %c\n", *c);
+            return 2;
+        }
+        mode[task_count] = (CarMode_t)(*c - '0');
+        if (Sim_Track_Load(&track[task_count], Sim_Run_Default_Track(mode[task_count])) != 0)
+            return 1;
+        task_count++;
+    }
+    if (jobs <= 0)
+        jobs = Sim_Run_Jobs();
+
+    // 从固件默认值出发 Start from the firmware defaults
+    static SimCmaes_t es;
+    double x0[PARAM_COUNT];
+    for (int p = 0; p < PARAM_COUNT; p++)
+        x0[p] = (g_param[p].def - g_param[p].lo) / (g_param[p].hi - g_param[p].lo);
+    if (Sim_Cmaes_Init(&es, PARAM_COUNT, x0, sigma, lambda, seed) != 0)
+    {
+        fprintf(stderr, "bad lambda: %d (max %d)\n", lambda, SIM_CMAES_MAX_POP);
+        return 2;
+    }
+
+    Eval_t def, best;
+    for (int p = 0; p < PARAM_COUNT; p++)
+        def.value[p] = g_param[p].def;
+    Evaluate(&def, 1, mode, track, task_count, jobs);
+    Print_Eval(stderr, "default", &def);
+    best = def;
+    int best_feasible = def.done == def.runs;
+
+    fprintf(stderr, "%d parameters, lambda %d, %d generations x %d tasks, %d jobs\n",
+            PARAM_COUNT, es.lambda, generations, task_count, jobs);
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    static Eval_t eval[SIM_CMAES_MAX_POP];
+    double cost[SIM_CMAES_MAX_POP];
+
+    for (int g = 0; g < generations; g++)
+    {
+        Sim_Cmaes_Ask(&es);
+        for (int k = 0; k < es.lambda; k++)
+            for (int p = 0; p < PARAM_COUNT; p++)
+                eval[k].value[p] = Param_Value(p, es.x[k][p]);
+        Evaluate(eval, es.lambda, mode, track, task_count, jobs);
+
+        int gen_best = 0;
+        for (int k = 0; k < es.lambda; k++)
+        {
+            double out = 0.0;
+            for (int p = 0; p < PARAM_COUNT; p++)
+            {
+                double d = es.x[k][p] - Clamp01(es.x[k][p]);
+                out += d * d;
+            }
+            cost[k] = eval[k].cost + BOUND_PENALTY_S * out;
+            if (cost[k] < cost[gen_best])
+                gen_best = k;
+
+            // 只接受全部按时完成的候选 Only sets that finish every task in time are kept
+            int feasible = eval[k].done == eval[k].runs;
+            if (feasible && (!best_feasible || eval[k].cost < best.cost))
+            {
+                best = eval[k];
+                best_feasible = 1;
+            }
+        }
+        Sim_Cmaes_Tell(&es, cost);
+
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        double elapsed = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+        fprintf(stderr, "gen %3d  sigma %.3f  gen best %8.2f  best %8.2f  %.1f s\n",
+                g + 1, es.sigma, cost[gen_best], best.cost, elapsed);
+    }
+
+    Print_Eval(stdout, "default", &def);
+    Print_Eval(stdout, "best", &best);
+    printf("\n%-20s %10s %10s\n", "parameter", "default", "best");
+    for (int p = 0; p < PARAM_COUNT; p++)
+        printf("%-20s %10.4g %10.4g\n", g_param[p].macro, def.value[p], best.value[p]);
+
+    int rc = 0;
+    if (!best_feasible)
+    {
+        fprintf(stderr, "no set finished every task in time, %s not written\n", out_path);
+        rc = 1;
+    }
+    else if (Write_Header(out_path, &best, tasks, generations, seed) == 0)
+    {
+        printf("\nwrote %s\n", out_path);
+    }
+    else
+    {
+        rc = 1;
+    }
+
+    for (int t = 0; t < task_count; t++)
+        Sim_Track_Free(&track[t]);
+    return rc;
+}
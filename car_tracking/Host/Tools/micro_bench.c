@@ -0,0 +1,766 @@
+/*
+ * micro_bench.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * 热点函数微基准：PID_Incre_Calc、PID_Location_Calc、PID_Yaw_Calc及其定点版、
+ * Motion_Get_Speed、wheel_Ctrl、Motion_Set_Speed、get_sensor_status、
+ * car_irtrack和car_arc_tracking。输入取自一次运行的输入记录：传感器
+ * 状态按每遍主循环的直方图抽样，编码器计数按记录顺序使用，PID、偏航
+ * 和运动指令由编码器速度导出。默认在仿真中跑一次任务得到记录，-i可
+ * 改用实车导出或lap_bench -w写出的记录。
+ * Hot-function microbenchmark: PID_Incre_Calc, PID_Location_Calc,
+ * PID_Yaw_Calc and their fixed-point versions, Motion_Get_Speed, wheel_Ctrl, Motion_Set_Speed,
+ * get_sensor_status, car_irtrack and car_arc_tracking. Inputs come from the
+ * input trace of a run: sensor states are drawn from the per-pass histogram,
+ * encoder counts are used in recorded order and the PID, yaw and motion
+ * commands are derived from the encoder speeds. By default one task is run
+ * in simulation to get the trace; -i uses a trace dumped from the car or
+ * written by lap_bench -w instead.
+ *
+ * 每个函数报告主机构建上每次调用的时间，以及在Cortex-M3仿真核上调用
+ * Keil映像中同一函数的周期数、软浮点库调用次数、跳转次数(流水线重新
+ * 填充)和指令数，按目标周期数排序。映像中被链接器删掉的函数只有主机时间。
+ * Each function reports the time per call of the host build and, calling
+ * the same function of the Keil image on the Cortex-M3 core, the cycles,
+ * soft-float library calls, taken branches (pipeline refills) and
+ * instructions per call, ranked by target cycles. Functions the linker
+ * dropped from the image only have the host time.
+ *
+ * 用法 Usage: micro_bench [-i trace.trc] [-t task] [-n inputs] [-s seed]
+ *                         [-a car_tracking.axf]
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sim_fil.h"
+#include "sim_run.h"
+#include "sim_trace.h"
+#include "hal_shim.h"
+
+#define HOST_REPS (20)            // 主机计时重复次数，取最小值 Host timing repeats, the minimum is kept
+#define TARGET_CALL_LIMIT (200000u) // 单次调用的周期上限 Cycle limit for one target call
+#define MAX_FUNCS (12)
+
+// 固件中没有在头文件里声明的全局量 Firmware globals without a header declaration
+extern int g_Encoder_M1_Now, g_Encoder_M2_Now, g_Encoder_M3_Now, g_Encoder_M4_Now;
+extern uint8_t g_start_ctrl;
+extern car_data_t car_data;
+
+typedef struct
+{
+    uint8_t status;      // IN_X1..X4，与get_sensor_status相同的位序 Same bit order as get_sensor_status
+    uint8_t direction;   // car_arc_tracking的转向 Turn direction for car_arc_tracking
+    int32_t enc[4];      // 编码器累计计数 Running encoder counts
+    float speed[4];      // 轮速mm/s Wheel speeds in mm/s
+    float yaw;           // 由轮速积分的航向，rad Heading integrated from wheel speeds, rad
+    pidq_t speed_q[2];   // 定点PID的输入 Inputs of the fixed-point PIDs
+    pidq_t yaw_q;
+    int16_t vx, vz;      // wheel_Ctrl的指令 Command for wheel_Ctrl
+} BenchInput_t;
+
+typedef struct
+{
+    BenchInput_t *in;
+    int count;
+    uint64_t hist[16];   // 每遍主循环的传感器状态 Sensor state per main-loop pass
+    uint64_t passes;
+    uint32_t samples;    // 记录中的中断次数 Interrupts in the trace
+} BenchSet_t;
+
+typedef struct
+{
+    SimFil_t fil;
+    const SimCm3Sym_t *fp;   // 软浮点库函数 Soft-float library functions
+    uint32_t fp_count;
+    uint32_t *fp_lo, *fp_hi; // 软浮点库代码范围 Code ranges of the soft-float library
+    uint64_t fp_calls;
+    uint32_t enc_addr[4];
+    uint32_t pid_addr;       // pid_motor，浮点映像为PID_t，定点映像为PIDQ_t PID_t in a float image, PIDQ_t in a fixed-point one
+    uint32_t yaw_addr;
+    uint32_t start_ctrl_addr;
+} BenchTarget_t;
+
+typedef struct
+{
+    const char *name;
+    int isr;                                   // 在TIM6中断中调用 Called from the TIM6 interrupt
+    void (*setup)(const BenchInput_t *in);     // 主机：放入输入 Host: apply the input
+    void (*call)(const BenchInput_t *in);      // 主机：调用一次 Host: one call
+    int (*target)(BenchTarget_t *t, const BenchInput_t *in, uint32_t *args); // 目标：放入输入，返回参数个数 Target: apply the input, return the argument count
+} BenchFunc_t;
+
+typedef struct
+{
+    double host_ns;
+    int linked;
+    double cycles, fp_calls, branches, instructions;
+} BenchResult_t;
+
+static volatile float s_sink;
+
+// 主机端PID各用一份独立状态 The host PIDs each run on their own state
+static PID_t s_pid[2];
+static PIDQ_t s_pidq[2];
+static PIDQ_Yaw_t s_yawq;
+
+/* ---------------------------------------------------------------------------
+ * 输入 Inputs
+ * ------------------------------------------------------------------------- */
+
+static uint32_t Rand_Next(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static float Enc_Speed(int32_t offset)
+{
+    return offset * CTRL_RATE_HZ * MECANUM_CIRCLE_MM / ENCODER_CIRCLE_450;
+}
+
+/**
+ * @brief  从输入记录中统计传感器直方图，按中断取出编码器读数，生成count组输入
+ *         Build count input sets from a trace: a sensor histogram per
+ *         main-loop pass and the encoder reads per interrupt
+ * @retval 0成功，-1记录中没有编码器读数 0 on success, -1 if the trace holds no encoder reads
+ */
+static int Bench_Inputs(BenchSet_t *set, const SimTraceFile_t *trace, int count, uint32_t seed)
+{
+    uint8_t pin[4] = {0};
+    int32_t *offset = malloc(trace->count * sizeof(int32_t));
+    uint32_t n = 0, got = 0;
+    int32_t row[4] = {0};
+    uint16_t last[4] = {0x7fff, 0x7fff, 0x7fff, 0x7fff};
+
+    memset(set, 0, sizeof(*set));
+    if (offset == NULL)
+        return -1;
+    for (uint32_t i = 0; i < trace->count; i++)
+    {
+        uint32_t r = trace->rec[i], idx = TRACE_INDEX(r);
+        switch (TRACE_KIND(r))
+        {
+        case TRACE_KIND_IN:
+            if (idx <= TRACE_PIN_X4)
+                pin[idx] = TRACE_VALUE(r) != 0;
+            break;
+        case TRACE_KIND_LOOP:
+            set->hist[pin[0] << 3 | pin[1] << 2 | pin[2] << 1 | pin[3]] += TRACE_VALUE(r);
+            set->passes += TRACE_VALUE(r);
+            break;
+        case TRACE_KIND_CNT:
+            // 与Encoder_Read_CNT相同的换算 Same conversion as Encoder_Read_CNT
+            if (idx < 4)
+            {
+                row[idx] = (int16_t)(uint16_t)(last[idx] - TRACE_VALUE(r));
+                last[idx] = (uint16_t)TRACE_VALUE(r);
+                got |= 1u << idx;
+            }
+            if (got == 0xFu)
+            {
+                memcpy(&offset[n * 4u], row, sizeof(row));
+                n++;
+                got = 0;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    set->samples = n;
+    if (n == 0 || set->passes == 0)
+    {
+        free(offset);
+        return -1;
+    }
+
+    set->in = calloc((size_t)count, sizeof(BenchInput_t));
+    if (set->in == NULL)
+    {
+        free(offset);
+        return -1;
+    }
+    set->count = count;
+
+    int32_t enc[4] = {0};
+    float yaw = 0.0f;
+    for (int i = 0; i < count; i++)
+    {
+        BenchInput_t *in = &set->in[i];
+        const int32_t *off = &offset[(uint32_t)i % n * 4u];
+
+        // 按直方图抽取传感器状态 Draw a sensor state from the histogram
+        uint64_t pick = Rand_Next(&seed) % set->passes;
+        int s = 0;
+        while (pick >= set->hist[s])
+            pick -= set->hist[s++];
+        in->status = (uint8_t)s;
+        in->direction = Rand_Next(&seed) & 1u;
+
+        // 编码器计数为负累加，见Encoder_Update_Count The counts accumulate negated, see Encoder_Update_Count
+        for (int m = 0; m < 4; m++)
+        {
+            enc[m] -= off[m];
+            in->enc[m] = enc[m];
+            in->speed[m] = Enc_Speed(-off[m]);
+        }
+        float vx = (in->speed[0] + in->speed[1] + in->speed[2] + in->speed[3]) / 4;
+        float vz = -(in->speed[0] + in->speed[1] - in->speed[2] - in->speed[3]) / 4.0f / STM32Car_APB * 1000;
+        yaw += vz / 1000.0f * 0.01f;
+        in->yaw = yaw;
+        in->speed_q[0] = PIDQ_FROM_FLOAT(in->speed[0]);
+        in->speed_q[1] = PIDQ_FROM_FLOAT(in->speed[1]);
+        in->yaw_q = PIDQ_FROM_FLOAT(yaw);
+        in->vx = (int16_t)vx;
+        in->vz = (int16_t)vz;
+    }
+    free(offset);
+    return 0;
+}
+
+/* ---------------------------------------------------------------------------
+ * 主机端 Host side
+ * ------------------------------------------------------------------------- */
+
+static void Set_Pins(const BenchInput_t *in)
+{
+    Shim_GPIO_Set_Input(X1_GPIO_Port, X1_Pin, (in->status & 8u) ? GPIO_PIN_SET : GPIO_PIN_RESET);
+    Shim_GPIO_Set_Input(X2_GPIO_Port, X2_Pin, (in->status & 4u) ? GPIO_PIN_SET : GPIO_PIN_RESET);
+    Shim_GPIO_Set_Input(X3_GPIO_Port, X3_Pin, (in->status & 2u) ? GPIO_PIN_SET : GPIO_PIN_RESET);
+    Shim_GPIO_Set_Input(X4_GPIO_Port, X4_Pin, (in->status & 1u) ? GPIO_PIN_SET : GPIO_PIN_RESET);
+}
+
+static void Set_Encoders(const BenchInput_t *in)
+{
+    g_Encoder_M1_Now = in->enc[0];
+    g_Encoder_M2_Now = in->enc[1];
+    g_Encoder_M3_Now = in->enc[2];
+    g_Encoder_M4_Now = in->enc[3];
+}
+
+static void No_Setup(const BenchInput_t *in)
+{
+    (void)in;
+}
+
+static void Host_Incre(const BenchInput_t *in)
+{
+    s_sink = PID_Incre_Calc(&s_pid[0], in->speed[0]);
+}
+
+static void Host_Location(const BenchInput_t *in)
+{
+    s_sink = PID_Location_Calc(&s_pid[1], in->speed[1]);
+}
+
+static void Host_Yaw(const BenchInput_t *in)
+{
+    s_sink = PID_Yaw_Calc(in->yaw);
+}
+
+static void Host_Incre_Q(const BenchInput_t *in)
+{
+    s_sink = PIDQ_Incre_Calc(&s_pidq[0], in->speed_q[0]);
+}
+
+static void Host_Location_Q(const BenchInput_t *in)
+{
+    s_sink = PIDQ_Location_Calc(&s_pidq[1], in->speed_q[1]);
+}
+
+static void Host_Yaw_Q(const BenchInput_t *in)
+{
+    s_sink = PIDQ_Yaw_Calc(&s_yawq, in->yaw_q);
+}
+
+static void Host_Get_Speed(const BenchInput_t *in)
+{
+    (void)in;
+    Motion_Get_Speed(&car_data);
+}
+
+static void Host_Wheel_Ctrl(const BenchInput_t *in)
+{
+    wheel_Ctrl(in->vx, 0, in->vz);
+}
+
+static void Host_Set_Speed(const BenchInput_t *in)
+{
+    Motion_Set_Speed((int16_t)in->speed[0], (int16_t)in->speed[1], (int16_t)in->speed[2], (int16_t)in->speed[3]);
+}
+
+static void Host_Sensor(const BenchInput_t *in)
+{
+    (void)in;
+    s_sink = get_sensor_status();
+}
+
+static void Host_Irtrack(const BenchInput_t *in)
+{
+    (void)in;
+    car_irtrack();
+}
+
+static void Host_Arc(const BenchInput_t *in)
+{
+    car_arc_tracking(in->direction, ARC_TURN_RADIUS_DEF);
+}
+
+static double Now_Ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// 放入输入的开销单独计时后减去 The cost of applying inputs is timed alone and subtracted
+static double Host_Time(const BenchFunc_t *f, const BenchSet_t *set)
+{
+    double best_all = 1e30, best_setup = 1e30;
+    for (int rep = 0; rep < HOST_REPS; rep++)
+    {
+        double t0 = Now_Ns();
+        for (int i = 0; i < set->count; i++)
+            f->setup(&set->in[i]);
+        double t1 = Now_Ns();
+        for (int i = 0; i < set->count; i++)
+        {
+            f->setup(&set->in[i]);
+            f->call(&set->in[i]);
+        }
+        double t2 = Now_Ns();
+        if (t1 - t0 < best_setup)
+            best_setup = t1 - t0;
+        if (t2 - t1 < best_all)
+            best_all = t2 - t1;
+    }
+    double ns = (best_all - best_setup) / set->count;
+    return ns > 0 ? ns : 0;
+}
+
+/* ---------------------------------------------------------------------------
+ * 目标端 Target side
+ * ------------------------------------------------------------------------- */
+
+static uint32_t Float_Bits(float v)
+{
+    uint32_t u;
+    memcpy(&u, &v, sizeof(u));
+    return u;
+}
+
+// armcc/armclang和libgcc的软浮点函数名 Soft-float names of armcc/armclang and libgcc
+static int Is_Soft_Float(const char *name)
+{
+    static const char *const prefix[] = {
+        "__aeabi_f", "__aeabi_d", "__aeabi_cf", "__aeabi_cd", "__aeabi_i2f", "__aeabi_ui2f", "__aeabi_l2f",
+        "__aeabi_ul2f", "__aeabi_i2d", "__aeabi_ui2d", "__aeabi_l2d", "__aeabi_ul2d", "__fpl_", "_float_",
+        "_double_",
+    };
+    static const char *const suffix[] = {"sf2", "sf3", "df2", "df3", "sfsi", "dfsi", "sisf", "sidf", "sfdi", "disf"};
+
+    for (size_t i = 0; i < sizeof(prefix) / sizeof(prefix[0]); i++)
+        if (strncmp(name, prefix[i], strlen(prefix[i])) == 0)
+            return 1;
+    // Keil的_fadd、_dmul等 Keil's _fadd, _dmul and so on
+    if (name[0] == '_' && (name[1] == 'f' || name[1] == 'd') && name[2] >= 'a' && name[2] <= 'z')
+        return 1;
+    size_t len = strlen(name);
+    if (strncmp(name, "__", 2) == 0)
+        for (size_t i = 0; i < sizeof(suffix) / sizeof(suffix[0]); i++)
+            if (len > strlen(suffix[i]) && strcmp(name + len - strlen(suffix[i]), suffix[i]) == 0)
+                return 1;
+    return 0;
+}
+
+// 只数从库外进入软浮点库的调用 Only calls into the soft-float library from outside it count
+static void Target_On_Watch(SimCm3_t *cpu, uint32_t pc)
+{
+    BenchTarget_t *t = (BenchTarget_t *)cpu->ctx; // fil是第一个成员 fil is the first member
+    uint32_t from = cpu->r[14] & ~1u;
+    (void)pc;
+    for (uint32_t i = 0; i < t->fp_count; i++)
+        if (from >= t->fp_lo[i] && from < t->fp_hi[i])
+            return;
+    t->fp_calls++;
+}
+
+static int Target_Init(BenchTarget_t *t, const char *axf)
+{
+    SimCarParam_t param;
+    Sim_Car_Default_Param(&param);
+    memset(t, 0, sizeof(*t));
+    if (Sim_Fil_Init(&t->fil, axf, &param) != 0)
+        return -1;
+
+    SimCm3_t *cpu = t->fil.cpu;
+    t->fp_lo = calloc(cpu->sym_count, sizeof(uint32_t));
+    t->fp_hi = calloc(cpu->sym_count, sizeof(uint32_t));
+    if (t->fp_lo == NULL || t->fp_hi == NULL)
+        return -1;
+    for (uint32_t i = 0; i < cpu->sym_count; i++)
+    {
+        const SimCm3Sym_t *s = &cpu->sym[i];
+        if (!s->func || !Is_Soft_Float(s->name))
+            continue;
+        t->fp_lo[t->fp_count] = s->addr;
+        t->fp_hi[t->fp_count] = s->addr + s->size;
+        t->fp_count++;
+        Sim_Cm3_Watch(cpu, s->addr, 1);
+    }
+    // 本工具不用探针，接管on_watch The tool uses no probes and takes over on_watch
+    cpu->on_watch = Target_On_Watch;
+
+    static const char *const enc[4] = {"g_Encoder_M1_Now", "g_Encoder_M2_Now", "g_Encoder_M3_Now", "g_Encoder_M4_Now"};
+    for (int m = 0; m < 4; m++)
+    {
+        const SimCm3Sym_t *s = Sim_Cm3_Find_Sym(cpu, enc[m]);
+        t->enc_addr[m] = s != NULL ? s->addr : 0;
+    }
+    const SimCm3Sym_t *s = Sim_Cm3_Find_Sym(cpu, "pid_motor");
+    t->pid_addr = s != NULL ? s->addr : 0;
+    s = Sim_Cm3_Find_Sym(cpu, "pid_Yaw");
+    t->yaw_addr = s != NULL ? s->addr : 0;
+    s = Sim_Cm3_Find_Sym(cpu, "g_start_ctrl");
+    t->start_ctrl_addr = s != NULL ? s->addr : 0;
+
+    // 跑过上电初始化进入主循环，然后在线程模式下关中断 Run through power-on init into the main loop, then mask interrupts in thread mode
+    if (Sim_Fil_Run_Us(&t->fil, 100000) != 0)
+        return -1;
+    while (cpu->depth != 0)
+    {
+        if (Sim_Cm3_Run(cpu, cpu->cycles + 16u) != 0)
+            return -1;
+    }
+    cpu->primask = 1;
+    cpu->irq_check = 1;
+    // 停掉底盘模型，GPIO输入只由本工具设置 Stop the chassis model so only this tool drives the GPIO inputs
+    t->fil.next_step = UINT64_MAX;
+    return 0;
+}
+
+static void Target_Free(BenchTarget_t *t)
+{
+    Sim_Fil_Free(&t->fil);
+    free(t->fp_lo);
+    free(t->fp_hi);
+}
+
+static void Target_Pins(BenchTarget_t *t, const BenchInput_t *in)
+{
+    (void)t;
+    Set_Pins(in); // 映像的GPIO读数落在同一组替身寄存器上 The image's GPIO reads land on the same shim registers
+}
+
+// 目标速度与主机相同，按被测函数的数制写入 Same target speed as the host, written in the format of the function under test
+static void Target_Pid(BenchTarget_t *t, int motor, uint32_t target_bits)
+{
+    Sim_Cm3_Write(t->fil.cpu, t->pid_addr + motor * sizeof(PID_t) + offsetof(PID_t, target_val), target_bits, 4);
+}
+
+static int Target_Incre(BenchTarget_t *t, const BenchInput_t *in, uint32_t *args)
+{
+    Target_Pid(t, 0, Float_Bits(LINE_SPEED_DEF));
+    args[0] = t->pid_addr;
+    args[1] = Float_Bits(in->speed[0]);
+    return 2;
+}
+
+static int Target_Location(BenchTarget_t *t, const BenchInput_t *in, uint32_t *args)
+{
+    Target_Pid(t, 1, Float_Bits(LINE_SPEED_DEF));
+    args[0] = t->pid_addr + sizeof(PID_t);
+    args[1] = Float_Bits(in->speed[1]);
+    return 2;
+}
+
+static int Target_Incre_Q(BenchTarget_t *t, const BenchInput_t *in, uint32_t *args)
+{
+    Target_Pid(t, 0, (uint32_t)PIDQ_FROM_INT(LINE_SPEED_DEF));
+    args[0] = t->pid_addr;
+    args[1] = (uint32_t)in->speed_q[0];
+    return 2;
+}
+
+static int Target_Location_Q(BenchTarget_t *t, const BenchInput_t *in, uint32_t *args)
+{
+    Target_Pid(t, 1, (uint32_t)PIDQ_FROM_INT(LINE_SPEED_DEF));
+    args[0] = t->pid_addr + sizeof(PID_t);
+    args[1] = (uint32_t)in->speed_q[1];
+    return 2;
+}
+
+static int Target_Yaw_Q(BenchTarget_t *t, const BenchInput_t *in, uint32_t *args)
+{
+    args[0] = t->yaw_addr;
+    args[1] = (uint32_t)in->yaw_q;
+    return 2;
+}
+
+static int Target_Yaw(BenchTarget_t *t, const BenchInput_t *in, uint32_t *args)
+{
+    (void)t;
+    args[0] = Float_Bits(in->yaw);
+    return 1;
+}
+
+static int Target_Get_Speed(BenchTarget_t *t, const BenchInput_t *in, uint32_t *args)
+{
+    for (int m = 0; m < 4; m++)
+        Sim_Cm3_Write(t->fil.cpu, t->enc_addr[m], (uint32_t)in->enc[m], 4);
+    Sim_Cm3_Write(t->fil.cpu, t->start_ctrl_addr, 1, 1);
+    args[0] = Sim_Cm3_Find_Sym(t->fil.cpu, "car_data")->addr;
+    return 1;
+}
+
+static int Target_Wheel_Ctrl(BenchTarget_t *t, const BenchInput_t *in, uint32_t *args)
+{
+    (void)t;
+    args[0] = (uint32_t)(int32_t)in->vx;
+    args[1] = 0;
+    args[2] = (uint32_t)(int32_t)in->vz;
+    return 3;
+}
+
+static int Target_Set_Speed(BenchTarget_t *t, const BenchInput_t *in, uint32_t *args)
+{
+    (void)t;
+    for (int m = 0; m < 4; m++)
+        args[m] = (uint32_t)(int32_t)(int16_t)in->speed[m];
+    return 4;
+}
+
+static int Target_Sensor(BenchTarget_t *t, const BenchInput_t *in, uint32_t *args)
+{
+    (void)args;
+    Target_Pins(t, in);
+    return 0;
+}
+
+static int Target_Arc(BenchTarget_t *t, const BenchInput_t *in, uint32_t *args)
+{
+    Target_Pins(t, in);
+    args[0] = in->direction;
+    args[1] = ARC_TURN_RADIUS_DEF;
+    return 2;
+}
+
+static int Target_Measure(BenchTarget_t *t, const BenchFunc_t *f, const BenchSet_t *set, BenchResult_t *res)
+{
+    SimCm3_t *cpu = t->fil.cpu;
+    const SimCm3Sym_t *s = Sim_Cm3_Find_Sym(cpu, f->name);
+    if (s == NULL || !s->func)
+        return -1;
+
+    uint64_t cycles = 0, branches = 0, instructions = 0;
+    t->fp_calls = 0;
+    for (int i = 0; i < set->count; i++)
+    {
+        uint32_t args[4];
+        int nargs = f->target(t, &set->in[i], args);
+        uint64_t c0 = cpu->cycles, b0 = cpu->branches, i0 = cpu->instructions;
+        if (Sim_Cm3_Call(cpu, s->addr, args, nargs, TARGET_CALL_LIMIT, NULL) != 0)
+        {
+            fprintf(stderr, "%s: call failed: %s\n", f->name, cpu->error[0] ? cpu->error : "no return");
+            return -1;
+        }
+        cycles += cpu->cycles - c0;
+        branches += cpu->branches - b0;
+        instructions += cpu->instructions - i0;
+    }
+    res->linked = 1;
+    res->cycles = (double)cycles / set->count;
+    res->fp_calls = (double)t->fp_calls / set->count;
+    res->branches = (double)branches / set->count;
+    res->instructions = (double)instructions / set->count;
+    return 0;
+}
+
+/* ---------------------------------------------------------------------------
+ * 主程序 Main
+ * ------------------------------------------------------------------------- */
+
+static const BenchFunc_t s_funcs[MAX_FUNCS] = {
+    {"PID_Incre_Calc", 1, No_Setup, Host_Incre, Target_Incre},
+    {"PID_Location_Calc", 0, No_Setup, Host_Location, Target_Location},
+    {"PID_Yaw_Calc", 0, No_Setup, Host_Yaw, Target_Yaw},
+    {"PIDQ_Incre_Calc", 1, No_Setup, Host_Incre_Q, Target_Incre_Q},
+    {"PIDQ_Location_Calc", 0, No_Setup, Host_Location_Q, Target_Location_Q},
+    {"PIDQ_Yaw_Calc", 0, No_Setup, Host_Yaw_Q, Target_Yaw_Q},
+    {"Motion_Get_Speed", 1, Set_Encoders, Host_Get_Speed, Target_Get_Speed},
+    {"wheel_Ctrl", 0, No_Setup, Host_Wheel_Ctrl, Target_Wheel_Ctrl},
+    {"Motion_Set_Speed", 0, No_Setup, Host_Set_Speed, Target_Set_Speed},
+    {"get_sensor_status", 0, Set_Pins, Host_Sensor, Target_Sensor},
+    {"car_irtrack", 0, Set_Pins, Host_Irtrack, Target_Sensor},
+    {"car_arc_tracking", 0, Set_Pins, Host_Arc, Target_Arc},
+};
+
+// 在子进程中仿真一次任务并写出输入记录 Simulate one task in a child process and write its input trace
+static int Record_Trace(CarMode_t mode, const char *path)
+{
+    SimTrack_t track;
+    SimRunConfig_t cfg;
+    SimRunResult_t res;
+
+    if (Sim_Track_Load(&track, Sim_Run_Default_Track(mode)) != 0)
+        return -1;
+    Sim_Run_Default_Config(&cfg, mode, &track);
+    cfg.trace_path = path;
+    int ret = Sim_Run_Isolated(&cfg, &res);
+    Sim_Track_Free(&track);
+    return ret;
+}
+
+static int Compare_Cost(const void *a, const void *b)
+{
+    const BenchResult_t *x = *(const BenchResult_t *const *)a, *y = *(const BenchResult_t *const *)b;
+    if (x->linked != y->linked)
+        return y->linked - x->linked;
+    double kx = x->linked ? x->cycles : x->host_ns, ky = y->linked ? y->cycles : y->host_ns;
+    return kx < ky ? 1 : kx > ky ? -1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *axf = HOST_AXF_PATH;
+    const char *trace_path = NULL;
+    int task = MODE_TASK3;
+    int count = 4096;
+    uint32_t seed = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "i:t:n:s:a:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'i':
+            trace_path = optarg;
+            break;
+        case 't':
+            task = atoi(optarg);
+            break;
+        case 'n':
+            count = atoi(optarg);
+            break;
+        case 's':
+            seed = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'a':
+            axf = optarg;
+            break;
+        default:
+            optind = argc + 1;
+            break;
+        }
+    }
+    if (optind != argc || task < MODE_TASK1 || task > MODE_TASK4 || count <= 0 || seed == 0)
+    {
+        fprintf(stderr, "usage: %s [-i trace.trc] [-t task] [-n inputs] [-s seed] [-a car_tracking.axf]\n", argv[0]);
+        return 2;
+    }
+
+    char tmp[] = "/tmp/micro_bench_XXXXXX";
+    if (trace_path == NULL)
+    {
+        int fd = mkstemp(tmp);
+        if (fd < 0 || (close(fd), Record_Trace((CarMode_t)task, tmp)) != 0)
+        {
+            fprintf(stderr, "cannot record a task %d trace\n", task);
+            return 1;
+        }
+    }
+
+    SimTraceFile_t trace;
+    BenchSet_t set;
+    int loaded = Sim_Trace_Load(trace_path != NULL ? trace_path : tmp, &trace);
+    if (trace_path == NULL)
+        unlink(tmp);
+    if (loaded != 0)
+        return 1;
+    if (Bench_Inputs(&set, &trace, count, seed) != 0)
+    {
+        fprintf(stderr, "trace has no main-loop passes or encoder reads\n");
+        return 1;
+    }
+    Sim_Trace_Free(&trace);
+
+    printf("inputs: %d sets from %s (%llu passes, %u interrupts)\n", set.count,
+           trace_path != NULL ? trace_path : "simulated run", (unsigned long long)set.passes, set.samples);
+    printf("sensor states X1..X4 per pass:");
+    for (int s = 0; s < 16; s++)
+        if (set.hist[s] * 1000u >= set.passes)
+            printf(" %d%d%d%d %.1f%%", s >> 3 & 1, s >> 2 & 1, s >> 1 & 1, s & 1, 100.0 * set.hist[s] / set.passes);
+    printf("\n");
+
+    // 主机：与仿真相同的上电顺序 Host: the same power-on sequence as the simulation
+    Shim_Reset();
+    Shim_Clock_Set_Virtual(1);
+    BSP_Init();
+    PID_Set_Motor_Parm(MAX_MOTOR, PID_DEF_KP, PID_DEF_KI, PID_DEF_KD);
+    set_line_speed(LINE_SPEED_DEF);
+    PID_Set_Motor_Target(MAX_MOTOR, LINE_SPEED_DEF);
+    g_start_ctrl = 1;
+    for (int m = 0; m < 2; m++)
+    {
+        s_pid[m].Kp = PID_DEF_KP;
+        s_pid[m].Ki = PID_KI_TICK(PID_DEF_KI);
+        s_pid[m].Kd = PID_KD_TICK(PID_DEF_KD);
+        s_pid[m].target_val = LINE_SPEED_DEF;
+        s_pidq[m].Kp = PIDQ_FROM_FLOAT(PID_DEF_KP);
+        s_pidq[m].Ki = PIDQ_FROM_FLOAT(PID_KI_TICK(PID_DEF_KI));
+        s_pidq[m].Kd = PIDQ_FROM_FLOAT(PID_KD_TICK(PID_DEF_KD));
+        s_pidq[m].target_val = PIDQ_FROM_INT(LINE_SPEED_DEF);
+    }
+    s_yawq.Proportion = PIDQ_FROM_FLOAT(PID_YAW_DEF_KP);
+    s_yawq.Derivative = PIDQ_FROM_FLOAT(PID_YAW_DEF_KD);
+
+    BenchResult_t res[MAX_FUNCS];
+    memset(res, 0, sizeof(res));
+    for (int i = 0; i < MAX_FUNCS; i++)
+        res[i].host_ns = Host_Time(&s_funcs[i], &set);
+
+    // 目标：同一组输入逐次调用映像中的函数 Target: the same inputs, call by call, on the image
+    BenchTarget_t target;
+    int have_target = Target_Init(&target, axf) == 0;
+    if (!have_target)
+        fprintf(stderr, "%s: cannot run the firmware image, host times only\n", axf);
+    else
+    {
+        for (int i = 0; i < MAX_FUNCS; i++)
+            Target_Measure(&target, &s_funcs[i], &set, &res[i]);
+    }
+
+    const BenchResult_t *order[MAX_FUNCS];
+    for (int i = 0; i < MAX_FUNCS; i++)
+        order[i] = &res[i];
+    qsort(order, MAX_FUNCS, sizeof(order[0]), Compare_Cost);
+
+    printf("%-20s %-4s %9s %10s %8s %9s %9s %8s\n", "function", "ctx", "host_ns", "m3_cycles", "m3_us",
+           "softfloat", "branches", "instr");
+    for (int k = 0; k < MAX_FUNCS; k++)
+    {
+        const BenchResult_t *r = order[k];
+        const BenchFunc_t *f = &s_funcs[r - res];
+        if (r->linked)
+            printf("%-20s %-4s %9.1f %10.1f %8.2f %9.2f %9.2f %8.1f\n", f->name, f->isr ? "isr" : "loop", r->host_ns,
+                   r->cycles, r->cycles / SIM_FIL_CYCLES_PER_US, r->fp_calls, r->branches, r->instructions);
+        else
+            printf("%-20s %-4s %9.1f %10s %8s %9s %9s %8s\n", f->name, f->isr ? "isr" : "loop", r->host_ns,
+                   "-", "-", "-", "-", "not in image");
+    }
+
+    if (have_target)
+        Target_Free(&target);
+    free(set.in);
+    return 0;
+}
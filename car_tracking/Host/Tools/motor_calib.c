@@ -0,0 +1,136 @@
+/*
+ * motor_calib.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * 在仿真底盘上运行车上标定(app_calib.c)，打印学到的摩擦前馈和模型的死区，
+ * 再用标定前后的参数各做一次低速阶跃比较。-i 改做系统辨识，另外打印辨识出的增益、
+ * 时间常数、死区与模型真值以及整定出的PID。
+ * Runs the on-car calibration (app_calib.c) on the simulated chassis,
+ * prints the learned friction feedforward next to the model's dead band,
+ * then compares a low-speed step with the parameters before and after. -i
+ * runs the system identification instead and also prints the identified
+ * gain, time constant and dead band against the model, and the tuned PID.
+ *
+ * 用法 Usage: motor_calib [-D profile] [-s step mm/s] [-i]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bsp.h"
+#include "hal_shim.h"
+#include "sim_board.h"
+
+#define CALIB_TIMEOUT_US (60000000u)
+#define STEP_US (2000000u)
+
+// 低速阶跃：各轮|目标-实际|的平均值和PWM换向次数 Low-speed step: mean |target - wheel| and PWM sign changes
+static void Step_Test(SimBoard_t *board, int16_t speed, const char *label)
+{
+    double iae = 0;
+    uint32_t flips = 0, n = 0;
+    float last[SIM_MOTORS] = {0};
+    uint64_t end_us = board->now_us + STEP_US;
+
+    Motion_Set_Speed(speed, speed, speed, speed);
+    while (board->now_us < end_us)
+    {
+        Sim_Board_Pass(board);
+        for (int i = 0; i < SIM_MOTORS; i++)
+        {
+            float d = board->car.duty[i];
+            flips += (d > 0 && last[i] < 0) || (d < 0 && last[i] > 0);
+            if (d != 0)
+                last[i] = d;
+            iae += fabsf(speed - board->car.wheel_mm_s[i]);
+        }
+        n++;
+    }
+    Motion_Stop(STOP_FREE);
+    printf("%-6s step %4d mm/s: mean |error| %6.1f mm/s, PWM reversals %u\n", label, speed,
+           iae / (n * SIM_MOTORS), (unsigned)flips);
+}
+
+int main(int argc, char **argv)
+{
+    const char *profile = "asym";
+    int16_t step = 150;
+    int ident = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "D:s:i")) != -1)
+    {
+        if (opt == 'D')
+            profile = optarg;
+        else if (opt == 's')
+            step = (int16_t)atoi(optarg);
+        else if (opt == 'i')
+            ident = 1;
+        else
+        {
+            fprintf(stderr, "usage: %s [-D profile] [-s step mm/s] [-i]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    SimCarParam_t param;
+    SimBoard_t board;
+    Sim_Car_Default_Param(&param);
+    if (Sim_Car_Apply_Profile(&param, profile) != 0)
+    {
+        fprintf(stderr, "unknown profile '%s'\n", profile);
+        return 2;
+    }
+    Shim_Clock_Set_Virtual(1);
+    Sim_Board_Init(&board, &param);
+
+    Step_Test(&board, step, "before");
+
+    uint64_t start_us = board.now_us;
+    if (ident)
+        Calib_Ident_Start();
+    else
+        Calib_Friction_Start();
+    while (Calib_Is_Running() && board.now_us - start_us < CALIB_TIMEOUT_US)
+        Sim_Board_Pass(&board);
+    if (Calib_Is_Running())
+    {
+        fprintf(stderr, "calibration did not finish\n");
+        return 1;
+    }
+    printf("calibration took %.1f s\n\n", (board.now_us - start_us) / 1e6);
+
+    printf("motor  model dead  slope  static fwd/rev  coulomb fwd/rev  viscous fwd/rev\n");
+    for (uint8_t i = 0; i < MAX_MOTOR; i++)
+    {
+        const Motor_Friction_t *f = Motor_Get_Friction(i);
+        const SimMotorParam_t *m = &param.motor[i];
+        printf("M%u     %10.0f  %5.2f  %6d %6d    %6d %6d     %6.2f %6.2f\n", i + 1, m->dead_pulse,
+               (MOTOR_MAX_PULSE - m->dead_pulse) / m->max_mm_s, f->static_pulse[0], f->static_pulse[1],
+               f->coulomb_pulse[0], f->coulomb_pulse[1], f->viscous_q8[0] / 256.0, f->viscous_q8[1] / 256.0);
+    }
+    printf("\n");
+
+    if (ident)
+    {
+        printf("motor  gain model fwd/rev     tau ms model fwd/rev   dead model fwd/rev     kp     ki      kd\n");
+        for (uint8_t i = 0; i < MAX_MOTOR; i++)
+        {
+            const Calib_Ident_t *r = Calib_Get_Ident(i);
+            const SimMotorParam_t *m = &param.motor[i];
+            printf("M%u     %4.2f  %4.2f %4.2f     %4.0f  %4.0f %4.0f     %4.0f %4d %4d    %5.2f  %5.1f  %6.4f%s\n", i + 1,
+                   m->max_mm_s / (MOTOR_MAX_PULSE - m->dead_pulse), r->gain[0], r->gain[1], m->tau_s * 1e3,
+                   r->tau_s[0] * 1e3, r->tau_s[1] * 1e3, m->dead_pulse, r->dead_pulse[0], r->dead_pulse[1], r->kp,
+                   r->ki, r->kd, r->valid == 3 ? "" : "  (incomplete)");
+        }
+        printf("\n");
+    }
+
+    Step_Test(&board, step, "after");
+    return 0;
+}
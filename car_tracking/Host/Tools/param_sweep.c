@@ -0,0 +1,353 @@
+/*
+ * param_sweep.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * 参数扫描：在网格或随机采样上扫描PID_DEF_KP/KI/KD、set_line_speed的
+ * 巡线速度和car_arc_tracking的弯曲半径，每组参数运行所选任务，
+ * 按完成率和总用时排序输出。各次仿真在子进程中并行运行。
+ * Parameter sweep: scans PID_DEF_KP/KI/KD, the set_line_speed line speed and
+ * the car_arc_tracking turn radius over a grid or random samples, runs the
+ * selected tasks for each set and prints a table ranked by completion rate
+ * and total time. Simulations run in parallel child processes.
+ *
+ * 范围写作"值"或"下限:上限:点数"，随机采样时点数被忽略。
+ * A range is "value" or "lo:hi:points"; points is ignored when sampling.
+ *
+ * -D在非理想条件下扫描，见Sim_Car_Apply_Profile。
+ * -D sweeps under imperfect conditions, see Sim_Car_Apply_Profile.
+ *
+ * 用法 Usage: param_sweep [-t tasks] [-p kp] [-i ki] [-d kd] [-v speed]
+ *                         [-a radius] [-n samples] [-s seed] [-j jobs]
+ *                         [-k top] [-D profile] [-c]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sim_run.h"
+
+#define AXES (5)
+#define MAX_TASKS (4)
+#define BATCH_CONFIGS (64) // 每批参数组数，批间打印进度 Sets per batch; progress is printed between batches
+
+typedef enum
+{
+    AXIS_KP = 0,
+    AXIS_KI,
+    AXIS_KD,
+    AXIS_SPEED,
+    AXIS_RADIUS
+} Axis_t;
+
+typedef struct
+{
+    const char *name;
+    double lo, hi;
+    int points;
+    uint8_t integer;
+} Range_t;
+
+// 一组参数及其在各任务上的结果 One parameter set and its results across tasks
+typedef struct
+{
+    SimRunTune_t tune;
+    int runs;
+    int done;       // 完成且满足时间要求 Completed within the time limit
+    int clean;      // 完成且无误判漏判 Done with no false positives or misses
+    double total_s; // 各任务用时之和，未完成按超时计 Sum over tasks, timeouts count in full
+    double xte_rms_mm;
+    double task_s[MAX_TASKS];
+} Entry_t;
+
+static int Parse_Range(Range_t *r, const char *text)
+{
+    char *end;
+    r->lo = strtod(text, &end);
+    r->hi = r->lo;
+    r->points = 1;
+    if (*end == ':')
+    {
+        r->hi = strtod(end + 1, &end);
+        r->points = 2;
+        if (*end == ':')
+            r->points = (int)strtol(end + 1, &end, 10);
+    }
+    if (*end != '\0' || r->points < 1 || r->hi < r->lo)
+    {
+        fprintf(stderr, "bad range for %s: %s\n", r->name, text);
+        return -1;
+    }
+    return 0;
+}
+
+static double Range_Grid(const Range_t *r, int k)
+{
+    double v = r->points > 1 ? r->lo + (r->hi - r->lo) * k / (r->points - 1) : r->lo;
+    return r->integer ? (double)(long)(v + 0.5) : v;
+}
+
+static double Range_Sample(const Range_t *r)
+{
+    double v = r->lo + (r->hi - r->lo) * (rand() / (double)RAND_MAX);
+    return r->integer ? (double)(long)(v + 0.5) : v;
+}
+
+static void Set_Tune(SimRunTune_t *tune, const double *v)
+{
+    tune->kp = (float)v[AXIS_KP];
+    tune->ki = (float)v[AXIS_KI];
+    tune->kd = (float)v[AXIS_KD];
+    tune->line_speed = (int16_t)v[AXIS_SPEED];
+    tune->arc_radius = (uint8_t)v[AXIS_RADIUS];
+}
+
+// 排序：无误完成率、完成率降序，总用时、横向偏差升序
+// Order by clean rate and done rate descending, then total time and cross-track error ascending
+static int Entry_Compare(const void *a, const void *b)
+{
+    const Entry_t *x = a, *y = b;
+    if (x->clean != y->clean)
+        return y->clean - x->clean;
+    if (x->done != y->done)
+        return y->done - x->done;
+    if (x->total_s != y->total_s)
+        return x->total_s < y->total_s ? -1 : 1;
+    if (x->xte_rms_mm != y->xte_rms_mm)
+        return x->xte_rms_mm < y->xte_rms_mm ? -1 : 1;
+    return 0;
+}
+
+static void Score(Entry_t *e, int slot, CarMode_t mode, const SimRunResult_t *res, int ok)
+{
+    e->runs++;
+    if (!ok)
+    {
+        e->task_s[slot] = -1.0;
+        return;
+    }
+    uint32_t limit_ms = Sim_Run_Time_Limit(mode);
+    int done = res->completed && (!limit_ms || res->total_ms <= limit_ms);
+    e->done += done;
+    e->clean += done && res->false_positives == 0 && res->misses == 0;
+    e->total_s += res->total_ms / 1000.0;
+    e->xte_rms_mm += res->xte_rms_mm;
+    e->task_s[slot] = res->completed ? res->total_ms / 1000.0 : -1.0;
+}
+
+int main(int argc, char **argv)
+{
+    Range_t range[AXES] = {
+        {"kp", PID_DEF_KP, PID_DEF_KP, 1, 0},
+        {"ki", PID_DEF_KI, PID_DEF_KI, 1, 0},
+        {"kd", PID_DEF_KD, PID_DEF_KD, 1, 0},
+        {"speed", LINE_SPEED_DEF, LINE_SPEED_DEF, 1, 1},
+        {"radius", ARC_TURN_RADIUS_DEF, ARC_TURN_RADIUS_DEF, 1, 1},
+    };
+    const char *tasks = "1234", *profile = NULL;
+    int samples = 0, jobs = 0, top = 20, csv = 0;
+    unsigned seed = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:p:i:d:v:a:n:s:j:k:D:c")) != -1)
+    {
+        int axis = -1;
+        switch (opt)
+        {
+        case 't':
+            tasks = optarg;
+            break;
+        case 'p':
+            axis = AXIS_KP;
+            break;
+        case 'i':
+            axis = AXIS_KI;
+            break;
+        case 'd':
+            axis = AXIS_KD;
+            break;
+        case 'v':
+            axis = AXIS_SPEED;
+            break;
+        case 'a':
+            axis = AXIS_RADIUS;
+            break;
+        case 'n':
+            samples = atoi(optarg);
+            break;
+        case 's':
+            seed = (unsigned)strtoul(optarg, NULL, 10);
+            break;
+        case 'j':
+            jobs = atoi(optarg);
+            break;
+        case 'k':
+            top = atoi(optarg);
+            break;
+        case 'D':
+            profile = optarg;
+            break;
+        case 'c':
+            csv = 1;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-t tasks] [-p kp] [-i ki] [-d kd] [-v speed] [-a radius]\n"
+                            "       [-n samples] [-s seed] [-j jobs] [-k top] [-D profile] [-c]\n"
+                            "range: value or lo:hi:points, e.g. -p 0.4:1.2:5\n",
+                    argv[0]);
+            return 2;
+        }
+        if (axis >= 0 && Parse_Range(&range[axis], optarg) != 0)
+            return 2;
+    }
+
+    SimCarParam_t car;
+    Sim_Car_Default_Param(&car);
+    if (profile != NULL && Sim_Car_Apply_Profile(&car, profile) != 0)
+    {
+        fprintf(stderr, "unknown profile in '%s'\n", profile);
+        return 2;
+    }
+
+    // 加载所选任务的赛道，子进程继承 Load the tracks once; children inherit them
+    static SimTrack_t track[MAX_TASKS];
+    CarMode_t mode[MAX_TASKS];
+    int task_count = 0;
+    for (const char *c = tasks; *c && task_count < MAX_TASKS; c++)
+    {
+        if (*c < '1' || *c > '4')
+        {
+            fprintf(stderr, "bad task: %c\n", *c);
+            return 2;
+        }
+        mode[task_count] = (CarMode_t)(*c - '0');
+        if (Sim_Track_Load(&track[task_count], Sim_Run_Default_Track(mode[task_count])) != 0)
+            return 1;
+        task_count++;
+    }
+
+    int count = 1;
+    if (samples > 0)
+        count = samples;
+    else
+        for (int a = 0; a < AXES; a++)
+            count *= range[a].points;
+
+    Entry_t *entry = calloc((size_t)count, sizeof(Entry_t));
+    if (entry == NULL)
+        return 1;
+    srand(seed);
+    for (int n = 0; n < count; n++)
+    {
+        double v[AXES];
+        int k = n;
+        for (int a = 0; a < AXES; a++)
+        {
+            if (samples > 0)
+            {
+                v[a] = Range_Sample(&range[a]);
+            }
+            else
+            {
+                v[a] = Range_Grid(&range[a], k % range[a].points);
+                k /= range[a].points;
+            }
+        }
+        Set_Tune(&entry[n].tune, v);
+    }
+
+    if (jobs <= 0)
+        jobs = Sim_Run_Jobs();
+    fprintf(stderr, "%d parameter sets x %d tasks, %d jobs\n", count, task_count, jobs);
+
+    static SimRunConfig_t cfg[BATCH_CONFIGS * MAX_TASKS];
+    static SimRunResult_t res[BATCH_CONFIGS * MAX_TASKS];
+    static int ok[BATCH_CONFIGS * MAX_TASKS];
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    for (int first = 0; first < count; first += BATCH_CONFIGS)
+    {
+        int batch = count - first < BATCH_CONFIGS ? count - first : BATCH_CONFIGS;
+        int runs = 0;
+        for (int n = 0; n < batch; n++)
+        {
+            for (int t = 0; t < task_count; t++)
+            {
+                Sim_Run_Default_Config(&cfg[runs], mode[t], &track[t]);
+                cfg[runs].car = car;
+                cfg[runs].tune = entry[first + n].tune;
+                runs++;
+            }
+        }
+
+        Sim_Run_Parallel(cfg, res, ok, runs, jobs);
+
+        for (int r = 0; r < runs; r++)
+        {
+            int t = r % task_count;
+            Score(&entry[first + r / task_count], t, mode[t], &res[r], ok[r]);
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        double elapsed = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+        fprintf(stderr, "\r%d/%d sets, %.1f s", first + batch, count, elapsed);
+    }
+    fprintf(stderr, "\n");
+
+    for (int n = 0; n < count; n++)
+        entry[n].xte_rms_mm /= entry[n].runs;
+    qsort(entry, (size_t)count, sizeof(Entry_t), Entry_Compare);
+
+    if (csv)
+    {
+        printf("rank,kp,ki,kd,speed,radius,clean,done,runs,total_s,xte_rms_mm");
+        for (int t = 0; t < task_count; t++)
+            printf(",task%d_s", mode[t]);
+        printf("\n");
+    }
+    else
+    {
+        printf("rank     kp     ki     kd  speed  radius  clean  done  total_s  xte_rms");
+        for (int t = 0; t < task_count; t++)
+            printf("  task%d_s", mode[t]);
+        printf("\n");
+    }
+
+    int shown = csv || top <= 0 || top > count ? count : top;
+    for (int n = 0; n < shown; n++)
+    {
+        const Entry_t *e = &entry[n];
+        if (csv)
+        {
+            printf("%d,%.4f,%.4f,%.6f,%d,%d,%d,%d,%d,%.3f,%.2f", n + 1,
+                   e->tune.kp, e->tune.ki, e->tune.kd, e->tune.line_speed, e->tune.arc_radius,
+                   e->clean, e->done, e->runs, e->total_s, e->xte_rms_mm);
+            for (int t = 0; t < task_count; t++)
+                printf(",%.3f", e->task_s[t]);
+        }
+        else
+        {
+            printf("%4d %6.3f %6.2f %6.4f  %5d  %6d  %2d/%-2d %2d/%-2d %8.2f  %7.1f", n + 1,
+                   e->tune.kp, e->tune.ki, e->tune.kd, e->tune.line_speed, e->tune.arc_radius,
+                   e->clean, e->runs, e->done, e->runs, e->total_s, e->xte_rms_mm);
+            for (int t = 0; t < task_count; t++)
+            {
+                if (e->task_s[t] < 0)
+                    printf("  %7s", "-");
+                else
+                    printf("  %7.2f", e->task_s[t]);
+            }
+        }
+        printf("\n");
+    }
+
+    for (int t = 0; t < task_count; t++)
+        Sim_Track_Free(&track[t]);
+    free(entry);
+    return 0;
+}
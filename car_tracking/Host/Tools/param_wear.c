@@ -0,0 +1,144 @@
+/*
+ * param_wear.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * Flash参数区(bsp_param.c)的耐久和掉电测试：反复改参数、保存、重新上电，
+ * 按概率在保存中途模拟掉电，检查每次上电恢复的都是最后一次完整保存的值，
+ * 最后报告各页擦除次数和Param_Init的主机耗时。
+ * Endurance and power-loss test of the flash parameter store
+ * (bsp_param.c): change parameters, save and power up again, over and over,
+ * cutting the power part-way through a save at random. Checks that every
+ * power-up restores the last complete save, then reports the erase count of
+ * each page and the host time of Param_Init.
+ *
+ * 用法 Usage: param_wear [-n saves] [-c cut %] [-s seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bsp.h"
+#include "hal_shim.h"
+
+// 一次保存的Flash操作数上限：一次擦页加逐个半字编程 Flash operations in one save at most: a page erase plus every halfword
+#define SAVE_OPS (1 + ((int)sizeof(Param_Data_t) + 12) / 2)
+
+static uint64_t Now_Ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// 重新上电：RAM中的参数回到编译时的值，再由BSP_Init读参数区
+// Power up again: parameters in RAM return to their compiled-in values, then BSP_Init reads the store
+static uint64_t Power_Up(void)
+{
+    AppTune_t tune = APP_TUNE_DEFAULT;
+    g_app_tune = tune;
+    APP_Set_Arc_Radius(ARC_TURN_RADIUS_DEF);
+    Shim_Reset();
+    uint64_t t0 = Now_Ns();
+    BSP_Init();
+    return Now_Ns() - t0;
+}
+
+int main(int argc, char **argv)
+{
+    int saves = 2000, cut_pct = 10;
+    unsigned seed = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:c:s:")) != -1)
+    {
+        if (opt == 'n')
+            saves = atoi(optarg);
+        else if (opt == 'c')
+            cut_pct = atoi(optarg);
+        else if (opt == 's')
+            seed = (unsigned)atoi(optarg);
+        else
+        {
+            fprintf(stderr, "usage: %s [-n saves] [-c cut %%] [-s seed]\n", argv[0]);
+            return 2;
+        }
+    }
+    srand(seed);
+    Shim_Clock_Set_Virtual(1);
+    Shim_Flash_Blank();
+
+    // 期望值：最后一次完整保存的，开始时为空参数区下的默认值
+    // Expected: the last complete save, at first the defaults read with an empty store
+    float kp, ki, kd;
+    Power_Up();
+    PID_Get_Motor_Parm(0, &kp, &ki, &kd);
+    if (Param_Get_Seq() != 0 || g_line_speed != LINE_SPEED_DEF)
+    {
+        printf("empty store did not give the defaults\n");
+        return 1;
+    }
+    int16_t want_speed = g_line_speed;
+    uint16_t want_arc_ms = g_app_tune.arc_min_ms;
+    float want_kp = kp;
+    int cuts = 0, failures = 0;
+    uint64_t init_ns = 0, init_max = 0;
+
+    for (int i = 0; i <= saves; i++)
+    {
+        uint64_t ns = Power_Up();
+        init_ns += ns;
+        init_max = ns > init_max ? ns : init_max;
+
+        PID_Get_Motor_Parm(0, &kp, &ki, &kd);
+        if (g_line_speed != want_speed || g_app_tune.arc_min_ms != want_arc_ms || kp != want_kp)
+        {
+            if (failures++ < 10)
+                printf("power-up %d: line speed %d arc_min_ms %u kp %.4f, expected %d %u %.4f\n", i, g_line_speed,
+                       g_app_tune.arc_min_ms, kp, want_speed, want_arc_ms, want_kp);
+            want_speed = g_line_speed;
+            want_arc_ms = g_app_tune.arc_min_ms;
+            want_kp = kp;
+        }
+        if (i == saves)
+            break;
+
+        int16_t speed = (int16_t)(300 + (i * 37) % 700);
+        uint16_t arc_ms = (uint16_t)(1000 + i % 3000);
+        set_line_speed(speed);
+        g_app_tune.arc_min_ms = arc_ms;
+        PID_Set_Motor_Parm(0, 0.5f + (i % 100) * 0.01f, ki, kd);
+        PID_Get_Motor_Parm(0, &kp, &ki, &kd);
+
+        int cut = rand() % 100 < cut_pct;
+        if (cut)
+        {
+            Shim_Flash_Cut_After(rand() % SAVE_OPS);
+            cuts++;
+        }
+        HAL_StatusTypeDef ret = Param_Save();
+        Shim_Flash_Cut_After(-1);
+        if (ret == HAL_OK)
+        {
+            want_speed = speed;
+            want_arc_ms = arc_ms;
+            want_kp = kp;
+        }
+    }
+
+    printf("%d saves, %d power cuts during a save, %d wrong power-ups, last record #%u\n", saves, cuts, failures,
+           (unsigned)Param_Get_Seq());
+    printf("record %u bytes, %u per %u-byte page, %d pages\n", (unsigned)(sizeof(Param_Data_t) + 12),
+           (unsigned)(FLASH_PAGE_SIZE / (sizeof(Param_Data_t) + 12)), FLASH_PAGE_SIZE, PARAM_PAGES);
+    printf("page erases:");
+    for (int p = 0; p < PARAM_PAGES; p++)
+    {
+        printf(" %u", (unsigned)Shim_Flash_Erase_Count(PARAM_ADDR + p * FLASH_PAGE_SIZE));
+    }
+    printf("\nBSP_Init with the store: mean %.1f us, max %.1f us (host)\n", init_ns / 1e3 / (saves + 1),
+           init_max / 1e3);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,537 @@
+/*
+ * perf_db.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * 性能记录：每次构建测一次并在结果文件末尾追加一行，内容为各任务的
+ * 仿真用时、Keil映像上TIM6中断的最坏和平均周期(fw_cycles的同一套仿真)，
+ * 以及map文件中的text/data/bss大小；随后与上一条(或-b指定的)记录
+ * 比较，超过阈值的变差标为REGRESSION并以3退出，可直接用作门禁。
+ * Performance record: measures once per build and appends one line to the
+ * results file, holding the simulated time of each task, the worst-case and
+ * mean TIM6 interrupt cycles of the Keil image (the same emulation as
+ * fw_cycles) and the text/data/bss sizes from the map file. The record is
+ * then compared with the previous one (or the one named by -b); changes for
+ * the worse beyond the threshold are flagged REGRESSION and the exit code is
+ * 3, so it can gate a change directly.
+ *
+ * 每条记录一行，字段为key=value，新增字段不影响读取旧文件。
+ * One record per line of key=value fields, so new fields do not break old files.
+ *
+ * 中断周期和大小来自映像而非当前源码，记录中另存映像的FNV-1a散列，映像落后于
+ * BSP/Core源码时标为image_stale=1，比较时两者都会列出，旧映像的数字不会记到新提交上。
+ * Interrupt cycles and sizes come from the image, not from the current
+ * sources, so each record also holds the image's FNV-1a hash and marks an
+ * image older than the BSP/Core sources with image_stale=1. Both are shown in
+ * comparisons, so an old image's numbers are not pinned on a new commit.
+ *
+ * -r只比较文件中已有的最后两条(或-b与最后一条)，不测量。-n测量并比较但不写入。
+ * -r only compares the last two records in the file (or -b with the last)
+ * without measuring. -n measures and compares without appending.
+ *
+ * 用法 Usage: perf_db [-f results.txt] [-a car_tracking.axf] [-m car_tracking.map]
+ *                     [-l label] [-b baseline_label] [-p percent] [-t isr_task]
+ *                     [-r] [-n]
+ */
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sim_fil.h"
+#include "sim_run.h"
+
+#define TASKS (4)
+#define LINE_LEN (512)
+
+typedef struct
+{
+    char label[64];
+    char date[24];
+    double lap_s[TASKS];   // 任务开始到完成或超时 Task start to completion or timeout
+    int done[TASKS];
+    double isr_mean;       // TIM6中断，含进出栈 TIM6 interrupt, stacking included
+    uint32_t isr_max;
+    uint32_t text;         // Code + RO Data
+    uint32_t data;         // RW Data
+    uint32_t bss;          // ZI Data
+    char image[12];        // 映像文件的FNV-1a散列，十六进制 FNV-1a hash of the image file, hex
+    int image_stale;       // 映像落后于固件源码 The image is older than the firmware sources
+} PerfRecord_t;
+
+/* ---------------------------------------------------------------------------
+ * 测量 Measurement
+ * ------------------------------------------------------------------------- */
+
+static int Measure_Laps(PerfRecord_t *rec)
+{
+    SimTrack_t track[TASKS];
+    SimRunConfig_t cfg[TASKS];
+    SimRunResult_t res[TASKS];
+    int ok[TASKS];
+
+    for (int t = 0; t < TASKS; t++)
+    {
+        CarMode_t mode = (CarMode_t)(MODE_TASK1 + t);
+        if (Sim_Track_Load(&track[t], Sim_Run_Default_Track(mode)) != 0)
+        {
+            while (t-- > 0)
+                Sim_Track_Free(&track[t]);
+            return -1;
+        }
+        Sim_Run_Default_Config(&cfg[t], mode, &track[t]);
+    }
+    int failed = Sim_Run_Parallel(cfg, res, ok, TASKS, 0);
+    for (int t = 0; t < TASKS; t++)
+    {
+        rec->lap_s[t] = ok[t] ? res[t].total_ms / 1000.0 : 0.0;
+        rec->done[t] = ok[t] && res[t].completed;
+        Sim_Track_Free(&track[t]);
+    }
+    return failed ? -1 : 0;
+}
+
+// 在Keil映像上跑完一个任务，统计TIM6中断 Run one task on the Keil image and collect the TIM6 interrupt
+static int Measure_Isr(PerfRecord_t *rec, const char *axf, CarMode_t mode)
+{
+    SimRunConfig_t cfg;
+    SimTrack_t track;
+    SimFil_t fil;
+
+    Sim_Run_Default_Config(&cfg, mode, NULL);
+    if (Sim_Track_Load(&track, Sim_Run_Default_Track(mode)) != 0)
+        return -1;
+    if (Sim_Fil_Init(&fil, axf, &cfg.car) != 0)
+    {
+        fprintf(stderr, "%s: cannot load firmware image\n", axf);
+        Sim_Track_Free(&track);
+        return -1;
+    }
+    Sim_Board_Set_Track(&fil.board, &track);
+    int tim6 = Sim_Fil_Probe_Irq(&fil, SIM_FIL_TIM6_IRQ, "TIM6_IRQHandler");
+
+    int ret = 0;
+    uint64_t end_us = SIM_FIL_PRESS_US + (uint64_t)cfg.timeout_ms * 1000u;
+    uint32_t completed = 0;
+    while (!completed && Sim_Fil_Us(&fil) < end_us)
+    {
+        Sim_Fil_Task_Key(&fil, mode);
+        if (Sim_Fil_Run_Us(&fil, 1000) != 0 || Sim_Fil_Read_Var(&fil, "task_completed", &completed) != 0)
+        {
+            fprintf(stderr, "%s: firmware stopped: %s\n", axf, fil.cpu->error);
+            ret = -1;
+            break;
+        }
+    }
+
+    const SimFilProbe_t *p = &fil.probe[tim6];
+    rec->isr_mean = p->calls ? (double)p->total / p->calls : 0.0;
+    rec->isr_max = p->max;
+    Sim_Fil_Free(&fil);
+    Sim_Track_Free(&track);
+    return ret;
+}
+
+/**
+ * @brief  从Keil map文件的Grand Totals行读出映像大小
+ *         Read the image sizes from the Grand Totals line of a Keil map file
+ * @retval 0成功，-1文件不存在或格式不符 0 on success, -1 if missing or unrecognised
+ */
+static int Map_Sizes(PerfRecord_t *rec, const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (f == NULL)
+        return -1;
+
+    // Code (inc. data)   RO Data    RW Data    ZI Data      Debug
+    char line[LINE_LEN];
+    int ret = -1;
+    while (fgets(line, sizeof(line), f) != NULL)
+    {
+        unsigned code, inc, ro, rw, zi, debug;
+        if (strstr(line, "Grand Totals") != NULL &&
+            sscanf(line, "%u %u %u %u %u %u", &code, &inc, &ro, &rw, &zi, &debug) == 6)
+        {
+            rec->text = code + ro;
+            rec->data = rw;
+            rec->bss = zi;
+            ret = 0;
+        }
+    }
+    fclose(f);
+    return ret;
+}
+
+// 在固件目录下运行git，取输出的第一行 Run git in the firmware directory and take the first line of its output
+static int Git_Line(const char *args, char *buf, size_t size)
+{
+    char cmd[LINE_LEN];
+    snprintf(cmd, sizeof(cmd), "git -C \"" HOST_FW_DIR "\" %s 2>/dev/null", args);
+    FILE *p = popen(cmd, "r");
+    if (p == NULL)
+        return -1;
+    int ret = -1;
+    if (fgets(buf, (int)size, p) != NULL && buf[0] != '\0' && buf[0] != '\n')
+    {
+        buf[strcspn(buf, "\r\n")] = '\0';
+        ret = 0;
+    }
+    pclose(p);
+    return ret;
+}
+
+// 默认标签为git describe，工作区有改动时带-dirty Default label is git describe, with -dirty for local changes
+static void Default_Label(char *label, size_t size)
+{
+    char buf[64];
+    if (Git_Line("describe --always --dirty", buf, sizeof(buf)) == 0)
+        snprintf(label, size, "%s", buf);
+    else
+        snprintf(label, size, "unknown");
+}
+
+// 映像文件的FNV-1a散列 FNV-1a hash of the image file
+static int Image_Hash(PerfRecord_t *rec, const char *axf)
+{
+    FILE *f = fopen(axf, "rb");
+    if (f == NULL)
+        return -1;
+    uint32_t h = 2166136261u;
+    int c;
+    while ((c = fgetc(f)) != EOF)
+        h = (h ^ (uint32_t)c) * 16777619u;
+    fclose(f);
+    snprintf(rec->image, sizeof(rec->image), "%08x", h);
+    return 0;
+}
+
+// 目录下最新文件的修改时间，含子目录 Modification time of the newest file under a directory, recursively
+static time_t Newest_Mtime(const char *dir)
+{
+    time_t newest = 0;
+    DIR *d = opendir(dir);
+    if (d == NULL)
+        return 0;
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL)
+    {
+        char path[LINE_LEN];
+        struct stat st;
+        if (e->d_name[0] == '.')
+            continue;
+        snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+        if (lstat(path, &st) != 0)
+            continue;
+        time_t t = S_ISDIR(st.st_mode) ? Newest_Mtime(path) : S_ISREG(st.st_mode) ? st.st_mtime : 0;
+        if (t > newest)
+            newest = t;
+    }
+    closedir(d);
+    return newest;
+}
+
+/**
+ * @brief  映像是否落后于固件源码(BSP、Core)
+ *         Whether the image is older than the firmware sources (BSP, Core)
+ * @note   本地重新编译过的映像(相对git有改动或不在git中)按修改时间比较；未改动的映像
+ *         按最后一次提交的时间比较，源码另有未提交的改动时也算落后
+ *         A locally rebuilt image (changed against git, or not in git) is
+ *         compared by modification time. An unchanged one is compared by the
+ *         time of its last commit, and uncommitted source changes also make
+ *         it stale
+ * @retval 1落后，0不落后或无法判断 1 if stale, 0 if current or unknown
+ */
+static int Image_Stale(const char *axf)
+{
+    char cmd[LINE_LEN], buf[64], image_ct[64];
+
+    snprintf(cmd, sizeof(cmd), "status --porcelain -- \"%s\"", axf);
+    int changed = Git_Line(cmd, buf, sizeof(buf)) == 0;
+    snprintf(cmd, sizeof(cmd), "log -1 --format=%%ct -- \"%s\"", axf);
+    if (changed || Git_Line(cmd, image_ct, sizeof(image_ct)) != 0)
+    {
+        struct stat st;
+        if (stat(axf, &st) != 0)
+            return 0;
+        time_t bsp = Newest_Mtime(HOST_FW_DIR "/BSP");
+        time_t core = Newest_Mtime(HOST_FW_DIR "/Core");
+        return (bsp > core ? bsp : core) > st.st_mtime;
+    }
+    if (Git_Line("status --porcelain -- BSP Core", buf, sizeof(buf)) == 0)
+        return 1;
+    if (Git_Line("log -1 --format=%ct -- BSP Core", buf, sizeof(buf)) != 0)
+        return 0;
+    return atol(buf) > atol(image_ct);
+}
+
+/* ---------------------------------------------------------------------------
+ * 结果文件 Results file
+ * ------------------------------------------------------------------------- */
+
+static void Record_Write(FILE *f, const PerfRecord_t *rec)
+{
+    fprintf(f, "label=%s date=%s", rec->label, rec->date);
+    for (int t = 0; t < TASKS; t++)
+        fprintf(f, " task%d=%.3f done%d=%d", t + 1, rec->lap_s[t], t + 1, rec->done[t]);
+    fprintf(f, " isr_mean=%.1f isr_max=%u text=%u data=%u bss=%u image=%s image_stale=%d\n",
+            rec->isr_mean, rec->isr_max, rec->text, rec->data, rec->bss, rec->image, rec->image_stale);
+}
+
+static int Record_Parse(char *line, PerfRecord_t *rec)
+{
+    memset(rec, 0, sizeof(*rec));
+    int fields = 0;
+    for (char *tok = strtok(line, " \t\r\n"); tok != NULL; tok = strtok(NULL, " \t\r\n"))
+    {
+        char *eq = strchr(tok, '=');
+        if (eq == NULL)
+            continue;
+        *eq = '\0';
+        const char *key = tok, *val = eq + 1;
+        int t;
+        fields++;
+
+        if (strcmp(key, "label") == 0)
+            snprintf(rec->label, sizeof(rec->label), "%s", val);
+        else if (strcmp(key, "date") == 0)
+            snprintf(rec->date, sizeof(rec->date), "%s", val);
+        else if (sscanf(key, "task%d", &t) == 1 && t >= 1 && t <= TASKS)
+            rec->lap_s[t - 1] = atof(val);
+        else if (sscanf(key, "done%d", &t) == 1 && t >= 1 && t <= TASKS)
+            rec->done[t - 1] = atoi(val);
+        else if (strcmp(key, "isr_mean") == 0)
+            rec->isr_mean = atof(val);
+        else if (strcmp(key, "isr_max") == 0)
+            rec->isr_max = (uint32_t)strtoul(val, NULL, 10);
+        else if (strcmp(key, "text") == 0)
+            rec->text = (uint32_t)strtoul(val, NULL, 10);
+        else if (strcmp(key, "data") == 0)
+            rec->data = (uint32_t)strtoul(val, NULL, 10);
+        else if (strcmp(key, "bss") == 0)
+            rec->bss = (uint32_t)strtoul(val, NULL, 10);
+        else if (strcmp(key, "image") == 0)
+            snprintf(rec->image, sizeof(rec->image), "%s", val);
+        else if (strcmp(key, "image_stale") == 0)
+            rec->image_stale = atoi(val);
+        else
+            fields--; // 未知字段来自新版本，忽略 Unknown fields come from newer versions
+    }
+    return fields > 0 ? 0 : -1;
+}
+
+/**
+ * @brief  读出结果文件中的基准记录和最后一条记录
+ * @param  baseline: 基准标签，NULL为倒数第二条 Baseline label, NULL for the second to last
+ * @param  base/last: 找不到时对应的found为0 The matching found flag is 0 when absent
+ * @retval 记录总数，文件不存在为0 Total records, 0 when the file does not exist
+ */
+static int Db_Load(const char *path, const char *baseline, PerfRecord_t *base, int *base_found,
+                   PerfRecord_t *last, int *last_found)
+{
+    *base_found = *last_found = 0;
+    FILE *f = fopen(path, "r");
+    if (f == NULL)
+        return 0;
+
+    char line[LINE_LEN];
+    PerfRecord_t rec, prev;
+    int count = 0;
+    while (fgets(line, sizeof(line), f) != NULL)
+    {
+        if (line[0] == '#' || Record_Parse(line, &rec) != 0)
+            continue;
+        if (baseline != NULL && strcmp(rec.label, baseline) == 0)
+        {
+            *base = rec;
+            *base_found = 1;
+        }
+        if (count > 0)
+            prev = *last;
+        *last = rec;
+        count++;
+    }
+    fclose(f);
+
+    *last_found = count > 0;
+    if (baseline == NULL && count > 1)
+    {
+        *base = prev;
+        *base_found = 1;
+    }
+    return count;
+}
+
+static int Db_Append(const char *path, const PerfRecord_t *rec)
+{
+    FILE *f = fopen(path, "a");
+    if (f == NULL)
+    {
+        perror(path);
+        return -1;
+    }
+    Record_Write(f, rec);
+    fclose(f);
+    return 0;
+}
+
+/* ---------------------------------------------------------------------------
+ * 比较 Comparison
+ * ------------------------------------------------------------------------- */
+
+// 所有指标都是越小越好，基准为0时不比较 Every metric is lower-is-better; a zero baseline is not compared
+static int Compare_Row(const char *name, double base, double cur, double pct)
+{
+    double delta = base != 0.0 ? 100.0 * (cur - base) / base : 0.0;
+    int bad = base != 0.0 && delta > pct;
+    printf("%-12s %12.3f %12.3f %+8.2f %%%s\n", name, base, cur, delta, bad ? "  REGRESSION" : "");
+    return bad;
+}
+
+static int Compare(const PerfRecord_t *base, const PerfRecord_t *cur, double pct)
+{
+    int bad = 0;
+    printf("%s (%s) -> %s (%s), threshold %.1f %%\n", base->label, base->date, cur->label, cur->date, pct);
+    // 旧记录没有散列字段 Older records have no hash field
+    printf("image %s%s -> %s%s\n", base->image[0] ? base->image : "?", base->image_stale ? " (stale)" : "",
+           cur->image[0] ? cur->image : "?", cur->image_stale ? " (stale)" : "");
+    if (cur->image[0] && strcmp(base->image, cur->image) == 0)
+        printf("same image: isr and size rows do not measure the change between these records\n");
+    printf("%-12s %12s %12s %9s\n", "metric", "baseline", "current", "change");
+    for (int t = 0; t < TASKS; t++)
+    {
+        char name[16];
+        snprintf(name, sizeof(name), "task%d_s", t + 1);
+        bad += Compare_Row(name, base->lap_s[t], cur->lap_s[t], pct);
+        if (base->done[t] && !cur->done[t])
+        {
+            printf("%-12s %12s %12s %9s  REGRESSION\n", "", "done", "timeout", "");
+            bad++;
+        }
+    }
+    bad += Compare_Row("isr_mean", base->isr_mean, cur->isr_mean, pct);
+    bad += Compare_Row("isr_max", base->isr_max, cur->isr_max, pct);
+    bad += Compare_Row("text", base->text, cur->text, pct);
+    bad += Compare_Row("data", base->data, cur->data, pct);
+    bad += Compare_Row("bss", base->bss, cur->bss, pct);
+    printf("%d regression%s\n", bad, bad == 1 ? "" : "s");
+    return bad;
+}
+
+int main(int argc, char **argv)
+{
+    const char *db = "perf_db.txt";
+    const char *axf = HOST_AXF_PATH;
+    const char *map = HOST_MAP_PATH;
+    const char *label = NULL;
+    const char *baseline = NULL;
+    double pct = 5.0;
+    int isr_task = MODE_TASK2; // 仓库中的映像上任务3/4不能完成 Tasks 3/4 do not complete on the checked-in image
+    int report_only = 0, dry = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "f:a:m:l:b:p:t:rn")) != -1)
+    {
+        switch (opt)
+        {
+        case 'f':
+            db = optarg;
+            break;
+        case 'a':
+            axf = optarg;
+            break;
+        case 'm':
+            map = optarg;
+            break;
+        case 'l':
+            label = optarg;
+            break;
+        case 'b':
+            baseline = optarg;
+            break;
+        case 'p':
+            pct = atof(optarg);
+            break;
+        case 't':
+            isr_task = atoi(optarg);
+            break;
+        case 'r':
+            report_only = 1;
+            break;
+        case 'n':
+            dry = 1;
+            break;
+        default:
+            optind = argc + 1;
+            break;
+        }
+    }
+    if (optind != argc || isr_task < MODE_TASK1 || isr_task > MODE_TASK4)
+    {
+        fprintf(stderr, "usage: %s [-f results.txt] [-a car_tracking.axf] [-m car_tracking.map]\n"
+                        "       [-l label] [-b baseline_label] [-p percent] [-t isr_task] [-r] [-n]\n",
+                argv[0]);
+        return 2;
+    }
+
+    PerfRecord_t base, last;
+    int base_found, last_found;
+    int count = Db_Load(db, baseline, &base, &base_found, &last, &last_found);
+
+    if (report_only)
+    {
+        if (!last_found || !base_found)
+        {
+            fprintf(stderr, "%s: %d records, nothing to compare\n", db, count);
+            return 1;
+        }
+        return Compare(&base, &last, pct) ? 3 : 0;
+    }
+
+    PerfRecord_t rec;
+    memset(&rec, 0, sizeof(rec));
+    if (label != NULL)
+        snprintf(rec.label, sizeof(rec.label), "%s", label);
+    else
+        Default_Label(rec.label, sizeof(rec.label));
+    time_t now = time(NULL);
+    strftime(rec.date, sizeof(rec.date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+    if (Measure_Laps(&rec) != 0)
+        fprintf(stderr, "warning: some lap runs failed\n");
+    if (Measure_Isr(&rec, axf, (CarMode_t)isr_task) != 0)
+        fprintf(stderr, "warning: no interrupt cycles from %s\n", axf);
+    if (Map_Sizes(&rec, map) != 0)
+        fprintf(stderr, "warning: no sizes from %s\n", map);
+    if (Image_Hash(&rec, axf) == 0)
+    {
+        rec.image_stale = Image_Stale(axf);
+        if (rec.image_stale)
+            fprintf(stderr, "warning: %s is older than the firmware sources; rebuild it in Keil, "
+                            "isr and size fields belong to the old image\n", axf);
+    }
+
+    Record_Write(stdout, &rec);
+    if (!dry && Db_Append(db, &rec) != 0)
+        return 1;
+
+    // 没有-b时与追加前的最后一条比较 Without -b compare with the last record before this one
+    if (baseline == NULL && last_found)
+    {
+        base = last;
+        base_found = 1;
+    }
+    if (!base_found)
+    {
+        if (baseline != NULL)
+            printf("baseline %s not found\n", baseline);
+        else
+            printf("first record, nothing to compare\n");
+        return 0;
+    }
+    return Compare(&base, &rec, pct) ? 3 : 0;
+}
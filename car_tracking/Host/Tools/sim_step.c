@@ -0,0 +1,106 @@
+/*
+ * sim_step.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * 速度阶跃仿真：通过Motion_Set_Speed给出阶跃，经真实的Motion_Handle/PID闭环，
+ * 输出轮速响应和行驶偏差。
+ * Speed step simulation: steps Motion_Set_Speed and closes the loop through
+ * the real Motion_Handle/PID code, printing wheel response and path error.
+ *
+ * 用法 Usage: sim_step [left mm/s] [right mm/s] [seconds] [kp ki kd]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bsp.h"
+#include "hal_shim.h"
+#include "sim_board.h"
+
+#define STEP_AT_US (200000u)
+#define PRINT_US (50000u)
+
+int main(int argc, char **argv)
+{
+    int16_t left = argc > 1 ? (int16_t)atoi(argv[1]) : 700;
+    int16_t right = argc > 2 ? (int16_t)atoi(argv[2]) : 700;
+    double seconds = argc > 3 ? atof(argv[3]) : 2.0;
+
+    SimCarParam_t param;
+    SimBoard_t board;
+    Sim_Car_Default_Param(&param);
+    Shim_Clock_Set_Virtual(1);
+    Sim_Board_Init(&board, &param);
+
+    if (argc > 6)
+        PID_Set_Motor_Parm(MAX_MOTOR, atof(argv[4]), atof(argv[5]), atof(argv[6]));
+
+    uint64_t end_us = STEP_AT_US + (uint64_t)(seconds * 1e6);
+    uint64_t next_print_us = 0;
+    uint8_t stepped = 0;
+    float target = (left + right) * 0.5f;
+    float peak = 0, t10 = -1, t90 = -1;
+    double err_sum = 0, err_sq = 0;
+    uint32_t err_n = 0;
+
+    printf("   t_ms  set_L  set_R  wheel_L  wheel_R   fw_M1   fw_M3   pwm_M1  pwm_M3     x_mm    y_mm  yaw_deg\n");
+    while (board.now_us < end_us)
+    {
+        Sim_Board_Pass(&board);
+
+        if (!stepped && board.now_us >= STEP_AT_US)
+        {
+            Motion_Set_Speed(left, left, right, right);
+            stepped = 1;
+        }
+
+        SimCar_t *car = &board.car;
+        float v = (car->wheel_mm_s[0] + car->wheel_mm_s[1] + car->wheel_mm_s[2] + car->wheel_mm_s[3]) * 0.25f;
+        if (stepped && target != 0)
+        {
+            float t_ms = (board.now_us - STEP_AT_US) / 1000.0f;
+            if (t10 < 0 && v / target >= 0.1f)
+                t10 = t_ms;
+            if (t90 < 0 && v / target >= 0.9f)
+                t90 = t_ms;
+            if (v / target > peak)
+                peak = v / target;
+            if (board.now_us + 1000000u >= end_us)
+            {
+                err_sum += target - v;
+                err_sq += (target - v) * (target - v);
+                err_n++;
+            }
+        }
+
+        if (board.now_us >= next_print_us)
+        {
+            float fw[4];
+            Motion_Get_Motor_Speed(fw);
+            next_print_us += PRINT_US;
+            printf("%7.0f  %5d  %5d  %7.1f  %7.1f  %6.1f  %6.1f  %7.0f %7.0f  %7.1f %7.1f  %7.2f\n",
+                   board.now_us / 1000.0, stepped ? left : 0, stepped ? right : 0,
+                   (car->wheel_mm_s[0] + car->wheel_mm_s[1]) * 0.5f,
+                   (car->wheel_mm_s[2] + car->wheel_mm_s[3]) * 0.5f,
+                   fw[0], fw[2], car->duty[0], car->duty[2],
+                   car->x_mm, car->y_mm, car->yaw_rad * 180.0 / M_PI);
+        }
+    }
+
+    printf("\nstep %d/%d mm/s, %u TIM6 interrupts\n", left, right, (unsigned)board.isr_count);
+    if (target != 0)
+    {
+        printf("rise 10-90%%   : %.0f ms\n", (t10 >= 0 && t90 >= 0) ? t90 - t10 : -1.0f);
+        printf("overshoot     : %.1f %%\n", (peak - 1.0f) * 100.0f);
+        if (err_n)
+            printf("steady error  : mean %.1f mm/s, rms %.1f mm/s (last 1 s)\n",
+                   err_sum / err_n, sqrt(err_sq / err_n));
+    }
+    if (left == right)
+        printf("path error    : %.1f mm lateral, %.2f deg heading after %.0f mm\n",
+               board.car.y_mm, board.car.yaw_rad * 180.0 / M_PI, board.car.x_mm);
+    return 0;
+}
@@ -0,0 +1,151 @@
+/*
+ * trace_replay.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * 回放输入记录：把实车(或lap_bench -w)记下的传感器、按键、编码器和
+ * 节拍读数喂回BSP_Loop和TIM6中断，打印固件的关键点判定，并检查
+ * 重新记录的结果是否与原记录逐位相同。修改APP_Check_Points等逻辑后
+ * 重新编译再回放，即可在毫秒级时间内对比同一次运行上的判定。
+ * Input trace replay: feeds the sensor, key, encoder and tick reads
+ * recorded on the car (or by lap_bench -w) back into BSP_Loop and the TIM6
+ * interrupt, prints the firmware's point detections and checks that the
+ * re-recorded trace is bit-identical to the original. Rebuild after
+ * changing APP_Check_Points or similar logic and replay again to compare
+ * the decisions on the same run within milliseconds.
+ *
+ * 用法 Usage: trace_replay [-m mode] [-o out.trc] trace.trc
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sim_trace.h"
+#include "hal_shim.h"
+
+static char Point_Char(PathPoint_t point)
+{
+    return point >= POINT_A && point <= POINT_D ? (char)('A' + point - POINT_A) : '-';
+}
+
+static double Now_Ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec * 1e-6;
+}
+
+int main(int argc, char **argv)
+{
+    const char *out_path = NULL;
+    int mode = -1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "m:o:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'm':
+            mode = atoi(optarg);
+            break;
+        case 'o':
+            out_path = optarg;
+            break;
+        default:
+            optind = argc;
+            break;
+        }
+    }
+    if (optind != argc - 1)
+    {
+        fprintf(stderr, "usage: %s [-m mode] [-o out.trc] trace.trc\n", argv[0]);
+        return 2;
+    }
+
+    SimTraceFile_t trace;
+    if (Sim_Trace_Load(argv[optind], &trace) != 0)
+        return 1;
+    if (mode >= 0)
+        trace.mode = (CarMode_t)mode;
+
+    // 与Sim_Run相同的上电顺序 Same power-on sequence as Sim_Run
+    Shim_Reset();
+    Shim_Clock_Set_Virtual(1);
+    BSP_Init();
+    PID_Set_Motor_Parm(MAX_MOTOR, PID_DEF_KP, PID_DEF_KI, PID_DEF_KD);
+    set_line_speed(LINE_SPEED_DEF);
+    APP_Set_Arc_Radius(ARC_TURN_RADIUS_DEF);
+
+    SimReplay_t rp;
+    if (Sim_Replay_Start(&rp, trace.rec, trace.count) != 0)
+    {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    // 时间从记录的第一个节拍算起 Times count from the first recorded tick
+    uint32_t start_tick = 0;
+    for (uint32_t i = 0; i < trace.count; i++)
+    {
+        if (TRACE_KIND(trace.rec[i]) == TRACE_KIND_TICK)
+        {
+            start_tick = TRACE_VALUE(trace.rec[i]);
+            break;
+        }
+    }
+
+    double t0 = Now_Ms();
+    if (trace.mode != MODE_IDLE)
+        APP_Set_Mode(trace.mode);
+
+    PathPoint_t last_point = APP_Get_Point(), shown_point = last_point;
+    uint8_t completed = 0, shown_completed = 0;
+
+    // 固件在HAL_Delay期间不读节拍，判定延后一遍打印，用下一遍读到的时间
+    // The firmware reads no tick inside HAL_Delay, so a detection is printed
+    // one pass later with the time the next pass read
+    printf("%s: %u records, task %d\n", argv[optind], trace.count, trace.mode);
+    for (int more = 1; more;)
+    {
+        more = !Sim_Replay_Done(&rp);
+        if (more)
+            BSP_Loop();
+        else
+            Sim_Replay_Finish(&rp);
+
+        double t = (rp.tick - start_tick) / 1000.0;
+        if (shown_point != last_point)
+        {
+            printf("  %8.3f s  point %c\n", t, Point_Char(last_point));
+            shown_point = last_point;
+        }
+        if (shown_completed != completed)
+        {
+            printf("  %8.3f s  task completed\n", t);
+            shown_completed = completed;
+        }
+        last_point = APP_Get_Point();
+        completed = APP_Get_Task_Completed();
+    }
+    double elapsed = Now_Ms() - t0;
+
+    uint32_t diff;
+    int exact = Sim_Replay_Compare(&rp, &diff) == 0;
+    printf("replayed %.3f s of car time in %.1f ms: %u passes, %u interrupts\n",
+           (rp.tick - start_tick) / 1000.0, elapsed, rp.passes, rp.isrs);
+    if (exact)
+        printf("bit-exact: re-recorded trace is identical\n");
+    else
+        printf("diverged at record %u of %u: %u mismatched reads, %u unread changes, %u missing\n",
+               diff, trace.count, rp.mismatched, rp.unread, rp.missing);
+
+    if (out_path != NULL)
+        Sim_Trace_Save(out_path, trace.mode, g_trace.buf, g_trace.count);
+
+    Sim_Replay_Stop(&rp);
+    Sim_Trace_Free(&trace);
+    return exact ? 0 : 3;
+}
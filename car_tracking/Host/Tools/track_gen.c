@@ -0,0 +1,138 @@
+/*
+ * track_gen.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * 赛道生成：按任务布局族和参数范围生成一批.trk文件，供lap_bench在
+ * 多条赛道上评估。文件名为gen<种子>.trk。
+ * Track generation: writes a batch of .trk files for one task layout
+ * family and set of ranges, so lap_bench can be run over many layouts.
+ * Files are named gen<seed>.trk.
+ *
+ * 范围写作"值"或"下限:上限"。A range is "value" or "lo:hi".
+ *
+ * 用法 Usage: track_gen [-t task] [-n count] [-s seed] [-o dir]
+ *                       [-L straight] [-R radius] [-K skew_deg] [-B bend_deg]
+ *                       [-W bar] [-G gap_prob] [-X cross_prob] [-A cross_deg]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "sim_trackgen.h"
+
+static int Parse_Range(SimGenRange_t *r, const char *text)
+{
+    char *end;
+    r->lo = strtod(text, &end);
+    r->hi = r->lo;
+    if (*end == ':')
+        r->hi = strtod(end + 1, &end);
+    if (*end != '\0' || r->hi < r->lo)
+    {
+        fprintf(stderr, "bad range: %s\n", text);
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    SimTrackGen_t gen;
+    int task = 3, count = 100;
+    unsigned seed = 1;
+    const char *dir = ".";
+    int opt;
+
+    // 先取任务号，其余选项在默认范围上修改 Take the task first; other options edit its defaults
+    for (int i = 1; i + 1 < argc; i++)
+        if (argv[i][0] == '-' && argv[i][1] == 't' && argv[i][2] == '\0')
+            task = atoi(argv[i + 1]);
+    if (task < MODE_TASK1 || task > MODE_TASK4)
+    {
+        fprintf(stderr, "bad task: %d\n", task);
+        return 2;
+    }
+    Sim_Track_Gen_Default(&gen, (CarMode_t)task);
+
+    while ((opt = getopt(argc, argv, "t:n:s:o:L:R:K:B:W:G:X:A:")) != -1)
+    {
+        int bad = 0;
+        switch (opt)
+        {
+        case 't':
+            break;
+        case 'n':
+            count = atoi(optarg);
+            break;
+        case 's':
+            seed = (unsigned)strtoul(optarg, NULL, 10);
+            break;
+        case 'o':
+            dir = optarg;
+            break;
+        case 'L':
+            bad = Parse_Range(&gen.straight_mm, optarg);
+            break;
+        case 'R':
+            bad = Parse_Range(&gen.radius_mm, optarg);
+            break;
+        case 'K':
+            bad = Parse_Range(&gen.skew_deg, optarg);
+            break;
+        case 'B':
+            bad = Parse_Range(&gen.bend_deg, optarg);
+            break;
+        case 'W':
+            bad = Parse_Range(&gen.bar_mm, optarg);
+            break;
+        case 'G':
+            gen.gap_prob = atof(optarg);
+            break;
+        case 'X':
+            gen.cross_prob = atof(optarg);
+            break;
+        case 'A':
+            bad = Parse_Range(&gen.cross_deg, optarg);
+            break;
+        default:
+            bad = 1;
+            break;
+        }
+        if (bad)
+        {
+            fprintf(stderr, "usage: %s [-t task] [-n count] [-s seed] [-o dir]\n"
+                            "       [-L straight] [-R radius] [-K skew_deg] [-B bend_deg]\n"
+                            "       [-W bar] [-G gap_prob] [-X cross_prob] [-A cross_deg]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    int written = 0;
+    for (int n = 0; n < count; n++)
+    {
+        char text[SIM_TRACKGEN_TEXT_MAX];
+        char path[1024];
+        unsigned s = seed + (unsigned)n;
+        if (Sim_Track_Gen_Text(&gen, s, text, sizeof(text)) != 0)
+        {
+            fprintf(stderr, "seed %u: no closed layout within the ranges\n", s);
+            continue;
+        }
+        snprintf(path, sizeof(path), "%s/gen%u.trk", dir, s);
+        FILE *f = fopen(path, "w");
+        if (f == NULL)
+        {
+            perror(path);
+            return 1;
+        }
+        fputs(text, f);
+        fclose(f);
+        written++;
+    }
+    printf("wrote %d task%d tracks to %s\n", written, task, dir);
+    return written == count ? 0 : 1;
+}
@@ -0,0 +1,91 @@
+/*
+ * track_info.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: AutoCar
+ *
+ * 加载赛道文件，打印路段和关键点，测量传感器采样耗时，可导出PGM图像。
+ * Loads a track file, prints its segments and markers, times sensor
+ * lookups and optionally writes the raster as a PGM image.
+ *
+ * 用法 Usage: track_info <file.trk> [out.pgm]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "sim_track.h"
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <file.trk> [out.pgm]\n", argv[0]);
+        return 2;
+    }
+
+    static SimTrack_t track;
+    if (Sim_Track_Load(&track, argv[1]) != 0)
+        return 1;
+
+    printf("track %s: %.0f mm, line %.0f mm, raster %dx%d @ %.1f mm (%.1f MB)\n",
+           track.name, track.length, track.line_width, track.width, track.height, track.resolution,
+           track.width * (double)track.height / 1e6);
+    for (int i = 0; i < track.seg_count; i++)
+    {
+        const SimSeg_t *seg = &track.seg[i];
+        printf("  seg %2d  s=%7.1f  %-8s len %7.1f", i, seg->s0,
+               seg->type == SEG_ARC ? "arc" : (seg->drawn ? "straight" : "gap"), seg->length);
+        if (seg->type == SEG_ARC)
+            printf("  r %.0f sweep %.0f deg", seg->radius, seg->sweep * 180.0 / 3.14159265358979);
+        printf("\n");
+    }
+    for (int i = 0; i < track.marker_count; i++)
+    {
+        const SimMarker_t *m = &track.marker[i];
+        printf("  marker %c  s=%7.1f  (%.1f, %.1f)  bar %.0f mm\n",
+               'A' + m->point - POINT_A, m->s, m->x, m->y, m->bar_mm);
+    }
+    for (int i = 0; i < track.cross_count; i++)
+    {
+        const SimCross_t *c = &track.cross[i];
+        printf("  cross     (%.1f, %.1f)  %.0f deg  %.0f mm\n",
+               c->x, c->y, c->angle * 180.0 / 3.14159265358979, c->length);
+    }
+
+    // 随机采样计时 Time random lookups
+    const int n = 10000000;
+    unsigned seed = 1, black = 0;
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < n; i++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        double x = track.origin_x + (seed >> 8) % (unsigned)track.width * track.resolution;
+        seed = seed * 1103515245u + 12345u;
+        double y = track.origin_y + (seed >> 8) % (unsigned)track.height * track.resolution;
+        black += Sim_Track_Sample(&track, x, y) < 128;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double ns = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / n;
+    printf("lookup: %.2f ns/sample (%.2f%% black)\n", ns, 100.0 * black / n);
+
+    if (argc > 2)
+    {
+        FILE *f = fopen(argv[2], "wb");
+        if (f == NULL)
+        {
+            perror(argv[2]);
+            return 1;
+        }
+        // 图像上方为+y Image top is +y
+        fprintf(f, "P5\n%d %d\n255\n", track.width, track.height);
+        for (int iy = track.height - 1; iy >= 0; iy--)
+            fwrite(&track.pixels[iy * track.width], 1, (size_t)track.width, f);
+        fclose(f);
+    }
+
+    Sim_Track_Free(&track);
+    return 0;
+}